@@ -9,18 +9,28 @@
 #ifndef _M_MYSVAC_JSON_MACROS_HPP
 #define _M_MYSVAC_JSON_MACROS_HPP
 
+/**
+ * @def M_MYSVAC_JSON_MACROS_TYPE
+ * @brief The Json type the macros convert to and construct from, `::mysvac::Json` by default.
+ * @details Define it before including this header to use another instantiation,
+ *          e.g. one with `MapType::eIndex` so generated objects keep the member order.
+ */
+#ifndef M_MYSVAC_JSON_MACROS_TYPE
+#define M_MYSVAC_JSON_MACROS_TYPE ::mysvac::Json
+#endif
+
 /**
  * @defgroup JSON_CONVERSION_MACROS JSON Conversion Macros
  * @brief Macros for converting C++ objects to JSON Values
  * @details These macros provide automatic serialization of C++ class members to JSON format.
- *          They generate operator::mysvac::Json() with perfect forwarding support.
+ *          They generate operator M_MYSVAC_JSON_MACROS_TYPE() with perfect forwarding support.
  */
 
 
 #define M_MYSVAC_JSON_CONVERSION_FIELD( member_name ) \
     do {    \
-        static_assert( std::is_constructible_v< ::mysvac::Json, decltype(this->member_name) >, "MYSVAC_JSON: " #member_name " use macros CONVERSION_FILED, Json must be constructible from it. " );  \
-        json_value[ #member_name ] = ::mysvac::Json{ _move_if_rvalue(this->member_name) };  \
+        static_assert( std::is_constructible_v< M_MYSVAC_JSON_MACROS_TYPE, decltype(this->member_name) >, "MYSVAC_JSON: " #member_name " use macros CONVERSION_FILED, Json must be constructible from it. " );  \
+        json_value[ #member_name ] = M_MYSVAC_JSON_MACROS_TYPE{ _move_if_rvalue(this->member_name) };  \
     }while(false);
     
 /**
@@ -31,8 +41,8 @@
  */
 #define M_MYSVAC_JSON_CONVERSION_MAP_FIELD( field_name, member_name ) \
     do {    \
-        static_assert( std::is_constructible_v< ::mysvac::Json, decltype(this->member_name) >, "MYSVAC_JSON: " #member_name " use macros CONVERSION_FILED, Json must be constructible from it. " );  \
-        json_value[ #field_name ] = ::mysvac::Json{ _move_if_rvalue(this->member_name) };  \
+        static_assert( std::is_constructible_v< M_MYSVAC_JSON_MACROS_TYPE, decltype(this->member_name) >, "MYSVAC_JSON: " #member_name " use macros CONVERSION_FILED, Json must be constructible from it. " );  \
+        json_value[ #field_name ] = M_MYSVAC_JSON_MACROS_TYPE{ _move_if_rvalue(this->member_name) };  \
     }while(false);
 
 /**
@@ -42,20 +52,20 @@
  * @param ... Variable arguments containing conversion field macros
  */
 #define M_MYSVAC_JSON_CONVERSION_FUNCTION( class_name, ... )   \
-    explicit operator ::mysvac::Json() const & noexcept { \
-        ::mysvac::Json json_value{ ::mysvac::Json::Obj{} }; \
+    explicit operator M_MYSVAC_JSON_MACROS_TYPE() const & noexcept { \
+        M_MYSVAC_JSON_MACROS_TYPE json_value{ M_MYSVAC_JSON_MACROS_TYPE::Obj{} }; \
         auto _move_if_rvalue = [](const auto& val) -> const auto& { return val; }; \
         __VA_ARGS__ \
         return json_value; \
     } \
-    explicit operator ::mysvac::Json() && noexcept { \
-    ::mysvac::Json json_value{ ::mysvac::Json::Obj{} }; \
+    explicit operator M_MYSVAC_JSON_MACROS_TYPE() && noexcept { \
+    M_MYSVAC_JSON_MACROS_TYPE json_value{ M_MYSVAC_JSON_MACROS_TYPE::Obj{} }; \
     auto _move_if_rvalue = [](auto& val) -> auto&& { return std::move(val); }; \
     __VA_ARGS__ \
     return json_value; \
     } \
-    explicit operator ::mysvac::Json() & noexcept { \
-        ::mysvac::Json json_value{ ::mysvac::Json::Obj{} }; \
+    explicit operator M_MYSVAC_JSON_MACROS_TYPE() & noexcept { \
+        M_MYSVAC_JSON_MACROS_TYPE json_value{ M_MYSVAC_JSON_MACROS_TYPE::Obj{} }; \
         auto _move_if_rvalue = [](auto& val) -> auto& { return val; }; \
         __VA_ARGS__ \
         return json_value; \
@@ -136,7 +146,7 @@
  * @param ... Variable arguments containing constructor field macros
  */
 #define M_MYSVAC_JSON_CONSTRUCTOR_FUNCTION( class_name, ... ) \
-    explicit class_name ( ::mysvac::Json json_value ) noexcept {  \
+    explicit class_name ( M_MYSVAC_JSON_MACROS_TYPE json_value ) noexcept {  \
         __VA_ARGS__     \
     }
 
@@ -12,10 +12,10 @@ module;
 #include <cctype>
 #include <cmath>
 #include <cstdint>
+#include <limits>
 #include <charconv>
 #include <format>
 #include <iostream>
-#include <iomanip>
 #include <type_traits>
 #include <array>
 #include <string>
@@ -23,13 +23,55 @@ module;
 #include <vector>
 #include <map>
 #include <unordered_map>
+#include <unordered_set>
 #include <variant>
 #include <optional>
 #include <iterator>
 #include <ranges>
+#include <memory>
+#include <span>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+#include <memory_resource>
+#include <mutex>
+#include <condition_variable>
+#include <barrier>
+#include <atomic>
+#include <utility>
+#include <numeric>
+#include <bit>
+#include <cstring>
+#include <random>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
 
 #endif
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define M_MYSVAC_JSON_HAS_SSE2
+#endif
+
+#if __has_include(<unistd.h>) && __has_include(<sys/uio.h>) && __has_include(<poll.h>)
+#include <cerrno>
+#include <climits>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <poll.h>
+#define M_MYSVAC_JSON_HAS_POSIX_IO
+#endif
+
+#if __has_include(<sys/mman.h>) && __has_include(<sys/stat.h>) && __has_include(<fcntl.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define M_MYSVAC_JSON_HAS_MMAP
+#endif
+
 export module mysvac.json;
 
 #ifdef M_MYSVAC_JSON_ENABLE_STD_MODULE
@@ -68,6 +110,733 @@ namespace mysvac::json {
     }();
 
     constexpr char hex_digits[] = "0123456789abcdef";
+
+    /**
+     * @brief A lookup table for characters that must be escaped in JSON strings.
+     * @note Non-export.
+     */
+    constexpr std::array<bool, 256> escape_table = [] {
+        std::array<bool, 256> table{};
+        for (int i = 0; i < 0x20; ++i) table[i] = true;
+        table['\"'] = true;
+        table['\\'] = true;
+        return table;
+    }();
+
+    /**
+     * @brief Spaces used for indentation, appended in blocks.
+     * @note Non-export.
+     */
+    constexpr std::string_view indent_spaces = "                                                                ";
+
+    /**
+     * @brief Escape a string and write it with quotes to a sink.
+     * @tparam Borrow `str` outlives the output, e.g. it belongs to the value being written.
+     * @param out The sink to write to.
+     * @param str The string to escape.
+     * @note Non-export. Unescaped runs are appended in bulk,
+     * with `Borrow` a string without escapes is passed by `append_ref` if the sink has it.
+     */
+    template<bool Borrow = false>
+    void escape_to(auto& out, const std::string_view str) {
+        out.push_back('\"');
+        const char* run = str.data();
+        const char* const end = run + str.size();
+        const char* it = std::find_if(run, end, [](const char c) { return escape_table[static_cast<unsigned char>(c)]; });
+        if constexpr (Borrow && requires { out.append_ref(run, str.size()); }) {
+            if (it == end) {
+                out.append_ref(run, str.size());
+                out.push_back('\"');
+                return;
+            }
+        }
+        for (; it != end; ++it) {
+            if (!escape_table[static_cast<unsigned char>(*it)]) continue;
+            if (it != run) out.append(run, static_cast<std::size_t>(it - run));
+            switch (*it) {
+                case '\\': out.append(R"(\\)", 2); break;
+                case '\"': out.append(R"(\")", 2); break;
+                case '\r': out.append(R"(\r)", 2); break;
+                case '\n': out.append(R"(\n)", 2); break;
+                // case '\f': out.append(R"(\f)", 2); break; // do not support `\f` for better performance
+                case '\t': out.append(R"(\t)", 2); break;
+                // case '\b': out.append(R"(\b)", 2); break; // do not support `\b` for better performance
+                default: {
+                    out.append(R"(\u00)", 4);
+                    out.push_back(hex_digits[*it >> 4]);
+                    out.push_back(hex_digits[*it & 0x0F]);
+                } break;
+            }
+            run = it + 1;
+        }
+        if (run != end) out.append(run, static_cast<std::size_t>(end - run));
+        out.push_back('\"');
+    }
+
+    /**
+     * @brief Write a number to a sink, shortest round-trip form with 17 significant digits.
+     * @note Non-export.
+     */
+    void number_to(auto& out, const double value) {
+        char buffer[25]; // Reserve enough space for typical numbers
+        const auto [ptr, ec]  = std::to_chars(
+            buffer,
+            buffer + 25,
+            value,
+            std::chars_format::general,
+            17
+        );
+        if(ec != std::errc{}) {
+            const auto str = std::format("{:.17}", value);
+            out.append(str.data(), str.size());
+        } else out.append(buffer, static_cast<std::size_t>(ptr - buffer));
+    }
+
+    /**
+     * @brief Write `count` spaces to a sink.
+     * @note Non-export.
+     */
+    void indent_to(auto& out, std::size_t count) {
+        while (count > indent_spaces.size()) {
+            out.append(indent_spaces.data(), indent_spaces.size());
+            count -= indent_spaces.size();
+        }
+        out.append(indent_spaces.data(), count);
+    }
+
+    /**
+     * @brief Sink writing through an output iterator, used by `std::formatter`.
+     * @note Non-export.
+     */
+    template<typename It>
+    struct iterator_sink {
+        It it;
+        void push_back(const char c) { *it = c; ++it; }
+        void append(const char* data, const std::size_t len) { it = std::copy_n(data, len, std::move(it)); }
+    };
+
+    /**
+     * @brief Base of Json holding the cached `write` output of a container, empty if disabled.
+     * @tparam Enable Whether the cache exists.
+     * @tparam Str The string type of the cache.
+     * @note Non-export. Copies start without cache.
+     * The cache is filled through const access, it is published with a compare-exchange
+     * so that several threads may write the same value at once. It is only dropped by non-const access.
+     */
+    template<bool Enable, typename Str>
+    class dump_cache {};
+
+    template<typename Str>
+    class dump_cache<true, Str> {
+    protected:
+        mutable std::atomic<const Str*> m_dump_cache{ nullptr };
+        // a mutable reference into the value was handed out, the children may change unseen
+        bool m_exposed{ false };
+
+        dump_cache() noexcept = default;
+        dump_cache(const dump_cache&) noexcept {}
+        dump_cache& operator=(const dump_cache&) noexcept {
+            drop_cache();
+            m_exposed = false;
+            return *this;
+        }
+        ~dump_cache() { drop_cache(); }
+
+        void drop_cache() noexcept {
+            delete m_dump_cache.exchange(nullptr, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Take the cache and the exposed state of a moved-from value.
+         */
+        void take_cache(dump_cache& other) noexcept {
+            drop_cache();
+            m_dump_cache.store(other.m_dump_cache.exchange(nullptr, std::memory_order_relaxed), std::memory_order_relaxed);
+            m_exposed = std::exchange(other.m_exposed, false);
+        }
+
+        /**
+         * @brief Get the cached output, `nullptr` if there is none or the value is exposed.
+         */
+        const Str* cached() const noexcept {
+            return m_exposed ? nullptr : m_dump_cache.load(std::memory_order_acquire);
+        }
+
+        /**
+         * @brief Store `fragment` as the cache unless another thread stored one first.
+         * @return The cache in place afterwards, with the same bytes either way.
+         */
+        const Str& publish(std::unique_ptr<Str> fragment) const noexcept {
+            const Str* expected = nullptr;
+            if (m_dump_cache.compare_exchange_strong(expected, fragment.get(), std::memory_order_acq_rel, std::memory_order_acquire)) {
+                return *fragment.release();
+            }
+            return *expected;
+        }
+    };
+
+    /**
+     * @brief Tagged 16-byte storage for Json, scalars inline and Str/Arr/Obj out-of-line.
+     * @tparam Str, Arr, Obj The Json types.
+     * @tparam StrAlloc, ArrAlloc, ObjAlloc Allocators for the out-of-line objects, always default-constructed.
+     * @tparam Shared Share out-of-line objects between copies through a reference count, copied on write.
+     * @note Non-export. Mirrors the subset of `std::variant` used by Json, index order is `Type`.
+     * Moving steals the pointer and leaves Nul behind, no allocation.
+     * If `Shared`, non-const `ref` detaches a node that is referenced more than once, const `ref` never does.
+     * A detach invalidates every reference taken into the node before it was shared, const references too.
+     */
+    template<typename Str, typename Arr, typename Obj, typename StrAlloc, typename ArrAlloc, typename ObjAlloc, bool Shared>
+    class compact_storage {
+        template<typename T>
+        struct shared_box {
+            std::atomic<std::size_t> refs;
+            T value;
+        };
+        template<typename T>
+        using box = std::conditional_t<Shared, shared_box<T>, T>;
+
+        union {
+            std::nullptr_t m_nul;
+            bool m_bol;
+            double m_num;
+            box<Str>* m_str;
+            box<Arr>* m_arr;
+            box<Obj>* m_obj;
+        };
+        std::uint8_t m_index;
+
+        template<typename T>
+        [[nodiscard]]
+        static T& value_of(box<T>* ptr) noexcept {
+            if constexpr (Shared) return ptr->value;
+            else return *ptr;
+        }
+
+        // the node is allocated with the allocator of the object it holds,
+        // so a stateful allocator frees it to the same resource
+        template<typename T, typename Alloc, typename U>
+        static box<T>* create(U&& value) {
+            using BoxAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<box<T>>;
+            using traits = std::allocator_traits<BoxAlloc>;
+            BoxAlloc alloc;
+            box<T>* ptr = traits::allocate(alloc, 1);
+            try {
+                if constexpr (Shared) {
+                    std::construct_at(&ptr->refs, 1);
+                    std::construct_at(&ptr->value, std::forward<U>(value), typename T::allocator_type(alloc));
+                } else {
+                    std::construct_at(ptr, std::forward<U>(value), typename T::allocator_type(alloc));
+                }
+            } catch (...) {
+                traits::deallocate(alloc, ptr, 1);
+                throw;
+            }
+            return ptr;
+        }
+
+        template<typename Alloc, typename T>
+        static void destroy(T* ptr) noexcept {
+            using BoxAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<T>;
+            if constexpr (Shared) {
+                if (ptr->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+                BoxAlloc alloc(ptr->value.get_allocator());
+                std::destroy_at(ptr);
+                std::allocator_traits<BoxAlloc>::deallocate(alloc, ptr, 1);
+            } else {
+                BoxAlloc alloc(ptr->get_allocator());
+                std::destroy_at(ptr);
+                std::allocator_traits<BoxAlloc>::deallocate(alloc, ptr, 1);
+            }
+        }
+
+        template<typename T>
+        static T* share(T* ptr) noexcept {
+            ptr->refs.fetch_add(1, std::memory_order_relaxed);
+            return ptr;
+        }
+
+        // give this storage its own copy of a node referenced elsewhere,
+        // references taken into the old node, const or not, now point into the other owners' node
+        template<typename T, typename Alloc>
+        static void detach(box<T>*& ptr) {
+            if constexpr (Shared) {
+                if (ptr->refs.load(std::memory_order_acquire) == 1) return;
+                box<T>* copy = create<T, Alloc>(std::as_const(ptr->value));
+                destroy<Alloc>(ptr);
+                ptr = copy;
+            }
+        }
+
+        template<typename T>
+        static constexpr std::uint8_t index_of() noexcept {
+            if constexpr (std::is_same_v<T, std::nullptr_t>) return 0;
+            else if constexpr (std::is_same_v<T, bool>) return 1;
+            else if constexpr (std::is_same_v<T, double>) return 2;
+            else if constexpr (std::is_same_v<T, Str>) return 3;
+            else if constexpr (std::is_same_v<T, Arr>) return 4;
+            else return 5;
+        }
+
+        template<typename T>
+        void construct(T&& value) {
+            using U = std::remove_cvref_t<T>;
+            if constexpr (std::is_same_v<U, std::nullptr_t>) m_nul = nullptr;
+            else if constexpr (std::is_same_v<U, bool>) m_bol = value;
+            else if constexpr (std::is_same_v<U, double>) m_num = value;
+            else if constexpr (std::is_same_v<U, Str>) m_str = create<Str, StrAlloc>(std::forward<T>(value));
+            else if constexpr (std::is_same_v<U, Arr>) m_arr = create<Arr, ArrAlloc>(std::forward<T>(value));
+            else m_obj = create<Obj, ObjAlloc>(std::forward<T>(value));
+            m_index = index_of<U>();
+        }
+
+        void steal(compact_storage& other) noexcept {
+            switch (other.m_index) {
+                case 1: m_bol = other.m_bol; break;
+                case 2: m_num = other.m_num; break;
+                case 3: m_str = other.m_str; break;
+                case 4: m_arr = other.m_arr; break;
+                case 5: m_obj = other.m_obj; break;
+                default: m_nul = nullptr; break;
+            }
+            m_index = other.m_index;
+            other.m_nul = nullptr;
+            other.m_index = 0;
+        }
+
+        void release() noexcept {
+            switch (m_index) {
+                case 3: destroy<StrAlloc>(m_str); break;
+                case 4: destroy<ArrAlloc>(m_arr); break;
+                case 5: destroy<ObjAlloc>(m_obj); break;
+                default: break;
+            }
+            m_nul = nullptr;
+            m_index = 0;
+        }
+
+    public:
+        template<typename T>
+        static constexpr bool is_alternative = std::disjunction_v<
+            std::is_same<T, std::nullptr_t>, std::is_same<T, bool>, std::is_same<T, double>,
+            std::is_same<T, Str>, std::is_same<T, Arr>, std::is_same<T, Obj>
+        >;
+
+        constexpr compact_storage() noexcept : m_nul(nullptr), m_index(0) {}
+
+        template<typename T>
+        requires is_alternative<std::remove_cvref_t<T>>
+        compact_storage(T&& value) : m_nul(nullptr), m_index(0) { construct(std::forward<T>(value)); }
+
+        compact_storage(const compact_storage& other) : m_nul(nullptr), m_index(0) {
+            if constexpr (Shared) {
+                switch (other.m_index) {
+                    case 1: m_bol = other.m_bol; break;
+                    case 2: m_num = other.m_num; break;
+                    case 3: m_str = share(other.m_str); break;
+                    case 4: m_arr = share(other.m_arr); break;
+                    case 5: m_obj = share(other.m_obj); break;
+                    default: break;
+                }
+                m_index = other.m_index;
+            } else {
+                switch (other.m_index) {
+                    case 1: construct(other.m_bol); break;
+                    case 2: construct(other.m_num); break;
+                    case 3: construct(*other.m_str); break;
+                    case 4: construct(*other.m_arr); break;
+                    case 5: construct(*other.m_obj); break;
+                    default: break;
+                }
+            }
+        }
+
+        compact_storage(compact_storage&& other) noexcept : m_nul(nullptr), m_index(0) { steal(other); }
+
+        ~compact_storage() { release(); }
+
+        compact_storage& operator=(const compact_storage& other) {
+            if (this != &other) *this = compact_storage(other);
+            return *this;
+        }
+
+        compact_storage& operator=(compact_storage&& other) noexcept {
+            if (this == &other) return *this;
+            release();
+            steal(other);
+            return *this;
+        }
+
+        template<typename T>
+        requires is_alternative<std::remove_cvref_t<T>>
+        compact_storage& operator=(T&& value) {
+            using U = std::remove_cvref_t<T>;
+            if constexpr (std::is_same_v<U, Str> || std::is_same_v<U, Arr> || std::is_same_v<U, Obj>) {
+                // reuse the out-of-line object of the same type, unless it is shared
+                if (m_index == index_of<U>() && unique()) {
+                    ref<U>() = std::forward<T>(value);
+                    return *this;
+                }
+                // construct first, `value` may live inside this storage
+                compact_storage tmp(std::forward<T>(value));
+                return *this = std::move(tmp);
+            } else {
+                release();
+                construct(std::forward<T>(value));
+                return *this;
+            }
+        }
+
+        [[nodiscard]]
+        constexpr std::size_t index() const noexcept { return m_index; }
+
+        /**
+         * @brief Whether the out-of-line object is referenced by this storage only, always true for scalars.
+         */
+        [[nodiscard]]
+        bool unique() const noexcept {
+            if constexpr (Shared) {
+                switch (m_index) {
+                    case 3: return m_str->refs.load(std::memory_order_acquire) == 1;
+                    case 4: return m_arr->refs.load(std::memory_order_acquire) == 1;
+                    case 5: return m_obj->refs.load(std::memory_order_acquire) == 1;
+                    default: return true;
+                }
+            } else return true;
+        }
+
+        template<typename T>
+        [[nodiscard]]
+        T& ref() {
+            if (m_index != index_of<T>()) throw std::bad_variant_access{};
+            if constexpr (std::is_same_v<T, std::nullptr_t>) return m_nul;
+            else if constexpr (std::is_same_v<T, bool>) return m_bol;
+            else if constexpr (std::is_same_v<T, double>) return m_num;
+            else if constexpr (std::is_same_v<T, Str>) {
+                detach<Str, StrAlloc>(m_str);
+                return value_of<Str>(m_str);
+            } else if constexpr (std::is_same_v<T, Arr>) {
+                detach<Arr, ArrAlloc>(m_arr);
+                return value_of<Arr>(m_arr);
+            } else {
+                detach<Obj, ObjAlloc>(m_obj);
+                return value_of<Obj>(m_obj);
+            }
+        }
+
+        template<typename T>
+        [[nodiscard]]
+        const T& ref() const {
+            if (m_index != index_of<T>()) throw std::bad_variant_access{};
+            if constexpr (std::is_same_v<T, std::nullptr_t>) return m_nul;
+            else if constexpr (std::is_same_v<T, bool>) return m_bol;
+            else if constexpr (std::is_same_v<T, double>) return m_num;
+            else if constexpr (std::is_same_v<T, Str>) return value_of<Str>(m_str);
+            else if constexpr (std::is_same_v<T, Arr>) return value_of<Arr>(m_arr);
+            else return value_of<Obj>(m_obj);
+        }
+    };
+
+    /**
+     * @brief `std::get` counterparts for compact_storage, found together with `std::get` by unqualified calls.
+     * @note Non-export.
+     */
+    template<typename T, typename S, typename A, typename O, typename SA, typename AA, typename OA, bool Shared>
+    constexpr T& get(compact_storage<S, A, O, SA, AA, OA, Shared>& storage) { return storage.template ref<T>(); }
+    template<typename T, typename S, typename A, typename O, typename SA, typename AA, typename OA, bool Shared>
+    constexpr const T& get(const compact_storage<S, A, O, SA, AA, OA, Shared>& storage) { return storage.template ref<T>(); }
+    template<typename T, typename S, typename A, typename O, typename SA, typename AA, typename OA, bool Shared>
+    constexpr T&& get(compact_storage<S, A, O, SA, AA, OA, Shared>&& storage) { return std::move(storage.template ref<T>()); }
+    template<typename T, typename S, typename A, typename O, typename SA, typename AA, typename OA, bool Shared>
+    constexpr const T&& get(const compact_storage<S, A, O, SA, AA, OA, Shared>&& storage) { return std::move(storage.template ref<T>()); }
+
+    /**
+     * @brief The memory resource installed by the innermost MemoryScope of this thread, `nullptr` if none.
+     * @note Non-export.
+     */
+    inline std::pmr::memory_resource*& scoped_resource() noexcept {
+        thread_local std::pmr::memory_resource* resource{ nullptr };
+        return resource;
+    }
+
+    /**
+     * @brief Sink that only counts the bytes written to it.
+     * @note Non-export.
+     */
+    struct size_counter {
+        std::size_t size{ 0 };
+        constexpr void push_back(char) noexcept { ++size; }
+        constexpr void append(const char*, const std::size_t len) noexcept { size += len; }
+    };
+
+    /**
+     * @brief Base of the buffered sinks, collects output and hands it to `Derived::emit` in large blocks.
+     * @tparam Derived The concrete sink, must provide `bool emit(const char*, std::size_t)`.
+     * @note Non-export.
+     */
+    template<typename Derived>
+    class buffered_sink {
+        std::unique_ptr<char[]> m_buffer;
+        std::size_t m_capacity;
+        std::size_t m_size{ 0 };
+        bool m_failed{ false };
+
+        void emit_buffer() {
+            if (m_size != 0 && !m_failed) {
+                m_failed = !static_cast<Derived*>(this)->emit(m_buffer.get(), m_size);
+            }
+            m_size = 0;
+        }
+
+    protected:
+        explicit buffered_sink(const std::size_t capacity)
+            : m_buffer(std::make_unique_for_overwrite<char[]>(capacity)), m_capacity(capacity) {}
+
+        buffered_sink(const buffered_sink&) = delete;
+        buffered_sink& operator=(const buffered_sink&) = delete;
+        ~buffered_sink() = default;
+
+        /**
+         * @brief `flush()` for destructors, an exception from the destination only marks the sink failed.
+         */
+        void finish() noexcept {
+            try {
+                emit_buffer();
+            } catch (...) {
+                m_failed = true;
+            }
+        }
+
+    public:
+        void push_back(const char c) {
+            if (m_size == m_capacity) emit_buffer();
+            m_buffer[m_size++] = c;
+        }
+
+        void append(const char* data, std::size_t len) {
+            if (m_failed) return;
+            if (len > m_capacity - m_size) {
+                emit_buffer();
+                // large pieces skip the buffer entirely
+                if (len >= m_capacity) {
+                    if (!m_failed) m_failed = !static_cast<Derived*>(this)->emit(data, len);
+                    return;
+                }
+            }
+            std::copy_n(data, len, m_buffer.get() + m_size);
+            m_size += len;
+        }
+
+        /**
+         * @brief Hand all buffered bytes to the destination.
+         * @return `false` if the destination has failed at any point.
+         */
+        bool flush() {
+            emit_buffer();
+            return !m_failed;
+        }
+
+        /**
+         * @brief Check if the destination has failed, later output is discarded.
+         */
+        [[nodiscard]]
+        bool failed() const noexcept { return m_failed; }
+    };
+
+    /**
+     * @brief Initial byte and argument of a CBOR data item.
+     * @note Non-export.
+     */
+    struct cbor_head {
+        std::uint8_t major;     ///< major type, 0 to 7
+        std::uint8_t info;      ///< additional information, the low 5 bits
+        std::uint64_t arg;      ///< value, length, count, tag number or float bits
+        bool indefinite;        ///< additional information 31, a break for major type 7
+    };
+
+    /**
+     * @brief Read a CBOR head and move `it` past it.
+     * @return `false` for truncated input or reserved additional information.
+     * @note Non-export.
+     */
+    inline bool cbor_read_head(const unsigned char*& it, const unsigned char* const end, cbor_head& head) noexcept {
+        if (it == end) return false;
+        const std::uint8_t initial = *it++;
+        head.major = initial >> 5;
+        head.info = initial & 0x1f;
+        head.arg = head.info;
+        head.indefinite = false;
+        if (head.info < 24) return true;
+        if (head.info <= 27) {
+            const std::size_t bytes = std::size_t{ 1 } << (head.info - 24);
+            if (static_cast<std::size_t>(end - it) < bytes) return false;
+            head.arg = 0;
+            for (std::size_t i = 0; i < bytes; ++i) head.arg = head.arg << 8 | it[i];
+            it += bytes;
+            return true;
+        }
+        if (head.info == 31 && head.major >= 2 && head.major != 6) {
+            head.indefinite = true;
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Whether a tag leaves the meaning of its item intact, so the item can be taken as is.
+     * @details
+     * Date/time strings and epochs (0, 1), expected base encodings (21-23), embedded CBOR (24),
+     * URI, base64, regular expression and MIME strings (32-36) and the self-describe prefix (55799).
+     * Other tags, such as bignums (2, 3) or decimal fractions (4, 5), change what the item means.
+     * @note Non-export.
+     */
+    inline constexpr bool cbor_plain_tag(const std::uint64_t tag) noexcept {
+        return tag <= 1 || (tag >= 21 && tag <= 24) || (tag >= 32 && tag <= 36) || tag == 55799;
+    }
+
+    /**
+     * @brief Decode an IEEE 754 half-precision float.
+     * @note Non-export.
+     */
+    inline double cbor_half(const std::uint16_t bits) noexcept {
+        const int exponent = bits >> 10 & 0x1f;
+        const int mantissa = bits & 0x3ff;
+        double value;
+        if (exponent == 0) value = std::ldexp(mantissa, -24);
+        else if (exponent != 31) value = std::ldexp(mantissa + 1024, exponent - 25);
+        else value = mantissa == 0 ? std::numeric_limits<double>::infinity() : std::numeric_limits<double>::quiet_NaN();
+        return bits & 0x8000 ? -value : value;
+    }
+
+    /**
+     * @brief Find the end of the CBOR data item starting at `it`, checking that it is well-formed.
+     * @param max_depth The maximum number of arrays, maps and chunked strings open at once.
+     * @return The first byte after the item, or `nullptr` if the item is malformed, truncated, too deep,
+     * holds a simple value other than false, true, null and undefined, or a tag rejected by `cbor_plain_tag`.
+     * @note Non-export. Nesting is tracked on an explicit stack.
+     */
+    inline const unsigned char* cbor_skip(const unsigned char* it, const unsigned char* const end, const std::size_t max_depth) noexcept {
+        struct frame {
+            std::uint64_t count;    // items left if definite, items seen if indefinite
+            std::uint8_t major;
+            bool indefinite;
+        };
+        std::vector<frame> open;
+        bool tagged = false;    // a tag was read, its item follows
+        try {
+            do {
+                cbor_head head;
+                if (!cbor_read_head(it, end, head)) return nullptr;
+                if (head.major == 7 && head.indefinite) {
+                    // break, only valid right inside an indefinite-length item, and a map needs whole pairs
+                    if (tagged || open.empty() || !open.back().indefinite) return nullptr;
+                    if (open.back().major == 5 && open.back().count % 2) return nullptr;
+                    open.pop_back();
+                } else {
+                    // chunks of a string are definite-length strings of the same major type
+                    if (!open.empty() && (open.back().major == 2 || open.back().major == 3)
+                        && (head.major != open.back().major || head.indefinite)
+                    ) return nullptr;
+                    tagged = false;
+                    const auto remaining = static_cast<std::uint64_t>(end - it);
+                    switch (head.major) {
+                        case 0: case 1: break;
+                        case 2: case 3:
+                            if (head.indefinite) {
+                                open.push_back({ 0, head.major, true });
+                                if (open.size() > max_depth) return nullptr;
+                                continue;
+                            }
+                            if (head.arg > remaining) return nullptr;
+                            it += head.arg;
+                            break;
+                        case 4: case 5:
+                            if (head.indefinite) {
+                                open.push_back({ 0, head.major, true });
+                            } else {
+                                // every item takes at least one byte
+                                if (head.arg > (head.major == 5 ? remaining / 2 : remaining)) return nullptr;
+                                if (head.arg == 0) break;
+                                open.push_back({ head.major == 5 ? head.arg * 2 : head.arg, head.major, false });
+                            }
+                            if (open.size() > max_depth) return nullptr;
+                            continue;
+                        case 6:
+                            if (!cbor_plain_tag(head.arg)) return nullptr;
+                            tagged = true;
+                            continue;
+                        default:
+                            if (head.info < 20 || head.info == 24 || head.info >= 28) return nullptr;
+                            break;
+                    }
+                }
+                // an item is complete, which may complete its definite-length parents
+                while (!open.empty()) {
+                    auto& parent = open.back();
+                    if (parent.indefinite) {
+                        ++parent.count;
+                        break;
+                    }
+                    if (--parent.count) break;
+                    open.pop_back();
+                }
+            } while (!open.empty() || tagged);
+        } catch (...) {
+            return nullptr;
+        }
+        return it;
+    }
+
+    /**
+     * @brief First 8 bytes of a snapshot file, see `Json::write_snapshot`.
+     * @note Non-export.
+     */
+    inline constexpr std::array<char, 8> snapshot_magic{ 'M', 'J', 'S', 'N', 'A', 'P', '0', '1' };
+
+    /**
+     * @brief Second word of a snapshot, reads differently on a platform of the other byte order.
+     * @note Non-export.
+     */
+    inline constexpr std::uint64_t snapshot_order = 0x0102030405060708;
+
+    /**
+     * @brief A key with its hash computed in advance, looked up in maps hashed by `SeededHash`.
+     * @note Non-export.
+     */
+    struct hashed_key {
+        std::string_view key;
+        std::size_t hash;
+
+        [[nodiscard]]
+        friend bool operator==(const hashed_key& a, const std::string_view b) noexcept { return a.key == b; }
+    };
+
+    /**
+     * @brief Forwards to a sink without its `append_ref`, so that every byte is copied.
+     * @note Non-export.
+     */
+    template<typename S>
+    struct copying_sink {
+        S* out;
+        void push_back(const char c) { out->push_back(c); }
+        void append(const char* data, const std::size_t len) { out->append(data, len); }
+    };
+
+#ifdef M_MYSVAC_JSON_HAS_POSIX_IO
+    /**
+     * @brief Handle a failed write on `fd`, waiting until it is writable again if it is non-blocking.
+     * @return `true` if the write should be retried.
+     * @note Non-export.
+     */
+    inline bool retry_write(const int fd) noexcept {
+        if (errno == EINTR) return true;
+        if (errno != EAGAIN && errno != EWOULDBLOCK) return false;
+        ::pollfd item{ fd, POLLOUT, 0 };
+        while (::poll(&item, 1, -1) < 0) {
+            if (errno != EINTR) return false;
+        }
+        return true;
+    }
+#endif
 }
 
 /**
@@ -182,1554 +951,8353 @@ export namespace mysvac::json {
     };
 
     /**
-     * @brief Enum class representing the type of JSON data.
+     * @brief Concept to check if a type can receive serialized JSON text.
+     * @tparam S The sink type to check.
+     * @note `std::basic_string` satisfies it, and serves as the growable buffer sink.
      */
-    enum class Type{
-        eNul = 0,  ///< Nul type
-        eBol,      ///< boolean type
-        eNum,    ///< Num type
-        eStr,    ///< Str type
-        eArr,     ///< Arr type
-        eObj     ///< Obj type
+    template<typename S>
+    concept output_sink = requires (S& sink, const char c, const char* data, const std::size_t len) {
+        sink.push_back(c);
+        sink.append(data, len);
     };
 
-
     /**
-     * @brief Get the name of the JSON data type.
-     * @return The name of the JSON data type as a string.
+     * @brief Sink writing to a caller-provided fixed buffer.
+     * @note When the buffer is full, later output is discarded and `overflow()` becomes true,
+     * the buffer then holds a prefix of the output.
      */
-    [[nodiscard]]
-    constexpr const char* type_name(const Type type) noexcept {
-        switch ( type ) {
-            case Type::eObj: return "Obj";
-            case Type::eArr:  return "Arr";
-            case Type::eStr: return "Str";
-            case Type::eNum: return "Num";
-            case Type::eBol:   return "Bol";
-            case Type::eNul:   return "Nul";
-            default: return "Unknown Enum Value"; // should never happen
-        }
-    }
+    class FixedBufferSink {
+        char* m_data;
+        std::size_t m_capacity;
+        std::size_t m_size{ 0 };
+        std::size_t m_required{ 0 };
 
-    /**
-     * @brief A JSON container class that can represent various JSON data types.
-     * @tparam UseOrderedMap  Use `std::map` for JSON objects if true, otherwise use `std::unordered_map`.
-     * @tparam VecAllocator A allocator template for the vector containers, default is `std::allocator`.
-     * @tparam MapAllocator A allocator template for the map/unordered_map containers, default is `std::allocator`.
-     * @tparam StrAllocator A allocator template for the string containers, default is `std::allocator`.
-     * @note Str is always `std::basic_string< ... >`。
-     */
-    template<
-        bool UseOrderedMap = true,
-        template<typename U> class VecAllocator = std::allocator,
-        template<typename U> class MapAllocator = std::allocator,
-        template<typename U> class StrAllocator = std::allocator
-    >
-    requires requires{
-        typename std::basic_string<char, std::char_traits<char>, StrAllocator<char>>;
-        typename std::vector<int, VecAllocator<int>>;
-        typename std::map<std::string, int, std::less<std::string>, MapAllocator<std::pair<const std::string, int>>>;
-        typename std::unordered_map<std::string, int, std::hash<std::string>, std::equal_to<std::string>, MapAllocator<std::pair<const std::string, int>>>;
-    }
-    class Json {
     public:
+        FixedBufferSink(char* data, const std::size_t capacity) noexcept
+            : m_data(data), m_capacity(capacity) {}
+        explicit FixedBufferSink(const std::span<char> buffer) noexcept
+            : m_data(buffer.data()), m_capacity(buffer.size()) {}
+
+        void push_back(const char c) noexcept {
+            if (m_size < m_capacity) m_data[m_size++] = c;
+            ++m_required;
+        }
+
+        void append(const char* data, const std::size_t len) noexcept {
+            const std::size_t count = std::min(len, m_capacity - m_size);
+            std::copy_n(data, count, m_data + m_size);
+            m_size += count;
+            m_required += len;
+        }
+
         /**
-         * @brief Json's Nul Type, must be `std::nullptr_t`.
-         */
-        using Nul = std::nullptr_t;
-        /**
-         * @brief Json's Bol Type, must be `bool`.
-         */
-        using Bol = bool;
-        /**
-         * @brief Json's Num Type, must be `double`.
-         * @note When converted to integers, it will be rounded to the nearest integer.
+         * @brief Check if the output did not fit in the buffer.
          */
-        using Num = double;
+        [[nodiscard]]
+        bool overflow() const noexcept { return m_required > m_capacity; }
+
         /**
-         * @brief Json's Str Type, `std::basic_string<char, std::char_traits<char>, StrAllocator<char>>`.
-         * @note default is `std::string`.
+         * @brief Number of bytes written to the buffer.
          */
-        using Str = std::basic_string<char, std::char_traits<char>, StrAllocator<char>>;
+        [[nodiscard]]
+        std::size_t size() const noexcept { return m_size; }
+
         /**
-         * @brief Json's Arr Type, `vector<Json, VecAllocator<Json>>`.
-         * @note default is `std::vector<Json>`.
+         * @brief Number of bytes the whole output needs, also valid after overflow.
          */
-        using Arr = std::vector<Json, VecAllocator<Json>>;
+        [[nodiscard]]
+        std::size_t required_size() const noexcept { return m_required; }
+
         /**
-         * @brief Json's Obj Type, `std::map` or `std::unordered_map`.
-         * @note default is `std::map<std::string, Json>`.
+         * @brief View of the written bytes, only meaningful if `!overflow()`.
          */
-        using Obj = std::conditional_t<UseOrderedMap,
-            std::map<Str, Json, std::less<Str>, MapAllocator<std::pair<const Str, Json>>>,
-            std::unordered_map<Str, Json, std::hash<Str>, std::equal_to<Str>, MapAllocator<std::pair<const Str, Json>>>
-        >;
+        [[nodiscard]]
+        std::string_view view() const noexcept { return { m_data, m_size }; }
+    };
 
-    protected:
-        std::variant<
-            Nul,
-            Bol,
-            Num,
-            Str,
-            Arr,
-            Obj
-        > m_data { Nul{} };
+    /**
+     * @brief Sink passing output in chunks to a callback, `callback(std::string_view)`.
+     * @tparam F The callback type, the return value is ignored.
+     * @note Remaining bytes are passed by `flush()` or the destructor.
+     * The destructor swallows exceptions of the callback, call `flush()` to see them.
+     */
+    template<typename F>
+    requires std::invocable<F&, std::string_view>
+    class ChunkSink : public buffered_sink<ChunkSink<F>> {
+        friend class buffered_sink<ChunkSink>;
+        F m_callback;
+
+        bool emit(const char* data, const std::size_t len) {
+            std::invoke(m_callback, std::string_view{ data, len });
+            return true;
+        }
+
+    public:
+        explicit ChunkSink(F callback, const std::size_t chunk_size = 64 * 1024)
+            : buffered_sink<ChunkSink>(chunk_size), m_callback(std::move(callback)) {}
+        ~ChunkSink() { this->finish(); }
+    };
+
+    /**
+     * @brief Sink writing to a `std::ostream` through an internal buffer.
+     * @note Output stops once the stream fails.
+     */
+    class StreamSink : public buffered_sink<StreamSink> {
+        friend class buffered_sink<StreamSink>;
+        std::ostream* m_stream;
+
+        bool emit(const char* data, const std::size_t len) {
+            if (m_stream->fail()) return false;
+            m_stream->write(data, static_cast<std::streamsize>(len));
+            return !m_stream->fail();
+        }
+
+    public:
+        explicit StreamSink(std::ostream& stream, const std::size_t buffer_size = 8 * 1024)
+            : buffered_sink(buffer_size), m_stream(&stream) {}
+        ~StreamSink() { this->finish(); }
+    };
+
+#ifdef M_MYSVAC_JSON_HAS_POSIX_IO
+    /**
+     * @brief Sink writing to a POSIX file descriptor through an internal 64 KiB buffer.
+     * @note The descriptor is not owned. Check `flush()` or `failed()` for write errors.
+     */
+    class FdSink : public buffered_sink<FdSink> {
+        friend class buffered_sink<FdSink>;
+        int m_fd;
+
+        bool emit(const char* data, std::size_t len) const noexcept {
+            while (len != 0) {
+                const auto n = ::write(m_fd, data, len);
+                if (n < 0) {
+                    if (retry_write(m_fd)) continue;
+                    return false;
+                }
+                data += n;
+                len -= static_cast<std::size_t>(n);
+            }
+            return true;
+        }
+
+    public:
+        explicit FdSink(const int fd, const std::size_t buffer_size = 64 * 1024)
+            : buffered_sink(buffer_size), m_fd(fd) {}
+        ~FdSink() { this->finish(); }
+    };
+
+    /**
+     * @brief Sink writing to a POSIX file descriptor with `writev`, long strings are referenced in place.
+     * @note
+     * Structural and escaped pieces are copied into a scratch arena. Escape-free strings of at least
+     * `ref_threshold` bytes that belong to the value being written are referenced without copy,
+     * strings given to `JsonWriter` are always copied. Pending pieces are written in batches,
+     * so the written value must stay alive and unchanged until `flush()` or the destructor.
+     * The descriptor is not owned.
+     */
+    class WritevSink {
+        static constexpr std::size_t block_size = 64 * 1024;
+        static constexpr std::size_t max_blocks = 16;
+        // pieces per `writev` call, at most IOV_MAX
+#ifdef IOV_MAX
+        static constexpr std::size_t max_iov = IOV_MAX < 1024 ? IOV_MAX : 1024;
+#else
+        static constexpr std::size_t max_iov = 16;
+#endif
+
+        int m_fd;
+        std::size_t m_ref_threshold;
+        std::vector<std::unique_ptr<char[]>> m_blocks;
+        std::vector<std::unique_ptr<char[]>> m_large;
+        std::vector<::iovec> m_iov;
+        std::size_t m_block{ 0 };
+        std::size_t m_used{ 0 };
+        bool m_failed{ false };
+
+        void add_iov(const char* data, const std::size_t len) {
+            if (!m_iov.empty()) {
+                auto& last = m_iov.back();
+                if (static_cast<const char*>(last.iov_base) + last.iov_len == data) {
+                    last.iov_len += len;
+                    return;
+                }
+            }
+            m_iov.push_back({ const_cast<char*>(data), len });
+        }
 
-    private:
         /**
-         * @brief Escape a string to a string back.
-         * @param out The output string to append the escaped string to.
-         * @param str The string to escape.
-         */
-        static void escape_to(Str& out, const std::string_view str) noexcept {
-            out.push_back('\"');
-            for (const char c : str) {
-                switch (c) {
-                    case '\\': out.append(R"(\\)"); break;
-                    case '\"': out.append(R"(\")"); break;
-                    case '\r': out.append(R"(\r)"); break;
-                    case '\n': out.append(R"(\n)"); break;
-                    // case '\f': out.append(R"(\f)"); break; // do not support `\f` for better performance
-                    case '\t': out.append(R"(\t)"); break;
-                    // case '\b': out.append(R"(\b)"); break; // do not support `\b` for better performance
-                    default: {
-                        if (static_cast<unsigned char>(c) < 0x20) {
-                            out.append(R"(\u00)");
-                            out.push_back(hex_digits[c >> 4]);
-                            out.push_back(hex_digits[c & 0x0F]);
-                        } else out.push_back(c);
-                    } break;
+         * @brief Make room for one more piece, before scratch memory is taken.
+         */
+        void reserve_iov() {
+            if (m_iov.size() == max_iov) flush();
+        }
+
+        char* scratch(const std::size_t len) {
+            if (len > block_size) return m_large.emplace_back(std::make_unique_for_overwrite<char[]>(len)).get();
+            if (m_blocks.empty() || block_size - m_used < len) {
+                if (!m_blocks.empty() && m_block + 1 == max_blocks) flush();
+                else if (!m_blocks.empty()) {
+                    ++m_block;
+                    m_used = 0;
                 }
+                if (m_block == m_blocks.size()) m_blocks.emplace_back(std::make_unique_for_overwrite<char[]>(block_size));
             }
-            out.push_back('"');
+            char* ptr = m_blocks[m_block].get() + m_used;
+            m_used += len;
+            return ptr;
+        }
+
+    public:
+        explicit WritevSink(const int fd, const std::size_t ref_threshold = 256)
+            : m_fd(fd), m_ref_threshold(ref_threshold) {
+            m_iov.reserve(max_iov);
+        }
+        WritevSink(const WritevSink&) = delete;
+        WritevSink& operator=(const WritevSink&) = delete;
+        ~WritevSink() { flush(); }
+
+        void push_back(const char c) {
+            if (m_failed) return;
+            reserve_iov();
+            char* ptr = scratch(1);
+            *ptr = c;
+            add_iov(ptr, 1);
+        }
+
+        void append(const char* data, const std::size_t len) {
+            if (m_failed || len == 0) return;
+            reserve_iov();
+            char* ptr = scratch(len);
+            std::copy_n(data, len, ptr);
+            add_iov(ptr, len);
         }
 
         /**
-         * @brief Escape a string to an out-stream.
-         * @param out The output stream to append the escaped string to.
-         * @param str The string to escape.
+         * @brief Reference bytes without copy, short pieces are copied anyway.
          */
-        static void escape_to(std::ostream& out, const std::string_view str) {
-            out.put('\"');
-            for (const char c : str) {
-                switch (c) {
-                    case '\\': out << R"(\\)"; break;
-                    case '\"': out << R"(\")"; break;
-                    case '\r': out << R"(\r)"; break;
-                    case '\n': out << R"(\n)"; break;
-                    // case '\f': out << R"(\f)"; break; // do not support `\f` for better performance
-                    case '\t': out << R"(\t)"; break;
-                    // case '\b': out << R"(\b)"; break; // do not support `\b` for better performance
-                    default: {
-                        if (static_cast<unsigned char>(c) < 0x20) {
-                            out << R"(\u00)";
-                            out.put(hex_digits[c >> 4]);
-                            out.put(hex_digits[c & 0x0F]);
-                        } else out.put(c);
-                    } break;
+        void append_ref(const char* data, const std::size_t len) {
+            if (len < m_ref_threshold) return append(data, len);
+            if (m_failed) return;
+            reserve_iov();
+            add_iov(data, len);
+        }
+
+        /**
+         * @brief Write all pending pieces and reset the scratch arena.
+         * @return `false` if writing has failed at any point.
+         */
+        bool flush() noexcept {
+            for (std::size_t i = 0; i < m_iov.size() && !m_failed;) {
+                const auto count = static_cast<int>(std::min(m_iov.size() - i, max_iov));
+                const auto n = ::writev(m_fd, m_iov.data() + i, count);
+                if (n < 0) {
+                    if (!retry_write(m_fd)) m_failed = true;
+                    continue;
+                }
+                // skip written pieces, adjust a partially written one
+                for (auto written = static_cast<std::size_t>(n); i < m_iov.size(); ++i) {
+                    if (written < m_iov[i].iov_len) {
+                        m_iov[i].iov_base = static_cast<char*>(m_iov[i].iov_base) + written;
+                        m_iov[i].iov_len -= written;
+                        break;
+                    }
+                    written -= m_iov[i].iov_len;
                 }
             }
-            out.put('\"');
+            m_iov.clear();
+            m_large.clear();
+            m_block = 0;
+            m_used = 0;
+            return !m_failed;
         }
 
         /**
-         * @brief Unescape a Unicode escape sequence in a string, and move ptr.
-         * @param out The output string to append the unescaped Unicode character to.
-         * @param it The iterator pointing to the current position in the string.
-         * @param end_ptr The end iterator of the string.
-         * @return `true` if the unescape was successful, `false` if it failed.
+         * @brief Check if writing has failed, later output is discarded.
          */
-        static bool unescape_unicode_next(
-            Str& out,
-            char_iterator auto& it,
-            const char_iterator auto end_ptr
-        ) noexcept {
-            // it was in `\uABCD`'s `u` position
-            ++it;
-            if (it == end_ptr) return false;
-            // `it` was in `\uXXXX`'s A position
+        [[nodiscard]]
+        bool failed() const noexcept { return m_failed; }
+    };
+#endif
 
-            // move to \uABCD's D position and get hex4 value
-            std::uint32_t code_point{ 0 };
-            {
-                const std::uint8_t d1 = hex_table[static_cast<unsigned char>(*it)];
-                if (d1 == 255) return false; // Invalid if not a hex digit
-                code_point = code_point << 4 | d1;
+    /**
+     * @brief Streaming writer, emits compact JSON text to a sink without building a `Json` tree.
+     * @tparam S The sink type.
+     * @note Nesting is validated if `NDEBUG` is not defined, misuse throws `std::logic_error`.
+     * A key or an end outside any container throws in every build.
+     * @details
+     * writer.begin_object().key("id").value(1).key("tags").begin_array().value("a").end_array().end_object();
+     */
+    template<output_sink S>
+    class JsonWriter {
+        struct Frame {
+            bool is_object;
+            bool has_elem;
+        };
 
-                ++it; // External `++it` may reduce some instructions
-                if(it == end_ptr) return false; // Invalid if not enough characters
-                const std::uint8_t d2 = hex_table[static_cast<unsigned char>(*it)];
-                if (d2 == 255) return false; // Invalid if not a hex digit
-                code_point = code_point << 4 | d2;
+        S* m_out;
+        std::vector<Frame> m_stack;
+        bool m_after_key{ false };
+        bool m_done{ false };
 
-                ++it;
-                if(it == end_ptr) return false; // Invalid if not enough characters
-                const std::uint8_t d3 = hex_table[static_cast<unsigned char>(*it)];
-                if (d3 == 255) return false; // Invalid if not a hex digit
-                code_point = code_point << 4 | d3;
+        static void check([[maybe_unused]] const bool condition, [[maybe_unused]] const char* message) {
+#ifndef NDEBUG
+            if (!condition) throw std::logic_error(message);
+#endif
+        }
 
-                ++it;
-                if(it == end_ptr) return false; // Invalid if not enough characters
-                const std::uint8_t d4 = hex_table[static_cast<unsigned char>(*it)];
-                if (d4 == 255) return false; // Invalid if not a hex digit
-                code_point = code_point << 4 | d4;
+        void before_value() {
+            if (m_stack.empty()) {
+                check(!m_done, "JsonWriter: more than one top-level value.");
+                m_done = true;
+                return;
             }
-            // `it` was in `\uABCD`'s D position and not be `end_ptr`, if hex4_next successful
+            auto& frame = m_stack.back();
+            if (frame.is_object) {
+                check(m_after_key, "JsonWriter: object member without key.");
+                m_after_key = false;
+                return;
+            }
+            if (frame.has_elem) m_out->push_back(',');
+            frame.has_elem = true;
+        }
 
-            // [0xD800 , 0xE000) is agent pair, which is two consecutive \u encoding
-            if (code_point >= 0xD800 && code_point <= 0xDFFF) {
-                // agent pair, must be high agent + low agent
-                // high agent [\uD800, \uDBFF]
-                // low agent [\uDC00, \uDFFF]
+        void begin(const bool is_object, const char bracket) {
+            before_value();
+            m_out->push_back(bracket);
+            m_stack.push_back({ is_object, false });
+        }
 
-                // first char must be high agent
-                if (code_point >= 0xDC00) return false;
+        void end(const bool is_object, const char bracket) {
+            if (m_stack.empty()) throw std::logic_error("JsonWriter: end outside container.");
+            check(m_stack.back().is_object == is_object, "JsonWriter: mismatched end of container.");
+            check(!m_after_key, "JsonWriter: key without value.");
+            m_stack.pop_back();
+            m_out->push_back(bracket);
+        }
 
-                // second char must be low agent
-                ++it;
-                if(it == end_ptr || *it != '\\') return false;
-                ++it;
-                if(it == end_ptr || *it != 'u') return false;
-                ++it;
-                if(it == end_ptr) return false;
-                // `it` was in `\uXXXX`'s A position, and be not end_ptr
+    public:
+        explicit JsonWriter(S& out) : m_out(&out) {}
 
-                // move to \uABCD's D position and get hex4 value
-                std::uint32_t low_code_point{ 0 };
-                {
-                    const std::uint8_t d1 = hex_table[static_cast<unsigned char>(*it)];
-                    if (d1 == 255) return false; // Invalid if not a hex digit
-                    low_code_point = low_code_point << 4 | d1;
+        JsonWriter& begin_object() { begin(true, '{'); return *this; }
+        JsonWriter& end_object() { end(true, '}'); return *this; }
+        JsonWriter& begin_array() { begin(false, '['); return *this; }
+        JsonWriter& end_array() { end(false, ']'); return *this; }
 
-                    ++it; // External `++it` may reduce some instructions
-                    if(it == end_ptr) return false; // Invalid if not enough characters
-                    const std::uint8_t d2 = hex_table[static_cast<unsigned char>(*it)];
-                    if (d2 == 255) return false; // Invalid if not a hex digit
-                    low_code_point = low_code_point << 4 | d2;
+        /**
+         * @brief Write the key of the next object member.
+         */
+        JsonWriter& key(const std::string_view name) {
+            if (m_stack.empty()) throw std::logic_error("JsonWriter: key outside object.");
+            check(m_stack.back().is_object && !m_after_key, "JsonWriter: key outside object.");
+            auto& frame = m_stack.back();
+            if (frame.has_elem) m_out->push_back(',');
+            frame.has_elem = true;
+            escape_to(*m_out, name);
+            m_out->push_back(':');
+            m_after_key = true;
+            return *this;
+        }
 
-                    ++it;
-                    if(it == end_ptr) return false; // Invalid if not enough characters
-                    const std::uint8_t d3 = hex_table[static_cast<unsigned char>(*it)];
-                    if (d3 == 255) return false; // Invalid if not a hex digit
-                    low_code_point = low_code_point << 4 | d3;
+        JsonWriter& value(std::nullptr_t) {
+            before_value();
+            m_out->append("null", 4);
+            return *this;
+        }
 
-                    ++it;
-                    if(it == end_ptr) return false; // Invalid if not enough characters
-                    const std::uint8_t d4 = hex_table[static_cast<unsigned char>(*it)];
-                    if (d4 == 255) return false; // Invalid if not a hex digit
-                    low_code_point = low_code_point << 4 | d4;
-                }
-                if( 0xDFFF < low_code_point ||  low_code_point < 0xDC00 ) return false;
-                // `it` was in `\uABCD`'s D position and not be `end_ptr`, if hex4_next successful
+        JsonWriter& value(const bool boolean) {
+            before_value();
+            if (boolean) m_out->append("true", 4);
+            else m_out->append("false", 5);
+            return *this;
+        }
 
-                // combine the agent pair into a single code point
-                code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low_code_point - 0xDC00);
+        /**
+         * @brief Write a number, integers are written exactly.
+         */
+        template<typename T>
+        requires std::is_arithmetic_v<T> && (!std::is_same_v<T, bool>)
+        JsonWriter& value(const T number) {
+            before_value();
+            if constexpr (std::is_integral_v<T>) {
+                char buffer[24];
+                const auto [ptr, ec] = std::to_chars(buffer, buffer + 24, number);
+                m_out->append(buffer, static_cast<std::size_t>(ptr - buffer));
+            } else {
+                number_to(*m_out, static_cast<double>(number));
             }
+            return *this;
+        }
 
-            // encode the code point to UTF-8
-            if (code_point <= 0x7F) {
-                out.push_back(static_cast<char>(code_point));
-            } else if (code_point <= 0x7FF) {
-                out.push_back(static_cast<char>(code_point >> 6 | 0xC0));
-                out.push_back(static_cast<char>(code_point & 0x3F | 0x80));
-            } else if (code_point <= 0xFFFF) {
-                out.push_back(static_cast<char>(code_point >> 12 | 0xE0));
-                out.push_back(static_cast<char>(code_point >> 6 & 0x3F | 0x80));
-                out.push_back(static_cast<char>(code_point & 0x3F | 0x80));
-            } else if (code_point <= 0x10FFFF) {
-                out.push_back(static_cast<char>(code_point >> 18 | 0xF0));
-                out.push_back(static_cast<char>(code_point >> 12 & 0x3F | 0x80));
-                out.push_back(static_cast<char>(code_point >> 6 & 0x3F | 0x80));
-                out.push_back(static_cast<char>(code_point & 0x3F | 0x80));
-            } else return false;
-            return true;
+        JsonWriter& value(const std::string_view str) {
+            before_value();
+            escape_to(*m_out, str);
+            return *this;
         }
 
+        JsonWriter& value(const char* str) { return value(std::string_view{ str }); }
+
         /**
-         * @brief Unescape the string in a JSON string, and move ptr.
-         * @param it The iterator pointing to the current position in the string.
-         * @param end_ptr The end iterator of the string.
-         * @return An expected Str containing the unescaped string, or a ParseError if an error occurred.
+         * @brief Embed an existing Json value.
+         * @note Its strings are copied even if the sink could reference them, `json` may be a temporary.
          */
-        static std::optional<Str> unescape_next(
-            char_iterator auto& it,
-            const char_iterator auto end_ptr
-        ) noexcept {
-            Str res;
-            ++it;
-            if (it != end_ptr && *it != '\"')  res.reserve( 128 );
-
-            while (it != end_ptr && *it != '\"') {
-                if (*it == '\\') {
-                    ++it;
-                    if (it == end_ptr) return std::nullopt;
-                    switch (*it) {
-                        case '\"': res.push_back('\"'); break;
-                        case '\\': res.push_back('\\'); break;
-                        case 'n':  res.push_back('\n'); break;
-                        case 'r':  res.push_back('\r'); break;
-                        case 't':  res.push_back('\t'); break;
-                        case 'f':  res.push_back('\f'); break;
-                        case 'b':  res.push_back('\b'); break;
-                        case 'u': case 'U': if (!unescape_unicode_next(res, it, end_ptr)) return std::nullopt; break;
-                        default: return std::nullopt;
-                    }
-                // } else if ( *it == '\b' || *it == '\n' || *it == '\f' || *it == '\r' /* || *it == '\t' */) {
-                //     return std::nullopt;
-                } else res.push_back( *it );
-                ++it;
+        template<typename J>
+        requires requires (const J& json, S& out) { json.write(out); }
+        JsonWriter& value(const J& json) {
+            before_value();
+            if constexpr (requires (const char* data) { m_out->append_ref(data, 0); }) {
+                copying_sink<S> sink{ m_out };
+                json.write(sink);
+            } else {
+                json.write(*m_out);
             }
-            if(it == end_ptr) return std::nullopt;
-            ++it;
-            res.shrink_to_fit();
-            return res;
+            return *this;
         }
 
         /**
-         * @brief Read a JSON value from the input iterator and create Json Obj.
-         * @param it The iterator pointing to the current position in the input.
-         * @param end_ptr The end iterator of the input.
-         * @param max_depth The maximum depth of nested JSON objects/arrays allowed.
-         * @return An expected Json object containing the parsed JSON value, or a ParseError if an error occurred.
+         * @brief Check if a complete top-level value has been written.
          */
-        static std::optional<Json> reader(
-            char_iterator auto& it,
-            const char_iterator auto end_ptr,
-            const std::int32_t max_depth
-        ) noexcept {
-            // Check for maximum depth
-            if(max_depth < 0) return std::nullopt;
-            // return value
-            Json json;
-            // Check the first character to determine the type
-            switch (*it) {
-                case '{': {
-                    // Obj type
-                    ++it;
-                    json = Obj{};
-                    auto& object = json.obj();
-                    // Parse the object
-                    while(it != end_ptr){
-                        // Skip spaces
-                        while (it != end_ptr && std::isspace(*it)) ++it;
-                        if(it == end_ptr || *it == '}') break;
-                        // find key
-                        if (*it != '\"') return std::nullopt;
-                        auto key = unescape_next(it, end_ptr);
-                        if(!key) return std::nullopt;
-                        // find ':'
-                        while (it != end_ptr && std::isspace(*it)) ++it;
-                        if(it == end_ptr || *it != ':') return std::nullopt;
-                        ++it;
-                        // find value
-                        while (it != end_ptr && std::isspace(*it)) ++it;
-                        if (it == end_ptr) break;
-                        auto value = reader(it, end_ptr, max_depth - 1);
-                        if(!value) return value;
-                        // add to object
-                        object.emplace(std::move(*key), std::move(*value));
+        [[nodiscard]]
+        bool done() const noexcept { return m_done && m_stack.empty(); }
 
-                        while(it != end_ptr && std::isspace(*it)) ++it;
-                        if(it == end_ptr) break;
-                        if(*it == ',') ++it;
-                        else if(*it != '}') return std::nullopt;
-                    }
-                    if(it == end_ptr) return std::nullopt;
-                    ++it;
-                } break;
-                case '[': {
-                    // Arr type
-                    ++it;
-                    json = Arr{};
-                    auto& array = json.arr();
-                    if (it != end_ptr && *it != ']') array.reserve(8);
-                    while(it != end_ptr){
-                        // Skip spaces
-                        while (it != end_ptr && std::isspace(*it)) ++it;
-                        if(it == end_ptr || *it == ']') break;
-                        // find value
-                        auto value = reader(it, end_ptr, max_depth - 1);
-                        if(!value) return value;
-                        // add to array
-                        array.emplace_back(std::move(*value));
+        /**
+         * @brief Get the underlying sink.
+         */
+        [[nodiscard]]
+        S& sink() const noexcept { return *m_out; }
+    };
 
-                        while(it != end_ptr && std::isspace(*it)) ++it;
-                        if(it == end_ptr) break;
-                        if(*it == ',') ++it;
-                        else if(*it != ']') return std::nullopt;
-                    }
-                    if(it == end_ptr) return std::nullopt;
-                    ++it;
-                    array.shrink_to_fit();
-                } break;
-                case '\"': {
-                    // Str type
-                    auto str = unescape_next(it, end_ptr);
-                    if(!str) return std::nullopt;
-                    json = std::move(*str);
-                } break;
-                case 't': {
-                    // true
-                    if (++it == end_ptr || *it != 'r' ||
-                        ++it == end_ptr || *it != 'u' ||
-                        ++it == end_ptr || *it != 'e'
-                    ) return std::nullopt;
-                    json = Bol{true};
-                    ++it;
-                } break;
-                case 'f': {
-                    // false
-                    if (++it == end_ptr || *it != 'a' ||
-                        ++it == end_ptr || *it != 'l' ||
-                        ++it == end_ptr || *it != 's' ||
-                        ++it == end_ptr || *it != 'e'
-                    ) return std::nullopt;
-                    json = Bol{false};
-                    ++it;
-                } break;
-                case 'n': {
-                    // null
-                    if (++it == end_ptr || *it != 'u' ||
-                        ++it == end_ptr || *it != 'l' ||
-                        ++it == end_ptr || *it != 'l'
-                    ) return std::nullopt;
-                    json = Nul{};
-                    ++it;
-                } break;
-                default: {
-                    // number
-                    std::uint8_t buffer_len{};
-                    char buffer[26];    // Reserve enough space for typical numbers
-                    // std::array<char, 26> buffer;
+    /**
+     * @brief Get the memory resource used by default-constructed ResourceAllocator on this thread.
+     * @return The resource of the innermost MemoryScope, or `std::pmr::get_default_resource()`.
+     */
+    [[nodiscard]]
+    inline std::pmr::memory_resource* current_resource() noexcept {
+        const auto resource = scoped_resource();
+        return resource ? resource : std::pmr::get_default_resource();
+    }
 
-                    while(buffer_len < 26 && it != end_ptr &&
-                        (std::isdigit(*it)  || *it=='-' || *it=='.' || *it=='e' || *it=='E' || *it=='+')
-                    ) buffer[buffer_len++] = *it++;
-                    if( buffer_len == 0 || buffer_len == 26 ) return std::nullopt;
+    /**
+     * @brief RAII guard installing a memory resource for the current thread.
+     * @details
+     * While alive, every default-constructed ResourceAllocator, so every Str, Arr and Obj created by
+     * `parse`, the constructors, insertion and copies of a `pmr::Json`, allocates from `resource`.
+     * Scopes nest, the destructor restores the previous resource.
+     */
+    class MemoryScope {
+        std::pmr::memory_resource* m_prev;
+    public:
+        explicit MemoryScope(std::pmr::memory_resource* resource) noexcept : m_prev(scoped_resource()) {
+            scoped_resource() = resource;
+        }
+        ~MemoryScope() { scoped_resource() = m_prev; }
+        MemoryScope(const MemoryScope&) = delete;
+        MemoryScope& operator=(const MemoryScope&) = delete;
+    };
 
-                    Num value;
-                    if(const auto [ptr, ec] = std::from_chars(buffer, buffer + buffer_len, value);
-                        ec != std::errc{} || ptr != buffer + buffer_len
-                    ) return std::nullopt;
+    /**
+     * @brief Background thread destroying the values handed to it.
+     * @details
+     * Releasing a large document walks and frees every node, `retire` moves that cost off the calling thread.
+     * The destructor waits for the values already retired.
+     */
+    class Reclaimer {
+        std::mutex m_mutex;
+        std::condition_variable_any m_wake;
+        std::condition_variable m_idle;
+        std::vector<std::shared_ptr<void>> m_queue;
+        bool m_busy{ false };
+        std::jthread m_worker;
 
-                    json = value;
-                } break;
+        void run(const std::stop_token token) {
+            std::vector<std::shared_ptr<void>> batch;
+            while (true) {
+                {
+                    std::unique_lock lock{ m_mutex };
+                    m_busy = false;
+                    if (m_queue.empty()) m_idle.notify_all();
+                    m_wake.wait(lock, token, [this] { return !m_queue.empty(); });
+                    if (m_queue.empty()) return; // stop requested and nothing left
+                    batch.swap(m_queue);
+                    m_busy = true;
+                }
+                batch.clear();
             }
-            return json;
         }
-
     public:
-        /**
-         * @brief Get the type of the JSON data.
-         * @return The type of the JSON data as a Type enum value.
-         */
-        [[nodiscard]]
-        constexpr Type type() const noexcept { return static_cast<Type>(m_data.index()); }
-
-        /**
-         * @brief Check if the JSON data is of type Nul.
-         */
-        [[nodiscard]]
-        constexpr bool is_nul() const noexcept { return type() == Type::eNul; }
-
-        /**
-         * @brief Check if the JSON data is of type Bol.
-         */
-        [[nodiscard]]
-        constexpr bool is_bol() const noexcept { return type() == Type::eBol; }
-
-        /**
-         * @brief Check if the JSON data is of type Num.
-         */
-        [[nodiscard]]
-        constexpr bool is_num() const noexcept { return type() == Type::eNum; }
+        Reclaimer() : m_worker([this](const std::stop_token token) { run(token); }) {}
+        ~Reclaimer() {
+            wait_idle();
+            m_worker.request_stop();
+        }
+        Reclaimer(const Reclaimer&) = delete;
+        Reclaimer& operator=(const Reclaimer&) = delete;
 
         /**
-         * @brief Check if the JSON data is of type Str.
+         * @brief Take `value` over and destroy it on the background thread.
+         * @note Pass an rvalue, an lvalue is copied first.
          */
-        [[nodiscard]]
-        constexpr bool is_str() const noexcept { return type() == Type::eStr; }
+        template<typename T>
+        void retire(T value) {
+            auto holder = std::make_shared<T>(std::move(value));
+            {
+                std::lock_guard lock{ m_mutex };
+                m_queue.push_back(std::move(holder));
+            }
+            m_wake.notify_one();
+        }
 
         /**
-         * @brief Check if the JSON data is of type Arr.
+         * @brief Block until every retired value is destroyed.
          */
-        [[nodiscard]]
-        constexpr bool is_arr() const noexcept { return type() == Type::eArr; }
+        void wait_idle() {
+            std::unique_lock lock{ m_mutex };
+            m_idle.wait(lock, [this] { return m_queue.empty() && !m_busy; });
+        }
+    };
 
-        /**
-         * @brief Check if the JSON data is of type Obj.
-         */
-        [[nodiscard]]
-        constexpr bool is_obj() const noexcept { return type() == Type::eObj; }
+    /**
+     * @brief Allocator bound to a `std::pmr::memory_resource`, default-constructed from `current_resource()`.
+     * @tparam T The value type.
+     * @details
+     * Json default-constructs its allocators, so the resource of a new root is taken from MemoryScope.
+     * After that it propagates like `std::pmr::polymorphic_allocator`: a container keeps the resource it was
+     * constructed with, and the elements it constructs, with everything they create, allocate from it too.
+     * Copy-constructed containers take the current resource, move-constructed ones keep the source resource.
+     */
+    template<typename T>
+    class ResourceAllocator {
+        template<typename U> friend class ResourceAllocator;
+        std::pmr::memory_resource* m_resource;
+    public:
+        using value_type = T;
+        using propagate_on_container_copy_assignment = std::false_type;
+        using propagate_on_container_move_assignment = std::false_type;
+        using propagate_on_container_swap = std::false_type;
+        using is_always_equal = std::false_type;
 
+        ResourceAllocator() noexcept : m_resource(current_resource()) {}
+        ResourceAllocator(std::pmr::memory_resource* resource) noexcept : m_resource(resource) {}
+        template<typename U>
+        ResourceAllocator(const ResourceAllocator<U>& other) noexcept : m_resource(other.m_resource) {}
 
-        /**
-         * @brief Get a reference to the Nul type.
-         * @throw std::bad_variant_access if the JSON data is not of type Nul.
-         */
-        [[nodiscard]]
-        constexpr Nul& nul() & { return std::get<Nul>(m_data); }
-        [[nodiscard]]
-        constexpr Nul&& nul() && { return std::get<Nul>(std::move(m_data)); }
         [[nodiscard]]
-        constexpr const Nul& nul() const & { return std::get<Nul>(m_data); }
-        [[nodiscard]]
-        constexpr const Nul&& nul() const && { return std::get<Nul>(std::move(m_data)); }
+        T* allocate(const std::size_t n) {
+            return static_cast<T*>(m_resource->allocate(n * sizeof(T), alignof(T)));
+        }
+        void deallocate(T* ptr, const std::size_t n) noexcept {
+            m_resource->deallocate(ptr, n * sizeof(T), alignof(T));
+        }
 
         /**
-         * @brief Get a reference to the Bol type.
-         * @throw std::bad_variant_access if the JSON data is not of type Bol.
+         * @brief Construct an element with uses-allocator construction, the values it creates use this resource.
+         * @details Keys get this allocator directly. Json does not take allocators, so this resource is
+         * installed as the current one while it is constructed, its nested Str, Arr and Obj default-construct theirs.
          */
-        [[nodiscard]]
-        constexpr Bol& bol() & { return std::get<Bol>(m_data); }
-        [[nodiscard]]
-        constexpr Bol&& bol() && { return std::get<Bol>(std::move(m_data)); }
-        [[nodiscard]]
-        constexpr const Bol& bol() const & { return std::get<Bol>(m_data); }
-        [[nodiscard]]
-        constexpr const Bol&& bol() const && { return std::get<Bol>(std::move(m_data)); }
+        template<typename U, typename... Args>
+        void construct(U* ptr, Args&&... args) {
+            const MemoryScope scope{ m_resource };
+            std::uninitialized_construct_using_allocator(ptr, *this, std::forward<Args>(args)...);
+        }
 
         /**
-         * @brief Get a reference to the Num type.
-         * @throw std::bad_variant_access if the JSON data is not of type Num.
+         * @brief Copy-constructed containers allocate from the current resource.
          */
         [[nodiscard]]
-        constexpr Num& num() & { return std::get<Num>(m_data); }
-        [[nodiscard]]
-        constexpr Num&& num() && { return std::get<Num>(std::move(m_data)); }
-        [[nodiscard]]
-        constexpr const Num& num() const & { return std::get<Num>(m_data); }
-        [[nodiscard]]
-        constexpr const Num&& num() const && { return std::get<Num>(std::move(m_data)); }
+        ResourceAllocator select_on_container_copy_construction() const noexcept { return {}; }
 
-        /**
-         * @brief Get a reference to the Str type.
-         * @throw std::bad_variant_access if the JSON data is not of type Str.
-         */
-        [[nodiscard]]
-        constexpr Str& str() & { return std::get<Str>(m_data); }
         [[nodiscard]]
-        constexpr Str&& str() && { return std::get<Str>(std::move(m_data)); }
-        [[nodiscard]]
-        constexpr const Str& str() const & { return std::get<Str>(m_data); }
-        [[nodiscard]]
-        constexpr const Str&& str() const && { return std::get<Str>(std::move(m_data)); }
+        std::pmr::memory_resource* resource() const noexcept { return m_resource; }
 
-        /**
-         * @brief Get a reference to the Arr type.
-         * @throw std::bad_variant_access if the JSON data is not of type Arr.
-         */
-        [[nodiscard]]
-        constexpr Arr& arr() & { return std::get<Arr>(m_data); }
-        [[nodiscard]]
-        constexpr Arr&& arr() && { return std::get<Arr>(std::move(m_data)); }
-        [[nodiscard]]
-        constexpr const Arr& arr() const & { return std::get<Arr>(m_data); }
-        [[nodiscard]]
-        constexpr const Arr&& arr() const && { return std::get<Arr>(std::move(m_data)); }
+        template<typename U>
+        bool operator==(const ResourceAllocator<U>& other) const noexcept {
+            return m_resource == other.m_resource || m_resource->is_equal(*other.m_resource);
+        }
+    };
 
-        /**
-         * @brief Get a reference to the Obj type.
-         * @throw std::bad_variant_access if the JSON data is not of type Obj.
-         */
-        [[nodiscard]]
-        constexpr Obj& obj() & { return std::get<Obj>(m_data); }
-        [[nodiscard]]
-        constexpr Obj&& obj() && { return std::get<Obj>(std::move(m_data)); }
-        [[nodiscard]]
-        constexpr const Obj& obj() const & { return std::get<Obj>(m_data); }
-        [[nodiscard]]
-        constexpr const Obj&& obj() const && { return std::get<Obj>(std::move(m_data)); }
+    /**
+     * @brief Enum class representing the type of JSON data.
+     */
+    enum class Type{
+        eNul = 0,  ///< Nul type
+        eBol,      ///< boolean type
+        eNum,    ///< Num type
+        eStr,    ///< Str type
+        eArr,     ///< Arr type
+        eObj     ///< Obj type
+    };
+
+
+    /**
+     * @brief Get the name of the JSON data type.
+     * @return The name of the JSON data type as a string.
+     */
+    [[nodiscard]]
+    constexpr const char* type_name(const Type type) noexcept {
+        switch ( type ) {
+            case Type::eObj: return "Obj";
+            case Type::eArr:  return "Arr";
+            case Type::eStr: return "Str";
+            case Type::eNum: return "Num";
+            case Type::eBol:   return "Bol";
+            case Type::eNul:   return "Nul";
+            default: return "Unknown Enum Value"; // should never happen
+        }
+    }
+
+    /**
+     * @brief Enum class selecting the node representation of Json.
+     */
+    enum class Storage{
+        eVariant = 0,  ///< `std::variant` of the six types
+        eCompact,      ///< Tagged 16-byte node, scalars inline, Str/Arr/Obj out-of-line
+        eShared        ///< As eCompact, Str/Arr/Obj shared between copies and copied on write
+    };
+
+    /**
+     * @brief Enum class selecting the container used for Obj.
+     */
+    enum class MapType{
+        eStd = 0,  ///< `std::map` or `std::unordered_map`, chosen by `UseOrderedMap`
+        eFlat,     ///< FlatMap, a sorted vector of key/value pairs
+        eShape,    ///< ShapeMap, a value vector with a shared key sequence
+        eHash,     ///< HashMap, an open-addressing table with a seeded hash
+        eIndex,    ///< IndexMap, insertion-ordered pairs with a hash index
+        eBTree,    ///< BTreeMap, a B+ tree with nodes of a few cache lines
+        eAtom      ///< AtomMap, insertion-ordered pairs whose keys are interned atoms
+    };
+
+    template<typename Key, typename T, typename Compare, typename Allocator>
+    class BTreeMap;
+
+    /**
+     * @brief Map stored as one sorted vector of key/value pairs, moved to a BTreeMap once it grows large.
+     * @tparam Key The key type.
+     * @tparam T The mapped type.
+     * @tparam Compare The key comparison, transparent by default.
+     * @tparam Allocator The allocator of `std::pair<Key, T>`.
+     * @details
+     * One allocation for the whole object and contiguous lookup, linear for up to `linear_threshold` elements,
+     * binary search above. Insertion and erasure shift the following elements.
+     * An insertion beyond `tree_threshold` pairs moves them all to a BTreeMap, so building a large object
+     * costs `O(log n)` per key instead of a shift of the whole vector. The map stays a tree until cleared.
+     * Iteration is in key order, like `std::map`, `*it` is a `std::pair<const Key&, T&>` proxy.
+     * @note If allocating the tree fails, the pairs being moved are lost and the map is left empty.
+     */
+    template<
+        typename Key,
+        typename T,
+        typename Compare = std::less<>,
+        typename Allocator = std::allocator<std::pair<Key, T>>
+    >
+    class FlatMap {
+    public:
+        using key_type = Key;
+        using mapped_type = T;
+        using value_type = std::pair<Key, T>;
+        using key_compare = Compare;
+        using allocator_type = Allocator;
+        using container_type = std::vector<value_type, Allocator>;
+        using size_type = typename container_type::size_type;
+        using difference_type = typename container_type::difference_type;
 
         /**
-         * @brief Default constructor for Json, data is Nul type.
-         */
-        constexpr Json() noexcept = default;
-        /**
-         * @brief Destructor for Json, no special cleanup needed.
-         */
-        ~Json() noexcept = default;
-        /**
-         * @brief Copy constructor for Json, uses default copy semantics.
+         * @brief Objects up to this size are searched linearly.
          */
-        Json(const Json&) noexcept = default;
+        static constexpr size_type linear_threshold = 8;
         /**
-         * @brief Copy assignment operator for Json, uses default copy semantics.
+         * @brief Objects above this size are stored in a BTreeMap.
          */
-        Json& operator=(const Json&) noexcept = default;
+        static constexpr size_type tree_threshold = 64;
 
-        /**
-         * @brief Move constructor for Json, transfers ownership of data.
-         * @param other The Json object to move from, will be set to Nul.
-         */
-        Json(Json&& other) noexcept {
-            m_data = std::move(other.m_data);
-            other.m_data = Nul{};
+    private:
+        using tree_type = BTreeMap<Key, T, Compare, Allocator>;
+        using tree_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<tree_type>;
+        using tree_traits = std::allocator_traits<tree_allocator>;
+
+        container_type m_items;
+        tree_type* m_tree{ nullptr };  // holds the pairs once it exists, `m_items` is then empty
+        [[no_unique_address]] Compare m_comp;
+
+        template<typename... Args>
+        [[nodiscard]]
+        tree_type* new_tree(Args&&... args) {
+            tree_allocator alloc(m_items.get_allocator());
+            auto* const tree = tree_traits::allocate(alloc, 1);
+            try {
+                ::new (static_cast<void*>(tree)) tree_type(std::forward<Args>(args)...);
+            } catch (...) {
+                tree_traits::deallocate(alloc, tree, 1);
+                throw;
+            }
+            return tree;
         }
-        /**
-         * @brief Move assignment operator for Json, transfers ownership of data.
-         * @param other The Json object to move from, will be set to Nul.
-         */
-        Json& operator=(Json&& other) noexcept {
-            if (this == &other) return *this;
-            m_data = std::move(other.m_data);
-            other.m_data = Nul{};
-            return *this;
+
+        void free_tree() noexcept {
+            if (!m_tree) return;
+            tree_allocator alloc(m_items.get_allocator());
+            m_tree->~tree_type();
+            tree_traits::deallocate(alloc, m_tree, 1);
+            m_tree = nullptr;
         }
 
-        /**
-         * @brief Constructor for Json that accepts various types and converts them to Json.
-         * @tparam T The type of the other object to convert to Json.
-         * @param other The object to convert to Json.
-         */
-        template<typename T>
-        requires constructible<Json, std::remove_cvref_t<T>>
-        Json(T&& other) noexcept {
-            if constexpr(std::is_same_v<T, Nul>) {
-                m_data = Nul{};
-            } else if constexpr(std::is_same_v<T, Bol>) {
-                m_data = other;
-            } else if constexpr(std::is_same_v<T, Num>) {
-                m_data = other;
-            } else if constexpr(std::is_same_v<T, Str>) {
-                m_data = std::forward<T>(other);
-            } else if constexpr(std::is_same_v<T, Arr>) {
-                m_data = std::forward<T>(other);
-            } else if constexpr(std::is_same_v<T, Obj>) {
-                m_data = std::forward<T>(other);
-            } else if constexpr(std::is_arithmetic_v<T> || std::is_enum_v<T>) {
-                m_data = static_cast<Num>(other);
-            } else if constexpr(std::is_convertible_v<T, Str>) {
-                m_data = static_cast<Str>(std::forward<T>(other));
-            } else if constexpr(std::is_convertible_v<T, Obj>) {
-                m_data = static_cast<Obj>(std::forward<T>(other));
-            } else if constexpr(std::is_convertible_v<T,Arr>) {
-                m_data = static_cast<Arr>(std::forward<T>(other));
-            } else if constexpr(std::is_convertible_v<T,Num>) {
-                m_data = static_cast<Num>(std::forward<T>(other));
-            } else if constexpr(std::is_convertible_v<T,Bol>) {
-                m_data = static_cast<Bol>(std::forward<T>(other));
-            } else {
-                m_data = Nul{};
-            }
+        // hand the pairs over to a new tree, which sorts them unless they already are
+        void migrate() {
+            const auto alloc = m_items.get_allocator();
+            m_tree = new_tree(std::exchange(m_items, container_type(alloc)));
         }
 
-        /**
-         * @brief Assignment operator for Json that accepts various types and converts them to Json.
-         * @tparam T The type of the other object to convert to Json.
-         * @param other The object to convert to Json.
-         */
-        template<typename T>
-        requires constructible<Json, std::remove_cvref_t<T>>
-        Json& operator=(T&& other) noexcept {
-            if constexpr(std::is_same_v<T, Nul>) {
-                m_data = Nul{};
-            } else if constexpr(std::is_same_v<T, Bol>) {
-                m_data = other;
-            } else if constexpr(std::is_same_v<T, Num>) {
-                m_data = other;
-            } else if constexpr(std::is_same_v<T, Str>) {
-                m_data = std::forward<T>(other);
-            } else if constexpr(std::is_same_v<T, Arr>) {
-                m_data = std::forward<T>(other);
-            } else if constexpr(std::is_same_v<T, Obj>) {
-                m_data = std::forward<T>(other);
-            } else if constexpr(std::is_arithmetic_v<T> || std::is_enum_v<T>) {
-                m_data = static_cast<Num>(other);
-            } else if constexpr(std::is_convertible_v<T, Str>) {
-                m_data = static_cast<Str>(std::forward<T>(other));
-            } else if constexpr(std::is_convertible_v<T, Obj>) {
-                m_data = static_cast<Obj>(std::forward<T>(other));
-            } else if constexpr(std::is_convertible_v<T,Arr>) {
-                m_data = static_cast<Arr>(std::forward<T>(other));
-            } else if constexpr(std::is_convertible_v<T,Num>) {
-                m_data = static_cast<Num>(std::forward<T>(other));
-            } else if constexpr(std::is_convertible_v<T,Bol>) {
-                m_data = static_cast<Bol>(std::forward<T>(other));
-            } else {
-                m_data = Nul{};
+        template<typename K>
+        [[nodiscard]]
+        size_type lower_index(const K& key) const {
+            if (m_items.size() <= linear_threshold) {
+                size_type index{ 0 };
+                while (index < m_items.size() && m_comp(m_items[index].first, key)) ++index;
+                return index;
             }
-            return *this;
+            return static_cast<size_type>(std::ranges::lower_bound(
+                m_items, key, [this](const auto& a, const auto& b) { return m_comp(a, b); }, &value_type::first
+            ) - m_items.begin());
         }
 
-        /**
-         * @brief Constructor for Json that accepts array-like types and converts them to Json.
-         * @tparam T The type of the other object to convert to Json.
-         * @param other The object to convert to Json.
-         */
-        template<typename T>
-        requires !constructible<Json, std::remove_cvref_t<T>> && !constructible_map<Json, std::remove_cvref_t<T>> && constructible_array<Json, std::remove_cvref_t<T>>
-        explicit Json(T&& other) noexcept : m_data( Arr{} ) {
-            auto& arr = std::get<Arr>(m_data);
-            for (auto&& item : std::forward<T>(other)) {
-                arr.emplace_back( static_cast<Json>(static_cast<typename std::remove_cvref_t<T>::value_type>( std::forward<decltype(item)>(item))));
+        template<typename K>
+        [[nodiscard]]
+        bool match(const size_type index, const K& key) const {
+            return index < m_items.size() && !m_comp(key, m_items[index].first);
+        }
+
+        // sort by key, the first of equal keys is kept like repeated `std::map::emplace`
+        void normalize() {
+            if (m_items.size() > tree_threshold) {
+                migrate();
+                return;
             }
+            const auto less = [this](const auto& a, const auto& b) { return m_comp(a, b); };
+            if (!std::ranges::is_sorted(m_items, less, &value_type::first)) {
+                std::ranges::stable_sort(m_items, less, &value_type::first);
+            }
+            const auto dup = std::ranges::unique(m_items, [this](const auto& a, const auto& b) {
+                return !m_comp(a, b) && !m_comp(b, a);
+            }, &value_type::first);
+            m_items.erase(dup.begin(), dup.end());
         }
 
+        template<bool Const>
+        class basic_iterator {
+            friend class FlatMap;
+            template<bool> friend class basic_iterator;
+            using item_ptr = std::conditional_t<Const, const std::pair<Key, T>*, std::pair<Key, T>*>;
+            using tree_iterator = std::conditional_t<Const, typename tree_type::const_iterator, typename tree_type::iterator>;
+            item_ptr m_item{ nullptr };  // into the vector, null in a tree
+            tree_iterator m_node{};      // into the tree, its end in a vector
+
+            explicit basic_iterator(const item_ptr item) noexcept : m_item(item) {}
+            explicit basic_iterator(const tree_iterator node) noexcept : m_node(node) {}
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = std::pair<Key, T>;
+            using difference_type = std::ptrdiff_t;
+            using reference = std::pair<const Key&, std::conditional_t<Const, const T&, T&>>;
+            struct pointer {
+                reference ref;
+                const reference* operator->() const noexcept { return &ref; }
+            };
+
+            basic_iterator() = default;
+            template<bool OtherConst>
+            requires (Const && !OtherConst)
+            basic_iterator(const basic_iterator<OtherConst>& other) noexcept : m_item(other.m_item), m_node(other.m_node) {}
+
+            reference operator*() const noexcept {
+                if (m_item) return { m_item->first, m_item->second };
+                return { m_node->first, m_node->second };
+            }
+            pointer operator->() const noexcept { return { **this }; }
+            basic_iterator& operator++() noexcept {
+                if (m_item) ++m_item;
+                else ++m_node;
+                return *this;
+            }
+            basic_iterator operator++(int) noexcept { auto tmp = *this; ++*this; return tmp; }
+            bool operator==(const basic_iterator& other) const noexcept { return m_item == other.m_item && m_node == other.m_node; }
+        };
+
+    public:
+        using iterator = basic_iterator<false>;
+        using const_iterator = basic_iterator<true>;
+        using reference = typename iterator::reference;
+        using const_reference = typename const_iterator::reference;
+
+        FlatMap() = default;
+        explicit FlatMap(const Allocator& alloc) : m_items(alloc) {}
+        FlatMap(std::initializer_list<value_type> init, const Allocator& alloc = Allocator())
+            : m_items(init, alloc) { normalize(); }
+        template<std::input_iterator It>
+        FlatMap(It first, It last, const Allocator& alloc = Allocator())
+            : m_items(first, last, alloc) { normalize(); }
         /**
-         * @brief Constructor for Json that accepts map-like types and converts them to Json.
-         * @tparam T The type of the other object to convert to Json.
-         * @param other The object to convert to Json.
+         * @brief Adopt an unsorted vector, sorted once instead of one insertion per element.
          */
-        template<typename T>
-        requires !constructible<Json, std::remove_cvref_t<T>> && constructible_map<Json, std::remove_cvref_t<T>>
-        explicit Json(T&& other) noexcept : m_data( Obj{} ) {
-            auto& obj = std::get<Obj>(m_data);
-            for (auto&& [key, val] : std::forward<T>(other)) {
-                obj.emplace( static_cast<Str>(key), static_cast<Json>(static_cast<typename std::remove_cvref_t<T>::mapped_type>(std::forward<decltype(val)>(val))) );
+        explicit FlatMap(container_type items) : m_items(std::move(items)) { normalize(); }
+        FlatMap(const FlatMap& other) : m_items(other.m_items), m_comp(other.m_comp) {
+            if (other.m_tree) m_tree = new_tree(*other.m_tree);
+        }
+        FlatMap(FlatMap&& other) noexcept
+            : m_items(std::move(other.m_items)), m_tree(std::exchange(other.m_tree, nullptr)), m_comp(other.m_comp) {}
+        FlatMap(const FlatMap& other, const Allocator& alloc) : m_items(other.m_items, alloc), m_comp(other.m_comp) {
+            if (other.m_tree) m_tree = new_tree(*other.m_tree, alloc);
+        }
+        FlatMap(FlatMap&& other, const Allocator& alloc) : m_items(std::move(other.m_items), alloc), m_comp(other.m_comp) {
+            if (!other.m_tree) return;
+            if (alloc == other.get_allocator()) {
+                m_tree = std::exchange(other.m_tree, nullptr);
+            } else {
+                m_tree = new_tree(std::move(*other.m_tree), alloc);
+                other.clear();
             }
         }
+        ~FlatMap() { free_tree(); }
 
-        /**
-         * @brief Reset the JSON data to a specific type.
-         * @tparam T The type to reset the JSON data to, defaults to Nul.
-         */
-        template<typename T = Nul>
-        requires json_type<Json, T>
-        void reset() noexcept {
-            if constexpr(std::is_same_v<T, Nul>) {
-                m_data = Nul{};
-            } else if constexpr(std::is_same_v<T, Bol>) {
-                m_data = Bol{};
-            } else if constexpr(std::is_same_v<T, Num>) {
-                m_data = Num{};
-            } else if constexpr(std::is_same_v<T, Str>) {
-                m_data = Str{};
-            } else if constexpr(std::is_same_v<T, Arr>) {
-                m_data = Arr{};
-            } else if constexpr(std::is_same_v<T, Obj>) {
-                m_data = Obj{};
+        FlatMap& operator=(const FlatMap& other) {
+            if (this == &other) return *this;
+            // the tree goes first, it was allocated with the allocator the assignment may replace
+            free_tree();
+            m_items = other.m_items;
+            m_comp = other.m_comp;
+            if (other.m_tree) m_tree = new_tree(*other.m_tree, m_items.get_allocator());
+            return *this;
+        }
+        FlatMap& operator=(FlatMap&& other) noexcept(
+            std::allocator_traits<Allocator>::propagate_on_container_move_assignment::value
+            || std::allocator_traits<Allocator>::is_always_equal::value
+        ) {
+            if (this == &other) return *this;
+            free_tree();
+            m_items = std::move(other.m_items);
+            m_comp = other.m_comp;
+            if (!other.m_tree) return *this;
+            if (m_items.get_allocator() == other.get_allocator()) {
+                m_tree = std::exchange(other.m_tree, nullptr);
+            } else {
+                m_tree = new_tree(std::move(*other.m_tree), m_items.get_allocator());
+                other.clear();
             }
+            return *this;
+        }
+
+        [[nodiscard]]
+        allocator_type get_allocator() const noexcept { return m_items.get_allocator(); }
+
+        [[nodiscard]] iterator begin() noexcept { return m_tree ? iterator{ m_tree->begin() } : iterator{ m_items.data() }; }
+        [[nodiscard]] iterator end() noexcept { return m_tree ? iterator{ m_tree->end() } : iterator{ m_items.data() + m_items.size() }; }
+        [[nodiscard]] const_iterator begin() const noexcept {
+            return m_tree ? const_iterator{ std::as_const(*m_tree).begin() } : const_iterator{ m_items.data() };
+        }
+        [[nodiscard]] const_iterator end() const noexcept {
+            return m_tree ? const_iterator{ std::as_const(*m_tree).end() } : const_iterator{ m_items.data() + m_items.size() };
         }
+        [[nodiscard]] const_iterator cbegin() const noexcept { return begin(); }
+        [[nodiscard]] const_iterator cend() const noexcept { return end(); }
 
+        [[nodiscard]] size_type size() const noexcept { return m_tree ? m_tree->size() : m_items.size(); }
+        [[nodiscard]] bool empty() const noexcept { return size() == 0; }
         /**
-         * @brief Accessor for JSON data using the subscript operator.
+         * @brief Check if the pairs have been moved to a BTreeMap.
          */
+        [[nodiscard]] bool is_tree() const noexcept { return m_tree != nullptr; }
+        void reserve(const size_type count) {
+            if (!m_tree) m_items.reserve(std::min(count, tree_threshold));
+        }
+        void clear() noexcept {
+            free_tree();
+            m_items.clear();
+        }
+
+        template<typename K>
         [[nodiscard]]
-        Json& operator[](const Str& key) { return std::get<Obj>(m_data)[key]; }
+        iterator find(const K& key) {
+            if (m_tree) return iterator{ m_tree->find(key) };
+            const auto index = lower_index(key);
+            return match(index, key) ? iterator{ m_items.data() + index } : end();
+        }
+        template<typename K>
         [[nodiscard]]
-        const Json& operator[](const Str& key) const { return std::get<Obj>(m_data).at(key); }
+        const_iterator find(const K& key) const { return const_cast<FlatMap*>(this)->find(key); }
+        template<typename K>
         [[nodiscard]]
-        Json& operator[](const std::size_t index) { return std::get<Arr>(m_data)[index]; }
+        bool contains(const K& key) const {
+            if (m_tree) return m_tree->contains(key);
+            return match(lower_index(key), key);
+        }
+        template<typename K>
         [[nodiscard]]
-        const Json& operator[](const std::size_t index) const { return std::get<Arr>(m_data).at(index); }
+        size_type count(const K& key) const { return contains(key) ? 1 : 0; }
 
         /**
-         * @brief Accessor for JSON data using the at() method.
+         * @throw std::out_of_range if the key does not exist.
          */
+        template<typename K>
         [[nodiscard]]
-        Json& at(const Str& key) { return std::get<Obj>(m_data).at(key); }
-        [[nodiscard]]
-        const Json& at(const Str& key) const { return std::get<Obj>(m_data).at(key); }
-        [[nodiscard]]
-        Json& at(const std::size_t index) { return std::get<Arr>(m_data).at(index); }
+        T& at(const K& key) {
+            const auto it = find(key);
+            if (it == end()) throw std::out_of_range("FlatMap::at: key not found");
+            return it->second;
+        }
+        template<typename K>
         [[nodiscard]]
-        const Json& at(const std::size_t index) const { return std::get<Arr>(m_data).at(index); }
+        const T& at(const K& key) const { return const_cast<FlatMap*>(this)->at(key); }
 
-        /**
-         * @brief Write the JSON data to a string back.
-         */
-        void write(Str& out) const noexcept {
-            switch (type()) {
-                case Type::eObj: {
-                    out.push_back('{');
-                    for (const auto& [key, val] : std::get<Obj>(m_data)) {
-                        escape_to(out, key);
-                        out.push_back(':');
-                        val.write(out);
-                        out.push_back(',');
-                    }
-                    if (*out.rbegin() == ',') *out.rbegin() = '}';
-                    else out.push_back('}');
-                } break;
-                case Type::eArr: {
-                    out.push_back('[');
-                    for (const auto& val : std::get<Arr>(m_data)) {
-                        val.write(out);
-                        out.push_back(',');
-                    }
-                    if (*out.rbegin() == ',') *out.rbegin() = ']';
-                    else out.push_back(']');
-                } break;
-                case Type::eBol:
-                    out.append(std::get<Bol>(m_data) ? "true" : "false");
-                    break;
-                case Type::eNul:
-                    out.append("null");
-                    break;
-                case Type::eStr:
-                    escape_to(out, std::get<Str>(m_data));
-                    break;
-                case Type::eNum: {
-                    char buffer[25]; // Reserve enough space for typical numbers
-                    const auto [ptr, ec]  = std::to_chars(
-                        buffer,
-                        buffer + 25,
-                        std::get<Num>(m_data),
-                        std::chars_format::general,
-                        17
-                    );
-                    if(ec != std::errc{}) {
-                        out.append(std::format("{:.17}",std::get<Num>(m_data)));
-                    } else out.append(buffer, ptr);
-                } break;
+        template<typename K, typename... Args>
+        std::pair<iterator, bool> try_emplace(K&& key, Args&&... args) {
+            if (m_tree) {
+                const auto [it, inserted] = m_tree->try_emplace(std::forward<K>(key), std::forward<Args>(args)...);
+                return { iterator{ it }, inserted };
             }
+            const auto index = lower_index(key);
+            if (match(index, key)) return { iterator{ m_items.data() + index }, false };
+            if (m_items.size() >= tree_threshold) {
+                migrate();
+                return try_emplace(std::forward<K>(key), std::forward<Args>(args)...);
+            }
+            m_items.emplace(
+                m_items.begin() + static_cast<difference_type>(index),
+                std::piecewise_construct,
+                std::forward_as_tuple(std::forward<K>(key)),
+                std::forward_as_tuple(std::forward<Args>(args)...)
+            );
+            return { iterator{ m_items.data() + index }, true };
         }
 
-        /**
-         * @brief Write the JSON data to an output stream.
-         */
-        void write(std::ostream& out) const {
-            if(out.fail()) return;
-            switch (type()) {
-                case Type::eObj: {
-                    out.put('{');
-                    for(bool first = true;
-                        const auto& [key, val] : std::get<Obj>(m_data)
-                    ) {
-                        if(!first) out.put(',');
-                        else first = false;
-                        escape_to(out, key);
-                        out.put(':');
-                        val.write(out);
-                        if(out.fail()) return;
-                    }
-                    out.put('}');
-                } break;
-                case Type::eArr: {
-                    out.put('[');
-                    for(bool first = true;
-                        const auto& val : std::get<Arr>(m_data)
-                    ) {
-                        if(!first) out.put(',');
-                        else first = false;
-                        val.write(out);
-                        if(out.fail()) return;
-                    }
-                    out.put(']');
-                } break;
-                case Type::eBol:
-                    out << (std::get<Bol>(m_data) ? "true" : "false");
-                    break;
-                case Type::eNul:
-                    out << "null";
-                    break;
-                case Type::eStr:
-                    escape_to(out, std::get<Str>(m_data));
-                    break;
-                case Type::eNum: {
-                    char buffer[25]; // Reserve enough space for typical numbers
-                    const auto [ptr, ec]  = std::to_chars(
-                        buffer,
-                        buffer + 25,
-                        std::get<Num>(m_data),
-                        std::chars_format::general,
-                        17
-                    );
-                    if(ec != std::errc{}) {
-                        out << std::format("{:.17}", std::get<Num>(m_data));
-                    } else out.write(buffer, static_cast<std::size_t>(ptr-buffer));
-                } break;
-            }
+        template<typename... Args>
+        std::pair<iterator, bool> emplace(Args&&... args) {
+            value_type item(std::forward<Args>(args)...);
+            return try_emplace(std::move(item.first), std::move(item.second));
         }
 
-        /**
-         * @brief Dump the JSON data to a string.
-         */
-        [[nodiscard]]
-        Str dump() const noexcept {
-            Str res;
-            this->write(res);
+        std::pair<iterator, bool> insert(const value_type& item) { return try_emplace(item.first, item.second); }
+        std::pair<iterator, bool> insert(value_type&& item) { return try_emplace(std::move(item.first), std::move(item.second)); }
+
+        template<typename K, typename V>
+        std::pair<iterator, bool> insert_or_assign(K&& key, V&& value) {
+            auto res = try_emplace(std::forward<K>(key), std::forward<V>(value));
+            if (!res.second) res.first->second = std::forward<V>(value);
             return res;
         }
 
-        /**
-         * @brief Write the JSON data to a string with formatting.
-         * @param out The output string to write to.
-         * @param space_num The number of spaces to use for indentation (default is 2).
-         * @param depth The current depth of indentation (default is 0).
-         */
-        void writef(
-            Str& out,
-            const std::uint16_t space_num = 2,
-            const std::uint16_t depth = 0
-        ) const noexcept {
-            const std::uint32_t tabs  = depth * space_num + space_num;
+        T& operator[](const Key& key) { return try_emplace(key).first->second; }
+        T& operator[](Key&& key) { return try_emplace(std::move(key)).first->second; }
 
-            switch (type()) {
-                case Type::eObj: {
-                    out.push_back('{');
-                    for (const auto& [key, val] : std::get<Obj>(m_data)) {
-                        out.push_back('\n');
-                        out.append(tabs, ' ');
-                        escape_to(out, key);
-                        out.append(": ");
-                        val.writef(out, space_num, depth + 1);
-                        out.push_back(',');
-                    }
-                    if (*out.rbegin() == ',') *out.rbegin() = '\n';
-                    if(!std::get<Obj>(m_data).empty()){
-                        out.append(tabs - space_num, ' ');
-                    }
-                    out.push_back('}');
-                } break;
-                case Type::eArr: {
-                    out.push_back('[');
-                    for (const auto& val : std::get<Arr>(m_data)) {
-                        out.push_back('\n');
-                        out.append(tabs, ' ');
-                        val.writef(out, space_num, depth + 1);
-                        out.push_back(',');
-                    }
-                    if (*out.rbegin() == ',') *out.rbegin() = '\n';
-                    if(!std::get<Arr>(m_data).empty()){
-                        out.append(tabs - space_num, ' ');
-                    }
-                    out.push_back(']');
-                } break;
-                case Type::eBol:
-                    out.append(std::get<Bol>(m_data) ? "true" : "false");
-                    break;
-                case Type::eNul:
-                    out.append("null");
-                    break;
-                case Type::eStr:
-                    escape_to(out, std::get<Str>(m_data));
-                    break;
-                case Type::eNum: {
-                    char buffer[25]; // Reserve enough space for typical numbers
-                    const auto [ptr, ec]  = std::to_chars(
-                        buffer,
-                        buffer + 25,
-                        std::get<Num>(m_data),
-                        std::chars_format::general,
-                        17
-                    );
-                    if(ec != std::errc{}) {
-                        out.append(std::format("{:.17}",std::get<Num>(m_data)));
-                    } else out.append(buffer, ptr);
-                } break;
-            }
+        iterator erase(const const_iterator pos) {
+            if (m_tree) return iterator{ m_tree->erase(pos.m_node) };
+            const auto index = pos.m_item - m_items.data();
+            m_items.erase(m_items.begin() + index);
+            return iterator{ m_items.data() + index };
+        }
+        iterator erase(const iterator pos) { return erase(const_iterator(pos)); }
+        template<typename K>
+        requires (!std::is_convertible_v<const K&, const_iterator>)
+        size_type erase(const K& key) {
+            if (m_tree) return m_tree->erase(key);
+            const auto index = lower_index(key);
+            if (!match(index, key)) return 0;
+            m_items.erase(m_items.begin() + static_cast<difference_type>(index));
+            return 1;
+        }
+
+        void swap(FlatMap& other) noexcept {
+            m_items.swap(other.m_items);
+            std::swap(m_tree, other.m_tree);
+            std::swap(m_comp, other.m_comp);
         }
 
+        [[nodiscard]]
+        bool operator==(const FlatMap& other) const {
+            return size() == other.size() && std::equal(begin(), end(), other.begin(), [](const auto& a, const auto& b) {
+                return a.first == b.first && a.second == b.second;
+            });
+        }
+    };
+
+    /**
+     * @brief Map whose key sequence is a shared, immutable shape, each object only stores its values.
+     * @tparam Key The key type.
+     * @tparam T The mapped type.
+     * @tparam Allocator The allocator, rebound to `T` for the value array.
+     * @details
+     * Shapes form a transition tree: adding key `k` to an object of shape `S` moves it to the child `S + k`,
+     * created once and reused by every object that adds the same keys in the same order.
+     * So records parsed from one array end up sharing one shape, and cost a single value array each.
+     * Lookups resolve the slot in the shape, linearly for small shapes, through a sorted slot index above.
+     * Objects with more than `max_shared_keys` keys leave the tree and own a private shape.
+     * Iteration is in insertion order, `*it` is a `std::pair<const Key&, T&>` proxy.
+     * @note Shapes are shared between threads and documents, so their keys live on the global heap,
+     * with a `Key` allocator constructed from `std::pmr::new_delete_resource()` if it accepts a memory resource.
+     * Each thread keeps its last `cached_transitions` transitions, and the shapes they lead to, alive.
+     */
+    template<
+        typename Key,
+        typename T,
+        typename Allocator = std::allocator<std::pair<Key, T>>
+    >
+    class ShapeMap {
+    public:
+        using key_type = Key;
+        using mapped_type = T;
+        using value_type = std::pair<Key, T>;
+        using allocator_type = Allocator;
+        using size_type = std::size_t;
+        using difference_type = std::ptrdiff_t;
+        using container_type = std::vector<value_type, Allocator>;
+
         /**
-         * @brief Write the JSON data to an output stream with formatting.
-         * @param out The output stream to write to.
-         * @param space_num The number of spaces to use for indentation (default is 2).
-         * @param depth The current depth of indentation (default is 0).
+         * @brief Objects with more keys use a private shape.
          */
-        void writef(
-            std::ostream& out,
-            const std::uint16_t space_num = 2,
-            const std::uint16_t depth = 0
-        ) const {
-            if(out.fail()) return;
-            const std::uint32_t tabs  = depth * space_num + space_num;
+        static constexpr size_type max_shared_keys = 64;
+        /**
+         * @brief Shapes up to this size are searched linearly.
+         */
+        static constexpr size_type linear_threshold = 8;
+        /**
+         * @brief Transitions remembered per thread, taken again without locking.
+         */
+        static constexpr size_type cached_transitions = 64;
 
-            switch (type()) {
-                case Type::eObj: {
-                    out.put('{');
-                    bool first = true;
-                    for(const auto& [key, val] : std::get<Obj>(m_data)) {
-                        if(!first) out.put(',');
-                        else first = false;
-                        out.put('\n');
-                        out << std::setfill(' ') << std::setw(tabs) << "";
-                        escape_to(out, key);
-                        out.put(':');
-                        out.put(' ');
-                        val.writef(out, space_num, depth + 1);
-                        if(out.fail()) return;
-                    }
-                    if(!first) out.put('\n');
-                    if(!std::get<Obj>(m_data).empty()){
-                        out << std::setfill(' ') << std::setw(tabs - space_num) << "";
-                    }
-                    out.put('}');
-                } break;
-                case Type::eArr: {
-                    out.put('[');
-                    bool first = true;
-                    for (const auto& val : std::get<Arr>(m_data)) {
-                        if(!first) out.put(',');
-                        else first = false;
-                        out.put('\n');
-                        out << std::setfill(' ') << std::setw(tabs) << "";
-                        val.writef(out, space_num, depth + 1);
-                        if(out.fail()) return;
-                    }
-                    if(!first) out.put('\n');
-                    if(!std::get<Arr>(m_data).empty()){
-                        out << std::setfill(' ') << std::setw(tabs - space_num) << "";
+    private:
+        using values_type = std::vector<T, typename std::allocator_traits<Allocator>::template rebind_alloc<T>>;
+
+        struct Shape {
+            std::vector<Key> keys;              // slot order, i.e. insertion order
+            std::vector<std::uint32_t> order;   // slots sorted by key, empty up to linear_threshold
+            bool shared{ true };
+            std::shared_ptr<Shape> parent;      // keeps the path alive, children are only weakly referenced
+            std::mutex mutex;                   // guards transitions
+            std::map<std::string, std::weak_ptr<Shape>, std::less<>> transitions;
+            std::size_t sweep_at{ 8 };
+
+            /**
+             * @brief Copy the keys and the index of `other`, on the global heap.
+             */
+            void assign(const Shape& other) {
+                keys.reserve(other.keys.size() + 1);
+                for (const auto& key : other.keys) keys.push_back(make_key(key));
+                order = other.order;
+            }
+
+            template<typename K>
+            [[nodiscard]]
+            size_type find(const K& key) const {
+                if (order.empty()) {
+                    for (size_type i = 0; i < keys.size(); ++i) {
+                        if (keys[i] == key) return i;
                     }
-                    out.put(']');
-                } break;
-                case Type::eBol:
-                    out << (std::get<Bol>(m_data) ? "true" : "false");
-                    break;
-                case Type::eNul:
-                    out << "null";
-                    break;
-                case Type::eStr:
-                    escape_to(out, std::get<Str>(m_data));
-                    break;
-                case Type::eNum: {
-                    char buffer[25]; // Reserve enough space for typical numbers
-                    const auto [ptr, ec]  = std::to_chars(
-                        buffer,
-                        buffer + 25,
-                        std::get<Num>(m_data),
-                        std::chars_format::general,
-                        17
-                    );
-                    if(ec != std::errc{}) {
-                        out << std::format("{:.17}", std::get<Num>(m_data));
-                    } else out.write(buffer, static_cast<std::size_t>(ptr-buffer));
-                } break;
+                    return keys.size();
+                }
+                const auto it = std::ranges::lower_bound(order, key, std::less<>{}, [this](const std::uint32_t slot) -> const Key& {
+                    return keys[slot];
+                });
+                if (it != order.end() && !std::less<>{}(key, keys[*it])) return *it;
+                return keys.size();
             }
-            if(out.fail()) return;
-        }
+
+            void append(Key key) {
+                keys.push_back(std::move(key));
+                if (keys.size() <= linear_threshold) return;
+                const auto slot = static_cast<std::uint32_t>(keys.size() - 1);
+                if (order.empty()) {
+                    order.resize(keys.size());
+                    std::iota(order.begin(), order.end(), std::uint32_t{ 0 });
+                    std::ranges::sort(order, std::less<>{}, [this](const std::uint32_t s) -> const Key& { return keys[s]; });
+                } else {
+                    const auto it = std::ranges::upper_bound(order, keys.back(), std::less<>{}, [this](const std::uint32_t s) -> const Key& {
+                        return keys[s];
+                    });
+                    order.insert(it, slot);
+                }
+            }
+
+            void remove(const size_type slot) {
+                keys.erase(keys.begin() + static_cast<difference_type>(slot));
+                if (keys.size() <= linear_threshold) {
+                    order.clear();
+                    return;
+                }
+                std::erase(order, static_cast<std::uint32_t>(slot));
+                for (auto& s : order) if (s > slot) --s;
+            }
+        };
+
+        std::shared_ptr<Shape> m_shape;  // nullptr for the empty object
+        values_type m_values;
 
         /**
-         * @brief Dump the JSON data to a string with formatting.
-         * @param space_num The number of spaces to use for indentation (default is 2).
-         * @param depth The current depth of indentation (default is 0).
-         * @return A string containing the formatted JSON data.
+         * @brief Copy a key for a shape, shapes outlive any document and its memory resource.
          */
         [[nodiscard]]
-        Str dumpf(
-            const std::uint16_t space_num = 2,
-            const std::uint16_t depth = 0
-        ) const noexcept {
-            Str res;
-            this->writef(res, space_num, depth);
-            return res;
+        static Key make_key(const std::string_view key) {
+            if constexpr (std::is_constructible_v<typename Key::allocator_type, std::pmr::memory_resource*>) {
+                return Key(key.data(), key.size(), typename Key::allocator_type(std::pmr::new_delete_resource()));
+            } else {
+                return Key(key.data(), key.size());
+            }
         }
 
-        /**
-         * @brief Parse a JSON string or stream into a Json object.
-         * @param text The JSON string to parse.
-         * @param max_depth The maximum depth of nested structures allowed (default is 256).
-         * @return A Json object if parsing is successful, or an error if it fails.
-         */
         [[nodiscard]]
-        static std::optional<Json> parse(const std::string_view text, const std::int32_t max_depth = 256) noexcept  {
-            auto it = text.begin();
-            const auto end_ptr = text.end();
-            // Skip spaces
-            while(it != end_ptr && std::isspace(*it)) ++it;
-            if(it == end_ptr) return std::nullopt;
-            // Parse the JSON
-            const auto result = reader(it, end_ptr, max_depth-1);
-            if(!result) return result;
-            // check for trailing spaces
-            while(it != end_ptr && std::isspace(*it)) ++it;
-            if(it != end_ptr) return std::nullopt;
-            return result;
+        static const std::shared_ptr<Shape>& root() {
+            static const std::shared_ptr<Shape> shape = std::make_shared<Shape>();
+            return shape;
         }
+
         [[nodiscard]]
-        static std::optional<Json> parse(std::istream& is_text, const std::int32_t max_depth = 256) noexcept {
-            auto it = std::istreambuf_iterator<char>(is_text);
-            constexpr auto end_ptr = std::istreambuf_iterator<char>();
-            // Skip spaces
-            while(it != end_ptr && std::isspace(*it)) ++it;
-            if(it == end_ptr) return std::nullopt;
-            // Parse the JSON
-            const auto result = reader(it, end_ptr, max_depth-1);
-            if(!result) return result;
-            // check for trailing spaces
-            while(it != end_ptr && std::isspace(*it)) ++it;
-            if(it != end_ptr) return std::nullopt;
-            return result;
+        static std::shared_ptr<Shape> transition(const std::shared_ptr<Shape>& from, const std::string_view key) {
+            // lock-free fast path, a cached child keeps its parent alive so the pointer comparison is safe
+            thread_local std::array<std::shared_ptr<Shape>, cached_transitions> recent;
+            auto& cached = recent[(std::hash<const void*>{}(from.get()) ^ std::hash<std::string_view>{}(key)) % cached_transitions];
+            if (cached && cached->parent == from && std::string_view{ cached->keys.back() } == key) return cached;
+
+            std::lock_guard lock{ from->mutex };
+            std::shared_ptr<Shape> next;
+            if (const auto it = from->transitions.find(key); it != from->transitions.end()) next = it->second.lock();
+            if (!next) {
+                next = std::make_shared<Shape>();
+                next->assign(*from);
+                next->append(make_key(key));
+                next->parent = from;
+                // drop the transitions of shapes no object uses anymore
+                if (from->transitions.size() >= from->sweep_at) {
+                    std::erase_if(from->transitions, [](const auto& item) { return item.second.expired(); });
+                    from->sweep_at = from->transitions.size() * 2 + 8;
+                }
+                from->transitions.insert_or_assign(std::string(key), next);
+            }
+            cached = next;
+            return next;
         }
 
-        /**
-         * @brief type conversion, copy inner value to specified type
-         * @tparam T The target type to convert to
-         * @tparam D The mapped_type or value_type of the target type, used for range conversion, default is Nul for other types(useless).
-         * @param default_range_elem if T is a range type and is not json::Arr or json::Obj, must be specified for safe conversion. Else, please use default value.
-         * @return The converted value
-         * @note Num is double, so conversions to integral (and enum) types will round to nearest.
-         * @details
-         * Attempt sequence of conversions:
-         * inner value type -> target type
-         * 1. Nul -> Nul
-         * 2. Obj -> Obj
-         * 3. Arr -> Arr
-         * 4. Str -> Str
-         * 5. Bol -> Bol
-         * 6. Num -> enum types (us llround, round to nearest)
-         * 7. Num -> integral types (us llround, round to nearest)
-         * 8. Num -> floating_point types
-         * 9. Any -> T is constructible from json::Value
-         * 10. Obj -> implicit convertible types
-         * 11. Arr -> implicit convertible types
-         * 12. Str -> implicit convertible types
-         * 13. Num -> implicit convertible types
-         * 14. Bol -> implicit convertible types
-         * 15. Nul -> implicit convertible types (Nul is not convertible to bool !!!!!)
-         * 16. Obj -> Try copy to `range && Str->key_type && Value->mapped_type types && have default_range_value`
-         * 17. Arr -> Try copy to `range && Value->value_type types && have default_range_value`
-         * 18. return std::nullopt;
-         */
-        template<typename T, typename D = Nul>
-        requires convertible<Json, T> || convertible_map<Json, T, D> || convertible_array<Json, T, D>
+        // private shapes are modified in place, so copies need their own
         [[nodiscard]]
-        std::optional<T>  to_if( D default_range_elem = D{} ) const noexcept {
-            if constexpr (std::is_same_v<T, Nul>) {
-                if (type() == Type::eNul) return Nul{};
-            } else if constexpr (std::is_same_v<T, Obj>) {
-                if (type() == Type::eObj) return std::get<Obj>(m_data);
-            } else if constexpr (std::is_same_v<T, Arr>) {
-                if (type() == Type::eArr) return std::get<Arr>(m_data);
-            } else if constexpr (std::is_same_v<T, Str>) {
-                if (type() == Type::eStr) return std::get<Str>(m_data);
-            } else if constexpr (std::is_same_v<T, Bol>) {
-                if (type() == Type::eBol) return std::get<Bol>(m_data);
-            } else if constexpr (std::is_enum_v<T>) {
-                if (type() == Type::eNum) return static_cast<T>(std::llround(std::get<Num>(m_data)));
-            } else if constexpr (std::is_integral_v<T>) {
-                if (type() == Type::eNum) return static_cast<T>(std::llround(std::get<Num>(m_data)));
-            } else if constexpr (std::is_floating_point_v<T>) {
-                if (type() == Type::eNum) return static_cast<T>(std::get<Num>(m_data));
-            }
-            if constexpr (std::is_constructible_v<T, Json>) {
-                return static_cast<T>(*this);
-            }
-            if constexpr (std::is_convertible_v<Obj, T>) {
-                if (type() == Type::eObj) return static_cast<T>(std::get<Obj>(m_data));
+        static std::shared_ptr<Shape> share(const std::shared_ptr<Shape>& shape) {
+            if (!shape || shape->shared) return shape;
+            auto copy = std::make_shared<Shape>();
+            copy->assign(*shape);
+            copy->shared = false;
+            return copy;
+        }
+
+        template<typename K>
+        void add_key(K&& key) {
+            if (!m_shape || m_shape->shared) {
+                const size_type count = m_shape ? m_shape->keys.size() : 0;
+                if (count < max_shared_keys) {
+                    m_shape = transition(m_shape ? m_shape : root(), key);
+                    return;
+                }
+                // leave the tree with a private copy
+                auto copy = std::make_shared<Shape>();
+                copy->assign(*m_shape);
+                copy->shared = false;
+                m_shape = std::move(copy);
             }
-            if constexpr (std::is_convertible_v<Arr, T>) {
-                if (type() == Type::eArr) return static_cast<T>(std::get<Arr>(m_data));
+            m_shape->append(make_key(key));
+        }
+
+        /**
+         * @brief Remove a value and its key, the object is unchanged if this throws.
+         */
+        void remove_slot(const size_type slot) {
+            std::shared_ptr<Shape> shape;
+            if (m_values.size() > 1 && m_shape->shared) {
+                // walk the tree again without the removed key, before anything is modified
+                shape = root();
+                for (size_type i = 0; i < m_shape->keys.size(); ++i) {
+                    if (i != slot) shape = transition(shape, m_shape->keys[i]);
+                }
             }
-            if constexpr (std::is_convertible_v<Str, T>) {
-                if (type() == Type::eStr) return static_cast<T>(std::get<Str>(m_data));
+            m_values.erase(m_values.begin() + static_cast<difference_type>(slot));
+            if (m_values.empty()) {
+                m_shape.reset();
+            } else if (!m_shape->shared) {
+                m_shape->remove(slot);
+            } else {
+                m_shape = std::move(shape);
             }
-            if constexpr (std::is_convertible_v<Num, T>) {
-                if (type() == Type::eNum) return static_cast<T>(std::get<Num>(m_data));
+        }
+
+        template<typename K>
+        [[nodiscard]]
+        size_type slot_of(const K& key) const {
+            return m_shape ? m_shape->find(key) : 0;
+        }
+
+        template<bool Const>
+        class basic_iterator {
+            friend class ShapeMap;
+            template<bool> friend class basic_iterator;
+            using value_ptr = std::conditional_t<Const, const T*, T*>;
+            const Key* m_keys{ nullptr };
+            value_ptr m_values{ nullptr };
+            size_type m_index{ 0 };
+
+            basic_iterator(const Key* keys, value_ptr values, const size_type index) noexcept
+                : m_keys(keys), m_values(values), m_index(index) {}
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = std::pair<Key, T>;
+            using difference_type = std::ptrdiff_t;
+            using reference = std::pair<const Key&, std::conditional_t<Const, const T&, T&>>;
+            struct pointer {
+                reference ref;
+                const reference* operator->() const noexcept { return &ref; }
+            };
+
+            basic_iterator() = default;
+            template<bool OtherConst>
+            requires (Const && !OtherConst)
+            basic_iterator(const basic_iterator<OtherConst>& other) noexcept
+                : m_keys(other.m_keys), m_values(other.m_values), m_index(other.m_index) {}
+
+            reference operator*() const noexcept { return { m_keys[m_index], m_values[m_index] }; }
+            pointer operator->() const noexcept { return { **this }; }
+            basic_iterator& operator++() noexcept { ++m_index; return *this; }
+            basic_iterator operator++(int) noexcept { auto tmp = *this; ++m_index; return tmp; }
+            bool operator==(const basic_iterator& other) const noexcept { return m_index == other.m_index; }
+        };
+
+    public:
+        using iterator = basic_iterator<false>;
+        using const_iterator = basic_iterator<true>;
+        using reference = typename iterator::reference;
+        using const_reference = typename const_iterator::reference;
+
+        ShapeMap() = default;
+        explicit ShapeMap(const Allocator& alloc) : m_values(alloc) {}
+        ShapeMap(std::initializer_list<value_type> init, const Allocator& alloc = Allocator()) : m_values(alloc) {
+            m_values.reserve(init.size());
+            for (const auto& [key, value] : init) try_emplace(key, value);
+        }
+        template<std::input_iterator It>
+        ShapeMap(It first, It last, const Allocator& alloc = Allocator()) : m_values(alloc) {
+            for (; first != last; ++first) emplace(*first);
+        }
+        /**
+         * @brief Adopt a vector of pairs, the first of duplicated keys is kept.
+         */
+        explicit ShapeMap(container_type items) : m_values(items.get_allocator()) {
+            m_values.reserve(items.size());
+            if (items.size() <= max_shared_keys) {
+                for (auto& [key, value] : items) try_emplace(std::move(key), std::move(value));
+                return;
             }
-            if constexpr (std::is_convertible_v<Bol, T>) {
-                if (type() == Type::eBol) return static_cast<T>(std::get<Bol>(m_data));
+            // large objects build their private shape at once
+            std::vector<std::uint32_t> sorted(items.size());
+            std::iota(sorted.begin(), sorted.end(), std::uint32_t{ 0 });
+            std::ranges::stable_sort(sorted, std::less<>{}, [&items](const std::uint32_t i) -> const Key& { return items[i].first; });
+            std::vector<bool> keep(items.size(), true);
+            for (size_type i = 1; i < sorted.size(); ++i) {
+                if (items[sorted[i]].first == items[sorted[i - 1]].first) keep[sorted[i]] = false;
             }
-            if constexpr (std::is_convertible_v<Nul, T>) {
-                if (type() == Type::eNul) return static_cast<T>(Nul{});
+            std::vector<std::uint32_t> slots(items.size());
+            auto shape = std::make_shared<Shape>();
+            shape->shared = false;
+            shape->keys.reserve(items.size());
+            for (size_type i = 0; i < items.size(); ++i) {
+                if (!keep[i]) continue;
+                slots[i] = static_cast<std::uint32_t>(shape->keys.size());
+                shape->keys.push_back(make_key(items[i].first));
+                m_values.push_back(std::move(items[i].second));
             }
-            if constexpr ( convertible_map<Json, T, D> ) {
-                if (type() == Type::eObj) {
-                    T result{};
-                    for (auto& [key, value] : std::get<Obj>(m_data)) {
-                        auto val = value.template to_if<typename T::mapped_type>();
-                        if (!val) result.emplace(static_cast<typename T::key_type>(key), static_cast<typename T::mapped_type>(default_range_elem));
-                        else result.emplace(static_cast<typename T::key_type>(key), std::move(*val));
-                    }
-                    return result;
-                }
+            for (const auto i : sorted) {
+                if (keep[i]) shape->order.push_back(slots[i]);
             }
-            if constexpr ( convertible_array<Json, T, D> ) {
-                if (type() == Type::eArr) {
-                    T result{};
-                    for (auto& value : std::get<Arr>(m_data)) {
-                        auto val = value.template to_if<typename T::value_type>();
-                        if (!val) result.emplace_back(default_range_elem);
-                        else result.emplace_back(std::move(*val));
-                    }
-                    return result;
-                }
+            m_shape = std::move(shape);
+        }
+        ShapeMap(const ShapeMap& other) : m_shape(share(other.m_shape)), m_values(other.m_values) {}
+        ShapeMap(ShapeMap&&) noexcept = default;
+        ShapeMap(const ShapeMap& other, const Allocator& alloc) : m_shape(share(other.m_shape)), m_values(other.m_values, alloc) {}
+        ShapeMap(ShapeMap&& other, const Allocator& alloc) : m_shape(std::move(other.m_shape)), m_values(std::move(other.m_values), alloc) {
+            other.m_values.clear();
+        }
+        ShapeMap& operator=(const ShapeMap& other) {
+            if (this != &other) {
+                m_values = other.m_values;
+                m_shape = share(other.m_shape);
             }
-            return std::nullopt;
+            return *this;
         }
+        ShapeMap& operator=(ShapeMap&&) noexcept = default;
+
+        [[nodiscard]]
+        allocator_type get_allocator() const noexcept { return allocator_type(m_values.get_allocator()); }
 
         /**
-         * @brief type conversion, copy inner value to specified type
-         * @tparam T The target type to convert to
-         * @tparam D The mapped_type or value_type of the target type, used for range conversion, default is Nul for other types(useless).
-         * @param default_range_elem if T is a range type and is not json::Arr or json::Obj, must be specified for safe conversion. Else, please use default value.
-         * @return The converted value
-         * @throws std::runtime_error if conversion fails
-         * @note Num is double, so conversions to integral (and enum) types will round to nearest.
-         * @details
-         * Attempt sequence of conversions:
+         * @brief Identity of the shape, equal for objects sharing the same key sequence, `nullptr` if empty.
+         */
+        [[nodiscard]]
+        const void* shape() const noexcept { return m_shape.get(); }
+
+        [[nodiscard]] iterator begin() noexcept { return { m_shape ? m_shape->keys.data() : nullptr, m_values.data(), 0 }; }
+        [[nodiscard]] iterator end() noexcept { return { nullptr, nullptr, m_values.size() }; }
+        [[nodiscard]] const_iterator begin() const noexcept { return { m_shape ? m_shape->keys.data() : nullptr, m_values.data(), 0 }; }
+        [[nodiscard]] const_iterator end() const noexcept { return { nullptr, nullptr, m_values.size() }; }
+        [[nodiscard]] const_iterator cbegin() const noexcept { return begin(); }
+        [[nodiscard]] const_iterator cend() const noexcept { return end(); }
+
+        [[nodiscard]] size_type size() const noexcept { return m_values.size(); }
+        [[nodiscard]] bool empty() const noexcept { return m_values.empty(); }
+        void reserve(const size_type count) { m_values.reserve(count); }
+        void clear() noexcept {
+            m_values.clear();
+            m_shape.reset();
+        }
+
+        template<typename K>
+        [[nodiscard]]
+        iterator find(const K& key) {
+            auto it = begin();
+            it.m_index = slot_of(key);
+            return it;
+        }
+        template<typename K>
+        [[nodiscard]]
+        const_iterator find(const K& key) const {
+            auto it = begin();
+            it.m_index = slot_of(key);
+            return it;
+        }
+        template<typename K>
+        [[nodiscard]]
+        bool contains(const K& key) const { return slot_of(key) < size(); }
+        template<typename K>
+        [[nodiscard]]
+        size_type count(const K& key) const { return contains(key) ? 1 : 0; }
+
+        /**
+         * @throw std::out_of_range if the key does not exist.
+         */
+        template<typename K>
+        [[nodiscard]]
+        T& at(const K& key) {
+            const auto slot = slot_of(key);
+            if (slot == size()) throw std::out_of_range("ShapeMap::at: key not found");
+            return m_values[slot];
+        }
+        template<typename K>
+        [[nodiscard]]
+        const T& at(const K& key) const {
+            const auto slot = slot_of(key);
+            if (slot == size()) throw std::out_of_range("ShapeMap::at: key not found");
+            return m_values[slot];
+        }
+
+        template<typename K, typename... Args>
+        std::pair<iterator, bool> try_emplace(K&& key, Args&&... args) {
+            if (const auto slot = slot_of(key); slot < size()) {
+                auto it = begin();
+                it.m_index = slot;
+                return { it, false };
+            }
+            m_values.emplace_back(std::forward<Args>(args)...);
+            try {
+                add_key(std::forward<K>(key));
+            } catch (...) {
+                m_values.pop_back();
+                throw;
+            }
+            auto it = begin();
+            it.m_index = size() - 1;
+            return { it, true };
+        }
+
+        template<typename... Args>
+        std::pair<iterator, bool> emplace(Args&&... args) {
+            value_type item(std::forward<Args>(args)...);
+            return try_emplace(std::move(item.first), std::move(item.second));
+        }
+
+        std::pair<iterator, bool> insert(const value_type& item) { return try_emplace(item.first, item.second); }
+        std::pair<iterator, bool> insert(value_type&& item) { return try_emplace(std::move(item.first), std::move(item.second)); }
+
+        template<typename K, typename V>
+        std::pair<iterator, bool> insert_or_assign(K&& key, V&& value) {
+            auto res = try_emplace(std::forward<K>(key), std::forward<V>(value));
+            if (!res.second) res.first->second = std::forward<V>(value);
+            return res;
+        }
+
+        T& operator[](const Key& key) { return try_emplace(key).first->second; }
+        T& operator[](Key&& key) { return try_emplace(std::move(key)).first->second; }
+
+        iterator erase(const const_iterator pos) {
+            remove_slot(pos.m_index);
+            auto it = begin();
+            it.m_index = pos.m_index;
+            return it;
+        }
+        iterator erase(const iterator pos) { return erase(const_iterator(pos)); }
+        template<typename K>
+        requires (!std::is_convertible_v<const K&, const_iterator>)
+        size_type erase(const K& key) {
+            const auto slot = slot_of(key);
+            if (slot == size()) return 0;
+            remove_slot(slot);
+            return 1;
+        }
+
+        void swap(ShapeMap& other) noexcept {
+            m_shape.swap(other.m_shape);
+            m_values.swap(other.m_values);
+        }
+
+        /**
+         * @brief Equal if both hold the same keys with equal values, in any order.
+         */
+        [[nodiscard]]
+        bool operator==(const ShapeMap& other) const {
+            if (size() != other.size()) return false;
+            if (m_shape == other.m_shape) return m_values == other.m_values;
+            for (size_type i = 0; i < size(); ++i) {
+                const auto slot = other.slot_of(m_shape->keys[i]);
+                if (slot == other.size() || !(m_values[i] == other.m_values[slot])) return false;
+            }
+            return true;
+        }
+    };
+
+    /**
+     * @brief `std::hash<std::string_view>` accepting any string type, so `std::unordered_map` finds a `std::string_view`.
+     * @details Hashes equal `std::hash<std::string>`, the buckets are those of the standard hasher.
+     */
+    struct StringHash {
+        using is_transparent = void;
+
+        [[nodiscard]]
+        std::size_t operator()(const std::string_view key) const noexcept { return std::hash<std::string_view>{}(key); }
+    };
+
+    /**
+     * @brief Fast keyed string hash, seeded once per process from `std::random_device`.
+     * @details
+     * Reads the input 16 bytes at a time and folds it with 64x64->128-bit multiplications,
+     * keys up to 16 bytes take two overlapping loads and no loop.
+     * The seed makes bucket positions unpredictable across runs, so documents crafted to collide
+     * in one process do not collide in another. It is not a cryptographic MAC.
+     */
+    struct SeededHash {
+        using is_transparent = void;
+
+        /**
+         * @brief The per-process seed.
+         */
+        [[nodiscard]]
+        static std::uint64_t seed() noexcept {
+            static const std::uint64_t value = [] {
+                std::uint64_t result = reinterpret_cast<std::uintptr_t>(&value);
+                try {
+                    std::random_device device;
+                    result ^= (static_cast<std::uint64_t>(device()) << 32) | device();
+                } catch (...) {
+                    result ^= static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+                }
+                return result;
+            }();
+            return value;
+        }
+
+        [[nodiscard]]
+        static constexpr std::uint64_t mix(const std::uint64_t a, const std::uint64_t b) noexcept {
+#ifdef __SIZEOF_INT128__
+            const auto product = static_cast<unsigned __int128>(a) * b;
+            return static_cast<std::uint64_t>(product) ^ static_cast<std::uint64_t>(product >> 64);
+#else
+            const std::uint64_t a_lo = a & 0xFFFFFFFFu, a_hi = a >> 32;
+            const std::uint64_t b_lo = b & 0xFFFFFFFFu, b_hi = b >> 32;
+            const std::uint64_t lo_lo = a_lo * b_lo, hi_lo = a_hi * b_lo, lo_hi = a_lo * b_hi;
+            const std::uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFFu) + lo_hi;
+            const std::uint64_t upper = (hi_lo >> 32) + (cross >> 32) + a_hi * b_hi;
+            return ((cross << 32) | (lo_lo & 0xFFFFFFFFu)) ^ upper;
+#endif
+        }
+
+        [[nodiscard]]
+        static std::uint64_t hash(const std::string_view str, const std::uint64_t seed) noexcept {
+            constexpr std::uint64_t k0 = 0xa0761d6478bd642full, k1 = 0xe7037ed1a0b428dbull, k2 = 0x8ebc6af09c88c6e3ull;
+            const auto read8 = [](const char* ptr) noexcept {
+                std::uint64_t word;
+                std::memcpy(&word, ptr, sizeof(word));
+                if constexpr (std::endian::native == std::endian::big) word = std::byteswap(word);
+                return word;
+            };
+            const auto read4 = [](const char* ptr) noexcept {
+                std::uint32_t word;
+                std::memcpy(&word, ptr, sizeof(word));
+                if constexpr (std::endian::native == std::endian::big) word = std::byteswap(word);
+                return static_cast<std::uint64_t>(word);
+            };
+            const char* ptr = str.data();
+            const std::size_t len = str.size();
+            std::uint64_t state = seed ^ k0;
+            std::uint64_t a{ 0 }, b{ 0 };
+            // short keys are read with overlapping fixed-size loads instead of a byte loop
+            if (len <= 16) {
+                if (len >= 4) {
+                    const std::size_t mid = (len >> 3) << 2;
+                    a = (read4(ptr) << 32) | read4(ptr + mid);
+                    b = (read4(ptr + len - 4) << 32) | read4(ptr + len - 4 - mid);
+                } else if (len > 0) {
+                    a = (static_cast<std::uint64_t>(static_cast<unsigned char>(ptr[0])) << 16)
+                      | (static_cast<std::uint64_t>(static_cast<unsigned char>(ptr[len >> 1])) << 8)
+                      | static_cast<unsigned char>(ptr[len - 1]);
+                }
+            } else {
+                std::size_t left = len;
+                for (; left > 16; ptr += 16, left -= 16) {
+                    state = mix(read8(ptr) ^ k1, read8(ptr + 8) ^ state);
+                }
+                a = read8(ptr + left - 16);
+                b = read8(ptr + left - 8);
+            }
+            return mix(k1 ^ len, mix(a ^ k1, b ^ state) ^ k2);
+        }
+
+        [[nodiscard]]
+        std::size_t operator()(const std::string_view str) const noexcept {
+            return static_cast<std::size_t>(hash(str, seed()));
+        }
+
+        [[nodiscard]]
+        std::size_t operator()(const hashed_key& key) const noexcept { return key.hash; }
+    };
+
+    /**
+     * @brief Open-addressing hash map with one metadata byte per slot, probed a group at a time.
+     * @tparam Key The key type.
+     * @tparam T The mapped type.
+     * @tparam Hash The hash, transparent `SeededHash` by default.
+     * @tparam KeyEqual The key equality, transparent by default.
+     * @tparam Allocator The allocator of `std::pair<Key, T>`, rebound to bytes for the metadata.
+     * @details
+     * Pairs live in one slot array, a parallel control array holds 7 bits of each key's hash,
+     * or marks the slot empty or erased. A lookup compares a whole group of control bytes
+     * against the hash bits at once, SSE2 on x86 and 8 bytes in a register elsewhere,
+     * and only compares keys whose bits match. Groups are probed triangularly, the load factor is at most 7/8.
+     * Iteration follows the slots, its order depends on the hash seed.
+     * @note Keys are reachable through non-const iterators but must not be modified.
+     * Rehashing invalidates iterators and references.
+     */
+    template<
+        typename Key,
+        typename T,
+        typename Hash = SeededHash,
+        typename KeyEqual = std::equal_to<>,
+        typename Allocator = std::allocator<std::pair<Key, T>>
+    >
+    class HashMap {
+    public:
+        using key_type = Key;
+        using mapped_type = T;
+        using value_type = std::pair<Key, T>;
+        using hasher = Hash;
+        using key_equal = KeyEqual;
+        using allocator_type = Allocator;
+        using size_type = std::size_t;
+        using difference_type = std::ptrdiff_t;
+        using container_type = std::vector<value_type, Allocator>;
+
+#ifdef M_MYSVAC_JSON_HAS_SSE2
+        static constexpr size_type group_width = 16;
+#else
+        static constexpr size_type group_width = 8;
+#endif
+
+    private:
+        using slot_traits = std::allocator_traits<Allocator>;
+        using ctrl_allocator = typename slot_traits::template rebind_alloc<std::uint8_t>;
+
+        static constexpr std::uint8_t ctrl_empty = 0x80;
+        static constexpr std::uint8_t ctrl_erased = 0xFE;
+        static constexpr size_type npos = static_cast<size_type>(-1);
+
+        // bit masks over one group of control bytes, iterated with `next_bit`
+        struct group {
+#ifdef M_MYSVAC_JSON_HAS_SSE2
+            static constexpr int shift = 0;
+            __m128i ctrl;
+            explicit group(const std::uint8_t* ptr) noexcept
+                : ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr))) {}
+            [[nodiscard]] std::uint64_t match(const std::uint8_t h2) const noexcept {
+                return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(static_cast<char>(h2)), ctrl)));
+            }
+            [[nodiscard]] std::uint64_t match_empty() const noexcept {
+                return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(static_cast<char>(ctrl_empty)), ctrl)));
+            }
+            [[nodiscard]] std::uint64_t match_free() const noexcept {
+                return static_cast<std::uint32_t>(_mm_movemask_epi8(ctrl));
+            }
+#else
+            static constexpr int shift = 3;
+            static constexpr std::uint64_t lsbs = 0x0101010101010101ull;
+            static constexpr std::uint64_t msbs = 0x8080808080808080ull;
+            std::uint64_t ctrl;
+            explicit group(const std::uint8_t* ptr) noexcept {
+                std::memcpy(&ctrl, ptr, sizeof(ctrl));
+                if constexpr (std::endian::native == std::endian::big) ctrl = std::byteswap(ctrl);
+            }
+            // may report false positives above a real match, keys are compared anyway
+            [[nodiscard]] std::uint64_t match(const std::uint8_t h2) const noexcept {
+                const auto x = ctrl ^ (lsbs * h2);
+                return (x - lsbs) & ~x & msbs;
+            }
+            [[nodiscard]] std::uint64_t match_empty() const noexcept { return ctrl & ~(ctrl << 6) & msbs; }
+            [[nodiscard]] std::uint64_t match_free() const noexcept { return ctrl & msbs; }
+#endif
+            [[nodiscard]]
+            static size_type next_bit(std::uint64_t& mask) noexcept {
+                const auto index = static_cast<size_type>(std::countr_zero(mask)) >> shift;
+                mask &= mask - 1;
+                return index;
+            }
+        };
+
+        std::uint8_t* m_ctrl{ nullptr };
+        value_type* m_slots{ nullptr };
+        size_type m_capacity{ 0 };     // 0 or a power of two not below group_width
+        size_type m_size{ 0 };
+        size_type m_growth_left{ 0 };  // empty slots that may still be filled before rehashing
+        [[no_unique_address]] Hash m_hash;
+        [[no_unique_address]] KeyEqual m_equal;
+        [[no_unique_address]] Allocator m_alloc;
+
+        [[nodiscard]]
+        static constexpr size_type max_load(const size_type capacity) noexcept { return capacity - capacity / 8; }
+
+        [[nodiscard]]
+        static constexpr size_type capacity_for(const size_type count) noexcept {
+            return std::max(group_width, std::bit_ceil(count + count / 7 + 1));
+        }
+
+        [[nodiscard]]
+        static constexpr std::uint8_t h2(const std::size_t hash) noexcept { return static_cast<std::uint8_t>(hash & 0x7F); }
+
+        template<typename K>
+        [[nodiscard]]
+        size_type find_index(const K& key, const std::size_t hash) const {
+            if (m_capacity == 0) return npos;
+            const size_type groups_mask = m_capacity / group_width - 1;
+            size_type pos = (hash >> 7) & groups_mask;
+            for (size_type step = 1; ; ++step) {
+                const group g{ m_ctrl + pos * group_width };
+                for (auto mask = g.match(h2(hash)); mask != 0; ) {
+                    const auto index = pos * group_width + group::next_bit(mask);
+                    if (m_equal(m_slots[index].first, key)) return index;
+                }
+                if (g.match_empty() != 0) return npos;
+                pos = (pos + step) & groups_mask;
+            }
+        }
+
+        // first empty or erased slot on the probe sequence of `hash`
+        [[nodiscard]]
+        size_type free_index(const std::size_t hash) const noexcept {
+            const size_type groups_mask = m_capacity / group_width - 1;
+            size_type pos = (hash >> 7) & groups_mask;
+            for (size_type step = 1; ; ++step) {
+                auto mask = group{ m_ctrl + pos * group_width }.match_free();
+                if (mask != 0) return pos * group_width + group::next_bit(mask);
+                pos = (pos + step) & groups_mask;
+            }
+        }
+
+        void release() noexcept {
+            if (m_capacity == 0) return;
+            for (size_type i = 0; i < m_capacity; ++i) {
+                if (!(m_ctrl[i] & 0x80)) slot_traits::destroy(m_alloc, m_slots + i);
+            }
+            slot_traits::deallocate(m_alloc, m_slots, m_capacity);
+            ctrl_allocator ctrl_alloc(m_alloc);
+            std::allocator_traits<ctrl_allocator>::deallocate(ctrl_alloc, m_ctrl, m_capacity);
+            m_ctrl = nullptr;
+            m_slots = nullptr;
+            m_capacity = m_size = m_growth_left = 0;
+        }
+
+        void steal(HashMap& other) noexcept {
+            m_ctrl = std::exchange(other.m_ctrl, nullptr);
+            m_slots = std::exchange(other.m_slots, nullptr);
+            m_capacity = std::exchange(other.m_capacity, 0);
+            m_size = std::exchange(other.m_size, 0);
+            m_growth_left = std::exchange(other.m_growth_left, 0);
+        }
+
+        void rehash(const size_type capacity) {
+            ctrl_allocator ctrl_alloc(m_alloc);
+            auto* const ctrl = std::allocator_traits<ctrl_allocator>::allocate(ctrl_alloc, capacity);
+            value_type* slots;
+            try {
+                slots = slot_traits::allocate(m_alloc, capacity);
+            } catch (...) {
+                std::allocator_traits<ctrl_allocator>::deallocate(ctrl_alloc, ctrl, capacity);
+                throw;
+            }
+            std::memset(ctrl, ctrl_empty, capacity);
+            const auto old_ctrl = std::exchange(m_ctrl, ctrl);
+            const auto old_slots = std::exchange(m_slots, slots);
+            const auto old_capacity = std::exchange(m_capacity, capacity);
+            for (size_type i = 0; i < old_capacity; ++i) {
+                if (old_ctrl[i] & 0x80) continue;
+                const std::size_t hash = m_hash(old_slots[i].first);
+                const auto index = free_index(hash);
+                slot_traits::construct(m_alloc, m_slots + index, std::move(old_slots[i]));
+                slot_traits::destroy(m_alloc, old_slots + i);
+                m_ctrl[index] = h2(hash);
+            }
+            m_growth_left = max_load(capacity) - m_size;
+            if (old_capacity != 0) {
+                slot_traits::deallocate(m_alloc, old_slots, old_capacity);
+                std::allocator_traits<ctrl_allocator>::deallocate(ctrl_alloc, old_ctrl, old_capacity);
+            }
+        }
+
+        void erase_index(const size_type index) noexcept {
+            slot_traits::destroy(m_alloc, m_slots + index);
+            --m_size;
+            if (m_size == 0) {
+                // nothing left to probe past, drop the tombstones
+                std::memset(m_ctrl, ctrl_empty, m_capacity);
+                m_growth_left = max_load(m_capacity);
+            } else {
+                m_ctrl[index] = ctrl_erased;
+            }
+        }
+
+        template<bool Const>
+        class basic_iterator {
+            friend class HashMap;
+            template<bool> friend class basic_iterator;
+            using slot_ptr = std::conditional_t<Const, const std::pair<Key, T>*, std::pair<Key, T>*>;
+            const std::uint8_t* m_ctrl{ nullptr };
+            slot_ptr m_slots{ nullptr };
+            size_type m_index{ 0 };
+            size_type m_capacity{ 0 };
+
+            basic_iterator(const std::uint8_t* ctrl, slot_ptr slots, const size_type index, const size_type capacity) noexcept
+                : m_ctrl(ctrl), m_slots(slots), m_index(index), m_capacity(capacity) { skip(); }
+
+            void skip() noexcept {
+                while (m_index < m_capacity && (m_ctrl[m_index] & 0x80)) ++m_index;
+            }
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = std::pair<Key, T>;
+            using difference_type = std::ptrdiff_t;
+            using reference = std::conditional_t<Const, const value_type&, value_type&>;
+            using pointer = slot_ptr;
+
+            basic_iterator() = default;
+            template<bool OtherConst>
+            requires (Const && !OtherConst)
+            basic_iterator(const basic_iterator<OtherConst>& other) noexcept
+                : m_ctrl(other.m_ctrl), m_slots(other.m_slots), m_index(other.m_index), m_capacity(other.m_capacity) {}
+
+            reference operator*() const noexcept { return m_slots[m_index]; }
+            pointer operator->() const noexcept { return m_slots + m_index; }
+            basic_iterator& operator++() noexcept { ++m_index; skip(); return *this; }
+            basic_iterator operator++(int) noexcept { auto tmp = *this; ++*this; return tmp; }
+            bool operator==(const basic_iterator& other) const noexcept { return m_index == other.m_index; }
+        };
+
+    public:
+        using iterator = basic_iterator<false>;
+        using const_iterator = basic_iterator<true>;
+
+    private:
+        [[nodiscard]] iterator make_iterator(const size_type index) noexcept { return { m_ctrl, m_slots, index, m_capacity }; }
+        [[nodiscard]] const_iterator make_iterator(const size_type index) const noexcept { return { m_ctrl, m_slots, index, m_capacity }; }
+        [[nodiscard]] size_type found(const size_type index) const noexcept { return index == npos ? m_capacity : index; }
+
+        void assign_from(const HashMap& other) {
+            reserve(other.m_size);
+            for (const auto& [key, value] : other) try_emplace(key, value);
+        }
+
+    public:
+        HashMap() = default;
+        explicit HashMap(const Allocator& alloc) : m_alloc(alloc) {}
+        HashMap(std::initializer_list<value_type> init, const Allocator& alloc = Allocator()) : m_alloc(alloc) {
+            reserve(init.size());
+            for (const auto& item : init) insert(item);
+        }
+        template<std::input_iterator It>
+        HashMap(It first, It last, const Allocator& alloc = Allocator()) : m_alloc(alloc) {
+            for (; first != last; ++first) emplace(*first);
+        }
+        /**
+         * @brief Adopt a vector of pairs, sized once, the first of duplicated keys is kept.
+         */
+        explicit HashMap(container_type items) : m_alloc(items.get_allocator()) {
+            reserve(items.size());
+            for (auto& [key, value] : items) try_emplace(std::move(key), std::move(value));
+        }
+        HashMap(const HashMap& other)
+            : m_hash(other.m_hash), m_equal(other.m_equal),
+              m_alloc(slot_traits::select_on_container_copy_construction(other.m_alloc)) { assign_from(other); }
+        HashMap(HashMap&& other) noexcept
+            : m_hash(other.m_hash), m_equal(other.m_equal), m_alloc(std::move(other.m_alloc)) { steal(other); }
+        HashMap(const HashMap& other, const Allocator& alloc)
+            : m_hash(other.m_hash), m_equal(other.m_equal), m_alloc(alloc) { assign_from(other); }
+        HashMap(HashMap&& other, const Allocator& alloc)
+            : m_hash(other.m_hash), m_equal(other.m_equal), m_alloc(alloc) {
+            if (m_alloc == other.m_alloc) {
+                steal(other);
+            } else {
+                reserve(other.m_size);
+                for (auto& [key, value] : other) try_emplace(std::move(key), std::move(value));
+                other.clear();
+            }
+        }
+        ~HashMap() { release(); }
+
+        HashMap& operator=(const HashMap& other) {
+            if (this != &other) {
+                clear();
+                assign_from(other);
+            }
+            return *this;
+        }
+        HashMap& operator=(HashMap&& other) noexcept(slot_traits::propagate_on_container_move_assignment::value || slot_traits::is_always_equal::value) {
+            if (this == &other) return *this;
+            release();
+            if constexpr (slot_traits::propagate_on_container_move_assignment::value) {
+                m_alloc = std::move(other.m_alloc);
+                steal(other);
+            } else {
+                if (m_alloc == other.m_alloc) {
+                    steal(other);
+                } else {
+                    reserve(other.m_size);
+                    for (auto& [key, value] : other) try_emplace(std::move(key), std::move(value));
+                    other.clear();
+                }
+            }
+            return *this;
+        }
+
+        [[nodiscard]]
+        allocator_type get_allocator() const noexcept { return m_alloc; }
+
+        [[nodiscard]] iterator begin() noexcept { return make_iterator(0); }
+        [[nodiscard]] iterator end() noexcept { return make_iterator(m_capacity); }
+        [[nodiscard]] const_iterator begin() const noexcept { return make_iterator(0); }
+        [[nodiscard]] const_iterator end() const noexcept { return make_iterator(m_capacity); }
+        [[nodiscard]] const_iterator cbegin() const noexcept { return begin(); }
+        [[nodiscard]] const_iterator cend() const noexcept { return end(); }
+
+        [[nodiscard]] size_type size() const noexcept { return m_size; }
+        [[nodiscard]] bool empty() const noexcept { return m_size == 0; }
+        /**
+         * @brief Number of slots, a power of two, or 0 before the first insertion.
+         */
+        [[nodiscard]] size_type capacity() const noexcept { return m_capacity; }
+
+        /**
+         * @brief Make room for `count` elements without rehashing.
+         */
+        void reserve(const size_type count) {
+            if (count > m_size + m_growth_left) rehash(capacity_for(count));
+        }
+        void clear() noexcept {
+            if (m_capacity == 0) return;
+            for (size_type i = 0; i < m_capacity; ++i) {
+                if (!(m_ctrl[i] & 0x80)) slot_traits::destroy(m_alloc, m_slots + i);
+            }
+            std::memset(m_ctrl, ctrl_empty, m_capacity);
+            m_size = 0;
+            m_growth_left = max_load(m_capacity);
+        }
+
+        template<typename K>
+        [[nodiscard]]
+        iterator find(const K& key) { return make_iterator(found(find_index(key, m_hash(key)))); }
+        template<typename K>
+        [[nodiscard]]
+        const_iterator find(const K& key) const { return make_iterator(found(find_index(key, m_hash(key)))); }
+        template<typename K>
+        [[nodiscard]]
+        bool contains(const K& key) const { return find_index(key, m_hash(key)) != npos; }
+        template<typename K>
+        [[nodiscard]]
+        size_type count(const K& key) const { return contains(key) ? 1 : 0; }
+
+        /**
+         * @throw std::out_of_range if the key does not exist.
+         */
+        template<typename K>
+        [[nodiscard]]
+        T& at(const K& key) {
+            const auto index = find_index(key, m_hash(key));
+            if (index == npos) throw std::out_of_range("HashMap::at: key not found");
+            return m_slots[index].second;
+        }
+        template<typename K>
+        [[nodiscard]]
+        const T& at(const K& key) const {
+            const auto index = find_index(key, m_hash(key));
+            if (index == npos) throw std::out_of_range("HashMap::at: key not found");
+            return m_slots[index].second;
+        }
+
+        template<typename K, typename... Args>
+        std::pair<iterator, bool> try_emplace(K&& key, Args&&... args) {
+            const std::size_t hash = m_hash(key);
+            if (const auto index = find_index(key, hash); index != npos) return { make_iterator(index), false };
+            if (m_capacity == 0) rehash(group_width);
+            auto index = free_index(hash);
+            if (m_growth_left == 0 && m_ctrl[index] == ctrl_empty) {
+                // grow, or only drop the tombstones if most slots are erased ones
+                rehash(capacity_for(m_size + 1));
+                index = free_index(hash);
+            }
+            slot_traits::construct(m_alloc, m_slots + index,
+                std::piecewise_construct,
+                std::forward_as_tuple(std::forward<K>(key)),
+                std::forward_as_tuple(std::forward<Args>(args)...)
+            );
+            if (m_ctrl[index] == ctrl_empty) --m_growth_left;
+            m_ctrl[index] = h2(hash);
+            ++m_size;
+            return { make_iterator(index), true };
+        }
+
+        template<typename... Args>
+        std::pair<iterator, bool> emplace(Args&&... args) {
+            value_type item(std::forward<Args>(args)...);
+            return try_emplace(std::move(item.first), std::move(item.second));
+        }
+
+        std::pair<iterator, bool> insert(const value_type& item) { return try_emplace(item.first, item.second); }
+        std::pair<iterator, bool> insert(value_type&& item) { return try_emplace(std::move(item.first), std::move(item.second)); }
+
+        template<typename K, typename V>
+        std::pair<iterator, bool> insert_or_assign(K&& key, V&& value) {
+            auto res = try_emplace(std::forward<K>(key), std::forward<V>(value));
+            if (!res.second) res.first->second = std::forward<V>(value);
+            return res;
+        }
+
+        T& operator[](const Key& key) { return try_emplace(key).first->second; }
+        T& operator[](Key&& key) { return try_emplace(std::move(key)).first->second; }
+
+        iterator erase(const const_iterator pos) {
+            erase_index(pos.m_index);
+            return make_iterator(pos.m_index + 1);
+        }
+        iterator erase(const iterator pos) { return erase(const_iterator(pos)); }
+        template<typename K>
+        requires (!std::is_convertible_v<const K&, const_iterator>)
+        size_type erase(const K& key) {
+            const auto index = find_index(key, m_hash(key));
+            if (index == npos) return 0;
+            erase_index(index);
+            return 1;
+        }
+
+        void swap(HashMap& other) noexcept {
+            std::swap(m_ctrl, other.m_ctrl);
+            std::swap(m_slots, other.m_slots);
+            std::swap(m_capacity, other.m_capacity);
+            std::swap(m_size, other.m_size);
+            std::swap(m_growth_left, other.m_growth_left);
+            std::swap(m_hash, other.m_hash);
+            std::swap(m_equal, other.m_equal);
+            if constexpr (slot_traits::propagate_on_container_swap::value) std::swap(m_alloc, other.m_alloc);
+        }
+
+        /**
+         * @brief Equal if both hold the same keys with equal values, in any order.
+         */
+        [[nodiscard]]
+        bool operator==(const HashMap& other) const {
+            if (m_size != other.m_size) return false;
+            for (const auto& [key, value] : *this) {
+                const auto index = other.find_index(key, other.m_hash(key));
+                if (index == npos || !(other.m_slots[index].second == value)) return false;
+            }
+            return true;
+        }
+    };
+
+    /**
+     * @brief Map that keeps insertion order, a dense vector of key/value pairs plus an open-addressing index.
+     * @tparam Key The key type.
+     * @tparam T The mapped type.
+     * @tparam Hash The hash, transparent `SeededHash` by default.
+     * @tparam KeyEqual The key equality, transparent by default.
+     * @tparam Allocator The allocator of `std::pair<Key, T>`, rebound for the index.
+     * @details
+     * Iteration walks the pair vector, so it is in insertion order and contiguous.
+     * Objects up to `linear_threshold` pairs are searched linearly and have no index.
+     * Above, each index slot packs 32 hash bits with the position of the pair,
+     * the table is kept at most half full and probed linearly, so most lookups compare one key.
+     * Erasing closes the gap in the vector and the index instead of leaving tombstones,
+     * which costs a pass over the index; insertion and lookup are O(1).
+     * @note Keys are reachable through non-const iterators but must not be modified.
+     */
+    template<
+        typename Key,
+        typename T,
+        typename Hash = SeededHash,
+        typename KeyEqual = std::equal_to<>,
+        typename Allocator = std::allocator<std::pair<Key, T>>
+    >
+    class IndexMap {
+    public:
+        using key_type = Key;
+        using mapped_type = T;
+        using value_type = std::pair<Key, T>;
+        using hasher = Hash;
+        using key_equal = KeyEqual;
+        using allocator_type = Allocator;
+        using container_type = std::vector<value_type, Allocator>;
+        using size_type = typename container_type::size_type;
+        using difference_type = typename container_type::difference_type;
+        using iterator = typename container_type::iterator;
+        using const_iterator = typename container_type::const_iterator;
+
+        /**
+         * @brief Objects up to this size are searched linearly and have no index.
+         */
+        static constexpr size_type linear_threshold = 8;
+
+    private:
+        // 0 is an empty slot, otherwise the hash tag in the high half and the pair position + 1 in the low half
+        using slot_type = std::uint64_t;
+        using index_type = std::vector<slot_type, typename std::allocator_traits<Allocator>::template rebind_alloc<slot_type>>;
+        static constexpr size_type npos = static_cast<size_type>(-1);
+
+        container_type m_entries;
+        index_type m_index;
+        [[no_unique_address]] Hash m_hash;
+        [[no_unique_address]] KeyEqual m_equal;
+
+        [[nodiscard]]
+        static constexpr std::uint32_t tag_of(const std::size_t hash) noexcept {
+            const auto wide = static_cast<std::uint64_t>(hash);
+            return static_cast<std::uint32_t>(wide ^ (wide >> 32));
+        }
+        [[nodiscard]]
+        static constexpr slot_type make_slot(const std::uint32_t tag, const size_type position) noexcept {
+            return (static_cast<slot_type>(tag) << 32) | static_cast<slot_type>(position + 1);
+        }
+        [[nodiscard]]
+        static constexpr std::uint32_t slot_tag(const slot_type slot) noexcept { return static_cast<std::uint32_t>(slot >> 32); }
+        [[nodiscard]]
+        static constexpr size_type slot_position(const slot_type slot) noexcept { return static_cast<size_type>(slot & 0xFFFFFFFFu) - 1; }
+
+        [[nodiscard]]
+        size_type mask() const noexcept { return m_index.size() - 1; }
+
+        // index slot holding the pair of `key`, or the empty slot ending its probe sequence
+        template<typename K>
+        [[nodiscard]]
+        size_type probe(const K& key, const std::uint32_t tag) const {
+            for (size_type pos = tag & mask(); ; pos = (pos + 1) & mask()) {
+                const auto slot = m_index[pos];
+                if (slot == 0) return pos;
+                if (slot_tag(slot) == tag && m_equal(m_entries[slot_position(slot)].first, key)) return pos;
+            }
+        }
+
+        template<typename K>
+        [[nodiscard]]
+        size_type find_position(const K& key) const {
+            if (m_index.empty()) {
+                for (size_type i = 0; i < m_entries.size(); ++i) {
+                    if (m_equal(m_entries[i].first, key)) return i;
+                }
+                return npos;
+            }
+            const auto slot = m_index[probe(key, tag_of(m_hash(key)))];
+            return slot == 0 ? npos : slot_position(slot);
+        }
+
+        // index the first `count` pairs, which are known to be unique
+        void rebuild(const size_type count) {
+            m_index.assign(std::max<size_type>(16, std::bit_ceil(count * 2)), 0);
+            for (size_type i = 0; i < count; ++i) {
+                const auto tag = tag_of(m_hash(m_entries[i].first));
+                size_type pos = tag & mask();
+                while (m_index[pos] != 0) pos = (pos + 1) & mask();
+                m_index[pos] = make_slot(tag, i);
+            }
+        }
+
+        // index the pair just appended at the back
+        void index_back(const std::uint32_t tag, size_type pos) {
+            const auto count = m_entries.size();
+            if (count <= linear_threshold) return;
+            if (m_index.empty() || count * 2 > m_index.size()) {
+                rebuild(count);
+                return;
+            }
+            m_index[pos] = make_slot(tag, count - 1);
+        }
+
+        // keep the first of equal keys, moving the rest forward in order
+        void normalize() {
+            if (m_entries.size() <= linear_threshold) {
+                size_type kept = 0;
+                for (size_type i = 0; i < m_entries.size(); ++i) {
+                    bool duplicate = false;
+                    for (size_type j = 0; j < kept && !duplicate; ++j) duplicate = m_equal(m_entries[j].first, m_entries[i].first);
+                    if (duplicate) continue;
+                    if (kept != i) m_entries[kept] = std::move(m_entries[i]);
+                    ++kept;
+                }
+                m_entries.erase(m_entries.begin() + static_cast<difference_type>(kept), m_entries.end());
+                return;
+            }
+            m_index.assign(std::max<size_type>(16, std::bit_ceil(m_entries.size() * 2)), 0);
+            size_type kept = 0;
+            for (size_type i = 0; i < m_entries.size(); ++i) {
+                const auto tag = tag_of(m_hash(m_entries[i].first));
+                const auto pos = probe(m_entries[i].first, tag);
+                if (m_index[pos] != 0) continue;
+                if (kept != i) m_entries[kept] = std::move(m_entries[i]);
+                m_index[pos] = make_slot(tag, kept);
+                ++kept;
+            }
+            m_entries.erase(m_entries.begin() + static_cast<difference_type>(kept), m_entries.end());
+            if (kept <= linear_threshold) m_index.clear();
+        }
+
+        void erase_position(const size_type position) {
+            if (!m_index.empty()) {
+                // backward-shift deletion, later slots of the probe run move into the hole
+                size_type hole = probe(m_entries[position].first, tag_of(m_hash(m_entries[position].first)));
+                for (size_type pos = (hole + 1) & mask(); m_index[pos] != 0; pos = (pos + 1) & mask()) {
+                    const size_type home = slot_tag(m_index[pos]) & mask();
+                    if (((pos - home) & mask()) >= ((pos - hole) & mask())) {
+                        m_index[hole] = m_index[pos];
+                        hole = pos;
+                    }
+                }
+                m_index[hole] = 0;
+            }
+            m_entries.erase(m_entries.begin() + static_cast<difference_type>(position));
+            if (m_entries.size() <= linear_threshold) {
+                m_index.clear();
+            } else if (position != m_entries.size()) {
+                // the following pairs moved one place forward
+                for (auto& slot : m_index) {
+                    if (slot != 0 && slot_position(slot) > position) --slot;
+                }
+            }
+        }
+
+    public:
+        IndexMap() = default;
+        explicit IndexMap(const Allocator& alloc) : m_entries(alloc), m_index(alloc) {}
+        IndexMap(std::initializer_list<value_type> init, const Allocator& alloc = Allocator())
+            : m_entries(init, alloc), m_index(alloc) { normalize(); }
+        template<std::input_iterator It>
+        IndexMap(It first, It last, const Allocator& alloc = Allocator())
+            : m_entries(first, last, alloc), m_index(alloc) { normalize(); }
+        /**
+         * @brief Adopt a vector of pairs in its order, indexed once, the first of duplicated keys is kept.
+         */
+        explicit IndexMap(container_type items)
+            : m_entries(std::move(items)), m_index(m_entries.get_allocator()) { normalize(); }
+        IndexMap(const IndexMap&) = default;
+        IndexMap(IndexMap&&) noexcept = default;
+        IndexMap(const IndexMap& other, const Allocator& alloc)
+            : m_entries(other.m_entries, alloc), m_index(other.m_index, alloc), m_hash(other.m_hash), m_equal(other.m_equal) {}
+        IndexMap(IndexMap&& other, const Allocator& alloc)
+            : m_entries(std::move(other.m_entries), alloc), m_index(std::move(other.m_index), alloc), m_hash(other.m_hash), m_equal(other.m_equal) {
+            other.m_entries.clear();
+            other.m_index.clear();
+        }
+        IndexMap& operator=(const IndexMap&) = default;
+        IndexMap& operator=(IndexMap&&) noexcept = default;
+
+        [[nodiscard]]
+        allocator_type get_allocator() const noexcept { return m_entries.get_allocator(); }
+
+        [[nodiscard]] iterator begin() noexcept { return m_entries.begin(); }
+        [[nodiscard]] iterator end() noexcept { return m_entries.end(); }
+        [[nodiscard]] const_iterator begin() const noexcept { return m_entries.begin(); }
+        [[nodiscard]] const_iterator end() const noexcept { return m_entries.end(); }
+        [[nodiscard]] const_iterator cbegin() const noexcept { return m_entries.cbegin(); }
+        [[nodiscard]] const_iterator cend() const noexcept { return m_entries.cend(); }
+
+        [[nodiscard]] size_type size() const noexcept { return m_entries.size(); }
+        [[nodiscard]] bool empty() const noexcept { return m_entries.empty(); }
+        /**
+         * @brief The pairs in insertion order.
+         */
+        [[nodiscard]] const container_type& entries() const noexcept { return m_entries; }
+        void reserve(const size_type count) { m_entries.reserve(count); }
+        void clear() noexcept {
+            m_entries.clear();
+            m_index.clear();
+        }
+
+        template<typename K>
+        [[nodiscard]]
+        iterator find(const K& key) {
+            const auto position = find_position(key);
+            return position == npos ? m_entries.end() : m_entries.begin() + static_cast<difference_type>(position);
+        }
+        template<typename K>
+        [[nodiscard]]
+        const_iterator find(const K& key) const {
+            const auto position = find_position(key);
+            return position == npos ? m_entries.end() : m_entries.begin() + static_cast<difference_type>(position);
+        }
+        template<typename K>
+        [[nodiscard]]
+        bool contains(const K& key) const { return find_position(key) != npos; }
+        template<typename K>
+        [[nodiscard]]
+        size_type count(const K& key) const { return contains(key) ? 1 : 0; }
+
+        /**
+         * @throw std::out_of_range if the key does not exist.
+         */
+        template<typename K>
+        [[nodiscard]]
+        T& at(const K& key) {
+            const auto position = find_position(key);
+            if (position == npos) throw std::out_of_range("IndexMap::at: key not found");
+            return m_entries[position].second;
+        }
+        template<typename K>
+        [[nodiscard]]
+        const T& at(const K& key) const {
+            const auto position = find_position(key);
+            if (position == npos) throw std::out_of_range("IndexMap::at: key not found");
+            return m_entries[position].second;
+        }
+
+        template<typename K, typename... Args>
+        std::pair<iterator, bool> try_emplace(K&& key, Args&&... args) {
+            std::uint32_t tag{ 0 };
+            size_type pos{ 0 };
+            if (m_index.empty()) {
+                if (const auto position = find_position(key); position != npos) {
+                    return { m_entries.begin() + static_cast<difference_type>(position), false };
+                }
+            } else {
+                tag = tag_of(m_hash(key));
+                pos = probe(key, tag);
+                if (m_index[pos] != 0) return { m_entries.begin() + static_cast<difference_type>(slot_position(m_index[pos])), false };
+            }
+            m_entries.emplace_back(
+                std::piecewise_construct,
+                std::forward_as_tuple(std::forward<K>(key)),
+                std::forward_as_tuple(std::forward<Args>(args)...)
+            );
+            try {
+                index_back(tag, pos);
+            } catch (...) {
+                m_entries.pop_back();
+                throw;
+            }
+            return { std::prev(m_entries.end()), true };
+        }
+
+        template<typename... Args>
+        std::pair<iterator, bool> emplace(Args&&... args) {
+            value_type item(std::forward<Args>(args)...);
+            return try_emplace(std::move(item.first), std::move(item.second));
+        }
+
+        std::pair<iterator, bool> insert(const value_type& item) { return try_emplace(item.first, item.second); }
+        std::pair<iterator, bool> insert(value_type&& item) { return try_emplace(std::move(item.first), std::move(item.second)); }
+
+        template<typename K, typename V>
+        std::pair<iterator, bool> insert_or_assign(K&& key, V&& value) {
+            auto res = try_emplace(std::forward<K>(key), std::forward<V>(value));
+            if (!res.second) res.first->second = std::forward<V>(value);
+            return res;
+        }
+
+        T& operator[](const Key& key) { return try_emplace(key).first->second; }
+        T& operator[](Key&& key) { return try_emplace(std::move(key)).first->second; }
+
+        /**
+         * @brief Erase and close the gap, the following pairs keep their order.
+         */
+        iterator erase(const const_iterator pos) {
+            const auto position = static_cast<size_type>(pos - m_entries.cbegin());
+            erase_position(position);
+            return m_entries.begin() + static_cast<difference_type>(position);
+        }
+        iterator erase(const iterator pos) { return erase(const_iterator(pos)); }
+        template<typename K>
+        requires (!std::is_convertible_v<const K&, const_iterator>)
+        size_type erase(const K& key) {
+            const auto position = find_position(key);
+            if (position == npos) return 0;
+            erase_position(position);
+            return 1;
+        }
+
+        void swap(IndexMap& other) noexcept {
+            m_entries.swap(other.m_entries);
+            m_index.swap(other.m_index);
+            std::swap(m_hash, other.m_hash);
+            std::swap(m_equal, other.m_equal);
+        }
+
+        /**
+         * @brief Equal if both hold the same keys with equal values, in any order.
+         */
+        [[nodiscard]]
+        bool operator==(const IndexMap& other) const {
+            if (size() != other.size()) return false;
+            for (const auto& [key, value] : m_entries) {
+                const auto position = other.find_position(key);
+                if (position == npos || !(other.m_entries[position].second == value)) return false;
+            }
+            return true;
+        }
+    };
+
+    /**
+     * @brief Table of interned keys, each distinct key text is stored once as a shared immutable atom.
+     * @tparam Key The key string type.
+     * @details
+     * `intern` returns the atom of a text, made on first use. An atom is a `std::shared_ptr<const Key>`,
+     * it stays valid as long as a map holds it, and the table keeps every atom it made until it is cleared or destroyed.
+     * A table is installed for the current thread with KeyScope, AtomMap interns new keys through it.
+     * @note Atoms outlive any document, so their keys live on the global heap, like the keys of ShapeMap.
+     * A table must not be used by several threads at once, its atoms may be shared freely.
+     */
+    template<typename Key>
+    class KeyTable {
+    public:
+        using key_type = Key;
+        using atom_type = std::shared_ptr<const Key>;
+        using size_type = std::size_t;
+
+        /**
+         * @brief Hash of an atom or a text, by the text.
+         */
+        struct hasher {
+            using is_transparent = void;
+            [[nodiscard]]
+            std::size_t operator()(const std::string_view text) const noexcept { return SeededHash{}(text); }
+            [[nodiscard]]
+            std::size_t operator()(const atom_type& atom) const noexcept { return SeededHash{}(std::string_view{ *atom }); }
+        };
+
+        /**
+         * @brief Equality of atoms and texts, two atoms compare their pointers before their text.
+         */
+        struct key_equal {
+            using is_transparent = void;
+            [[nodiscard]]
+            bool operator()(const atom_type& a, const atom_type& b) const noexcept { return a == b || *a == *b; }
+            [[nodiscard]]
+            bool operator()(const atom_type& a, const std::string_view b) const noexcept { return std::string_view{ *a } == b; }
+            [[nodiscard]]
+            bool operator()(const std::string_view a, const atom_type& b) const noexcept { return a == std::string_view{ *b }; }
+        };
+
+    private:
+        std::unordered_set<atom_type, hasher, key_equal> m_atoms;
+
+    public:
+        KeyTable() = default;
+        KeyTable(const KeyTable&) = delete;
+        KeyTable& operator=(const KeyTable&) = delete;
+
+        /**
+         * @brief Make an atom that belongs to no table.
+         */
+        [[nodiscard]]
+        static atom_type make_atom(const std::string_view text) {
+            if constexpr (std::is_constructible_v<typename Key::allocator_type, std::pmr::memory_resource*>) {
+                return std::make_shared<const Key>(text.data(), text.size(), typename Key::allocator_type(std::pmr::new_delete_resource()));
+            } else {
+                return std::make_shared<const Key>(text.data(), text.size());
+            }
+        }
+
+        /**
+         * @brief Get the atom of `text`, made on first use.
+         */
+        [[nodiscard]]
+        atom_type intern(const std::string_view text) {
+            if (const auto it = m_atoms.find(text); it != m_atoms.end()) return *it;
+            return *m_atoms.insert(make_atom(text)).first;
+        }
+
+        /**
+         * @brief The number of distinct keys interned.
+         */
+        [[nodiscard]]
+        size_type size() const noexcept { return m_atoms.size(); }
+
+        /**
+         * @brief Forget every atom, those still held by maps stay valid.
+         */
+        void clear() noexcept { m_atoms.clear(); }
+
+        /**
+         * @brief The table installed on this thread, `nullptr` if there is none.
+         */
+        [[nodiscard]]
+        static KeyTable*& current() noexcept {
+            thread_local KeyTable* table{ nullptr };
+            return table;
+        }
+    };
+
+    /**
+     * @brief RAII guard installing a KeyTable for the current thread.
+     * @details Scopes nest, the destructor restores the previous table.
+     */
+    template<typename Key>
+    class KeyScope {
+        KeyTable<Key>* m_prev;
+    public:
+        explicit KeyScope(KeyTable<Key>& table) noexcept : m_prev(std::exchange(KeyTable<Key>::current(), &table)) {}
+        ~KeyScope() { KeyTable<Key>::current() = m_prev; }
+        KeyScope(const KeyScope&) = delete;
+        KeyScope& operator=(const KeyScope&) = delete;
+    };
+
+    /**
+     * @brief Insertion-ordered map whose keys are interned atoms, shared with every map using the same KeyTable.
+     * @tparam Key The key type.
+     * @tparam T The mapped type.
+     * @tparam Allocator The allocator of `std::pair<Key, T>`, rebound for the pairs of atom and value.
+     * @details
+     * Pairs are kept in an IndexMap with a `KeyTable<Key>::atom_type` in place of the key.
+     * A new key is interned through the KeyTable installed on the thread, or gets an atom of its own without one,
+     * so records with the same field names hold one shared string per name instead of one Str per occurrence.
+     * Lookups by text hash it like IndexMap. Atoms are compared by pointer first,
+     * so copies and maps filled from one table compare their keys without reading them.
+     * Iteration is in insertion order, `*it` is a `std::pair<const Key&, T&>` proxy.
+     */
+    template<
+        typename Key,
+        typename T,
+        typename Allocator = std::allocator<std::pair<Key, T>>
+    >
+    class AtomMap {
+    public:
+        using key_type = Key;
+        using mapped_type = T;
+        using value_type = std::pair<Key, T>;
+        using allocator_type = Allocator;
+        using atom_type = typename KeyTable<Key>::atom_type;
+        using size_type = std::size_t;
+        using difference_type = std::ptrdiff_t;
+
+    private:
+        using entry_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<std::pair<atom_type, T>>;
+        using map_type = IndexMap<atom_type, T, typename KeyTable<Key>::hasher, typename KeyTable<Key>::key_equal, entry_allocator>;
+
+        map_type m_map;
+
+        [[nodiscard]]
+        static atom_type make_atom(const std::string_view text) {
+            if (auto* const table = KeyTable<Key>::current()) return table->intern(text);
+            return KeyTable<Key>::make_atom(text);
+        }
+
+        // atoms are looked up as they are, anything else by its text
+        template<typename K>
+        [[nodiscard]]
+        static decltype(auto) lookup_key(const K& key) noexcept {
+            if constexpr (std::is_same_v<K, atom_type>) return (key);
+            else return std::string_view{ key };
+        }
+
+        template<bool Const>
+        class basic_iterator {
+            friend class AtomMap;
+            template<bool> friend class basic_iterator;
+            using base_iterator = std::conditional_t<Const, typename map_type::const_iterator, typename map_type::iterator>;
+            base_iterator m_it{};
+
+            explicit basic_iterator(const base_iterator it) noexcept : m_it(it) {}
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = std::pair<Key, T>;
+            using difference_type = std::ptrdiff_t;
+            using reference = std::pair<const Key&, std::conditional_t<Const, const T&, T&>>;
+            struct pointer {
+                reference ref;
+                const reference* operator->() const noexcept { return &ref; }
+            };
+
+            basic_iterator() = default;
+            template<bool OtherConst>
+            requires (Const && !OtherConst)
+            basic_iterator(const basic_iterator<OtherConst>& other) noexcept : m_it(other.m_it) {}
+
+            reference operator*() const noexcept { return { *m_it->first, m_it->second }; }
+            pointer operator->() const noexcept { return { **this }; }
+            basic_iterator& operator++() noexcept { ++m_it; return *this; }
+            basic_iterator operator++(int) noexcept { auto tmp = *this; ++m_it; return tmp; }
+            bool operator==(const basic_iterator& other) const noexcept { return m_it == other.m_it; }
+
+            /**
+             * @brief The atom holding the key.
+             */
+            [[nodiscard]]
+            const atom_type& atom() const noexcept { return m_it->first; }
+        };
+
+    public:
+        using iterator = basic_iterator<false>;
+        using const_iterator = basic_iterator<true>;
+        using reference = typename iterator::reference;
+        using const_reference = typename const_iterator::reference;
+
+        AtomMap() = default;
+        explicit AtomMap(const Allocator& alloc) : m_map(entry_allocator(alloc)) {}
+        AtomMap(std::initializer_list<value_type> init, const Allocator& alloc = Allocator()) : m_map(entry_allocator(alloc)) {
+            m_map.reserve(init.size());
+            for (const auto& [key, value] : init) try_emplace(key, value);
+        }
+        template<std::input_iterator It>
+        AtomMap(It first, It last, const Allocator& alloc = Allocator()) : m_map(entry_allocator(alloc)) {
+            for (; first != last; ++first) emplace(*first);
+        }
+        AtomMap(const AtomMap&) = default;
+        AtomMap(AtomMap&&) noexcept = default;
+        AtomMap(const AtomMap& other, const Allocator& alloc) : m_map(other.m_map, entry_allocator(alloc)) {}
+        AtomMap(AtomMap&& other, const Allocator& alloc) : m_map(std::move(other.m_map), entry_allocator(alloc)) {}
+        AtomMap& operator=(const AtomMap&) = default;
+        AtomMap& operator=(AtomMap&&) noexcept = default;
+
+        [[nodiscard]]
+        allocator_type get_allocator() const noexcept { return allocator_type(m_map.get_allocator()); }
+
+        [[nodiscard]] iterator begin() noexcept { return iterator{ m_map.begin() }; }
+        [[nodiscard]] iterator end() noexcept { return iterator{ m_map.end() }; }
+        [[nodiscard]] const_iterator begin() const noexcept { return const_iterator{ m_map.begin() }; }
+        [[nodiscard]] const_iterator end() const noexcept { return const_iterator{ m_map.end() }; }
+        [[nodiscard]] const_iterator cbegin() const noexcept { return begin(); }
+        [[nodiscard]] const_iterator cend() const noexcept { return end(); }
+
+        [[nodiscard]] size_type size() const noexcept { return m_map.size(); }
+        [[nodiscard]] bool empty() const noexcept { return m_map.empty(); }
+        void reserve(const size_type count) { m_map.reserve(count); }
+        void clear() noexcept { m_map.clear(); }
+
+        /**
+         * @brief Lookups accept an atom, compared by pointer first, or anything convertible to `std::string_view`.
+         */
+        template<typename K>
+        [[nodiscard]]
+        iterator find(const K& key) { return iterator{ m_map.find(lookup_key(key)) }; }
+        template<typename K>
+        [[nodiscard]]
+        const_iterator find(const K& key) const { return const_iterator{ m_map.find(lookup_key(key)) }; }
+        template<typename K>
+        [[nodiscard]]
+        bool contains(const K& key) const { return m_map.contains(lookup_key(key)); }
+        template<typename K>
+        [[nodiscard]]
+        size_type count(const K& key) const { return contains(key) ? 1 : 0; }
+
+        /**
+         * @throw std::out_of_range if the key does not exist.
+         */
+        template<typename K>
+        [[nodiscard]]
+        T& at(const K& key) {
+            const auto it = m_map.find(lookup_key(key));
+            if (it == m_map.end()) throw std::out_of_range("AtomMap::at: key not found");
+            return it->second;
+        }
+        template<typename K>
+        [[nodiscard]]
+        const T& at(const K& key) const { return const_cast<AtomMap*>(this)->at(key); }
+
+        /**
+         * @brief Insert if the key is missing, a text is only interned then.
+         */
+        template<typename K, typename... Args>
+        std::pair<iterator, bool> try_emplace(K&& key, Args&&... args) {
+            if constexpr (std::is_same_v<std::remove_cvref_t<K>, atom_type>) {
+                const auto [it, inserted] = m_map.try_emplace(std::forward<K>(key), std::forward<Args>(args)...);
+                return { iterator{ it }, inserted };
+            } else {
+                const std::string_view text{ key };
+                if (const auto it = m_map.find(text); it != m_map.end()) return { iterator{ it }, false };
+                const auto [it, inserted] = m_map.try_emplace(make_atom(text), std::forward<Args>(args)...);
+                return { iterator{ it }, inserted };
+            }
+        }
+
+        template<typename... Args>
+        std::pair<iterator, bool> emplace(Args&&... args) {
+            value_type item(std::forward<Args>(args)...);
+            return try_emplace(std::move(item.first), std::move(item.second));
+        }
+
+        std::pair<iterator, bool> insert(const value_type& item) { return try_emplace(item.first, item.second); }
+        std::pair<iterator, bool> insert(value_type&& item) { return try_emplace(std::move(item.first), std::move(item.second)); }
+
+        template<typename K, typename V>
+        std::pair<iterator, bool> insert_or_assign(K&& key, V&& value) {
+            auto res = try_emplace(std::forward<K>(key), std::forward<V>(value));
+            if (!res.second) res.first->second = std::forward<V>(value);
+            return res;
+        }
+
+        T& operator[](const Key& key) { return try_emplace(key).first->second; }
+        T& operator[](Key&& key) { return try_emplace(key).first->second; }
+
+        iterator erase(const const_iterator pos) { return iterator{ m_map.erase(pos.m_it) }; }
+        iterator erase(const iterator pos) { return erase(const_iterator(pos)); }
+        template<typename K>
+        requires (!std::is_convertible_v<const K&, const_iterator>)
+        size_type erase(const K& key) { return m_map.erase(lookup_key(key)); }
+
+        void swap(AtomMap& other) noexcept { m_map.swap(other.m_map); }
+
+        /**
+         * @brief Equal if both hold the same keys with equal values, in any order.
+         */
+        [[nodiscard]]
+        bool operator==(const AtomMap& other) const {
+            if (size() != other.size()) return false;
+            for (const auto& [atom, value] : m_map) {
+                const auto it = other.m_map.find(atom);
+                if (it == other.m_map.end() || !(it->second == value)) return false;
+            }
+            return true;
+        }
+    };
+
+    /**
+     * @brief Sorted map stored as a B+ tree with nodes of about `node_bytes` bytes.
+     * @tparam Key The key type.
+     * @tparam T The mapped type.
+     * @tparam Compare The key comparison, transparent by default.
+     * @tparam Allocator The allocator of `std::pair<Key, T>`, rebound for the nodes.
+     * @details
+     * Pairs live in the leaves, several to a node, and the leaves are linked for iteration in key order.
+     * Inner nodes hold copies of the separating keys and are searched with binary search,
+     * so a lookup touches one node per level instead of one per comparison.
+     * Building from a vector sorts it only if needed and fills the tree bottom-up without splitting.
+     * Erasure frees nodes that become empty but does not merge underfull siblings.
+     * @note Keys are reachable through non-const iterators but must not be modified.
+     * Insertion and erasure invalidate iterators into the same leaf.
+     */
+    template<
+        typename Key,
+        typename T,
+        typename Compare = std::less<>,
+        typename Allocator = std::allocator<std::pair<Key, T>>
+    >
+    class BTreeMap {
+    public:
+        using key_type = Key;
+        using mapped_type = T;
+        using value_type = std::pair<Key, T>;
+        using key_compare = Compare;
+        using allocator_type = Allocator;
+        using size_type = std::size_t;
+        using difference_type = std::ptrdiff_t;
+        using container_type = std::vector<value_type, Allocator>;
+
+        /**
+         * @brief Target size of a node.
+         */
+        static constexpr size_type node_bytes = 1024;
+
+        /**
+         * @brief Pairs per leaf.
+         */
+        [[nodiscard]]
+        static constexpr size_type leaf_capacity() noexcept { return std::clamp<size_type>(node_bytes / sizeof(value_type), 4, 64); }
+        /**
+         * @brief Keys per inner node, which has one child more.
+         */
+        [[nodiscard]]
+        static constexpr size_type inner_capacity() noexcept { return std::clamp<size_type>(node_bytes / (sizeof(Key) + sizeof(void*)), 4, 64); }
+
+    private:
+        // one spare slot in every node, filled just before the node is split
+        struct leaf_node {
+            size_type count{ 0 };
+            leaf_node* prev{ nullptr };
+            leaf_node* next{ nullptr };
+            alignas(value_type) std::byte storage[sizeof(value_type) * (leaf_capacity() + 1)];
+            [[nodiscard]] value_type* items() noexcept { return reinterpret_cast<value_type*>(storage); }
+        };
+        struct inner_node {
+            size_type count{ 0 };  // keys, the node has count + 1 children
+            void* children[inner_capacity() + 2];
+            alignas(Key) std::byte storage[sizeof(Key) * (inner_capacity() + 1)];
+            [[nodiscard]] Key* keys() noexcept { return reinterpret_cast<Key*>(storage); }
+        };
+
+        using slot_traits = std::allocator_traits<Allocator>;
+        using key_allocator = typename slot_traits::template rebind_alloc<Key>;
+        using key_traits = std::allocator_traits<key_allocator>;
+        using leaf_allocator = typename slot_traits::template rebind_alloc<leaf_node>;
+        using inner_allocator = typename slot_traits::template rebind_alloc<inner_node>;
+
+        static constexpr size_type max_height = 64;
+        using path_type = std::array<std::pair<inner_node*, size_type>, max_height>;
+
+        void* m_root{ nullptr };       // a leaf if m_height is 0
+        leaf_node* m_first{ nullptr };
+        size_type m_height{ 0 };       // inner levels above the leaves
+        size_type m_size{ 0 };
+        [[no_unique_address]] Compare m_comp;
+        [[no_unique_address]] Allocator m_alloc;
+
+        template<bool Const>
+        class basic_iterator {
+            friend class BTreeMap;
+            template<bool> friend class basic_iterator;
+            leaf_node* m_leaf{ nullptr };
+            size_type m_index{ 0 };
+
+            basic_iterator(leaf_node* leaf, const size_type index) noexcept : m_leaf(leaf), m_index(index) {}
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = std::pair<Key, T>;
+            using difference_type = std::ptrdiff_t;
+            using reference = std::conditional_t<Const, const value_type&, value_type&>;
+            using pointer = std::conditional_t<Const, const value_type*, value_type*>;
+
+            basic_iterator() = default;
+            template<bool OtherConst>
+            requires (Const && !OtherConst)
+            basic_iterator(const basic_iterator<OtherConst>& other) noexcept : m_leaf(other.m_leaf), m_index(other.m_index) {}
+
+            reference operator*() const noexcept { return m_leaf->items()[m_index]; }
+            pointer operator->() const noexcept { return m_leaf->items() + m_index; }
+            basic_iterator& operator++() noexcept {
+                if (++m_index == m_leaf->count) {
+                    m_leaf = m_leaf->next;
+                    m_index = 0;
+                }
+                return *this;
+            }
+            basic_iterator operator++(int) noexcept { auto tmp = *this; ++*this; return tmp; }
+            bool operator==(const basic_iterator& other) const noexcept { return m_leaf == other.m_leaf && m_index == other.m_index; }
+        };
+
+    public:
+        using iterator = basic_iterator<false>;
+        using const_iterator = basic_iterator<true>;
+
+    private:
+        [[nodiscard]]
+        leaf_node* new_leaf() {
+            leaf_allocator alloc(m_alloc);
+            auto* const node = std::allocator_traits<leaf_allocator>::allocate(alloc, 1);
+            return ::new (static_cast<void*>(node)) leaf_node;
+        }
+        void free_leaf(leaf_node* const node) noexcept {
+            for (size_type i = 0; i < node->count; ++i) slot_traits::destroy(m_alloc, node->items() + i);
+            leaf_allocator alloc(m_alloc);
+            std::allocator_traits<leaf_allocator>::deallocate(alloc, node, 1);
+        }
+        [[nodiscard]]
+        inner_node* new_inner() {
+            inner_allocator alloc(m_alloc);
+            auto* const node = std::allocator_traits<inner_allocator>::allocate(alloc, 1);
+            return ::new (static_cast<void*>(node)) inner_node;
+        }
+        void free_inner(inner_node* const node) noexcept {
+            key_allocator keys(m_alloc);
+            for (size_type i = 0; i < node->count; ++i) key_traits::destroy(keys, node->keys() + i);
+            inner_allocator alloc(m_alloc);
+            std::allocator_traits<inner_allocator>::deallocate(alloc, node, 1);
+        }
+
+        // frees the inner levels top-down, their depth is bounded by the height
+        void free_subtree(void* const node, const size_type height) noexcept {
+            if (height == 0) return;
+            auto* const inner = static_cast<inner_node*>(node);
+            for (size_type i = 0; i <= inner->count; ++i) free_subtree(inner->children[i], height - 1);
+            free_inner(inner);
+        }
+
+        void release() noexcept {
+            free_subtree(m_root, m_height);
+            for (auto* leaf = m_first; leaf != nullptr; ) {
+                auto* const next = leaf->next;
+                free_leaf(leaf);
+                leaf = next;
+            }
+            m_root = nullptr;
+            m_first = nullptr;
+            m_height = m_size = 0;
+        }
+
+        void steal(BTreeMap& other) noexcept {
+            m_root = std::exchange(other.m_root, nullptr);
+            m_first = std::exchange(other.m_first, nullptr);
+            m_height = std::exchange(other.m_height, 0);
+            m_size = std::exchange(other.m_size, 0);
+        }
+
+        template<typename K>
+        [[nodiscard]]
+        size_type leaf_lower(leaf_node* const leaf, const K& key) const {
+            const auto items = leaf->items();
+            return static_cast<size_type>(std::partition_point(items, items + leaf->count, [&](const value_type& item) {
+                return m_comp(item.first, key);
+            }) - items);
+        }
+
+        template<typename K>
+        [[nodiscard]]
+        bool leaf_match(leaf_node* const leaf, const size_type index, const K& key) const {
+            return index < leaf->count && !m_comp(key, leaf->items()[index].first);
+        }
+
+        // the leaf that would hold `key`, recording the inner nodes and child indices on the way
+        template<typename K>
+        [[nodiscard]]
+        leaf_node* descend(const K& key, path_type* const path = nullptr) const {
+            void* node = m_root;
+            for (size_type level = 0; level < m_height; ++level) {
+                auto* const inner = static_cast<inner_node*>(node);
+                const auto keys = inner->keys();
+                const auto child = static_cast<size_type>(std::partition_point(keys, keys + inner->count, [&](const Key& sep) {
+                    return !m_comp(key, sep);
+                }) - keys);
+                if (path) (*path)[level] = { inner, child };
+                node = inner->children[child];
+            }
+            return static_cast<leaf_node*>(node);
+        }
+
+        void insert_into_parent(path_type& path, size_type level, Key&& separator, void* right) {
+            key_allocator keys(m_alloc);
+            while (true) {
+                if (level == 0) {
+                    auto* const root = new_inner();
+                    key_traits::construct(keys, root->keys(), std::move(separator));
+                    root->children[0] = m_root;
+                    root->children[1] = right;
+                    root->count = 1;
+                    m_root = root;
+                    ++m_height;
+                    return;
+                }
+                --level;
+                auto* const parent = path[level].first;
+                const auto index = path[level].second;
+                const auto pkeys = parent->keys();
+                // open a gap at `index` for the key and at `index + 1` for the child
+                for (size_type i = parent->count; i > index; --i) {
+                    key_traits::construct(keys, pkeys + i, std::move(pkeys[i - 1]));
+                    key_traits::destroy(keys, pkeys + i - 1);
+                }
+                key_traits::construct(keys, pkeys + index, std::move(separator));
+                for (size_type i = parent->count + 1; i > index + 1; --i) parent->children[i] = parent->children[i - 1];
+                parent->children[index + 1] = right;
+                if (++parent->count <= inner_capacity()) return;
+
+                // split, the middle key moves up
+                const size_type mid = parent->count / 2;
+                auto* const sibling = new_inner();
+                for (size_type i = mid + 1; i < parent->count; ++i) {
+                    key_traits::construct(keys, sibling->keys() + (i - mid - 1), std::move(pkeys[i]));
+                    key_traits::destroy(keys, pkeys + i);
+                }
+                for (size_type i = mid + 1; i <= parent->count; ++i) sibling->children[i - mid - 1] = parent->children[i];
+                sibling->count = parent->count - mid - 1;
+                Key promoted(std::move(pkeys[mid]));
+                key_traits::destroy(keys, pkeys + mid);
+                parent->count = mid;
+                // continue one level up with the new sibling
+                separator = std::move(promoted);
+                right = sibling;
+            }
+        }
+
+        // remove the child at path[level] whose subtree became empty
+        void remove_child(path_type& path, size_type level) noexcept {
+            key_allocator keys(m_alloc);
+            while (true) {
+                auto* const parent = path[level].first;
+                const auto index = path[level].second;
+                if (parent->count == 0) {
+                    // its only child is gone
+                    free_inner(parent);
+                    if (level == 0) {
+                        m_root = nullptr;
+                        m_height = 0;
+                        return;
+                    }
+                    --level;
+                    continue;
+                }
+                const auto pkeys = parent->keys();
+                const size_type key_index = index == 0 ? 0 : index - 1;
+                key_traits::destroy(keys, pkeys + key_index);
+                for (size_type i = key_index; i + 1 < parent->count; ++i) {
+                    key_traits::construct(keys, pkeys + i, std::move(pkeys[i + 1]));
+                    key_traits::destroy(keys, pkeys + i + 1);
+                }
+                for (size_type i = index; i < parent->count; ++i) parent->children[i] = parent->children[i + 1];
+                --parent->count;
+                break;
+            }
+            // a root with a single child is replaced by it
+            while (m_height > 0 && static_cast<inner_node*>(m_root)->count == 0) {
+                auto* const root = static_cast<inner_node*>(m_root);
+                m_root = root->children[0];
+                free_inner(root);
+                --m_height;
+            }
+        }
+
+        // erase items()[index] of `leaf`, reached through `path`, returns the position of the next pair
+        iterator erase_at(leaf_node* const leaf, const size_type index, path_type& path) noexcept {
+            const auto items = leaf->items();
+            slot_traits::destroy(m_alloc, items + index);
+            for (size_type i = index; i + 1 < leaf->count; ++i) {
+                slot_traits::construct(m_alloc, items + i, std::move(items[i + 1]));
+                slot_traits::destroy(m_alloc, items + i + 1);
+            }
+            --leaf->count;
+            --m_size;
+            if (index < leaf->count) return { leaf, index };
+            auto* const next = leaf->next;
+            if (leaf->count == 0) {
+                if (leaf->prev) leaf->prev->next = next;
+                else m_first = next;
+                if (next) next->prev = leaf->prev;
+                free_leaf(leaf);
+                if (m_height == 0) m_root = nullptr;
+                else remove_child(path, m_height - 1);
+            }
+            return { next, 0 };
+        }
+
+        // fill an empty tree from `count` sorted, unique pairs, balanced and bottom-up
+        template<typename It, typename Make>
+        void build(It first, const size_type count, Make make) {
+            if (count == 0) return;
+            std::vector<std::pair<void*, const Key*>> level;
+            std::vector<inner_node*> inners;
+            try {
+                const size_type leaves = (count + leaf_capacity() - 1) / leaf_capacity();
+                level.reserve(leaves);
+                leaf_node* prev = nullptr;
+                for (size_type l = 0; l < leaves; ++l) {
+                    auto* const leaf = new_leaf();
+                    leaf->prev = prev;
+                    if (prev) prev->next = leaf;
+                    else m_first = leaf;
+                    prev = leaf;
+                    const size_type fill = count / leaves + (l < count % leaves ? 1 : 0);
+                    for (; leaf->count < fill; ++leaf->count, ++first) {
+                        slot_traits::construct(m_alloc, leaf->items() + leaf->count, make(*first));
+                    }
+                    level.emplace_back(leaf, &leaf->items()->first);
+                }
+                key_allocator keys(m_alloc);
+                while (level.size() > 1) {
+                    const size_type groups = (level.size() + inner_capacity()) / (inner_capacity() + 1);
+                    std::vector<std::pair<void*, const Key*>> upper;
+                    upper.reserve(groups);
+                    size_type index = 0;
+                    for (size_type g = 0; g < groups; ++g) {
+                        const size_type fill = level.size() / groups + (g < level.size() % groups ? 1 : 0);
+                        auto* const inner = new_inner();
+                        inners.push_back(inner);
+                        inner->children[0] = level[index].first;
+                        for (size_type c = 1; c < fill; ++c, ++inner->count) {
+                            key_traits::construct(keys, inner->keys() + inner->count, *level[index + c].second);
+                            inner->children[c] = level[index + c].first;
+                        }
+                        upper.emplace_back(inner, level[index].second);
+                        index += fill;
+                    }
+                    level = std::move(upper);
+                    ++m_height;
+                }
+            } catch (...) {
+                for (auto* const inner : inners) free_inner(inner);
+                m_root = nullptr;
+                m_height = 0;
+                release();
+                throw;
+            }
+            m_root = level.front().first;
+            m_size = count;
+        }
+
+        // sort unless already sorted, the first of equal keys is kept like repeated `std::map::emplace`
+        void adopt(container_type& items) {
+            const auto less = [this](const value_type& a, const value_type& b) { return m_comp(a.first, b.first); };
+            if (!std::ranges::is_sorted(items, less)) std::ranges::stable_sort(items, less);
+            const auto dup = std::ranges::unique(items, [this](const auto& a, const auto& b) {
+                return !m_comp(a.first, b.first) && !m_comp(b.first, a.first);
+            });
+            items.erase(dup.begin(), dup.end());
+            build(items.begin(), items.size(), [](value_type& item) -> value_type&& { return std::move(item); });
+        }
+
+        void assign_from(const BTreeMap& other) {
+            build(other.begin(), other.size(), [](const value_type& item) -> const value_type& { return item; });
+        }
+
+    public:
+        BTreeMap() = default;
+        explicit BTreeMap(const Allocator& alloc) : m_alloc(alloc) {}
+        BTreeMap(std::initializer_list<value_type> init, const Allocator& alloc = Allocator()) : m_alloc(alloc) {
+            container_type items(init, alloc);
+            adopt(items);
+        }
+        template<std::input_iterator It>
+        BTreeMap(It first, It last, const Allocator& alloc = Allocator()) : m_alloc(alloc) {
+            container_type items(first, last, alloc);
+            adopt(items);
+        }
+        /**
+         * @brief Bulk load from a vector, sorted only if it is not already, without any node split.
+         */
+        explicit BTreeMap(container_type items) : m_alloc(items.get_allocator()) { adopt(items); }
+        BTreeMap(const BTreeMap& other)
+            : m_comp(other.m_comp), m_alloc(slot_traits::select_on_container_copy_construction(other.m_alloc)) { assign_from(other); }
+        BTreeMap(BTreeMap&& other) noexcept : m_comp(other.m_comp), m_alloc(std::move(other.m_alloc)) { steal(other); }
+        BTreeMap(const BTreeMap& other, const Allocator& alloc) : m_comp(other.m_comp), m_alloc(alloc) { assign_from(other); }
+        BTreeMap(BTreeMap&& other, const Allocator& alloc) : m_comp(other.m_comp), m_alloc(alloc) {
+            if (m_alloc == other.m_alloc) {
+                steal(other);
+            } else {
+                build(other.begin(), other.size(), [](value_type& item) -> value_type&& { return std::move(item); });
+                other.clear();
+            }
+        }
+        ~BTreeMap() { release(); }
+
+        BTreeMap& operator=(const BTreeMap& other) {
+            if (this != &other) {
+                release();
+                assign_from(other);
+            }
+            return *this;
+        }
+        BTreeMap& operator=(BTreeMap&& other) noexcept(slot_traits::propagate_on_container_move_assignment::value || slot_traits::is_always_equal::value) {
+            if (this == &other) return *this;
+            release();
+            if constexpr (slot_traits::propagate_on_container_move_assignment::value) {
+                m_alloc = std::move(other.m_alloc);
+                steal(other);
+            } else {
+                if (m_alloc == other.m_alloc) {
+                    steal(other);
+                } else {
+                    build(other.begin(), other.size(), [](value_type& item) -> value_type&& { return std::move(item); });
+                    other.clear();
+                }
+            }
+            return *this;
+        }
+
+        [[nodiscard]]
+        allocator_type get_allocator() const noexcept { return m_alloc; }
+
+        [[nodiscard]] iterator begin() noexcept { return { m_first, 0 }; }
+        [[nodiscard]] iterator end() noexcept { return {}; }
+        [[nodiscard]] const_iterator begin() const noexcept { return { m_first, 0 }; }
+        [[nodiscard]] const_iterator end() const noexcept { return {}; }
+        [[nodiscard]] const_iterator cbegin() const noexcept { return begin(); }
+        [[nodiscard]] const_iterator cend() const noexcept { return end(); }
+
+        [[nodiscard]] size_type size() const noexcept { return m_size; }
+        [[nodiscard]] bool empty() const noexcept { return m_size == 0; }
+        /**
+         * @brief Inner levels above the leaves, 0 while the map fits in one leaf.
+         */
+        [[nodiscard]] size_type height() const noexcept { return m_height; }
+        void clear() noexcept { release(); }
+
+        template<typename K>
+        [[nodiscard]]
+        iterator lower_bound(const K& key) {
+            if (!m_root) return end();
+            auto* const leaf = descend(key);
+            const auto index = leaf_lower(leaf, key);
+            return index < leaf->count ? iterator{ leaf, index } : iterator{ leaf->next, 0 };
+        }
+        template<typename K>
+        [[nodiscard]]
+        const_iterator lower_bound(const K& key) const { return const_cast<BTreeMap*>(this)->lower_bound(key); }
+        template<typename K>
+        [[nodiscard]]
+        iterator upper_bound(const K& key) {
+            auto it = lower_bound(key);
+            if (it != end() && !m_comp(key, it->first)) ++it;
+            return it;
+        }
+        template<typename K>
+        [[nodiscard]]
+        const_iterator upper_bound(const K& key) const { return const_cast<BTreeMap*>(this)->upper_bound(key); }
+
+        /**
+         * @brief The pairs whose key starts with `prefix`, in key order.
+         */
+        [[nodiscard]]
+        std::pair<iterator, iterator> prefix_range(const std::string_view prefix) {
+            // the end is the first key not below the shortest string greater than every match
+            std::string bound{ prefix };
+            while (!bound.empty() && static_cast<unsigned char>(bound.back()) == 0xFF) bound.pop_back();
+            if (bound.empty()) return { lower_bound(prefix), end() };
+            bound.back() = static_cast<char>(static_cast<unsigned char>(bound.back()) + 1);
+            return { lower_bound(prefix), lower_bound(std::string_view{ bound }) };
+        }
+        [[nodiscard]]
+        std::pair<const_iterator, const_iterator> prefix_range(const std::string_view prefix) const {
+            return const_cast<BTreeMap*>(this)->prefix_range(prefix);
+        }
+
+        template<typename K>
+        [[nodiscard]]
+        iterator find(const K& key) {
+            if (!m_root) return end();
+            auto* const leaf = descend(key);
+            const auto index = leaf_lower(leaf, key);
+            return leaf_match(leaf, index, key) ? iterator{ leaf, index } : end();
+        }
+        template<typename K>
+        [[nodiscard]]
+        const_iterator find(const K& key) const { return const_cast<BTreeMap*>(this)->find(key); }
+        template<typename K>
+        [[nodiscard]]
+        bool contains(const K& key) const { return find(key) != end(); }
+        template<typename K>
+        [[nodiscard]]
+        size_type count(const K& key) const { return contains(key) ? 1 : 0; }
+
+        /**
+         * @throw std::out_of_range if the key does not exist.
+         */
+        template<typename K>
+        [[nodiscard]]
+        T& at(const K& key) {
+            const auto it = find(key);
+            if (it == end()) throw std::out_of_range("BTreeMap::at: key not found");
+            return it->second;
+        }
+        template<typename K>
+        [[nodiscard]]
+        const T& at(const K& key) const {
+            const auto it = find(key);
+            if (it == end()) throw std::out_of_range("BTreeMap::at: key not found");
+            return it->second;
+        }
+
+        template<typename K, typename... Args>
+        std::pair<iterator, bool> try_emplace(K&& key, Args&&... args) {
+            if (!m_root) {
+                m_first = new_leaf();
+                m_root = m_first;
+            }
+            path_type path;
+            auto* const leaf = descend(key, &path);
+            const auto index = leaf_lower(leaf, key);
+            if (leaf_match(leaf, index, key)) return { iterator{ leaf, index }, false };
+
+            value_type item(std::piecewise_construct,
+                std::forward_as_tuple(std::forward<K>(key)),
+                std::forward_as_tuple(std::forward<Args>(args)...)
+            );
+            const auto items = leaf->items();
+            for (size_type i = leaf->count; i > index; --i) {
+                slot_traits::construct(m_alloc, items + i, std::move(items[i - 1]));
+                slot_traits::destroy(m_alloc, items + i - 1);
+            }
+            slot_traits::construct(m_alloc, items + index, std::move(item));
+            ++leaf->count;
+            ++m_size;
+            if (leaf->count <= leaf_capacity()) return { iterator{ leaf, index }, true };
+
+            // split the leaf, its upper half moves to a new right sibling
+            const size_type mid = leaf->count / 2;
+            auto* const right = new_leaf();
+            for (size_type i = mid; i < leaf->count; ++i) {
+                slot_traits::construct(m_alloc, right->items() + (i - mid), std::move(items[i]));
+                slot_traits::destroy(m_alloc, items + i);
+            }
+            right->count = leaf->count - mid;
+            leaf->count = mid;
+            right->next = leaf->next;
+            right->prev = leaf;
+            if (leaf->next) leaf->next->prev = right;
+            leaf->next = right;
+            insert_into_parent(path, m_height, Key(right->items()->first), right);
+            return { index < mid ? iterator{ leaf, index } : iterator{ right, index - mid }, true };
+        }
+
+        template<typename... Args>
+        std::pair<iterator, bool> emplace(Args&&... args) {
+            value_type item(std::forward<Args>(args)...);
+            return try_emplace(std::move(item.first), std::move(item.second));
+        }
+
+        std::pair<iterator, bool> insert(const value_type& item) { return try_emplace(item.first, item.second); }
+        std::pair<iterator, bool> insert(value_type&& item) { return try_emplace(std::move(item.first), std::move(item.second)); }
+
+        template<typename K, typename V>
+        std::pair<iterator, bool> insert_or_assign(K&& key, V&& value) {
+            auto res = try_emplace(std::forward<K>(key), std::forward<V>(value));
+            if (!res.second) res.first->second = std::forward<V>(value);
+            return res;
+        }
+
+        T& operator[](const Key& key) { return try_emplace(key).first->second; }
+        T& operator[](Key&& key) { return try_emplace(std::move(key)).first->second; }
+
+        iterator erase(const const_iterator pos) {
+            path_type path;
+            std::ignore = descend(pos->first, &path);
+            return erase_at(pos.m_leaf, pos.m_index, path);
+        }
+        iterator erase(const iterator pos) { return erase(const_iterator(pos)); }
+        template<typename K>
+        requires (!std::is_convertible_v<const K&, const_iterator>)
+        size_type erase(const K& key) {
+            if (!m_root) return 0;
+            path_type path;
+            auto* const leaf = descend(key, &path);
+            const auto index = leaf_lower(leaf, key);
+            if (!leaf_match(leaf, index, key)) return 0;
+            erase_at(leaf, index, path);
+            return 1;
+        }
+
+        void swap(BTreeMap& other) noexcept {
+            std::swap(m_root, other.m_root);
+            std::swap(m_first, other.m_first);
+            std::swap(m_height, other.m_height);
+            std::swap(m_size, other.m_size);
+            std::swap(m_comp, other.m_comp);
+            if constexpr (slot_traits::propagate_on_container_swap::value) std::swap(m_alloc, other.m_alloc);
+        }
+
+        [[nodiscard]]
+        bool operator==(const BTreeMap& other) const {
+            return m_size == other.m_size && std::equal(begin(), end(), other.begin());
+        }
+    };
+
+    class TapeDocument;
+    class JsonPointer;
+    class JsonPath;
+
+    /**
+     * @brief A JSON container class that can represent various JSON data types.
+     * @tparam UseOrderedMap  Use `std::map` for JSON objects if true, otherwise use `std::unordered_map`.
+     * @tparam VecAllocator A allocator template for the vector containers, default is `std::allocator`.
+     * @tparam MapAllocator A allocator template for the map/unordered_map containers, default is `std::allocator`.
+     * @tparam StrAllocator A allocator template for the string containers, default is `std::allocator`.
+     * @tparam UseDumpCache Keep the compact serialization of every Arr and Obj, reused by `write` until modified.
+     * @tparam NodeStorage The node representation, `std::variant`, the tagged 16-byte node or its copy-on-write form.
+     * @tparam ObjMap The Obj container, `eStd` follows `UseOrderedMap`.
+     * @note Str is always `std::basic_string< ... >`。
+     */
+    template<
+        bool UseOrderedMap = true,
+        template<typename U> class VecAllocator = std::allocator,
+        template<typename U> class MapAllocator = std::allocator,
+        template<typename U> class StrAllocator = std::allocator,
+        bool UseDumpCache = false,
+        Storage NodeStorage = Storage::eVariant,
+        MapType ObjMap = MapType::eStd
+    >
+    requires requires{
+        typename std::basic_string<char, std::char_traits<char>, StrAllocator<char>>;
+        typename std::vector<int, VecAllocator<int>>;
+        typename std::map<std::string, int, std::less<std::string>, MapAllocator<std::pair<const std::string, int>>>;
+        typename std::unordered_map<std::string, int, std::hash<std::string>, std::equal_to<std::string>, MapAllocator<std::pair<const std::string, int>>>;
+    }
+    class Json : dump_cache<UseDumpCache, std::basic_string<char, std::char_traits<char>, StrAllocator<char>>> {
+    public:
+        /**
+         * @brief Json's Nul Type, must be `std::nullptr_t`.
+         */
+        using Nul = std::nullptr_t;
+        /**
+         * @brief Json's Bol Type, must be `bool`.
+         */
+        using Bol = bool;
+        /**
+         * @brief Json's Num Type, must be `double`.
+         * @note When converted to integers, it will be rounded to the nearest integer.
+         */
+        using Num = double;
+        /**
+         * @brief Json's Str Type, `std::basic_string<char, std::char_traits<char>, StrAllocator<char>>`.
+         * @note default is `std::string`.
+         */
+        using Str = std::basic_string<char, std::char_traits<char>, StrAllocator<char>>;
+        /**
+         * @brief Json's Arr Type, `vector<Json, VecAllocator<Json>>`.
+         * @note default is `std::vector<Json>`.
+         */
+        using Arr = std::vector<Json, VecAllocator<Json>>;
+        /**
+         * @brief Json's Obj Type, `std::map`, `std::unordered_map`, `FlatMap`, `ShapeMap`, `HashMap`, `IndexMap`, `BTreeMap` or `AtomMap`.
+         * @note default is `std::map<std::string, Json>`.
+         */
+        using Obj = std::conditional_t<ObjMap == MapType::eFlat,
+            FlatMap<Str, Json, std::less<>, MapAllocator<std::pair<Str, Json>>>,
+            std::conditional_t<ObjMap == MapType::eShape,
+                ShapeMap<Str, Json, MapAllocator<std::pair<Str, Json>>>,
+                std::conditional_t<ObjMap == MapType::eHash,
+                    HashMap<Str, Json, SeededHash, std::equal_to<>, MapAllocator<std::pair<Str, Json>>>,
+                    std::conditional_t<ObjMap == MapType::eIndex,
+                        IndexMap<Str, Json, SeededHash, std::equal_to<>, MapAllocator<std::pair<Str, Json>>>,
+                        std::conditional_t<ObjMap == MapType::eBTree,
+                            BTreeMap<Str, Json, std::less<>, MapAllocator<std::pair<Str, Json>>>,
+                            std::conditional_t<ObjMap == MapType::eAtom,
+                                AtomMap<Str, Json, MapAllocator<std::pair<Str, Json>>>,
+                                std::conditional_t<UseOrderedMap,
+                                    std::map<Str, Json, std::less<>, MapAllocator<std::pair<const Str, Json>>>,
+                                    std::unordered_map<Str, Json, StringHash, std::equal_to<>, MapAllocator<std::pair<const Str, Json>>>
+                                >
+                            >
+                        >
+                    >
+                >
+            >
+        >;
+
+    protected:
+        std::conditional_t<NodeStorage != Storage::eVariant,
+            compact_storage<Str, Arr, Obj, StrAllocator<Str>, VecAllocator<Arr>, MapAllocator<Obj>, NodeStorage == Storage::eShared>,
+            std::variant<
+                Nul,
+                Bol,
+                Num,
+                Str,
+                Arr,
+                Obj
+            >
+        > m_data { Nul{} };
+
+    private:
+        // shares the string unescaping of the parser
+        friend class TapeDocument;
+        // look keys up with `find_key` and `find_or_insert`
+        friend class JsonPointer;
+        friend class JsonPath;
+
+        /**
+         * @brief Find a key in an Obj without building a temporary Str.
+         * @note Every Obj compares and hashes transparently, the standard maps through `std::less<>`, `StringHash` and `std::equal_to<>`.
+         */
+        template<typename M>
+        [[nodiscard]]
+        static auto find_key(M& obj, const std::string_view key) noexcept {
+            return obj.find(key);
+        }
+
+        /**
+         * @brief Find a key whose `SeededHash` is already known, maps hashed by it skip hashing again.
+         */
+        template<typename M>
+        [[nodiscard]]
+        static auto find_key(M& obj, const std::string_view key, const std::size_t hash) noexcept {
+            if constexpr (requires { requires std::is_same_v<typename M::hasher, SeededHash>; }) {
+                return obj.find(hashed_key{ key, hash });
+            } else {
+                return find_key(obj, key);
+            }
+        }
+
+        /**
+         * @brief Find a key, or insert it with a Nul value, a Str is only built for a missing key.
+         * @details
+         * The maps of this library and `std::map` do it in one lookup.
+         * `std::unordered_map` has no heterogeneous `try_emplace` before C++26, it is searched again on insertion.
+         */
+        [[nodiscard]]
+        static Json& find_or_insert(Obj& obj, const std::string_view key) {
+            if constexpr (ObjMap != MapType::eStd) {
+                return obj.try_emplace(key).first->second;
+            } else if constexpr (UseOrderedMap) {
+                auto it = obj.lower_bound(key);
+                if (it == obj.end() || it->first != key) {
+                    it = obj.emplace_hint(it, std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple());
+                }
+                return it->second;
+            } else {
+                if (const auto it = find_key(obj, key); it != obj.end()) return it->second;
+                return obj.try_emplace(Str(key)).first->second;
+            }
+        }
+
+        /**
+         * @brief Whether Obj iterates in key order, so two objects can be walked side by side.
+         */
+        static constexpr bool sorted_obj = (ObjMap == MapType::eStd && UseOrderedMap)
+            || ObjMap == MapType::eFlat || ObjMap == MapType::eBTree;
+
+        /**
+         * @brief Whether Obj iterates in the order its pairs were inserted, or in key order.
+         */
+        static constexpr bool stable_obj = sorted_obj || ObjMap == MapType::eIndex || ObjMap == MapType::eShape
+            || ObjMap == MapType::eAtom;
+
+        /**
+         * @brief Compare the scalars and sizes of `a` and `b`, queue their container children.
+         */
+        static bool shallow_equal(const Json& a, const Json& b, std::vector<std::pair<const Json*, const Json*>>& pending) {
+            if (a.type() != b.type()) return false;
+            const auto child_equal = [&pending](const Json& x, const Json& y) {
+                if (x.type() != y.type()) return false;
+                if (x.type() != Type::eArr && x.type() != Type::eObj) return shallow_equal(x, y, pending);
+                pending.emplace_back(&x, &y);
+                return true;
+            };
+            switch (a.type()) {
+                case Type::eNul: return true;
+                case Type::eBol: return get<Bol>(a.m_data) == get<Bol>(b.m_data);
+                case Type::eNum: return get<Num>(a.m_data) == get<Num>(b.m_data);
+                case Type::eStr: return get<Str>(a.m_data) == get<Str>(b.m_data);
+                case Type::eArr: {
+                    const auto& x = get<Arr>(a.m_data);
+                    const auto& y = get<Arr>(b.m_data);
+                    if (&x == &y) return true;  // shared node
+                    if (x.size() != y.size()) return false;
+                    for (std::size_t i = 0; i < x.size(); ++i) {
+                        if (!child_equal(x[i], y[i])) return false;
+                    }
+                    return true;
+                }
+                case Type::eObj: {
+                    const auto& x = get<Obj>(a.m_data);
+                    const auto& y = get<Obj>(b.m_data);
+                    if (&x == &y) return true;
+                    if (x.size() != y.size()) return false;
+                    if constexpr (sorted_obj) {
+                        auto it = y.begin();
+                        for (const auto& [key, val] : x) {
+                            const auto& item = *it;
+                            if (!(key == item.first) || !child_equal(val, item.second)) return false;
+                            ++it;
+                        }
+                    } else {
+                        for (const auto& [key, val] : x) {
+                            const auto it = y.find(key);
+                            if (it == y.end() || !child_equal(val, it->second)) return false;
+                        }
+                    }
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /**
+         * @brief `src` itself, with an empty Arr or Obj in place of a container.
+         */
+        [[nodiscard]]
+        static Json shallow_copy(const Json& src) {
+            switch (src.type()) {
+                case Type::eArr: return Json{ Arr{} };
+                case Type::eObj: return Json{ Obj{} };
+                case Type::eStr: return Json{ get<Str>(src.m_data) };
+                case Type::eNum: return Json{ get<Num>(src.m_data) };
+                case Type::eBol: return Json{ Bol{ get<Bol>(src.m_data) } };
+                default: return Json{};
+            }
+        }
+
+        /**
+         * @brief Hash of a whole subtree, equal values hash equal whatever the iteration order of Obj.
+         * @details
+         * Each node adds its own type and scalar mixed with the hash of its path,
+         * so the sum is taken in one pre-order pass from an explicit stack.
+         */
+        [[nodiscard]]
+        static std::uint64_t structural_hash(const Json& root) {
+            constexpr std::uint64_t k1 = 0x9e3779b97f4a7c15, k2 = 0xbf58476d1ce4e5b9, k3 = 0x94d049bb133111eb;
+            std::uint64_t result = 0;
+            std::vector<std::pair<const Json*, std::uint64_t>> pending{ { &root, k1 } };
+            while (!pending.empty()) {
+                const auto [node, path] = pending.back();
+                pending.pop_back();
+                std::uint64_t local = 0;
+                switch (node->type()) {
+                    case Type::eBol: local = get<Bol>(node->m_data) ? 1 : 2; break;
+                    case Type::eNum: {
+                        const Num num = get<Num>(node->m_data);
+                        local = std::bit_cast<std::uint64_t>(num == 0 ? Num{ 0 } : num);    // -0 == 0
+                        break;
+                    }
+                    case Type::eStr: local = SeededHash{}(std::string_view{ get<Str>(node->m_data) }); break;
+                    case Type::eArr: {
+                        const auto& arr = get<Arr>(node->m_data);
+                        local = arr.size();
+                        for (std::size_t i = 0; i < arr.size(); ++i) {
+                            pending.emplace_back(&arr[i], SeededHash::mix(path ^ k2, i ^ k3));
+                        }
+                        break;
+                    }
+                    case Type::eObj: {
+                        const auto& obj = get<Obj>(node->m_data);
+                        local = obj.size();
+                        for (const auto& [key, val] : obj) {
+                            pending.emplace_back(&val, SeededHash::mix(path ^ k3, SeededHash{}(std::string_view{ key }) ^ k2));
+                        }
+                        break;
+                    }
+                    default: break;
+                }
+                result += SeededHash::mix(path ^ k1, (local ^ k2) + static_cast<std::uint64_t>(node->type()));
+            }
+            return result;
+        }
+
+        /**
+         * @brief Deep copy without recursion, one container level at a time from an explicit stack.
+         * @details
+         * Every container is first filled with shallow copies of its children,
+         * then the containers among them are queued, their addresses no longer change.
+         */
+        void copy_from(const Json& other) {
+            std::vector<std::pair<const Json*, Json*>> pending;
+            const Json* src = &other;
+            Json* dst = this;
+            while (true) {
+                switch (src->type()) {
+                    case Type::eArr: {
+                        const auto& from = get<Arr>(src->m_data);
+                        Arr arr;
+                        arr.reserve(from.size());
+                        for (const auto& val : from) arr.push_back(shallow_copy(val));
+                        dst->m_data = std::move(arr);
+                        auto& to = get<Arr>(dst->m_data);
+                        for (std::size_t i = 0; i < from.size(); ++i) {
+                            if (is_nested(from[i])) pending.emplace_back(&from[i], &to[i]);
+                        }
+                    } break;
+                    case Type::eObj: {
+                        const auto& from = get<Obj>(src->m_data);
+                        Obj obj;
+                        if constexpr (ObjMap == MapType::eAtom) {
+                            // the copy shares the atoms instead of interning the keys again
+                            obj.reserve(from.size());
+                            for (auto it = from.begin(); it != from.end(); ++it) obj.try_emplace(it.atom(), shallow_copy(it->second));
+                        } else if constexpr (requires { typename Obj::container_type; }) {
+                            // the backends adopt a vector at once, BTreeMap and FlatMap see it is already sorted
+                            typename Obj::container_type items;
+                            items.reserve(from.size());
+                            for (const auto& [key, val] : from) items.emplace_back(key, shallow_copy(val));
+                            obj = Obj(std::move(items));
+                        } else if constexpr (UseOrderedMap) {
+                            for (const auto& [key, val] : from) obj.emplace_hint(obj.end(), key, shallow_copy(val));
+                        } else {
+                            obj.reserve(from.size());
+                            for (const auto& [key, val] : from) obj.emplace(key, shallow_copy(val));
+                        }
+                        dst->m_data = std::move(obj);
+                        auto& to = get<Obj>(dst->m_data);
+                        if constexpr (stable_obj) {
+                            auto it = to.begin();
+                            for (const auto& item : from) {
+                                if (is_nested(item.second)) pending.emplace_back(&item.second, &(*it).second);
+                                ++it;
+                            }
+                        } else {
+                            for (const auto& [key, val] : from) {
+                                if (is_nested(val)) pending.emplace_back(&val, &to.find(key)->second);
+                            }
+                        }
+                    } break;
+                    case Type::eStr: dst->m_data = get<Str>(src->m_data); break;
+                    case Type::eNum: dst->m_data = get<Num>(src->m_data); break;
+                    case Type::eBol: dst->m_data = get<Bol>(src->m_data); break;
+                    default: break;
+                }
+                if (pending.empty()) return;
+                std::tie(src, dst) = pending.back();
+                pending.pop_back();
+            }
+        }
+
+        /**
+         * @brief Whether `json` is a non-empty Arr or Obj.
+         */
+        [[nodiscard]]
+        static bool is_nested(const Json& json) noexcept {
+            if (json.type() == Type::eArr) return !get<Arr>(json.m_data).empty();
+            if (json.type() == Type::eObj) return !get<Obj>(json.m_data).empty();
+            return false;
+        }
+
+        /**
+         * @brief Levels handled by plain recursive calls when copying, comparing or destroying, deeper ones go to an explicit stack.
+         * @details
+         * The walks over a tree do not share one traversal engine, each keeps the loop its job needs:
+         * - the writers and size counters close a container after its children, they share `walk_frame`;
+         * - copying and `operator==` visit two trees in step, and hashed Obj pair children by lookup rather than by position,
+         *   they recurse up to this limit and continue from `copy_from` and `shallow_equal`;
+         * - `teardown` must not fail, it hands deeper nodes to a list instead of pushing a frame per level.
+         */
+        static constexpr std::size_t nesting_limit = 256;
+
+        /**
+         * @brief Levels below the written value that keep their output with `UseDumpCache`.
+         * @note Every cached level holds its own copy of the bytes below it, deeper containers are written anew.
+         */
+        static constexpr std::size_t dump_cache_depth = 8;
+
+        /**
+         * @brief Items reserved at most from a length prefix of binary input, longer containers grow as they are read.
+         * @note Nested prefixes may each claim the whole remaining input, the cap bounds what each level reserves.
+         */
+        static constexpr std::size_t reserve_limit = 4096;
+
+        /**
+         * @brief While a document is read with `MapType::eAtom`, a KeyTable of its own if the thread has none installed.
+         */
+        class document_keys {
+            std::conditional_t<ObjMap == MapType::eAtom, std::optional<KeyTable<Str>>, Nul> m_table{};
+            std::conditional_t<ObjMap == MapType::eAtom, std::optional<KeyScope<Str>>, Nul> m_scope{};
+        public:
+            document_keys() noexcept {
+                if constexpr (ObjMap == MapType::eAtom) {
+                    if (!KeyTable<Str>::current()) {
+                        m_table.emplace();
+                        m_scope.emplace(*m_table);
+                    }
+                }
+            }
+        };
+
+        /**
+         * @brief Release the container held by this node with bounded recursion.
+         * @details
+         * Children are destroyed recursively up to `nesting_limit` levels below the outermost destructor,
+         * containers further down are moved to a thread-local list which that destructor drains afterwards.
+         * Shared nodes are left alone, other owners still see them.
+         */
+        void teardown() noexcept {
+            thread_local std::size_t depth = 0;
+            thread_local std::vector<Json> deferred;
+            if constexpr (NodeStorage == Storage::eShared) {
+                if (!m_data.unique()) return;
+            }
+            if (depth == nesting_limit) {
+                try {
+                    deferred.push_back(std::move(*this));
+                    return;
+                } catch (...) {
+                    // out of memory, keep recursing
+                }
+            }
+            ++depth;
+            m_data = Nul{};
+            if (depth == 1) {
+                while (!deferred.empty()) {
+                    Json node = std::move(deferred.back());
+                    deferred.pop_back();
+                    // `node` is destroyed here, at most `nesting_limit` levels deep again
+                }
+            }
+            --depth;
+        }
+
+        /**
+         * @brief Drop the cached serialization, called by every non-const access.
+         */
+        constexpr void touch() noexcept {
+            if constexpr (UseDumpCache) this->drop_cache();
+        }
+
+        /**
+         * @brief Drop the cached serialization and stop caching, called by accessors returning a mutable reference.
+         * @note The reference may modify the children later without passing through this node again.
+         */
+        constexpr void expose() noexcept {
+            if constexpr (UseDumpCache) {
+                this->drop_cache();
+                this->m_exposed = true;
+            }
+        }
+
+        /**
+         * @brief Drop the cached serialization of a value replaced as a whole, caching resumes.
+         */
+        constexpr void renew() noexcept {
+            if constexpr (UseDumpCache) {
+                this->drop_cache();
+                this->m_exposed = false;
+            }
+        }
+
+        /**
+         * @brief Unescape a Unicode escape sequence in a string, and move ptr.
+         * @param out The output string to append the unescaped Unicode character to.
+         * @param it The iterator pointing to the current position in the string.
+         * @param end_ptr The end iterator of the string.
+         * @return `true` if the unescape was successful, `false` if it failed.
+         */
+        static bool unescape_unicode_next(
+            Str& out,
+            char_iterator auto& it,
+            const char_iterator auto end_ptr
+        ) noexcept {
+            // it was in `\uABCD`'s `u` position
+            ++it;
+            if (it == end_ptr) return false;
+            // `it` was in `\uXXXX`'s A position
+
+            // move to \uABCD's D position and get hex4 value
+            std::uint32_t code_point{ 0 };
+            {
+                const std::uint8_t d1 = hex_table[static_cast<unsigned char>(*it)];
+                if (d1 == 255) return false; // Invalid if not a hex digit
+                code_point = code_point << 4 | d1;
+
+                ++it; // External `++it` may reduce some instructions
+                if(it == end_ptr) return false; // Invalid if not enough characters
+                const std::uint8_t d2 = hex_table[static_cast<unsigned char>(*it)];
+                if (d2 == 255) return false; // Invalid if not a hex digit
+                code_point = code_point << 4 | d2;
+
+                ++it;
+                if(it == end_ptr) return false; // Invalid if not enough characters
+                const std::uint8_t d3 = hex_table[static_cast<unsigned char>(*it)];
+                if (d3 == 255) return false; // Invalid if not a hex digit
+                code_point = code_point << 4 | d3;
+
+                ++it;
+                if(it == end_ptr) return false; // Invalid if not enough characters
+                const std::uint8_t d4 = hex_table[static_cast<unsigned char>(*it)];
+                if (d4 == 255) return false; // Invalid if not a hex digit
+                code_point = code_point << 4 | d4;
+            }
+            // `it` was in `\uABCD`'s D position and not be `end_ptr`, if hex4_next successful
+
+            // [0xD800 , 0xE000) is agent pair, which is two consecutive \u encoding
+            if (code_point >= 0xD800 && code_point <= 0xDFFF) {
+                // agent pair, must be high agent + low agent
+                // high agent [\uD800, \uDBFF]
+                // low agent [\uDC00, \uDFFF]
+
+                // first char must be high agent
+                if (code_point >= 0xDC00) return false;
+
+                // second char must be low agent
+                ++it;
+                if(it == end_ptr || *it != '\\') return false;
+                ++it;
+                if(it == end_ptr || *it != 'u') return false;
+                ++it;
+                if(it == end_ptr) return false;
+                // `it` was in `\uXXXX`'s A position, and be not end_ptr
+
+                // move to \uABCD's D position and get hex4 value
+                std::uint32_t low_code_point{ 0 };
+                {
+                    const std::uint8_t d1 = hex_table[static_cast<unsigned char>(*it)];
+                    if (d1 == 255) return false; // Invalid if not a hex digit
+                    low_code_point = low_code_point << 4 | d1;
+
+                    ++it; // External `++it` may reduce some instructions
+                    if(it == end_ptr) return false; // Invalid if not enough characters
+                    const std::uint8_t d2 = hex_table[static_cast<unsigned char>(*it)];
+                    if (d2 == 255) return false; // Invalid if not a hex digit
+                    low_code_point = low_code_point << 4 | d2;
+
+                    ++it;
+                    if(it == end_ptr) return false; // Invalid if not enough characters
+                    const std::uint8_t d3 = hex_table[static_cast<unsigned char>(*it)];
+                    if (d3 == 255) return false; // Invalid if not a hex digit
+                    low_code_point = low_code_point << 4 | d3;
+
+                    ++it;
+                    if(it == end_ptr) return false; // Invalid if not enough characters
+                    const std::uint8_t d4 = hex_table[static_cast<unsigned char>(*it)];
+                    if (d4 == 255) return false; // Invalid if not a hex digit
+                    low_code_point = low_code_point << 4 | d4;
+                }
+                if( 0xDFFF < low_code_point ||  low_code_point < 0xDC00 ) return false;
+                // `it` was in `\uABCD`'s D position and not be `end_ptr`, if hex4_next successful
+
+                // combine the agent pair into a single code point
+                code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low_code_point - 0xDC00);
+            }
+
+            // encode the code point to UTF-8
+            if (code_point <= 0x7F) {
+                out.push_back(static_cast<char>(code_point));
+            } else if (code_point <= 0x7FF) {
+                out.push_back(static_cast<char>(code_point >> 6 | 0xC0));
+                out.push_back(static_cast<char>(code_point & 0x3F | 0x80));
+            } else if (code_point <= 0xFFFF) {
+                out.push_back(static_cast<char>(code_point >> 12 | 0xE0));
+                out.push_back(static_cast<char>(code_point >> 6 & 0x3F | 0x80));
+                out.push_back(static_cast<char>(code_point & 0x3F | 0x80));
+            } else if (code_point <= 0x10FFFF) {
+                out.push_back(static_cast<char>(code_point >> 18 | 0xF0));
+                out.push_back(static_cast<char>(code_point >> 12 & 0x3F | 0x80));
+                out.push_back(static_cast<char>(code_point >> 6 & 0x3F | 0x80));
+                out.push_back(static_cast<char>(code_point & 0x3F | 0x80));
+            } else return false;
+            return true;
+        }
+
+        /**
+         * @brief Unescape the string in a JSON string, and move ptr.
+         * @param it The iterator pointing to the current position in the string.
+         * @param end_ptr The end iterator of the string.
+         * @return An expected Str containing the unescaped string, or a ParseError if an error occurred.
+         */
+        static std::optional<Str> unescape_next(
+            char_iterator auto& it,
+            const char_iterator auto end_ptr
+        ) noexcept {
+            Str res;
+            ++it;
+            if constexpr (std::contiguous_iterator<std::remove_cvref_t<decltype(it)>>) {
+                // copy the run before the first quote or escape at once, short keys stay in SSO without allocation
+                auto run = it;
+                while (run != end_ptr && *run != '\"' && *run != '\\') ++run;
+                res.assign(it, run);
+                it = run;
+                if (it != end_ptr && *it == '\"') {
+                    ++it;
+                    return res;
+                }
+            }
+
+            while (it != end_ptr && *it != '\"') {
+                if (*it == '\\') {
+                    ++it;
+                    if (it == end_ptr) return std::nullopt;
+                    switch (*it) {
+                        case '\"': res.push_back('\"'); break;
+                        case '\\': res.push_back('\\'); break;
+                        case 'n':  res.push_back('\n'); break;
+                        case 'r':  res.push_back('\r'); break;
+                        case 't':  res.push_back('\t'); break;
+                        case 'f':  res.push_back('\f'); break;
+                        case 'b':  res.push_back('\b'); break;
+                        case 'u': case 'U': if (!unescape_unicode_next(res, it, end_ptr)) return std::nullopt; break;
+                        default: return std::nullopt;
+                    }
+                // } else if ( *it == '\b' || *it == '\n' || *it == '\f' || *it == '\r' /* || *it == '\t' */) {
+                //     return std::nullopt;
+                } else res.push_back( *it );
+                ++it;
+            }
+            if(it == end_ptr) return std::nullopt;
+            ++it;
+            res.shrink_to_fit();
+            return res;
+        }
+
+        /**
+         * @brief Read a JSON string without escapes in place, and move ptr past it.
+         * @return A view into the input, or `std::nullopt` with `it` unchanged if the string has escapes or the input is not contiguous.
+         */
+        static std::optional<std::string_view> plain_next(
+            char_iterator auto& it,
+            const char_iterator auto end_ptr
+        ) noexcept {
+            if constexpr (std::contiguous_iterator<std::remove_cvref_t<decltype(it)>>) {
+                auto run = std::next(it);
+                while (run != end_ptr && *run != '\"' && *run != '\\') ++run;
+                if (run == end_ptr || *run != '\"') return std::nullopt;
+                const std::string_view res{ std::to_address(std::next(it)), static_cast<std::size_t>(run - std::next(it)) };
+                it = std::next(run);
+                return res;
+            } else {
+                return std::nullopt;
+            }
+        }
+
+        /**
+         * @brief Read a JSON value from the input iterator and create Json Obj.
+         * @param it The iterator pointing to the current position in the input.
+         * @param end_ptr The end iterator of the input.
+         * @param max_depth The maximum depth of nested JSON objects/arrays allowed.
+         * @return An expected Json object containing the parsed JSON value, or a ParseError if an error occurred.
+         */
+        static std::optional<Json> reader(
+            char_iterator auto& it,
+            const char_iterator auto end_ptr,
+            const std::int32_t max_depth
+        ) noexcept {
+            // Check for maximum depth
+            if(max_depth < 0) return std::nullopt;
+            // return value
+            Json json;
+            // Check the first character to determine the type
+            switch (*it) {
+                case '{': {
+                    // Obj type
+                    ++it;
+                    json = Obj{};
+                    auto& object = json.obj();
+                    // FlatMap is sorted once at the end instead of shifting on every insertion,
+                    // ShapeMap looks small objects up by the key text and builds large shapes at once,
+                    // IndexMap adopts the vector as is and builds its index once,
+                    // BTreeMap is bulk loaded without splits, and skips sorting sorted input
+                    constexpr bool collect = ObjMap == MapType::eFlat || ObjMap == MapType::eShape
+                        || ObjMap == MapType::eIndex || ObjMap == MapType::eBTree;
+                    std::conditional_t<collect,
+                        std::vector<std::pair<Str, Json>, MapAllocator<std::pair<Str, Json>>>, Nul
+                    > flat_items{};
+                    // Parse the object
+                    while(it != end_ptr){
+                        // Skip spaces
+                        while (it != end_ptr && std::isspace(*it)) ++it;
+                        if(it == end_ptr || *it == '}') break;
+                        // find key
+                        if (*it != '\"') return std::nullopt;
+                        // ShapeMap stores a key once per shape and AtomMap once per KeyTable, a key already there is not copied
+                        std::optional<std::string_view> key_view;
+                        if constexpr (ObjMap == MapType::eShape || ObjMap == MapType::eAtom) key_view = plain_next(it, end_ptr);
+                        std::optional<Str> key;
+                        if (!key_view) {
+                            key = unescape_next(it, end_ptr);
+                            if(!key) return std::nullopt;
+                        }
+                        // find ':'
+                        while (it != end_ptr && std::isspace(*it)) ++it;
+                        if(it == end_ptr || *it != ':') return std::nullopt;
+                        ++it;
+                        // find value
+                        while (it != end_ptr && std::isspace(*it)) ++it;
+                        if (it == end_ptr) break;
+                        auto value = reader(it, end_ptr, max_depth - 1);
+                        if(!value) return value;
+                        // add to object
+                        if constexpr (ObjMap == MapType::eShape) {
+                            if (flat_items.empty() && object.size() < Obj::max_shared_keys) {
+                                if (key_view) object.try_emplace(*key_view, std::move(*value));
+                                else object.try_emplace(std::move(*key), std::move(*value));
+                            } else {
+                                if (flat_items.empty()) {
+                                    flat_items.reserve(object.size() * 2);
+                                    for (auto&& [k, v] : object) flat_items.emplace_back(k, std::move(v));
+                                    object.clear();
+                                }
+                                if (key_view) flat_items.emplace_back(Str(*key_view), std::move(*value));
+                                else flat_items.emplace_back(std::move(*key), std::move(*value));
+                            }
+                        } else if constexpr (ObjMap == MapType::eAtom) {
+                            if (key_view) object.try_emplace(*key_view, std::move(*value));
+                            else object.try_emplace(std::move(*key), std::move(*value));
+                        } else if constexpr (collect) flat_items.emplace_back(std::move(*key), std::move(*value));
+                        else object.emplace(std::move(*key), std::move(*value));
+
+                        while(it != end_ptr && std::isspace(*it)) ++it;
+                        if(it == end_ptr) break;
+                        if(*it == ',') ++it;
+                        else if(*it != '}') return std::nullopt;
+                    }
+                    if(it == end_ptr) return std::nullopt;
+                    ++it;
+                    if constexpr (ObjMap == MapType::eShape) {
+                        if (!flat_items.empty()) object = Obj(std::move(flat_items));
+                    } else if constexpr (collect) object = Obj(std::move(flat_items));
+                } break;
+                case '[': {
+                    // Arr type
+                    ++it;
+                    json = Arr{};
+                    auto& array = json.arr();
+                    if (it != end_ptr && *it != ']') array.reserve(8);
+                    while(it != end_ptr){
+                        // Skip spaces
+                        while (it != end_ptr && std::isspace(*it)) ++it;
+                        if(it == end_ptr || *it == ']') break;
+                        // find value
+                        auto value = reader(it, end_ptr, max_depth - 1);
+                        if(!value) return value;
+                        // add to array
+                        array.emplace_back(std::move(*value));
+
+                        while(it != end_ptr && std::isspace(*it)) ++it;
+                        if(it == end_ptr) break;
+                        if(*it == ',') ++it;
+                        else if(*it != ']') return std::nullopt;
+                    }
+                    if(it == end_ptr) return std::nullopt;
+                    ++it;
+                    array.shrink_to_fit();
+                } break;
+                case '\"': {
+                    // Str type
+                    auto str = unescape_next(it, end_ptr);
+                    if(!str) return std::nullopt;
+                    json = std::move(*str);
+                } break;
+                case 't': {
+                    // true
+                    if (++it == end_ptr || *it != 'r' ||
+                        ++it == end_ptr || *it != 'u' ||
+                        ++it == end_ptr || *it != 'e'
+                    ) return std::nullopt;
+                    json = Bol{true};
+                    ++it;
+                } break;
+                case 'f': {
+                    // false
+                    if (++it == end_ptr || *it != 'a' ||
+                        ++it == end_ptr || *it != 'l' ||
+                        ++it == end_ptr || *it != 's' ||
+                        ++it == end_ptr || *it != 'e'
+                    ) return std::nullopt;
+                    json = Bol{false};
+                    ++it;
+                } break;
+                case 'n': {
+                    // null
+                    if (++it == end_ptr || *it != 'u' ||
+                        ++it == end_ptr || *it != 'l' ||
+                        ++it == end_ptr || *it != 'l'
+                    ) return std::nullopt;
+                    json = Nul{};
+                    ++it;
+                } break;
+                default: {
+                    // number
+                    std::uint8_t buffer_len{};
+                    char buffer[26];    // Reserve enough space for typical numbers
+                    // std::array<char, 26> buffer;
+
+                    while(buffer_len < 26 && it != end_ptr &&
+                        (std::isdigit(*it)  || *it=='-' || *it=='.' || *it=='e' || *it=='E' || *it=='+')
+                    ) buffer[buffer_len++] = *it++;
+                    if( buffer_len == 0 || buffer_len == 26 ) return std::nullopt;
+
+                    Num value;
+                    if(const auto [ptr, ec] = std::from_chars(buffer, buffer + buffer_len, value);
+                        ec != std::errc{} || ptr != buffer + buffer_len
+                    ) return std::nullopt;
+
+                    json = value;
+                } break;
+            }
+            return json;
+        }
+
+    public:
+        /**
+         * @brief Get the type of the JSON data.
+         * @return The type of the JSON data as a Type enum value.
+         */
+        [[nodiscard]]
+        constexpr Type type() const noexcept { return static_cast<Type>(m_data.index()); }
+
+        /**
+         * @brief Check if the JSON data is of type Nul.
+         */
+        [[nodiscard]]
+        constexpr bool is_nul() const noexcept { return type() == Type::eNul; }
+
+        /**
+         * @brief Check if the JSON data is of type Bol.
+         */
+        [[nodiscard]]
+        constexpr bool is_bol() const noexcept { return type() == Type::eBol; }
+
+        /**
+         * @brief Check if the JSON data is of type Num.
+         */
+        [[nodiscard]]
+        constexpr bool is_num() const noexcept { return type() == Type::eNum; }
+
+        /**
+         * @brief Check if the JSON data is of type Str.
+         */
+        [[nodiscard]]
+        constexpr bool is_str() const noexcept { return type() == Type::eStr; }
+
+        /**
+         * @brief Check if the JSON data is of type Arr.
+         */
+        [[nodiscard]]
+        constexpr bool is_arr() const noexcept { return type() == Type::eArr; }
+
+        /**
+         * @brief Check if the JSON data is of type Obj.
+         */
+        [[nodiscard]]
+        constexpr bool is_obj() const noexcept { return type() == Type::eObj; }
+
+
+        /**
+         * @brief Get a reference to the Nul type.
+         * @throw std::bad_variant_access if the JSON data is not of type Nul.
+         */
+        [[nodiscard]]
+        constexpr Nul& nul() & { expose(); return get<Nul>(m_data); }
+        [[nodiscard]]
+        constexpr Nul&& nul() && { expose(); return get<Nul>(std::move(m_data)); }
+        [[nodiscard]]
+        constexpr const Nul& nul() const & { return get<Nul>(m_data); }
+        [[nodiscard]]
+        constexpr const Nul&& nul() const && { return get<Nul>(std::move(m_data)); }
+
+        /**
+         * @brief Get a reference to the Bol type.
+         * @throw std::bad_variant_access if the JSON data is not of type Bol.
+         */
+        [[nodiscard]]
+        constexpr Bol& bol() & { expose(); return get<Bol>(m_data); }
+        [[nodiscard]]
+        constexpr Bol&& bol() && { expose(); return get<Bol>(std::move(m_data)); }
+        [[nodiscard]]
+        constexpr const Bol& bol() const & { return get<Bol>(m_data); }
+        [[nodiscard]]
+        constexpr const Bol&& bol() const && { return get<Bol>(std::move(m_data)); }
+
+        /**
+         * @brief Get a reference to the Num type.
+         * @throw std::bad_variant_access if the JSON data is not of type Num.
+         */
+        [[nodiscard]]
+        constexpr Num& num() & { expose(); return get<Num>(m_data); }
+        [[nodiscard]]
+        constexpr Num&& num() && { expose(); return get<Num>(std::move(m_data)); }
+        [[nodiscard]]
+        constexpr const Num& num() const & { return get<Num>(m_data); }
+        [[nodiscard]]
+        constexpr const Num&& num() const && { return get<Num>(std::move(m_data)); }
+
+        /**
+         * @brief Get a reference to the Str type.
+         * @throw std::bad_variant_access if the JSON data is not of type Str.
+         */
+        [[nodiscard]]
+        constexpr Str& str() & { expose(); return get<Str>(m_data); }
+        [[nodiscard]]
+        constexpr Str&& str() && { expose(); return get<Str>(std::move(m_data)); }
+        [[nodiscard]]
+        constexpr const Str& str() const & { return get<Str>(m_data); }
+        [[nodiscard]]
+        constexpr const Str&& str() const && { return get<Str>(std::move(m_data)); }
+
+        /**
+         * @brief Get a reference to the Arr type.
+         * @throw std::bad_variant_access if the JSON data is not of type Arr.
+         */
+        [[nodiscard]]
+        constexpr Arr& arr() & { expose(); return get<Arr>(m_data); }
+        [[nodiscard]]
+        constexpr Arr&& arr() && { expose(); return get<Arr>(std::move(m_data)); }
+        [[nodiscard]]
+        constexpr const Arr& arr() const & { return get<Arr>(m_data); }
+        [[nodiscard]]
+        constexpr const Arr&& arr() const && { return get<Arr>(std::move(m_data)); }
+
+        /**
+         * @brief Get a reference to the Obj type.
+         * @throw std::bad_variant_access if the JSON data is not of type Obj.
+         */
+        [[nodiscard]]
+        constexpr Obj& obj() & { expose(); return get<Obj>(m_data); }
+        [[nodiscard]]
+        constexpr Obj&& obj() && { expose(); return get<Obj>(std::move(m_data)); }
+        [[nodiscard]]
+        constexpr const Obj& obj() const & { return get<Obj>(m_data); }
+        [[nodiscard]]
+        constexpr const Obj&& obj() const && { return get<Obj>(std::move(m_data)); }
+
+        /**
+         * @brief Default constructor for Json, data is Nul type.
+         */
+        constexpr Json() noexcept = default;
+        /**
+         * @brief Destructor for Json, nested containers are released without recursion.
+         */
+        ~Json() noexcept {
+            if (type() == Type::eArr || type() == Type::eObj) teardown();
+        }
+        /**
+         * @brief Copy constructor for Json, deep copy with bounded recursion.
+         * @note With `Storage::eShared` the copy shares the nodes instead.
+         */
+        Json(const Json& other) noexcept : dump_cache<UseDumpCache, Str>{} {
+            if constexpr (NodeStorage == Storage::eShared) {
+                m_data = other.m_data;
+            } else {
+                // containers copy their children through this constructor,
+                // past `nesting_limit` levels the rest of the value is copied from an explicit stack
+                thread_local std::size_t depth = 0;
+                if (depth == nesting_limit) {
+                    copy_from(other);
+                    return;
+                }
+                ++depth;
+                m_data = other.m_data;
+                --depth;
+            }
+        }
+        /**
+         * @brief Copy assignment operator for Json, copies like the copy constructor.
+         */
+        Json& operator=(const Json& other) noexcept {
+            if (this != &other) *this = Json(other);
+            return *this;
+        }
+
+        /**
+         * @brief Move constructor for Json, transfers ownership of data.
+         * @param other The Json object to move from, will be set to Nul.
+         */
+        Json(Json&& other) noexcept {
+            m_data = std::move(other.m_data);
+            other.m_data = Nul{};
+            if constexpr (UseDumpCache) this->take_cache(other);
+        }
+        /**
+         * @brief Move assignment operator for Json, transfers ownership of data.
+         * @param other The Json object to move from, will be set to Nul.
+         */
+        Json& operator=(Json&& other) noexcept {
+            if (this == &other) return *this;
+            m_data = std::move(other.m_data);
+            other.m_data = Nul{};
+            if constexpr (UseDumpCache) this->take_cache(other);
+            return *this;
+        }
+
+        /**
+         * @brief Constructor for Json that accepts various types and converts them to Json.
+         * @tparam T The type of the other object to convert to Json.
+         * @param other The object to convert to Json.
+         */
+        template<typename T>
+        requires constructible<Json, std::remove_cvref_t<T>>
+        Json(T&& other) noexcept {
+            if constexpr(std::is_same_v<T, Nul>) {
+                m_data = Nul{};
+            } else if constexpr(std::is_same_v<T, Bol>) {
+                m_data = other;
+            } else if constexpr(std::is_same_v<T, Num>) {
+                m_data = other;
+            } else if constexpr(std::is_same_v<T, Str>) {
+                m_data = std::forward<T>(other);
+            } else if constexpr(std::is_same_v<T, Arr>) {
+                m_data = std::forward<T>(other);
+            } else if constexpr(std::is_same_v<T, Obj>) {
+                m_data = std::forward<T>(other);
+            } else if constexpr(std::is_arithmetic_v<T> || std::is_enum_v<T>) {
+                m_data = static_cast<Num>(other);
+            } else if constexpr(std::is_convertible_v<T, Str>) {
+                m_data = static_cast<Str>(std::forward<T>(other));
+            } else if constexpr(std::is_convertible_v<T, Obj>) {
+                m_data = static_cast<Obj>(std::forward<T>(other));
+            } else if constexpr(std::is_convertible_v<T,Arr>) {
+                m_data = static_cast<Arr>(std::forward<T>(other));
+            } else if constexpr(std::is_convertible_v<T,Num>) {
+                m_data = static_cast<Num>(std::forward<T>(other));
+            } else if constexpr(std::is_convertible_v<T,Bol>) {
+                m_data = static_cast<Bol>(std::forward<T>(other));
+            } else {
+                m_data = Nul{};
+            }
+        }
+
+        /**
+         * @brief Assignment operator for Json that accepts various types and converts them to Json.
+         * @tparam T The type of the other object to convert to Json.
+         * @param other The object to convert to Json.
+         */
+        template<typename T>
+        requires constructible<Json, std::remove_cvref_t<T>>
+        Json& operator=(T&& other) noexcept {
+            renew();
+            if constexpr(std::is_same_v<T, Nul>) {
+                m_data = Nul{};
+            } else if constexpr(std::is_same_v<T, Bol>) {
+                m_data = other;
+            } else if constexpr(std::is_same_v<T, Num>) {
+                m_data = other;
+            } else if constexpr(std::is_same_v<T, Str>) {
+                m_data = std::forward<T>(other);
+            } else if constexpr(std::is_same_v<T, Arr>) {
+                m_data = std::forward<T>(other);
+            } else if constexpr(std::is_same_v<T, Obj>) {
+                m_data = std::forward<T>(other);
+            } else if constexpr(std::is_arithmetic_v<T> || std::is_enum_v<T>) {
+                m_data = static_cast<Num>(other);
+            } else if constexpr(std::is_convertible_v<T, Str>) {
+                m_data = static_cast<Str>(std::forward<T>(other));
+            } else if constexpr(std::is_convertible_v<T, Obj>) {
+                m_data = static_cast<Obj>(std::forward<T>(other));
+            } else if constexpr(std::is_convertible_v<T,Arr>) {
+                m_data = static_cast<Arr>(std::forward<T>(other));
+            } else if constexpr(std::is_convertible_v<T,Num>) {
+                m_data = static_cast<Num>(std::forward<T>(other));
+            } else if constexpr(std::is_convertible_v<T,Bol>) {
+                m_data = static_cast<Bol>(std::forward<T>(other));
+            } else {
+                m_data = Nul{};
+            }
+            return *this;
+        }
+
+        /**
+         * @brief Constructor for Json that accepts array-like types and converts them to Json.
+         * @tparam T The type of the other object to convert to Json.
+         * @param other The object to convert to Json.
+         */
+        template<typename T>
+        requires !constructible<Json, std::remove_cvref_t<T>> && !constructible_map<Json, std::remove_cvref_t<T>> && constructible_array<Json, std::remove_cvref_t<T>>
+        explicit Json(T&& other) noexcept : m_data( Arr{} ) {
+            auto& arr = get<Arr>(m_data);
+            for (auto&& item : std::forward<T>(other)) {
+                arr.emplace_back( static_cast<Json>(static_cast<typename std::remove_cvref_t<T>::value_type>( std::forward<decltype(item)>(item))));
+            }
+        }
+
+        /**
+         * @brief Constructor for Json that accepts map-like types and converts them to Json.
+         * @tparam T The type of the other object to convert to Json.
+         * @param other The object to convert to Json.
+         */
+        template<typename T>
+        requires !constructible<Json, std::remove_cvref_t<T>> && constructible_map<Json, std::remove_cvref_t<T>>
+        explicit Json(T&& other) noexcept : m_data( Obj{} ) {
+            auto& obj = get<Obj>(m_data);
+            for (auto&& [key, val] : std::forward<T>(other)) {
+                obj.emplace( static_cast<Str>(key), static_cast<Json>(static_cast<typename std::remove_cvref_t<T>::mapped_type>(std::forward<decltype(val)>(val))) );
+            }
+        }
+
+        /**
+         * @brief Assignment operator for maps of Json whose comparator or hash differ from Obj, such as `std::map<std::string, Json>`.
+         * @tparam T The type of the map.
+         * @param other The map to convert to Json.
+         */
+        template<typename T>
+        requires !constructible<Json, std::remove_cvref_t<T>> && constructible_map<Json, std::remove_cvref_t<T>>
+            && std::is_same_v<typename std::remove_cvref_t<T>::mapped_type, Json>
+        Json& operator=(T&& other) noexcept {
+            return *this = Json(std::forward<T>(other));
+        }
+
+        /**
+         * @brief Reset the JSON data to a specific type.
+         * @tparam T The type to reset the JSON data to, defaults to Nul.
+         */
+        template<typename T = Nul>
+        requires json_type<Json, T>
+        void reset() noexcept {
+            renew();
+            if constexpr(std::is_same_v<T, Nul>) {
+                m_data = Nul{};
+            } else if constexpr(std::is_same_v<T, Bol>) {
+                m_data = Bol{};
+            } else if constexpr(std::is_same_v<T, Num>) {
+                m_data = Num{};
+            } else if constexpr(std::is_same_v<T, Str>) {
+                m_data = Str{};
+            } else if constexpr(std::is_same_v<T, Arr>) {
+                m_data = Arr{};
+            } else if constexpr(std::is_same_v<T, Obj>) {
+                m_data = Obj{};
+            }
+        }
+
+        /**
+         * @brief Forget the JSON data without destroying it, the value becomes Nul.
+         * @warning
+         * Nothing is freed and no destructor runs. Only for documents whose memory is released in one go,
+         * such as a `pmr::Json` built inside a MemoryScope over a `std::pmr::monotonic_buffer_resource`,
+         * the resource must outlive this call and be released afterwards. Anywhere else the memory leaks.
+         * @note Only available when Str, Arr and Obj allocate from a `std::pmr::memory_resource`, e.g. `pmr::Json`.
+         */
+        void discard() noexcept
+        requires std::is_constructible_v<StrAllocator<char>, std::pmr::memory_resource*>
+            && std::is_constructible_v<VecAllocator<Json>, std::pmr::memory_resource*>
+            && std::is_constructible_v<MapAllocator<std::pair<const Str, Json>>, std::pmr::memory_resource*> {
+            renew();
+            std::construct_at(std::addressof(m_data));
+        }
+
+        /**
+         * @brief Accessor for JSON data using the subscript operator.
+         * @note Key lookups do not allocate, a Str is only created when a missing key is inserted.
+         */
+        [[nodiscard]]
+        Json& operator[](const std::string_view key) {
+            expose();
+            return find_or_insert(get<Obj>(m_data), key);
+        }
+        [[nodiscard]]
+        const Json& operator[](const std::string_view key) const { return at(key); }
+        [[nodiscard]]
+        Json& operator[](const std::size_t index) { expose(); return get<Arr>(m_data)[index]; }
+        [[nodiscard]]
+        const Json& operator[](const std::size_t index) const { return get<Arr>(m_data).at(index); }
+
+        /**
+         * @brief Accessor for JSON data using the at() method.
+         * @throw std::out_of_range if the key or index does not exist.
+         */
+        [[nodiscard]]
+        Json& at(const std::string_view key) {
+            expose();
+            auto& obj = get<Obj>(m_data);
+            const auto it = find_key(obj, key);
+            if (it == obj.end()) throw std::out_of_range("Json::at: key not found");
+            return it->second;
+        }
+        [[nodiscard]]
+        const Json& at(const std::string_view key) const {
+            const auto& obj = get<Obj>(m_data);
+            const auto it = find_key(obj, key);
+            if (it == obj.end()) throw std::out_of_range("Json::at: key not found");
+            return it->second;
+        }
+        [[nodiscard]]
+        Json& at(const std::size_t index) { expose(); return get<Arr>(m_data).at(index); }
+        [[nodiscard]]
+        const Json& at(const std::size_t index) const { return get<Arr>(m_data).at(index); }
+
+        /**
+         * @brief Write the JSON data to a sink.
+         * @tparam S The sink type, e.g. `Str`, `FixedBufferSink`, `FdSink`, `ChunkSink`.
+         * @note If `UseDumpCache`, Arr and Obj keep their output and reuse it until modified,
+         * except for values that handed out a mutable reference and the ones more than `dump_cache_depth` levels down.
+         */
+        template<output_sink S>
+        void write(S& out) const {
+            if constexpr (UseDumpCache) {
+                if ((type() == Type::eObj || type() == Type::eArr) && !this->m_exposed) {
+                    const Str* cache = this->cached();
+                    if (!cache) {
+                        auto fragment = std::make_unique<Str>();
+                        write_data(*fragment);
+                        cache = &this->publish(std::move(fragment));
+                    }
+                    out.append(cache->data(), cache->size());
+                    return;
+                }
+            }
+            write_data(out);
+        }
+
+        /**
+         * @brief Write the JSON data to an output stream.
+         */
+        void write(std::ostream& out) const {
+            if(out.fail()) return;
+            StreamSink sink{ out };
+            this->write(sink);
+        }
+
+    private:
+        /**
+         * @brief Write a Nul, Bol, Num or Str.
+         */
+        template<output_sink S>
+        void write_scalar(S& out) const {
+            switch (type()) {
+                case Type::eBol:
+                    if (get<Bol>(m_data)) out.append("true", 4);
+                    else out.append("false", 5);
+                    break;
+                case Type::eNul:
+                    out.append("null", 4);
+                    break;
+                case Type::eStr:
+                    escape_to<true>(out, get<Str>(m_data));
+                    break;
+                case Type::eNum:
+                    number_to(out, get<Num>(m_data));
+                    break;
+                default: break;
+            }
+        }
+
+        /**
+         * @brief Position inside an Arr or Obj during the non-recursive walks.
+         */
+        struct walk_frame {
+            const Json* node;
+            typename Obj::const_iterator obj_it{};
+            std::size_t arr_index{ 0 };
+            bool first{ true };
+            // the container's own output, kept as its cache when it is closed, empty if it is not cached
+            [[no_unique_address]] std::conditional_t<UseDumpCache, std::unique_ptr<Str>, Nul> fragment{};
+            // the innermost fragment of this frame and its parents, `nullptr` for the sink itself
+            [[no_unique_address]] std::conditional_t<UseDumpCache, Str*, Nul> target{};
+
+            explicit walk_frame(const Json* json) noexcept : node(json) {
+                if (json->type() == Type::eObj) obj_it = get<Obj>(json->m_data).begin();
+            }
+
+            /**
+             * @brief Advance to the next child, `nullptr` once the container is exhausted.
+             */
+            const Json* next(const Str*& key) {
+                if (node->type() == Type::eObj) {
+                    if (obj_it == get<Obj>(node->m_data).end()) return nullptr;
+                    const auto& item = *obj_it;
+                    key = &item.first;
+                    const Json* child = &item.second;
+                    ++obj_it;
+                    return child;
+                }
+                const auto& arr = get<Arr>(node->m_data);
+                if (arr_index == arr.size()) return nullptr;
+                key = nullptr;
+                return &arr[arr_index++];
+            }
+        };
+
+        /**
+         * @brief Write the JSON data to a sink, nesting is tracked on an explicit stack.
+         * @note If `UseDumpCache`, cached children are appended as is and the others get their cache filled.
+         */
+        template<output_sink S>
+        void write_data(S& out) const {
+            if (type() != Type::eArr && type() != Type::eObj) {
+                write_scalar(out);
+                return;
+            }
+            std::vector<walk_frame> stack;
+            stack.reserve(16);
+            stack.emplace_back(this);
+            // below the root, a cached container writes into its own fragment first
+            const auto emit = [&](auto&& write) {
+                if constexpr (UseDumpCache) {
+                    if (Str* const fragment = stack.back().target) {
+                        write(*fragment);
+                        return;
+                    }
+                }
+                write(out);
+            };
+            out.push_back(type() == Type::eObj ? '{' : '[');
+            while (!stack.empty()) {
+                auto& top = stack.back();
+                const Str* key = nullptr;
+                const Json* child = top.next(key);
+                if (!child) {
+                    const char close = top.node->type() == Type::eObj ? '}' : ']';
+                    emit([close](auto& sink) { sink.push_back(close); });
+                    if constexpr (UseDumpCache) {
+                        if (top.fragment) {
+                            auto fragment = std::move(top.fragment);
+                            const Json* node = top.node;
+                            stack.pop_back();
+                            const Str& bytes = node->publish(std::move(fragment));
+                            emit([&bytes](auto& sink) { sink.append(bytes.data(), bytes.size()); });
+                            continue;
+                        }
+                    }
+                    stack.pop_back();
+                    continue;
+                }
+                const bool first = std::exchange(top.first, false);
+                emit([first, key](auto& sink) {
+                    if (!first) sink.push_back(',');
+                    if (key) {
+                        escape_to<true>(sink, *key);
+                        sink.push_back(':');
+                    }
+                });
+                if (child->type() != Type::eArr && child->type() != Type::eObj) {
+                    emit([child](auto& sink) { child->write_scalar(sink); });
+                    continue;
+                }
+                if constexpr (UseDumpCache) {
+                    if (const Str* cache = child->cached()) {
+                        emit([cache](auto& sink) { sink.append(cache->data(), cache->size()); });
+                        continue;
+                    }
+                }
+                stack.emplace_back(child);
+                if constexpr (UseDumpCache) {
+                    auto& frame = stack.back();
+                    frame.target = stack[stack.size() - 2].target;
+                    if (!child->m_exposed && stack.size() <= dump_cache_depth) {
+                        frame.fragment = std::make_unique<Str>();
+                        frame.target = frame.fragment.get();
+                    }
+                }
+                const char open = child->type() == Type::eObj ? '{' : '[';
+                emit([open](auto& sink) { sink.push_back(open); });
+            }
+        }
+
+    public:
+        /**
+         * @brief Dump the JSON data to a string.
+         */
+        [[nodiscard]]
+        Str dump() const noexcept {
+            Str res;
+            this->write(res);
+            return res;
+        }
+
+        /**
+         * @brief Get the exact length of `dump()` without building the string.
+         * @return The number of bytes `write` would produce.
+         * @note This is a full serialization pass, `dump()` does not call it.
+         */
+        [[nodiscard]]
+        std::size_t dump_size() const noexcept {
+            size_counter counter;
+            this->write(counter);
+            return counter.size;
+        }
+
+        /**
+         * @brief Dump the JSON data to a string, serializing the children of a top-level Arr or Obj on several threads.
+         * @param thread_count The number of threads to use, 0 means `std::thread::hardware_concurrency()`.
+         * @return A string equal to `dump()`.
+         * @throw The first exception thrown by a thread, after all of them have finished.
+         * @details
+         * 1. The serialized size of every child is computed in parallel.
+         * 2. The result is allocated once, and every child gets its exact offset.
+         * 3. Children are split into ranges of similar byte size, each thread writes its range in place.
+         * The same threads run both passes, they meet at a barrier in between.
+         */
+        [[nodiscard]]
+        Str dump_parallel(std::size_t thread_count = 0) const {
+            if (thread_count == 0) thread_count = std::max(1u, std::thread::hardware_concurrency());
+            // key is nullptr for array elements
+            std::vector<std::pair<const Str*, const Json*>> items;
+            if (type() == Type::eArr) {
+                items.reserve(get<Arr>(m_data).size());
+                for (const auto& val : get<Arr>(m_data)) items.emplace_back(nullptr, &val);
+            } else if (type() == Type::eObj) {
+                items.reserve(get<Obj>(m_data).size());
+                for (const auto& [key, val] : get<Obj>(m_data)) items.emplace_back(&key, &val);
+            }
+            thread_count = std::min(thread_count, items.size());
+            if (thread_count < 2) return dump();
+
+            std::vector<std::size_t> bounds(thread_count + 1);
+            for (std::size_t i = 0; i <= thread_count; ++i) bounds[i] = items.size() * i / thread_count;
+            std::vector<std::size_t> sizes(items.size());
+            std::vector<std::size_t> offsets(items.size());
+            std::vector<std::exception_ptr> errors(thread_count + 1);
+            Str res;
+            bool failed{ false };
+
+            // 2. between the passes, on one thread: offsets, one bracket before and one comma between children,
+            // then split by bytes and allocate the result
+            const auto layout = [&]() noexcept {
+                failed = std::ranges::any_of(errors, [](const std::exception_ptr& error) { return bool(error); });
+                if (failed) return;
+                std::size_t total = 1;
+                for (std::size_t i = 0; i < items.size(); ++i) {
+                    if (i != 0) ++total;
+                    offsets[i] = total;
+                    total += sizes[i];
+                }
+                ++total;
+                for (std::size_t i = 1, k = 0; i < thread_count; ++i) {
+                    const std::size_t target = total * i / thread_count;
+                    while (k < items.size() && offsets[k] < target) ++k;
+                    bounds[i] = std::max(k, bounds[i - 1]);
+                }
+                try {
+                    res.resize(total);
+                } catch (...) {
+                    errors.back() = std::current_exception();
+                    failed = true;
+                    return;
+                }
+                res.front() = type() == Type::eObj ? '{' : '[';
+                res.back() = type() == Type::eObj ? '}' : ']';
+            };
+            std::barrier sync{ static_cast<std::ptrdiff_t>(thread_count), layout };
+
+            // every thread runs both passes on its part, an exception is kept and rethrown after the join
+            const auto run = [&](const std::size_t part) {
+                try {
+                    // 1. size pre-pass, key and ':' included
+                    for (std::size_t i = bounds[part]; i < bounds[part + 1]; ++i) {
+                        size_counter counter;
+                        if (items[i].first) {
+                            escape_to(counter, *items[i].first);
+                            counter.push_back(':');
+                        }
+                        items[i].second->write(counter);
+                        sizes[i] = counter.size;
+                    }
+                } catch (...) {
+                    errors[part] = std::current_exception();
+                }
+                sync.arrive_and_wait();
+                if (failed) return;
+                try {
+                    // 3. write in place
+                    for (std::size_t i = bounds[part]; i < bounds[part + 1]; ++i) {
+                        if (i != 0) res[offsets[i] - 1] = ',';
+                        FixedBufferSink sink{ res.data() + offsets[i], sizes[i] };
+                        if (items[i].first) {
+                            escape_to(sink, *items[i].first);
+                            sink.push_back(':');
+                        }
+                        items[i].second->write(sink);
+                    }
+                } catch (...) {
+                    errors[part] = std::current_exception();
+                }
+            };
+            {
+                std::vector<std::jthread> workers;
+                workers.reserve(thread_count - 1);
+                for (std::size_t part = 0; part + 1 < thread_count; ++part) {
+                    try {
+                        workers.emplace_back(run, part);
+                    } catch (...) {
+                        // the part is left undone, its arrival is dropped so the others are not blocked
+                        errors[part] = std::current_exception();
+                        sync.arrive_and_drop();
+                    }
+                }
+                run(thread_count - 1);
+            }
+            for (const auto& error : errors) {
+                if (error) std::rethrow_exception(error);
+            }
+            return res;
+        }
+
+        /**
+         * @brief Write the JSON data to a sink with formatting.
+         * @param out The sink to write to.
+         * @param space_num The number of spaces to use for indentation (default is 2).
+         * @param depth The current depth of indentation (default is 0).
+         */
+        template<output_sink S>
+        void writef(
+            S& out,
+            const std::uint16_t space_num = 2,
+            const std::uint16_t depth = 0
+        ) const {
+            if (type() != Type::eArr && type() != Type::eObj) {
+                write_scalar(out);
+                return;
+            }
+            std::vector<walk_frame> stack;
+            stack.reserve(16);
+            stack.emplace_back(this);
+            out.push_back(type() == Type::eObj ? '{' : '[');
+            while (!stack.empty()) {
+                auto& top = stack.back();
+                // indentation of the children of `top`
+                const std::size_t tabs = (depth + stack.size()) * static_cast<std::size_t>(space_num);
+                const Str* key = nullptr;
+                const Json* child = top.next(key);
+                if (!child) {
+                    if (!top.first) {
+                        out.push_back('\n');
+                        indent_to(out, tabs - space_num);
+                    }
+                    out.push_back(top.node->type() == Type::eObj ? '}' : ']');
+                    stack.pop_back();
+                    continue;
+                }
+                if (!std::exchange(top.first, false)) out.push_back(',');
+                out.push_back('\n');
+                indent_to(out, tabs);
+                if (key) {
+                    escape_to<true>(out, *key);
+                    out.append(": ", 2);
+                }
+                if (child->type() != Type::eArr && child->type() != Type::eObj) {
+                    child->write_scalar(out);
+                    continue;
+                }
+                stack.emplace_back(child);
+                out.push_back(child->type() == Type::eObj ? '{' : '[');
+            }
+        }
+
+        /**
+         * @brief Write the JSON data to an output stream with formatting.
+         * @param out The output stream to write to.
+         * @param space_num The number of spaces to use for indentation (default is 2).
+         * @param depth The current depth of indentation (default is 0).
+         */
+        void writef(
+            std::ostream& out,
+            const std::uint16_t space_num = 2,
+            const std::uint16_t depth = 0
+        ) const {
+            if(out.fail()) return;
+            StreamSink sink{ out };
+            this->writef(sink, space_num, depth);
+        }
+
+        /**
+         * @brief Dump the JSON data to a string with formatting.
+         * @param space_num The number of spaces to use for indentation (default is 2).
+         * @param depth The current depth of indentation (default is 0).
+         * @return A string containing the formatted JSON data.
+         */
+        [[nodiscard]]
+        Str dumpf(
+            const std::uint16_t space_num = 2,
+            const std::uint16_t depth = 0
+        ) const noexcept {
+            Str res;
+            this->writef(res, space_num, depth);
+            return res;
+        }
+
+        /**
+         * @brief Get the exact length of `dumpf(space_num, depth)` without building the string.
+         * @param space_num The number of spaces to use for indentation (default is 2).
+         * @param depth The current depth of indentation (default is 0).
+         * @return The number of bytes `writef` would produce.
+         */
+        [[nodiscard]]
+        std::size_t dumpf_size(
+            const std::uint16_t space_num = 2,
+            const std::uint16_t depth = 0
+        ) const noexcept {
+            size_counter counter;
+            this->writef(counter, space_num, depth);
+            return counter.size;
+        }
+
+        /**
+         * @brief Parse a JSON string or stream into a Json object.
+         * @param text The JSON string to parse.
+         * @param max_depth The maximum depth of nested structures allowed (default is 256).
+         * @return A Json object if parsing is successful, or an error if it fails.
+         */
+        [[nodiscard]]
+        static std::optional<Json> parse(const std::string_view text, const std::int32_t max_depth = 256) noexcept  {
+            auto it = text.begin();
+            const auto end_ptr = text.end();
+            // Skip spaces
+            while(it != end_ptr && std::isspace(*it)) ++it;
+            if(it == end_ptr) return std::nullopt;
+            // Parse the JSON
+            const document_keys keys;
+            const auto result = reader(it, end_ptr, max_depth-1);
+            if(!result) return result;
+            // check for trailing spaces
+            while(it != end_ptr && std::isspace(*it)) ++it;
+            if(it != end_ptr) return std::nullopt;
+            return result;
+        }
+        [[nodiscard]]
+        static std::optional<Json> parse(std::istream& is_text, const std::int32_t max_depth = 256) noexcept {
+            auto it = std::istreambuf_iterator<char>(is_text);
+            constexpr auto end_ptr = std::istreambuf_iterator<char>();
+            // Skip spaces
+            while(it != end_ptr && std::isspace(*it)) ++it;
+            if(it == end_ptr) return std::nullopt;
+            // Parse the JSON
+            const document_keys keys;
+            const auto result = reader(it, end_ptr, max_depth-1);
+            if(!result) return result;
+            // check for trailing spaces
+            while(it != end_ptr && std::isspace(*it)) ++it;
+            if(it != end_ptr) return std::nullopt;
+            return result;
+        }
+
+    private:
+        /**
+         * @brief Append a tag byte followed by `value` in big-endian order, the layout of MessagePack and CBOR heads.
+         */
+        template<std::unsigned_integral U, output_sink S>
+        static void put_be(S& out, const std::uint8_t tag, const U value) {
+            char buffer[1 + sizeof(U)];
+            buffer[0] = static_cast<char>(tag);
+            for (std::size_t i = 0; i < sizeof(U); ++i) {
+                buffer[1 + i] = static_cast<char>(value >> (8 * (sizeof(U) - 1 - i)));
+            }
+            out.append(buffer, sizeof(buffer));
+        }
+
+        /**
+         * @brief Append the smallest MessagePack header for a length.
+         * @param fix The tag of the one-byte form, holding lengths up to `fix_max`.
+         * @param tag8 The tag of the 8-bit form, 0 if there is none.
+         * @param tag16 The tag of the 16-bit form, the 32-bit form follows it.
+         */
+        template<output_sink S>
+        static void msgpack_length(S& out, const std::size_t size, const std::uint8_t fix, const std::size_t fix_max,
+            const std::uint8_t tag8, const std::uint8_t tag16
+        ) {
+            if (size <= fix_max) out.push_back(static_cast<char>(fix | size));
+            else if (tag8 && size <= 0xff) put_be(out, tag8, static_cast<std::uint8_t>(size));
+            else if (size <= 0xffff) put_be(out, tag16, static_cast<std::uint16_t>(size));
+            else put_be(out, tag16 + 1, static_cast<std::uint32_t>(size));
+        }
+
+        /**
+         * @brief Append a string as fixstr, str8, str16 or str32.
+         */
+        template<output_sink S>
+        static void msgpack_str(S& out, const std::string_view str) {
+            msgpack_length(out, str.size(), 0xa0, 31, 0xd9, 0xda);
+            out.append(str.data(), str.size());
+        }
+
+        /**
+         * @brief Append a number, integral values take the smallest integer format, the others float 64.
+         */
+        template<output_sink S>
+        static void msgpack_num(S& out, const Num value) {
+            // 2^64 and -2^63, both exact in a double
+            constexpr Num uint_end = 18446744073709551616.0;
+            constexpr Num int_min = -9223372036854775808.0;
+            if (value == std::trunc(value) && value >= int_min && value < uint_end && !(value == 0 && std::signbit(value))) {
+                if (value >= 0) {
+                    const auto u = static_cast<std::uint64_t>(value);
+                    if (u < 0x80) out.push_back(static_cast<char>(u));
+                    else if (u <= 0xff) put_be(out, 0xcc, static_cast<std::uint8_t>(u));
+                    else if (u <= 0xffff) put_be(out, 0xcd, static_cast<std::uint16_t>(u));
+                    else if (u <= 0xffffffff) put_be(out, 0xce, static_cast<std::uint32_t>(u));
+                    else put_be(out, 0xcf, u);
+                } else {
+                    const auto i = static_cast<std::int64_t>(value);
+                    if (i >= -32) out.push_back(static_cast<char>(i));
+                    else if (i >= std::numeric_limits<std::int8_t>::min()) put_be(out, 0xd0, static_cast<std::uint8_t>(i));
+                    else if (i >= std::numeric_limits<std::int16_t>::min()) put_be(out, 0xd1, static_cast<std::uint16_t>(i));
+                    else if (i >= std::numeric_limits<std::int32_t>::min()) put_be(out, 0xd2, static_cast<std::uint32_t>(i));
+                    else put_be(out, 0xd3, static_cast<std::uint64_t>(i));
+                }
+                return;
+            }
+            put_be(out, 0xcb, std::bit_cast<std::uint64_t>(value));
+        }
+
+        /**
+         * @brief Append this value if it is a scalar, or the header of its Arr or Obj.
+         */
+        template<output_sink S>
+        void msgpack_head(S& out) const {
+            switch (type()) {
+                case Type::eNul: out.push_back(static_cast<char>(0xc0)); break;
+                case Type::eBol: out.push_back(static_cast<char>(get<Bol>(m_data) ? 0xc3 : 0xc2)); break;
+                case Type::eNum: msgpack_num(out, get<Num>(m_data)); break;
+                case Type::eStr: msgpack_str(out, get<Str>(m_data)); break;
+                case Type::eArr: msgpack_length(out, get<Arr>(m_data).size(), 0x90, 15, 0, 0xdc); break;
+                case Type::eObj: msgpack_length(out, get<Obj>(m_data).size(), 0x80, 15, 0, 0xde); break;
+            }
+        }
+
+        /**
+         * @brief Read an unsigned big-endian integer of `N` bytes, false if the input ends first.
+         */
+        template<std::size_t N>
+        static bool msgpack_get(const unsigned char*& it, const unsigned char* end, std::uint64_t& value) noexcept {
+            if (static_cast<std::size_t>(end - it) < N) return false;
+            value = 0;
+            for (std::size_t i = 0; i < N; ++i) value = value << 8 | it[i];
+            it += N;
+            return true;
+        }
+
+        /**
+         * @brief Read a MessagePack value and create Json.
+         * @param it The current position, moved past the value.
+         * @param end The end of the input.
+         * @param max_depth The maximum depth of nested arrays/maps allowed.
+         * @return The value, or `std::nullopt` for truncated or unsupported input.
+         */
+        static std::optional<Json> msgpack_reader(
+            const unsigned char*& it,
+            const unsigned char* const end,
+            const std::int32_t max_depth
+        ) noexcept {
+            if (max_depth < 0 || it == end) return std::nullopt;
+            const std::uint8_t tag = *it++;
+            if (tag < 0x80) return Json{ static_cast<Num>(tag) };
+            if (tag >= 0xe0) return Json{ static_cast<Num>(static_cast<std::int8_t>(tag)) };
+            // the remaining scalars return at once, Str, Arr and Obj leave their length here
+            std::uint64_t length = 0;
+            Type kind;
+            if (tag < 0x90) { kind = Type::eObj; length = tag & 0x0f; }
+            else if (tag < 0xa0) { kind = Type::eArr; length = tag & 0x0f; }
+            else if (tag < 0xc0) { kind = Type::eStr; length = tag & 0x1f; }
+            else {
+                std::uint64_t raw = 0;
+                switch (tag) {
+                    case 0xc0: return Json{};
+                    case 0xc2: return Json{ false };
+                    case 0xc3: return Json{ true };
+                    // bin is taken as a string of bytes
+                    case 0xc4: case 0xd9: if (!msgpack_get<1>(it, end, length)) return std::nullopt; kind = Type::eStr; break;
+                    case 0xc5: case 0xda: if (!msgpack_get<2>(it, end, length)) return std::nullopt; kind = Type::eStr; break;
+                    case 0xc6: case 0xdb: if (!msgpack_get<4>(it, end, length)) return std::nullopt; kind = Type::eStr; break;
+                    case 0xca:
+                        if (!msgpack_get<4>(it, end, raw)) return std::nullopt;
+                        return Json{ static_cast<Num>(std::bit_cast<float>(static_cast<std::uint32_t>(raw))) };
+                    case 0xcb:
+                        if (!msgpack_get<8>(it, end, raw)) return std::nullopt;
+                        return Json{ std::bit_cast<Num>(raw) };
+                    case 0xcc: if (!msgpack_get<1>(it, end, raw)) return std::nullopt; return Json{ static_cast<Num>(raw) };
+                    case 0xcd: if (!msgpack_get<2>(it, end, raw)) return std::nullopt; return Json{ static_cast<Num>(raw) };
+                    case 0xce: if (!msgpack_get<4>(it, end, raw)) return std::nullopt; return Json{ static_cast<Num>(raw) };
+                    case 0xcf: if (!msgpack_get<8>(it, end, raw)) return std::nullopt; return Json{ static_cast<Num>(raw) };
+                    case 0xd0:
+                        if (!msgpack_get<1>(it, end, raw)) return std::nullopt;
+                        return Json{ static_cast<Num>(static_cast<std::int8_t>(raw)) };
+                    case 0xd1:
+                        if (!msgpack_get<2>(it, end, raw)) return std::nullopt;
+                        return Json{ static_cast<Num>(static_cast<std::int16_t>(raw)) };
+                    case 0xd2:
+                        if (!msgpack_get<4>(it, end, raw)) return std::nullopt;
+                        return Json{ static_cast<Num>(static_cast<std::int32_t>(raw)) };
+                    case 0xd3:
+                        if (!msgpack_get<8>(it, end, raw)) return std::nullopt;
+                        return Json{ static_cast<Num>(static_cast<std::int64_t>(raw)) };
+                    case 0xdc: if (!msgpack_get<2>(it, end, length)) return std::nullopt; kind = Type::eArr; break;
+                    case 0xdd: if (!msgpack_get<4>(it, end, length)) return std::nullopt; kind = Type::eArr; break;
+                    case 0xde: if (!msgpack_get<2>(it, end, length)) return std::nullopt; kind = Type::eObj; break;
+                    case 0xdf: if (!msgpack_get<4>(it, end, length)) return std::nullopt; kind = Type::eObj; break;
+                    // 0xc1 is never used, ext types have no Json counterpart
+                    default: return std::nullopt;
+                }
+            }
+            const auto remaining = static_cast<std::uint64_t>(end - it);
+            if (kind == Type::eStr) {
+                if (length > remaining) return std::nullopt;
+                Json json{ Str(reinterpret_cast<const char*>(it), static_cast<std::size_t>(length)) };
+                it += length;
+                return json;
+            }
+            if (kind == Type::eArr) {
+                // every element takes at least one byte
+                if (length > remaining) return std::nullopt;
+                Arr array;
+                array.reserve(static_cast<std::size_t>(std::min<std::uint64_t>(length, reserve_limit)));
+                for (std::uint64_t i = 0; i < length; ++i) {
+                    auto value = msgpack_reader(it, end, max_depth - 1);
+                    if (!value) return std::nullopt;
+                    array.emplace_back(std::move(*value));
+                }
+                return Json{ std::move(array) };
+            }
+            if (length > remaining / 2) return std::nullopt;
+            // same insertion as `parse`, the first of duplicated keys is kept
+            constexpr bool collect = ObjMap == MapType::eFlat || ObjMap == MapType::eShape
+                || ObjMap == MapType::eIndex || ObjMap == MapType::eBTree;
+            std::conditional_t<collect,
+                std::vector<std::pair<Str, Json>, MapAllocator<std::pair<Str, Json>>>, Obj
+            > items;
+            if constexpr (requires { items.reserve(std::size_t{}); }) {
+                items.reserve(static_cast<std::size_t>(std::min<std::uint64_t>(length, reserve_limit)));
+            }
+            for (std::uint64_t i = 0; i < length; ++i) {
+                auto key = msgpack_reader(it, end, max_depth - 1);
+                if (!key || !key->is_str()) return std::nullopt;
+                auto value = msgpack_reader(it, end, max_depth - 1);
+                if (!value) return std::nullopt;
+                if constexpr (collect) items.emplace_back(std::move(*key).str(), std::move(*value));
+                else items.emplace(std::move(*key).str(), std::move(*value));
+            }
+            if constexpr (collect) return Json{ Obj(std::move(items)) };
+            else return Json{ std::move(items) };
+        }
+
+    public:
+        /**
+         * @brief Encode the JSON data as MessagePack.
+         * @param out The sink receiving the bytes as `char`.
+         * @details
+         * Num values that are integers in the int64/uint64 range use the smallest integer format, others float 64.
+         * Str, Arr and Obj use the smallest fix/16/32 format for their size.
+         * Nesting is tracked on an explicit stack like `write`.
+         */
+        template<output_sink S>
+        void to_msgpack(S& out) const {
+            msgpack_head(out);
+            if (type() != Type::eArr && type() != Type::eObj) return;
+            std::vector<walk_frame> stack;
+            stack.reserve(16);
+            stack.emplace_back(this);
+            while (!stack.empty()) {
+                const Str* key = nullptr;
+                const Json* child = stack.back().next(key);
+                if (!child) {
+                    stack.pop_back();
+                    continue;
+                }
+                if (key) msgpack_str(out, *key);
+                child->msgpack_head(out);
+                if (child->type() == Type::eArr || child->type() == Type::eObj) stack.emplace_back(child);
+            }
+        }
+
+        /**
+         * @brief Decode a single MessagePack value.
+         * @param data The encoded bytes, nothing may follow the value.
+         * @param max_depth The maximum depth of nested arrays/maps allowed (default is 256).
+         * @return A Json object, or `std::nullopt` for malformed, truncated or unsupported input.
+         * @note Integers and floats become Num, bin becomes Str, map keys must be strings, ext is rejected.
+         */
+        [[nodiscard]]
+        static std::optional<Json> from_msgpack(const std::span<const std::byte> data, const std::int32_t max_depth = 256) noexcept {
+            auto it = reinterpret_cast<const unsigned char*>(data.data());
+            const auto end = it + data.size();
+            const document_keys keys;
+            auto result = msgpack_reader(it, end, max_depth - 1);
+            if (it != end) return std::nullopt;
+            return result;
+        }
+
+    private:
+        /**
+         * @brief Append a CBOR head with the shortest encoding of `arg`.
+         */
+        template<output_sink S>
+        static void cbor_put(S& out, const std::uint8_t major, const std::uint64_t arg) {
+            const auto initial = static_cast<std::uint8_t>(major << 5);
+            if (arg < 24) out.push_back(static_cast<char>(initial | arg));
+            else if (arg <= 0xff) put_be(out, initial | 24, static_cast<std::uint8_t>(arg));
+            else if (arg <= 0xffff) put_be(out, initial | 25, static_cast<std::uint16_t>(arg));
+            else if (arg <= 0xffffffff) put_be(out, initial | 26, static_cast<std::uint32_t>(arg));
+            else put_be(out, initial | 27, arg);
+        }
+
+        /**
+         * @brief Append a number, integers as major type 0 or 1, others in the shortest float that keeps the value.
+         */
+        template<output_sink S>
+        static void cbor_num(S& out, const Num value) {
+            // 2^64, exact in a double
+            constexpr Num uint_end = 18446744073709551616.0;
+            if (value == std::trunc(value) && value > -uint_end && value < uint_end && !(value == 0 && std::signbit(value))) {
+                if (value >= 0) cbor_put(out, 0, static_cast<std::uint64_t>(value));
+                else cbor_put(out, 1, static_cast<std::uint64_t>(-value) - 1);
+                return;
+            }
+            if (std::isnan(value)) {
+                put_be(out, 0xf9, std::uint16_t{ 0x7e00 });
+                return;
+            }
+            if (const auto single = static_cast<float>(value); single == value) {
+                // candidate half from the float bits, kept only if it decodes to the same value
+                const auto bits = std::bit_cast<std::uint32_t>(single);
+                const auto sign = static_cast<std::uint16_t>(bits >> 16 & 0x8000);
+                const int exponent = static_cast<int>(bits >> 23 & 0xff) - 127 + 15;
+                const std::uint32_t mantissa = (bits & 0x7fffff) | 0x800000;
+                auto half = static_cast<std::uint16_t>(sign | 0x7c00);     // infinity
+                if (std::isfinite(single)) {
+                    if (exponent >= 1 && exponent <= 30) half = sign | static_cast<std::uint16_t>(exponent << 10 | (mantissa >> 13 & 0x3ff));
+                    else if (exponent > -10 && exponent < 1) half = sign | static_cast<std::uint16_t>(mantissa >> (14 - exponent));
+                    else half = sign;   // out of range, rejected below unless zero
+                }
+                if (cbor_half(half) == value) put_be(out, 0xf9, half);
+                else put_be(out, 0xfa, bits);
+                return;
+            }
+            put_be(out, 0xfb, std::bit_cast<std::uint64_t>(value));
+        }
+
+        /**
+         * @brief Append this value if it is a scalar, or the head of its Arr or Obj.
+         */
+        template<output_sink S>
+        void cbor_head_to(S& out) const {
+            switch (type()) {
+                case Type::eNul: out.push_back(static_cast<char>(0xf6)); break;
+                case Type::eBol: out.push_back(static_cast<char>(get<Bol>(m_data) ? 0xf5 : 0xf4)); break;
+                case Type::eNum: cbor_num(out, get<Num>(m_data)); break;
+                case Type::eStr: {
+                    const auto& str = get<Str>(m_data);
+                    cbor_put(out, 3, str.size());
+                    out.append(str.data(), str.size());
+                } break;
+                case Type::eArr: cbor_put(out, 4, get<Arr>(m_data).size()); break;
+                case Type::eObj: cbor_put(out, 5, get<Obj>(m_data).size()); break;
+            }
+        }
+
+        /**
+         * @brief Read a CBOR data item and create Json.
+         * @param it The current position, moved past the item.
+         * @param end The end of the input.
+         * @param max_depth The maximum depth of nested arrays/maps allowed.
+         * @return The value, or `std::nullopt` for malformed, truncated or unsupported input.
+         */
+        static std::optional<Json> cbor_reader(
+            const unsigned char*& it,
+            const unsigned char* const end,
+            const std::int32_t max_depth
+        ) noexcept {
+            if (max_depth < 0) return std::nullopt;
+            cbor_head head;
+            // the tags accepted by `cbor_plain_tag` carry no meaning for Json, the tagged item is taken as is
+            do {
+                if (!cbor_read_head(it, end, head)) return std::nullopt;
+                if (head.major == 6 && !cbor_plain_tag(head.arg)) return std::nullopt;
+            } while (head.major == 6);
+            const auto at_break = [&it, end] {
+                if (it != end && *it == 0xff) {
+                    ++it;
+                    return true;
+                }
+                return false;
+            };
+            switch (head.major) {
+                case 0: return Json{ static_cast<Num>(head.arg) };
+                case 1: return Json{ -1.0 - static_cast<Num>(head.arg) };
+                case 2: case 3: {
+                    // byte strings are taken as strings of bytes
+                    if (!head.indefinite) {
+                        if (head.arg > static_cast<std::uint64_t>(end - it)) return std::nullopt;
+                        Json json{ Str(reinterpret_cast<const char*>(it), static_cast<std::size_t>(head.arg)) };
+                        it += head.arg;
+                        return json;
+                    }
+                    Str str;
+                    while (!at_break()) {
+                        cbor_head chunk;
+                        if (!cbor_read_head(it, end, chunk) || chunk.major != head.major || chunk.indefinite) return std::nullopt;
+                        if (chunk.arg > static_cast<std::uint64_t>(end - it)) return std::nullopt;
+                        str.append(reinterpret_cast<const char*>(it), static_cast<std::size_t>(chunk.arg));
+                        it += chunk.arg;
+                    }
+                    return Json{ std::move(str) };
+                }
+                case 4: {
+                    Arr array;
+                    if (!head.indefinite) {
+                        // every item takes at least one byte
+                        if (head.arg > static_cast<std::uint64_t>(end - it)) return std::nullopt;
+                        array.reserve(static_cast<std::size_t>(std::min<std::uint64_t>(head.arg, reserve_limit)));
+                    }
+                    for (std::uint64_t i = 0; head.indefinite ? !at_break() : i < head.arg; ++i) {
+                        auto value = cbor_reader(it, end, max_depth - 1);
+                        if (!value) return std::nullopt;
+                        array.emplace_back(std::move(*value));
+                    }
+                    return Json{ std::move(array) };
+                }
+                case 5: {
+                    // same insertion as `parse`, the first of duplicated keys is kept
+                    constexpr bool collect = ObjMap == MapType::eFlat || ObjMap == MapType::eShape
+                        || ObjMap == MapType::eIndex || ObjMap == MapType::eBTree;
+                    std::conditional_t<collect,
+                        std::vector<std::pair<Str, Json>, MapAllocator<std::pair<Str, Json>>>, Obj
+                    > items;
+                    if (!head.indefinite) {
+                        if (head.arg > static_cast<std::uint64_t>(end - it) / 2) return std::nullopt;
+                        if constexpr (requires { items.reserve(std::size_t{}); }) {
+                            items.reserve(static_cast<std::size_t>(std::min<std::uint64_t>(head.arg, reserve_limit)));
+                        }
+                    }
+                    for (std::uint64_t i = 0; head.indefinite ? !at_break() : i < head.arg; ++i) {
+                        auto key = cbor_reader(it, end, max_depth - 1);
+                        if (!key || !key->is_str()) return std::nullopt;
+                        auto value = cbor_reader(it, end, max_depth - 1);
+                        if (!value) return std::nullopt;
+                        if constexpr (collect) items.emplace_back(std::move(*key).str(), std::move(*value));
+                        else items.emplace(std::move(*key).str(), std::move(*value));
+                    }
+                    if constexpr (collect) return Json{ Obj(std::move(items)) };
+                    else return Json{ std::move(items) };
+                }
+                default:
+                    switch (head.info) {
+                        case 20: return Json{ false };
+                        case 21: return Json{ true };
+                        case 22: case 23: return Json{};     // null and undefined
+                        case 25: return Json{ cbor_half(static_cast<std::uint16_t>(head.arg)) };
+                        case 26: return Json{ static_cast<Num>(std::bit_cast<float>(static_cast<std::uint32_t>(head.arg))) };
+                        case 27: return Json{ std::bit_cast<Num>(head.arg) };
+                        // other simple values, and a break outside an indefinite-length item
+                        default: return std::nullopt;
+                    }
+            }
+        }
+
+    public:
+        /**
+         * @brief Encode the JSON data as CBOR (RFC 8949).
+         * @param out The sink receiving the bytes as `char`.
+         * @details
+         * Lengths are definite and every head takes its shortest form.
+         * Num values that are integers in the 64-bit range use major type 0 or 1,
+         * others the shortest of float 16/32/64 that keeps the value.
+         * Nesting is tracked on an explicit stack like `write`.
+         */
+        template<output_sink S>
+        void to_cbor(S& out) const {
+            cbor_head_to(out);
+            if (type() != Type::eArr && type() != Type::eObj) return;
+            std::vector<walk_frame> stack;
+            stack.reserve(16);
+            stack.emplace_back(this);
+            while (!stack.empty()) {
+                const Str* key = nullptr;
+                const Json* child = stack.back().next(key);
+                if (!child) {
+                    stack.pop_back();
+                    continue;
+                }
+                if (key) {
+                    cbor_put(out, 3, key->size());
+                    out.append(key->data(), key->size());
+                }
+                child->cbor_head_to(out);
+                if (child->type() == Type::eArr || child->type() == Type::eObj) stack.emplace_back(child);
+            }
+        }
+
+        /**
+         * @brief Decode a single CBOR data item.
+         * @param data The encoded bytes, nothing may follow the item.
+         * @param max_depth The maximum depth of nested arrays/maps allowed (default is 256).
+         * @return A Json object, or `std::nullopt` for malformed, truncated or unsupported input.
+         * @note Definite and indefinite lengths are accepted, byte strings become Str, undefined becomes Nul,
+         * map keys must be strings. Tags that keep the meaning of their item are skipped, others are rejected.
+         */
+        [[nodiscard]]
+        static std::optional<Json> from_cbor(const std::span<const std::byte> data, const std::int32_t max_depth = 256) noexcept {
+            auto it = reinterpret_cast<const unsigned char*>(data.data());
+            const auto end = it + data.size();
+            const document_keys keys;
+            auto result = cbor_reader(it, end, max_depth - 1);
+            if (it != end) return std::nullopt;
+            return result;
+        }
+
+        /**
+         * @brief Write the JSON data as a binary snapshot, the format read by `json::Snapshot`.
+         * @param out The sink receiving the bytes as `char`.
+         * @details
+         * The snapshot is a header, a tape of 64-bit words and a string pool.
+         * Every value is a slot of two words, `type | length << 8` and a payload:
+         * the bits of a Num, the pool offset of a Str, or the tape index of the contiguous
+         * children of an Arr or Obj. Obj children are key and value slot pairs sorted by key,
+         * so lookups are a binary search. Keys are stored once in the pool.
+         * A container's children are laid out right before its first child's children,
+         * the tape is built on an explicit stack. Words are in native byte order.
+         */
+        template<output_sink S>
+        void write_snapshot(S& out) const {
+            std::vector<std::uint64_t> tape(2);
+            std::string pool;
+            std::unordered_map<std::string_view, std::uint64_t> keys;
+            const auto put_str = [&pool](const std::string_view str) {
+                const auto offset = static_cast<std::uint64_t>(pool.size());
+                pool.append(str);
+                return offset;
+            };
+            std::vector<std::pair<const Json*, std::size_t>> stack;
+            std::vector<std::pair<std::string_view, const Json*>> entries;
+            stack.emplace_back(this, 0);
+            while (!stack.empty()) {
+                const auto [node, slot] = stack.back();
+                stack.pop_back();
+                auto tag = static_cast<std::uint64_t>(node->type());
+                std::uint64_t payload = 0;
+                switch (node->type()) {
+                    case Type::eNul: break;
+                    case Type::eBol: payload = get<Bol>(node->m_data); break;
+                    case Type::eNum: payload = std::bit_cast<std::uint64_t>(get<Num>(node->m_data)); break;
+                    case Type::eStr: {
+                        const auto& str = get<Str>(node->m_data);
+                        tag |= static_cast<std::uint64_t>(str.size()) << 8;
+                        payload = put_str(str);
+                    } break;
+                    case Type::eArr: {
+                        const auto& arr = get<Arr>(node->m_data);
+                        tag |= static_cast<std::uint64_t>(arr.size()) << 8;
+                        payload = tape.size();
+                        tape.resize(tape.size() + arr.size() * 2);
+                        for (std::size_t i = arr.size(); i-- > 0;) stack.emplace_back(&arr[i], payload + i * 2);
+                    } break;
+                    case Type::eObj: {
+                        const auto& obj = get<Obj>(node->m_data);
+                        entries.clear();
+                        for (const auto& [key, value] : obj) entries.emplace_back(key, &value);
+                        if constexpr (!sorted_obj) std::ranges::sort(entries, {}, &std::pair<std::string_view, const Json*>::first);
+                        tag |= static_cast<std::uint64_t>(entries.size()) << 8;
+                        payload = tape.size();
+                        tape.resize(tape.size() + entries.size() * 4);
+                        for (std::size_t i = entries.size(); i-- > 0;) {
+                            const auto [key, value] = entries[i];
+                            const auto [it, added] = keys.try_emplace(key, 0);
+                            if (added) it->second = put_str(key);
+                            tape[payload + i * 4] = static_cast<std::uint64_t>(Type::eStr) | static_cast<std::uint64_t>(key.size()) << 8;
+                            tape[payload + i * 4 + 1] = it->second;
+                            stack.emplace_back(value, payload + i * 4 + 2);
+                        }
+                    } break;
+                }
+                tape[slot] = tag;
+                tape[slot + 1] = payload;
+            }
+            const std::array<std::uint64_t, 3> header{ snapshot_order, tape.size(), pool.size() };
+            out.append(snapshot_magic.data(), snapshot_magic.size());
+            out.append(reinterpret_cast<const char*>(header.data()), sizeof(header));
+            out.append(reinterpret_cast<const char*>(tape.data()), tape.size() * sizeof(std::uint64_t));
+            out.append(pool.data(), pool.size());
+        }
+
+        /**
+         * @brief Save the JSON data as a binary snapshot file, see `write_snapshot` and `json::Snapshot`.
+         * @param path The file to create or overwrite.
+         * @return `false` if the file could not be written.
+         */
+        bool save_snapshot(const std::filesystem::path& path) const {
+            std::ofstream file(path, std::ios::binary | std::ios::trunc);
+            if (!file) return false;
+            {
+                StreamSink sink{ file, 64 * 1024 };
+                write_snapshot(sink);
+                if (!sink.flush()) return false;
+            }
+            file.close();
+            return !file.fail();
+        }
+
+        /**
+         * @brief type conversion, copy inner value to specified type
+         * @tparam T The target type to convert to
+         * @tparam D The mapped_type or value_type of the target type, used for range conversion, default is Nul for other types(useless).
+         * @param default_range_elem if T is a range type and is not json::Arr or json::Obj, must be specified for safe conversion. Else, please use default value.
+         * @return The converted value
+         * @note Num is double, so conversions to integral (and enum) types will round to nearest.
+         * @details
+         * Attempt sequence of conversions:
+         * inner value type -> target type
+         * 1. Nul -> Nul
+         * 2. Obj -> Obj
+         * 3. Arr -> Arr
+         * 4. Str -> Str
+         * 5. Bol -> Bol
+         * 6. Num -> enum types (us llround, round to nearest)
+         * 7. Num -> integral types (us llround, round to nearest)
+         * 8. Num -> floating_point types
+         * 9. Any -> T is constructible from json::Value
+         * 10. Obj -> implicit convertible types
+         * 11. Arr -> implicit convertible types
+         * 12. Str -> implicit convertible types
+         * 13. Num -> implicit convertible types
+         * 14. Bol -> implicit convertible types
+         * 15. Nul -> implicit convertible types (Nul is not convertible to bool !!!!!)
+         * 16. Obj -> Try copy to `range && Str->key_type && Value->mapped_type types && have default_range_value`
+         * 17. Arr -> Try copy to `range && Value->value_type types && have default_range_value`
+         * 18. return std::nullopt;
+         */
+        template<typename T, typename D = Nul>
+        requires convertible<Json, T> || convertible_map<Json, T, D> || convertible_array<Json, T, D>
+        [[nodiscard]]
+        std::optional<T>  to_if( D default_range_elem = D{} ) const noexcept {
+            if constexpr (std::is_same_v<T, Nul>) {
+                if (type() == Type::eNul) return Nul{};
+            } else if constexpr (std::is_same_v<T, Obj>) {
+                if (type() == Type::eObj) return get<Obj>(m_data);
+            } else if constexpr (std::is_same_v<T, Arr>) {
+                if (type() == Type::eArr) return get<Arr>(m_data);
+            } else if constexpr (std::is_same_v<T, Str>) {
+                if (type() == Type::eStr) return get<Str>(m_data);
+            } else if constexpr (std::is_same_v<T, Bol>) {
+                if (type() == Type::eBol) return get<Bol>(m_data);
+            } else if constexpr (std::is_enum_v<T>) {
+                if (type() == Type::eNum) return static_cast<T>(std::llround(get<Num>(m_data)));
+            } else if constexpr (std::is_integral_v<T>) {
+                if (type() == Type::eNum) return static_cast<T>(std::llround(get<Num>(m_data)));
+            } else if constexpr (std::is_floating_point_v<T>) {
+                if (type() == Type::eNum) return static_cast<T>(get<Num>(m_data));
+            }
+            if constexpr (std::is_constructible_v<T, Json>) {
+                return static_cast<T>(*this);
+            }
+            if constexpr (std::is_convertible_v<Obj, T>) {
+                if (type() == Type::eObj) return static_cast<T>(get<Obj>(m_data));
+            }
+            if constexpr (std::is_convertible_v<Arr, T>) {
+                if (type() == Type::eArr) return static_cast<T>(get<Arr>(m_data));
+            }
+            if constexpr (std::is_convertible_v<Str, T>) {
+                if (type() == Type::eStr) return static_cast<T>(get<Str>(m_data));
+            }
+            if constexpr (std::is_convertible_v<Num, T>) {
+                if (type() == Type::eNum) return static_cast<T>(get<Num>(m_data));
+            }
+            if constexpr (std::is_convertible_v<Bol, T>) {
+                if (type() == Type::eBol) return static_cast<T>(get<Bol>(m_data));
+            }
+            if constexpr (std::is_convertible_v<Nul, T>) {
+                if (type() == Type::eNul) return static_cast<T>(Nul{});
+            }
+            if constexpr ( convertible_map<Json, T, D> ) {
+                if (type() == Type::eObj) {
+                    T result{};
+                    for (auto&& [key, value] : get<Obj>(m_data)) {
+                        auto val = value.template to_if<typename T::mapped_type>();
+                        if (!val) result.emplace(static_cast<typename T::key_type>(key), static_cast<typename T::mapped_type>(default_range_elem));
+                        else result.emplace(static_cast<typename T::key_type>(key), std::move(*val));
+                    }
+                    return result;
+                }
+            }
+            if constexpr ( convertible_array<Json, T, D> ) {
+                if (type() == Type::eArr) {
+                    T result{};
+                    for (auto& value : get<Arr>(m_data)) {
+                        auto val = value.template to_if<typename T::value_type>();
+                        if (!val) result.emplace_back(default_range_elem);
+                        else result.emplace_back(std::move(*val));
+                    }
+                    return result;
+                }
+            }
+            return std::nullopt;
+        }
+
+        /**
+         * @brief type conversion, copy inner value to specified type
+         * @tparam T The target type to convert to
+         * @tparam D The mapped_type or value_type of the target type, used for range conversion, default is Nul for other types(useless).
+         * @param default_range_elem if T is a range type and is not json::Arr or json::Obj, must be specified for safe conversion. Else, please use default value.
+         * @return The converted value
+         * @throws std::runtime_error if conversion fails
+         * @note Num is double, so conversions to integral (and enum) types will round to nearest.
+         * @details
+         * Attempt sequence of conversions:
          * inner value type -> target type
          * 1-17: equal to `to_if<T, D>()`
          * 18. throw std::runtime_error
          */
-        template<typename T, typename D = Nul>
-        requires convertible<Json, T> || convertible_map<Json, T, D> || convertible_array<Json, T, D>
+        template<typename T, typename D = Nul>
+        requires convertible<Json, T> || convertible_map<Json, T, D> || convertible_array<Json, T, D>
+        [[nodiscard]]
+        T  to( D default_range_elem = D{} ) const {
+            auto opt = to_if<T, D>( std::move(default_range_elem) );
+            if (!opt) throw std::runtime_error("Cast fail.");
+            return *opt;
+        }
+
+        /**
+         * @brief type conversion, copy inner value to specified type
+         * @tparam T The target type to convert to
+         * @tparam D The mapped_type or value_type of the target type, used for range conversion, default is Nul for other types(useless).
+         * @param default_result The default value to return if conversion fails
+         * @param default_range_elem if T is a range type and is not json::Arr or json::Obj, must be specified for safe conversion. Else, please use default value.
+         * @return The converted value or default_value if conversion fails
+         * @note Num is double, so conversions to integral (and enum) types will round to nearest.
+         * @details
+         * Attempt sequence of conversions:
+         * inner value type -> target type
+         * 1-17: equal to `to_if<T, D>()`
+         * 18: return default_result
+         */
+        template<typename T, typename D = Nul>
+        requires convertible<Json, T> || convertible_map<Json, T, D> || convertible_array<Json, T, D>
+        [[nodiscard]]
+        T  to_or( T default_result, D default_range_elem = D{} ) const noexcept {
+            auto opt = to_if<T, D>( std::move(default_range_elem) );
+            if (!opt) return std::move(default_result);
+            return *opt;
+        }
+
+        /**
+         * @brief type conversion, Move or Copy inner value to specified type
+         * @tparam T The target type to convert to
+         * @tparam D The mapped_type or value_type of the target type, used for range conversion, default is Nul for other types(useless).
+         * @param default_range_elem if T is a range type and is not json::Arr or json::Obj, must be specified for safe conversion. Else, please use default value.
+         * @return The converted value
+         * @note
+         * Num is double, so conversions to integral (and enum) types will round to nearest.
+         * Complex types like Obj, Arr, Str will be moved if possible.
+         * Simple types like Bol, Num, Nul will be copied.
+         * @details
+         * Attempt sequence of conversions:
+         * inner value type -> target type
+         * 1. Nul -> Nul
+         * 2. Obj -> Obj (Move)
+         * 3. Arr -> Arr (Move)
+         * 4. Str -> Str (Move)
+         * 5. Bol -> Bol
+         * 6. Num -> enum types (us llround, round to nearest)
+         * 7. Num -> integral types (us llround, round to nearest)
+         * 8. Num -> floating_point types
+         * 9. Any -> T is constructible from json::Value (try Move)
+         * 10. Obj -> implicit convertible types (try Move)
+         * 11. Arr -> implicit convertible types (try Move)
+         * 12. Str -> implicit convertible types (try Move)
+         * 13. Num -> implicit convertible types
+         * 14. Bol -> implicit convertible types
+         * 15. Nul -> implicit convertible types (Nul is not convertible to bool !!!!!)
+         * 16. Obj -> Try copy to `range && Str->key_type && Value->mapped_type types && have default_range_value`  (try Move)
+         * 17. Arr -> Try copy to `range && Value->value_type types && have default_range_value`  (try Move)
+         * 18. return std::nullopt;
+         */
+        template<typename T, typename D = Nul>
+        requires convertible<Json, T> || convertible_map<Json, T, D> || convertible_array<Json, T, D>
+        [[nodiscard]]
+        std::optional<T>  move_if( D default_range_elem = D{} ) noexcept  {
+            touch();
+            if constexpr (std::is_same_v<T, Nul>) {
+                if (type() == Type::eNul) return Nul{};
+            } else if constexpr (std::is_same_v<T, Obj>) {
+                if (type() == Type::eObj) return std::move(get<Obj>(m_data));
+            } else if constexpr (std::is_same_v<T, Arr>) {
+                if (type() == Type::eArr) return std::move(get<Arr>(m_data));
+            } else if constexpr (std::is_same_v<T, Str>) {
+                if (type() == Type::eStr) return std::move(get<Str>(m_data));
+            } else if constexpr (std::is_same_v<T, Bol>) {
+                if (type() == Type::eBol) return get<Bol>(m_data);
+            } else if constexpr (std::is_enum_v<T>) {
+                if (type() == Type::eNum) return static_cast<T>(std::llround(get<Num>(m_data)));
+            } else if constexpr (std::is_integral_v<T>) {
+                if (type() == Type::eNum) return static_cast<T>(std::llround(get<Num>(m_data)));
+            } else if constexpr (std::is_floating_point_v<T>) {
+                if (type() == Type::eNum) return static_cast<T>(get<Num>(m_data));
+            }
+            if constexpr (std::is_constructible_v<T, Json>) {
+                return static_cast<T>(std::move(*this));
+            }
+            if constexpr (std::is_convertible_v<Obj, T>) {
+                if (type() == Type::eObj) return static_cast<T>(std::move(get<Obj>(m_data)));
+            }
+            if constexpr (std::is_convertible_v<Arr, T>) {
+                if (type() == Type::eArr) return static_cast<T>(std::move(get<Arr>(m_data)));
+            }
+            if constexpr (std::is_convertible_v<Str, T>) {
+                if (type() == Type::eStr) return static_cast<T>(std::move(get<Str>(m_data)));
+            }
+            if constexpr (std::is_convertible_v<Num, T>) {
+                if (type() == Type::eNum) return static_cast<T>(get<Num>(m_data));
+            }
+            if constexpr (std::is_convertible_v<Bol, T>) {
+                if (type() == Type::eBol) return static_cast<T>(get<Bol>(m_data));
+            }
+            if constexpr (std::is_convertible_v<Nul, T>) {
+                if (type() == Type::eNul) return static_cast<T>(Nul{});
+            }
+            if constexpr ( convertible_map<Json, T, D> ) {
+                if (type() == Type::eObj) {
+                    T result{};
+                    for (auto&& [key, value] : get<Obj>(m_data)) {
+                        auto val = value.template move_if<typename T::mapped_type>();
+                        if (!val) result.emplace(static_cast<typename T::key_type>(key), static_cast<typename T::mapped_type>(default_range_elem));
+                        else result.emplace(static_cast<typename T::key_type>(key), std::move(*val));
+                    }
+                    return result;
+                }
+            }
+            if constexpr ( convertible_array<Json, T, D> ) {
+                if (type() == Type::eArr) {
+                    T result{};
+                    for (auto& value : get<Arr>(m_data)) {
+                        auto val = value.template move_if<typename T::value_type>();
+                        if (!val) result.emplace_back( static_cast<typename T::value_type>(default_range_elem) );
+                        else result.emplace_back(std::move(*val));
+                    }
+                    return result;
+                }
+            }
+            return std::nullopt; // return nullopt if conversion fails
+        }
+
+        /**
+         * @brief type conversion, Move or Copy inner value to specified type
+         * @tparam T The target type to convert to
+         * @tparam D The mapped_type or value_type of the target type, used for range conversion, default is Nul for other types(useless).
+         * @param default_range_elem if T is a range type and is not json::Arr or json::Obj, must be specified for safe conversion. Else, please use default value.
+         * @return The converted value
+         * @throws std::runtime_error if conversion fails
+         * @note
+         * Num is double, so conversions to integral (and enum) types will round to nearest.
+         * Complex types like Obj, Arr, Str will be moved if possible.
+         * Simple types like Bol, Num, Nul will be copied.
+         * @details
+         * Attempt sequence of conversions:
+         * inner value type -> target type
+         * 1-17: equal to `move_if<T, D>()`
+         * 18: throw std::runtime_error
+         */
+        template<typename T, typename D = Nul>
+        requires convertible<Json, T> || convertible_map<Json, T, D> || convertible_array<Json, T, D>
+        [[nodiscard]]
+        T  move( D default_range_elem = D{} ) {
+            auto opt = move_if<T, D>( std::move(default_range_elem) );
+            if (!opt) throw std::runtime_error("Cast fail.");
+            return *opt;
+        }
+
+        /**
+         * @brief type conversion, Move or Copy inner value to specified type
+         * @tparam T The target type to convert to
+         * @tparam D The mapped_type or value_type of the target type, used for range conversion, default is Nul for other types(useless).
+         * @param default_result The default value to return if conversion fails
+         * @param default_range_elem if T is a range type and is not json::Arr or json::Obj, must be specified for safe conversion. Else, please use default value.
+         * @return The converted value
+         * @note
+         * Num is double, so conversions to integral (and enum) types will round to nearest.
+         * Complex types like Obj, Arr, Str will be moved if possible.
+         * Simple types like Bol, Num, Nul will be copied.
+         * @details
+         * Attempt sequence of conversions:
+         * inner value type -> target type
+         * 1-17: equal to `move_if<T, D>()`
+         * 18: return default_result;
+         */
+        template<typename T, typename D = Nul>
+        requires convertible<Json, T> || convertible_map<Json, T, D> || convertible_array<Json, T, D>
+        [[nodiscard]]
+        T  move_or( T default_result, D default_range_elem = D{} ) noexcept {
+            auto opt = move_if<T, D>( std::move(default_range_elem) );
+            if (!opt) return default_result;
+            return *opt;
+        }
+
+        /**
+         * @brief For Value-to-Value accurate comparison
+         * @tparam T Type that satisfies std::equality_comparable concept
+         * @warning Num is double, so the comparison of numbers will be very strict
+         * @param other The value to compare with
+         * @return True if values are equal, false otherwise
+         */
+        [[nodiscard]]
+        bool operator==(const Json& other) const noexcept {
+            // containers compare their children through this operator,
+            // past `nesting_limit` levels the rest is compared from an explicit stack
+            thread_local std::size_t depth = 0;
+            if (depth < nesting_limit) {
+                if (type() != other.type()) return false;
+                ++depth;
+                bool result = false;
+                switch (type()) {
+                    case Type::eNul: result = true; break;
+                    case Type::eBol: result = get<Bol>(m_data) == get<Bol>(other.m_data); break;
+                    case Type::eNum: result = get<Num>(m_data) == get<Num>(other.m_data); break;
+                    // shared nodes of `Storage::eShared` are equal without a look inside
+                    case Type::eStr: result = &get<Str>(m_data) == &get<Str>(other.m_data) || get<Str>(m_data) == get<Str>(other.m_data); break;
+                    case Type::eObj: result = &get<Obj>(m_data) == &get<Obj>(other.m_data) || get<Obj>(m_data) == get<Obj>(other.m_data); break;
+                    case Type::eArr: result = &get<Arr>(m_data) == &get<Arr>(other.m_data) || get<Arr>(m_data) == get<Arr>(other.m_data); break;
+                }
+                --depth;
+                return result;
+            }
+            try {
+                std::vector<std::pair<const Json*, const Json*>> pending;
+                if (!shallow_equal(*this, other, pending)) return false;
+                while (!pending.empty()) {
+                    const auto [a, b] = pending.back();
+                    pending.pop_back();
+                    if (!shallow_equal(*a, *b, pending)) return false;
+                }
+                return true;
+            } catch (...) {
+                // out of memory for the stack, keep recursing
+                depth = 0;
+                const bool result = *this == other;
+                depth = nesting_limit;
+                return result;
+            }
+        }
+
+        /**
+         * @brief Generic equality comparison operator
+         * @tparam T Type that satisfies std::equality_comparable concept
+         * @param other The value to compare with
+         * @return True if values are equal, false otherwise
+         *
+         * @details
+         * rules:
+         * A. different json types are not equal( Bol, Num, Str, Arr, Obj, Nul )
+         * B. IF T is Value, use Value::operator==(const Value& other) ,
+         *    it's Accurate comparison !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+         * --------------------------------------------------------------------------------------------
+         * 1.  IF T is Nul, return true if this Value is null, false otherwise
+         * 2.  Else if T is Bol, return true if Value is Bol and Equal to Tvalue
+         * 3.  Else if T is Num, return true if Value is Num and Equal to Tvalue
+         * 4.  Else if T is Str, return true if Value is Str and Equal to Tvalue
+         * 5.  Else if T is Arr, return true if Value is Arr and Equal to Tvalue
+         * 6.  Else if T is Obj, return true if Value is Obj and Equal to Tvalue
+         * 7.  Else if T is enum, return true if Value is Num and Equal to Tvalue, Num will be rounded to nearest integer
+         * 8.  Else if T is integral, return true if Value is Num or Bol and Equal to Tvalue, Num will be rounded to nearest integer
+         * 9.  Else if T is floating_point, return true if Value is Num and Equal to Tvalue, double to double comparison is very strict
+         * 10. Else if T is convertible to std::string_view, return true if Value is Str and Equal to std::string_view( Tvalue )
+         * 11. Else if T is equality_comparable and constructible from Value, return true if Tvalue == T(*this);
+         * 12. Else if Value is constructible from T, return true if *this == json::Value(Tvalue);
+         * 13. Else return false
+         */
+        template<typename  T>
+        requires (!std::is_same_v<T, Json>)
+        [[nodiscard]]
+        bool operator==(const T& other) const  noexcept {
+            if constexpr ( std::is_same_v<T,Nul> ) {
+                return type() == Type::eNul;
+            } else if constexpr ( std::is_same_v<T,Bol> ) {
+                if ( type() == Type::eBol ) return get<Bol>(m_data) == other;
+            } else if constexpr ( std::is_same_v<T,Num> ) {
+                if ( type() == Type::eNum ) return get<Num>(m_data) == other;
+            } else if constexpr ( std::is_same_v<T,Str> ) {
+                if ( type() == Type::eStr ) return get<Str>(m_data) == other;
+            } else if constexpr ( std::is_same_v<T,Arr> ) {
+                if ( type() == Type::eArr ) return get<Arr>(m_data) == other;
+            } else if constexpr ( std::is_same_v<T,Obj> ) {
+                if ( type() == Type::eObj ) return get<Obj>(m_data) == other;
+            } else if constexpr (std::is_enum_v<T>) {
+                if ( type() == Type::eNum) return static_cast<T>(std::llround(get<Num>(m_data))) == other;
+            } else if constexpr (std::is_integral_v<T>) {
+                if ( type() == Type::eNum) return static_cast<T>(std::llround(get<Num>(m_data))) == other;
+            } else if constexpr (std::is_floating_point_v<T>) {
+                if ( type() == Type::eNum) return static_cast<T>(get<Num>(m_data)) == other;
+            } else if constexpr (std::is_convertible_v<T, std::string_view>) {
+                if( type() == Type::eStr) return get<Str>(m_data) == std::string_view( other );
+            } else if constexpr (std::equality_comparable<T> && std::is_constructible_v<T, Json>) {
+                return other == static_cast<T>(*this);     // Use T's operator==
+            } else if constexpr (std::is_constructible_v<Json, T>) {
+                return static_cast<Json>(other) == *this; // Use Value's operator==
+            }
+            return false;
+        }
+
+        /**
+         * @brief Compute a JSON Patch (RFC 6902) that turns `from` into `to`.
+         * @param from The source document.
+         * @param to The target document.
+         * @param detect_moves Match equal items of changed arrays wherever they moved and emit `move` for them,
+         * instead of editing the arrays position by position.
+         * @return An Arr of `add`, `remove`, `replace` and `move` operations, empty if the documents are equal.
+         * @details
+         * Both trees are walked together from an explicit stack. A pair of nodes is skipped without descending
+         * when it is the same node, or shares its Str/Arr/Obj (`Storage::eShared` copies).
+         * Objects are matched key by key, in a single merge pass when Obj iterates in key order.
+         * Arrays drop their common prefix and suffix, then edit the rest in place,
+         * or with `detect_moves` pair items by `structural_hash` and equality.
+         */
+        [[nodiscard]]
+        static Json diff(const Json& from, const Json& to, const bool detect_moves = false) {
+            static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+            struct item {
+                const Json* a;
+                const Json* b;
+                std::size_t depth;
+                std::string_view key;
+                std::size_t index;  ///< the array index, or `npos` for `key`
+            };
+
+            Json result{ Arr{} };
+            auto& ops = get<Arr>(result.m_data);
+            // the tokens to the pair being compared, written out only for an operation
+            std::vector<std::pair<std::string_view, std::size_t>> tokens;
+            std::vector<item> pending{ { &from, &to, 0, {}, npos } };
+
+            const auto token_to = [](Str& out, const std::string_view key, const std::size_t index) {
+                out.push_back('/');
+                if (index != npos) {
+                    char buffer[24];
+                    const auto [ptr, ec] = std::to_chars(buffer, buffer + 24, index);
+                    out.append(buffer, static_cast<std::size_t>(ptr - buffer));
+                    return;
+                }
+                for (const char c : key) {
+                    if (c == '~') out.append("~0", 2);
+                    else if (c == '/') out.append("~1", 2);
+                    else out.push_back(c);
+                }
+            };
+            const auto here = [&tokens, &token_to] {
+                Str out;
+                for (const auto& [key, index] : tokens) token_to(out, key, index);
+                return out;
+            };
+            const auto child = [&here, &token_to](const std::string_view key, const std::size_t index) {
+                Str out = here();
+                token_to(out, key, index);
+                return out;
+            };
+            const auto emit = [&ops](const char* name, Str at, const Json* value) -> Obj& {
+                Json op{ Obj{} };
+                auto& obj = get<Obj>(op.m_data);
+                obj.emplace(Str("op"), Json{ name });
+                obj.emplace(Str("path"), Json{ std::move(at) });
+                if (value) obj.emplace(Str("value"), *value);
+                ops.push_back(std::move(op));
+                return get<Obj>(ops.back().m_data);
+            };
+            // equal scalars are settled without a trip through `pending`
+            const auto same_leaf = [](const Json& x, const Json& y) noexcept {
+                if (x.type() != y.type()) return false;
+                switch (x.type()) {
+                    case Type::eNul: return true;
+                    case Type::eBol: return get<Bol>(x.m_data) == get<Bol>(y.m_data);
+                    case Type::eNum: return get<Num>(x.m_data) == get<Num>(y.m_data);
+                    case Type::eStr: return &get<Str>(x.m_data) == &get<Str>(y.m_data) || get<Str>(x.m_data) == get<Str>(y.m_data);
+                    default: return false;
+                }
+            };
+
+            while (!pending.empty()) {
+                const item top = pending.back();
+                pending.pop_back();
+                if (top.depth != 0) {
+                    tokens.resize(top.depth - 1);
+                    tokens.emplace_back(top.key, top.index);
+                }
+                const Json& a = *top.a;
+                const Json& b = *top.b;
+                if (&a == &b) continue;
+                if (a.type() != b.type()) {
+                    emit("replace", here(), &b);
+                    continue;
+                }
+                const std::size_t children = pending.size();
+                switch (a.type()) {
+                    case Type::eNul: break;
+                    case Type::eBol: case Type::eNum: case Type::eStr:
+                        if (!same_leaf(a, b)) emit("replace", here(), &b);
+                        break;
+                    case Type::eObj: {
+                        const auto& x = get<Obj>(a.m_data);
+                        const auto& y = get<Obj>(b.m_data);
+                        if (&x == &y) break;    // shared node
+                        if constexpr (sorted_obj) {
+                            auto it = x.begin();
+                            auto jt = y.begin();
+                            while (it != x.end() || jt != y.end()) {
+                                const int order = it == x.end() ? 1 : jt == y.end() ? -1 : it->first.compare(jt->first);
+                                if (order < 0) {
+                                    emit("remove", child(it->first, npos), nullptr);
+                                    ++it;
+                                } else if (order > 0) {
+                                    emit("add", child(jt->first, npos), &jt->second);
+                                    ++jt;
+                                } else {
+                                    if (!same_leaf(it->second, jt->second)) pending.push_back({ &it->second, &jt->second, top.depth + 1, it->first, npos });
+                                    ++it;
+                                    ++jt;
+                                }
+                            }
+                        } else {
+                            for (const auto& [key, val] : x) {
+                                const auto it = find_key(y, key);
+                                if (it == y.end()) emit("remove", child(key, npos), nullptr);
+                                else if (!same_leaf(val, it->second)) pending.push_back({ &val, &it->second, top.depth + 1, key, npos });
+                            }
+                            for (const auto& [key, val] : y) {
+                                if (find_key(x, key) == x.end()) emit("add", child(key, npos), &val);
+                            }
+                        }
+                        break;
+                    }
+                    case Type::eArr: {
+                        const auto& x = get<Arr>(a.m_data);
+                        const auto& y = get<Arr>(b.m_data);
+                        if (&x == &y) break;
+                        std::size_t begin = 0, end_x = x.size(), end_y = y.size();
+                        if (x.size() != y.size() || detect_moves) {
+                            while (begin < end_x && begin < end_y && x[begin] == y[begin]) ++begin;
+                            while (end_x > begin && end_y > begin && x[end_x - 1] == y[end_y - 1]) --end_x, --end_y;
+                        }
+                        const std::size_t na = end_x - begin;
+                        const std::size_t nb = end_y - begin;
+                        if (!detect_moves) {
+                            // the shorter middle is edited in place, the rest is removed from the back or appended
+                            for (std::size_t i = end_x; i > begin + nb; --i) emit("remove", child({}, i - 1), nullptr);
+                            for (std::size_t j = begin + na; j < end_y; ++j) emit("add", child({}, j), &y[j]);
+                            for (std::size_t k = begin; k < begin + std::min(na, nb); ++k) {
+                                if (!same_leaf(x[k], y[k])) pending.push_back({ &x[k], &y[k], top.depth + 1, {}, k });
+                            }
+                            break;
+                        }
+                        // source[j]: the item of the middle of `x` that becomes item j of the middle of `y`
+                        std::vector<std::size_t> source(nb, npos);
+                        std::vector<bool> used(na, false);
+                        std::vector<bool> edited(nb, false);
+                        std::unordered_multimap<std::uint64_t, std::size_t> by_hash;
+                        by_hash.reserve(na);
+                        for (std::size_t i = 0; i < na; ++i) by_hash.emplace(structural_hash(x[begin + i]), i);
+                        for (std::size_t j = 0; j < nb; ++j) {
+                            auto [first, last] = by_hash.equal_range(structural_hash(y[begin + j]));
+                            for (; first != last; ++first) {
+                                if (x[begin + first->second] != y[begin + j]) continue;
+                                source[j] = first->second;
+                                used[first->second] = true;
+                                by_hash.erase(first);
+                                break;
+                            }
+                        }
+                        // items left unmatched on both sides are paired in order and diffed in place
+                        for (std::size_t i = 0, j = 0; ; ++i, ++j) {
+                            while (i < na && used[i]) ++i;
+                            while (j < nb && source[j] != npos) ++j;
+                            if (i == na || j == nb) break;
+                            source[j] = i;
+                            used[i] = true;
+                            edited[j] = true;
+                        }
+                        std::vector<std::size_t> current;   // the middle of `x` as the operations so far left it
+                        for (std::size_t i = na; i-- > 0; ) {
+                            if (!used[i]) emit("remove", child({}, begin + i), nullptr);
+                        }
+                        for (std::size_t i = 0; i < na; ++i) {
+                            if (used[i]) current.push_back(i);
+                        }
+                        for (std::size_t j = 0; j < nb; ++j) {
+                            if (source[j] == npos) {
+                                emit("add", child({}, begin + j), &y[begin + j]);
+                                current.insert(current.begin() + static_cast<std::ptrdiff_t>(j), npos);
+                                continue;
+                            }
+                            const auto pos = std::find(current.begin() + static_cast<std::ptrdiff_t>(j), current.end(), source[j]);
+                            if (pos != current.begin() + static_cast<std::ptrdiff_t>(j)) {
+                                const auto from_index = begin + static_cast<std::size_t>(pos - current.begin());
+                                emit("move", child({}, begin + j), nullptr).emplace(Str("from"), Json{ child({}, from_index) });
+                                std::rotate(current.begin() + static_cast<std::ptrdiff_t>(j), pos, pos + 1);
+                            }
+                            if (edited[j]) pending.push_back({ &x[begin + source[j]], &y[begin + j], top.depth + 1, {}, begin + j });
+                        }
+                        break;
+                    }
+                }
+                // children pop in document order
+                std::reverse(pending.begin() + static_cast<std::ptrdiff_t>(children), pending.end());
+            }
+            return result;
+        }
+
+        /**
+         * @brief Get inner container size.
+         * @return The size of the inner container(Arr or Obj), or 0 for Nul, Bol, Num, Str.
+         */
+        [[nodiscard]]
+        std::size_t size() const noexcept {
+            if (type() == Type::eObj)  return get<Obj>(m_data).size();
+            if (type() == Type::eArr) return get<Arr>(m_data).size();
+            return 0; // Nul, Bol, Num, Str are considered to have size 0
+        }
+
+        /**
+         * @brief Check if the JSON object is empty.
+         * @return False if it contains any elements (Obj or Arr), true otherwise.
+         */
+        [[nodiscard]]
+        bool empty() const noexcept {
+            if (type() == Type::eObj)  return get<Obj>(m_data).empty();
+            if (type() == Type::eArr) return get<Arr>(m_data).empty();
+            return true; // Nul, Bol, Num, Str are considered empty
+        }
+
+        /**
+         * @brief Check if the JSON object contains a key.
+         * @param key The key to check in the JSON object.
+         * @return True if the key exists in the JSON object, false if the JSON is not an object or the key does not exist.
+         */
+        [[nodiscard]]
+        bool contains(const std::string_view key) const noexcept {
+            if (type() == Type::eObj) return find_key(get<Obj>(m_data), key) != get<Obj>(m_data).end();
+            return false; // Not an object
+        }
+
+        /**
+         * @brief Erase a key from the JSON object or an index from the JSON array.
+         * @param key The key to erase from the JSON object.
+         * @return True if the key was erased, false if the JSON is not an object or the key does not exist.
+         * @note Not `noexcept` with `MapType::eShape`, the shape of the remaining keys may be allocated.
+         */
+        bool erase(const std::string_view key) noexcept(ObjMap != MapType::eShape) {
+            touch();
+            if (type() == Type::eObj) {
+                auto& obj = get<Obj>(m_data);
+                const auto it = find_key(obj, key);
+                if (it == obj.end()) return false;
+                obj.erase(it);
+                return true;
+            }
+            return false;
+        }
+
+        /**
+         * @brief Erase an element at the specified index from the JSON array.
+         * @param index The index of the element to erase from the JSON array.
+         * @return True if the element was erased, false if the JSON is not an array or the index is out of bounds.
+         */
+        bool erase(const std::size_t index) noexcept {
+            touch();
+            if (type() == Type::eArr && index < get<Arr>(m_data).size()) {
+                get<Arr>(m_data).erase(get<Arr>(m_data).begin() + index);
+                return true;
+            }
+            return false;
+        }
+
+        /**
+         * @brief Insert a key-value pair into the JSON object.
+         * @param key The key to insert into the JSON object.
+         * @param value The value to insert into the JSON object.
+         * @return True if the key-value pair was inserted, false if the JSON is not an object.
+         */
+        template<typename  K, typename V>
+        requires std::convertible_to<K, Str> && std::convertible_to<V, Json>
+        bool insert(K&& key, V&& value) noexcept {
+            touch();
+            if (type() == Type::eObj) {
+                get<Obj>(m_data).try_emplace(static_cast<Str>(std::forward<K>(key)), std::forward<V>(value));
+                return true;
+            }
+            return false;
+        }
+
+        /**
+         * @brief Insert a value at the specified index into the JSON array.
+         * @param index The index at which to insert the value into the JSON array.
+         * @param value The value to insert into the JSON array.
+         * @return True if the value was inserted, false if the JSON is not an array or the index is out of bounds.
+         */
+        template<typename V>
+        requires std::convertible_to<V, Json>
+        bool insert(const std::size_t index, V&& value) noexcept {
+            touch();
+            if (type() == Type::eArr && index <= get<Arr>(m_data).size()) {
+                get<Arr>(m_data).emplace(get<Arr>(m_data).begin() + index, std::forward<V>(value));
+                return true;
+            }
+            return false;
+        }
+
+        /**
+         * @brief Push a value to the end of the JSON array.
+         * @param value The value to push to the end of the JSON array.
+         * @return True if the value was pushed, false if the JSON is not an array.
+         */
+        template<typename V>
+        requires std::convertible_to<V, Json>
+        bool push_back(V&& value) noexcept {
+            touch();
+            if (type() == Type::eArr) {
+                get<Arr>(m_data).emplace_back(std::forward<V>(value));
+                return true;
+            }
+            return false;
+        }
+
+        /**
+         * @brief Pop the last value from the JSON array.
+         * @return True if the value was popped, false if the JSON is not an array or is empty.
+         */
+        bool pop_back() noexcept {
+            touch();
+            if (type() == Type::eArr && !get<Arr>(m_data).empty()) {
+                get<Arr>(m_data).pop_back();
+                return true;
+            }
+            return false;
+        }
+
+    };
+
+    /**
+     * @brief Incremental MessagePack decoder for input arriving in chunks.
+     * @tparam J The Json type to produce.
+     * @details
+     * `feed` appends bytes, `next` returns each complete top-level value in order.
+     * While bytes arrive only the value boundaries are tracked from the length prefixes,
+     * a value is decoded with `J::from_msgpack` once its last byte is there.
+     */
+    template<typename J>
+    class MsgpackDecoder {
+        std::vector<unsigned char> m_buffer;
+        std::size_t m_begin{ 0 };       // first byte of the current value
+        std::size_t m_cursor{ 0 };      // first header not measured yet
+        std::uint64_t m_pending{ 1 };   // values left to measure in the current one
+        std::int32_t m_max_depth;
+        bool m_failed{ false };
+
+        /**
+         * @brief Measure headers from the cursor on, true once the current value is complete.
+         */
+        bool scan() noexcept {
+            const std::size_t size = m_buffer.size();
+            while (m_pending) {
+                if (m_cursor == size) return false;
+                const unsigned char* const p = m_buffer.data() + m_cursor;
+                const std::size_t avail = size - m_cursor;
+                const std::uint8_t tag = *p;
+                std::size_t head = 1;       // tag and fixed-size payload or length prefix
+                std::uint64_t body = 0;     // string bytes after the header
+                std::uint64_t items = 0;    // nested values
+                if (tag < 0x80 || tag >= 0xe0 || tag == 0xc0 || tag == 0xc2 || tag == 0xc3) {}
+                else if (tag < 0x90) items = 2 * (tag & 0x0f);
+                else if (tag < 0xa0) items = tag & 0x0f;
+                else if (tag < 0xc0) body = tag & 0x1f;
+                else {
+                    std::size_t prefix = 0;
+                    switch (tag) {
+                        case 0xcc: case 0xd0: head = 2; break;
+                        case 0xcd: case 0xd1: head = 3; break;
+                        case 0xca: case 0xce: case 0xd2: head = 5; break;
+                        case 0xcb: case 0xcf: case 0xd3: head = 9; break;
+                        case 0xc4: case 0xd9: prefix = 1; break;
+                        case 0xc5: case 0xda: case 0xdc: case 0xde: prefix = 2; break;
+                        case 0xc6: case 0xdb: case 0xdd: case 0xdf: prefix = 4; break;
+                        default:
+                            m_failed = true;
+                            return false;
+                    }
+                    if (prefix) {
+                        head = 1 + prefix;
+                        if (avail < head) return false;
+                        std::uint64_t length = 0;
+                        for (std::size_t i = 1; i <= prefix; ++i) length = length << 8 | p[i];
+                        if (tag == 0xdc || tag == 0xdd) items = length;
+                        else if (tag == 0xde || tag == 0xdf) items = 2 * length;
+                        else body = length;
+                    }
+                }
+                if (avail < head || avail - head < body) return false;
+                m_cursor += head + static_cast<std::size_t>(body);
+                m_pending += items;
+                --m_pending;
+            }
+            return true;
+        }
+
+    public:
+        explicit MsgpackDecoder(const std::int32_t max_depth = 256) noexcept : m_max_depth(max_depth) {}
+
+        /**
+         * @brief Append the next chunk of input.
+         */
+        void feed(const std::span<const std::byte> chunk) {
+            if (m_begin && m_begin >= m_buffer.size() / 2) {
+                // drop the values already returned instead of growing
+                m_buffer.erase(m_buffer.begin(), m_buffer.begin() + static_cast<std::ptrdiff_t>(m_begin));
+                m_cursor -= m_begin;
+                m_begin = 0;
+            }
+            const auto bytes = reinterpret_cast<const unsigned char*>(chunk.data());
+            m_buffer.insert(m_buffer.end(), bytes, bytes + chunk.size());
+        }
+
+        /**
+         * @brief Take the next complete value.
+         * @return The value, or `std::nullopt` if more input is needed or the input is malformed, see `failed`.
+         */
+        [[nodiscard]]
+        std::optional<J> next() noexcept {
+            if (m_failed || !scan()) return std::nullopt;
+            auto value = J::from_msgpack(
+                std::as_bytes(std::span{ m_buffer.data() + m_begin, m_cursor - m_begin }), m_max_depth
+            );
+            if (!value) {
+                m_failed = true;
+                return std::nullopt;
+            }
+            m_begin = m_cursor;
+            m_pending = 1;
+            return value;
+        }
+
+        /**
+         * @brief Check whether malformed input was met, no more values are returned afterwards.
+         */
+        [[nodiscard]]
+        bool failed() const noexcept { return m_failed; }
+
+        /**
+         * @brief Number of bytes received but not returned as a value yet.
+         */
+        [[nodiscard]]
+        std::size_t buffered() const noexcept { return m_buffer.size() - m_begin; }
+    };
+
+    /**
+     * @brief Incremental CBOR decoder for input arriving in chunks.
+     * @tparam J The Json type to produce.
+     * @details
+     * `feed` appends bytes, `next` returns each complete top-level data item in order.
+     * While bytes arrive only the heads are read to track the open arrays, maps and chunked strings,
+     * an item is decoded with `J::from_cbor` once its last byte is there.
+     */
+    template<typename J>
+    class CborDecoder {
+        struct frame {
+            std::uint64_t count;    // items left if definite
+            bool indefinite;
+        };
+        std::vector<unsigned char> m_buffer;
+        std::size_t m_begin{ 0 };       // first byte of the current item
+        std::size_t m_cursor{ 0 };      // first head not read yet
+        std::vector<frame> m_open;      // containers of the current item still open at the cursor
+        std::int32_t m_max_depth;
+        bool m_failed{ false };
+
+        /**
+         * @brief Read heads from the cursor on, true once the current item is complete.
+         */
+        bool scan() noexcept {
+            const unsigned char* const data = m_buffer.data();
+            const unsigned char* const end = data + m_buffer.size();
+            try {
+                while (true) {
+                    const unsigned char* it = data + m_cursor;
+                    if (it == end) return false;
+                    const std::uint8_t info = *it & 0x1f;
+                    const std::size_t size = info >= 24 && info <= 27 ? 1 + (std::size_t{ 1 } << (info - 24)) : 1;
+                    if (static_cast<std::size_t>(end - it) < size) return false;
+                    cbor_head head;
+                    if (!cbor_read_head(it, end, head)) break;
+                    // a definite-length string is waited for as a whole
+                    const std::uint64_t body = (head.major == 2 || head.major == 3) && !head.indefinite ? head.arg : 0;
+                    if (static_cast<std::uint64_t>(end - it) < body) return false;
+                    m_cursor = static_cast<std::size_t>(it - data + static_cast<std::ptrdiff_t>(body));
+                    if (head.major == 6) continue;  // the tagged item follows
+                    if (head.major == 7 && head.indefinite) {
+                        if (m_open.empty() || !m_open.back().indefinite) break;
+                        m_open.pop_back();
+                    } else if (head.indefinite || ((head.major == 4 || head.major == 5) && head.arg)) {
+                        if (head.major == 5 && head.arg > std::numeric_limits<std::uint64_t>::max() / 2) break;
+                        m_open.push_back({ head.major == 5 ? head.arg * 2 : head.arg, head.indefinite });
+                        if (m_open.size() > static_cast<std::size_t>(std::max(m_max_depth, 0))) break;
+                        continue;
+                    }
+                    // an item is complete, which may complete its definite-length parents
+                    while (!m_open.empty() && !m_open.back().indefinite && !--m_open.back().count) m_open.pop_back();
+                    if (m_open.empty()) return true;
+                }
+            } catch (...) {
+                // out of memory for the open containers
+            }
+            m_failed = true;
+            return false;
+        }
+
+    public:
+        explicit CborDecoder(const std::int32_t max_depth = 256) noexcept : m_max_depth(max_depth) {}
+
+        /**
+         * @brief Append the next chunk of input.
+         */
+        void feed(const std::span<const std::byte> chunk) {
+            if (m_begin && m_begin >= m_buffer.size() / 2) {
+                // drop the items already returned instead of growing
+                m_buffer.erase(m_buffer.begin(), m_buffer.begin() + static_cast<std::ptrdiff_t>(m_begin));
+                m_cursor -= m_begin;
+                m_begin = 0;
+            }
+            const auto bytes = reinterpret_cast<const unsigned char*>(chunk.data());
+            m_buffer.insert(m_buffer.end(), bytes, bytes + chunk.size());
+        }
+
+        /**
+         * @brief Take the next complete data item.
+         * @return The value, or `std::nullopt` if more input is needed or the input is malformed, see `failed`.
+         */
+        [[nodiscard]]
+        std::optional<J> next() noexcept {
+            if (m_failed || !scan()) return std::nullopt;
+            auto value = J::from_cbor(
+                std::as_bytes(std::span{ m_buffer.data() + m_begin, m_cursor - m_begin }), m_max_depth
+            );
+            if (!value) {
+                m_failed = true;
+                return std::nullopt;
+            }
+            m_begin = m_cursor;
+            return value;
+        }
+
+        /**
+         * @brief Check whether malformed input was met, no more values are returned afterwards.
+         */
+        [[nodiscard]]
+        bool failed() const noexcept { return m_failed; }
+
+        /**
+         * @brief Number of bytes received but not returned as a value yet.
+         */
+        [[nodiscard]]
+        std::size_t buffered() const noexcept { return m_buffer.size() - m_begin; }
+    };
+
+    /**
+     * @brief Read-only view of a CBOR data item, strings borrow the input instead of being copied.
+     * @details
+     * `parse` checks the whole item once, the accessors then walk the bytes on demand without allocating.
+     * The viewed buffer must stay alive and unchanged while the view or any view taken from it is used.
+     * Tags are skipped or rejected like `Json::from_cbor`, byte strings count as strings.
+     */
+    class CborView {
+        const unsigned char* m_begin;
+        const unsigned char* m_end;
+
+        CborView(const unsigned char* begin, const unsigned char* end) noexcept : m_begin(begin), m_end(end) {}
+
+        /**
+         * @brief Read the head of the item after its tags, `it` is left after the head.
+         */
+        cbor_head head(const unsigned char*& it) const noexcept {
+            it = m_begin;
+            cbor_head result;
+            do cbor_read_head(it, m_end, result); while (result.major == 6);
+            return result;
+        }
+
+        /**
+         * @brief Call `f(item)` for each item of an Arr or each key and value of an Obj, in order,
+         * until `f` returns `false`.
+         */
+        template<typename F>
+        void walk(F&& f) const {
+            const unsigned char* it;
+            const cbor_head h = head(it);
+            if (h.major != 4 && h.major != 5) return;
+            const std::uint64_t count = h.major == 5 ? h.arg * 2 : h.arg;
+            for (std::uint64_t i = 0; h.indefinite ? *it != 0xff : i < count; ++i) {
+                // already checked by `parse`, the depth needs no limit here, only memory for the stack may lack
+                const unsigned char* next = cbor_skip(it, m_end, std::numeric_limits<std::size_t>::max());
+                if (!next || !f(CborView{ it, next })) return;
+                it = next;
+            }
+        }
+
+    public:
+        /**
+         * @brief Check that `data` holds exactly one well-formed CBOR data item and view it.
+         * @param data The encoded bytes.
+         * @param max_depth The maximum depth of nested arrays/maps allowed (default is 256).
+         * @return The view, or `std::nullopt` for malformed, truncated or unsupported input.
+         */
+        [[nodiscard]]
+        static std::optional<CborView> parse(const std::span<const std::byte> data, const std::size_t max_depth = 256) noexcept {
+            const auto begin = reinterpret_cast<const unsigned char*>(data.data());
+            const auto end = begin + data.size();
+            if (cbor_skip(begin, end, max_depth) != end || begin == end) return std::nullopt;
+            return CborView{ begin, end };
+        }
+
+        /**
+         * @brief Get the Json type the item maps to.
+         */
+        [[nodiscard]]
+        Type type() const noexcept {
+            const unsigned char* it;
+            const cbor_head h = head(it);
+            switch (h.major) {
+                case 0: case 1: return Type::eNum;
+                case 2: case 3: return Type::eStr;
+                case 4: return Type::eArr;
+                case 5: return Type::eObj;
+                default:
+                    if (h.info == 20 || h.info == 21) return Type::eBol;
+                    if (h.info == 22 || h.info == 23) return Type::eNul;
+                    return Type::eNum;
+            }
+        }
+
+        /**
+         * @brief Get the value of a boolean item.
+         */
+        [[nodiscard]]
+        std::optional<bool> as_bol() const noexcept {
+            const unsigned char* it;
+            const cbor_head h = head(it);
+            if (h.major != 7 || (h.info != 20 && h.info != 21)) return std::nullopt;
+            return h.info == 21;
+        }
+
+        /**
+         * @brief Get the value of an integer or float item.
+         */
+        [[nodiscard]]
+        std::optional<double> as_num() const noexcept {
+            const unsigned char* it;
+            const cbor_head h = head(it);
+            switch (h.major) {
+                case 0: return static_cast<double>(h.arg);
+                case 1: return -1.0 - static_cast<double>(h.arg);
+                case 7:
+                    if (h.info == 25) return cbor_half(static_cast<std::uint16_t>(h.arg));
+                    if (h.info == 26) return std::bit_cast<float>(static_cast<std::uint32_t>(h.arg));
+                    if (h.info == 27) return std::bit_cast<double>(h.arg);
+                    return std::nullopt;
+                default: return std::nullopt;
+            }
+        }
+
+        /**
+         * @brief Get a definite-length text or byte string, pointing into the viewed buffer.
+         * @return `std::nullopt` if the item is not a string, or is an indefinite-length string split into chunks.
+         */
+        [[nodiscard]]
+        std::optional<std::string_view> as_str() const noexcept {
+            const unsigned char* it;
+            const cbor_head h = head(it);
+            if ((h.major != 2 && h.major != 3) || h.indefinite) return std::nullopt;
+            return std::string_view{ reinterpret_cast<const char*>(it), static_cast<std::size_t>(h.arg) };
+        }
+
+        /**
+         * @brief Get the number of items of an Arr or pairs of an Obj, 0 for other types.
+         * @note Indefinite-length items are counted by walking them.
+         */
+        [[nodiscard]]
+        std::size_t size() const noexcept {
+            const unsigned char* it;
+            const cbor_head h = head(it);
+            if (h.major != 4 && h.major != 5) return 0;
+            if (!h.indefinite) return static_cast<std::size_t>(h.arg);
+            std::size_t count = 0;
+            walk([&count](CborView) { ++count; return true; });
+            return h.major == 5 ? count / 2 : count;
+        }
+
+        /**
+         * @brief Get the item at `index` of an Arr.
+         * @return `std::nullopt` if this is not an Arr or the index is out of range.
+         */
+        [[nodiscard]]
+        std::optional<CborView> at(const std::size_t index) const noexcept {
+            if (type() != Type::eArr) return std::nullopt;
+            std::optional<CborView> result;
+            std::size_t i = 0;
+            walk([&](const CborView item) {
+                if (i++ != index) return true;
+                result = item;
+                return false;
+            });
+            return result;
+        }
+
+        /**
+         * @brief Get the value of the first pair of an Obj whose key is `key`.
+         * @return `std::nullopt` if this is not an Obj or no definite-length string key matches.
+         */
+        [[nodiscard]]
+        std::optional<CborView> find(const std::string_view key) const noexcept {
+            if (type() != Type::eObj) return std::nullopt;
+            std::optional<CborView> result;
+            bool is_key = true;
+            bool matched = false;
+            walk([&](const CborView item) {
+                if (std::exchange(is_key, !is_key)) {
+                    matched = item.as_str() == key;
+                    return true;
+                }
+                if (matched) result = item;
+                return !matched;
+            });
+            return result;
+        }
+
+        /**
+         * @brief Call `f(item)` for each item of an Arr, or `f(key, value)` for each pair of an Obj.
+         * @note A callable accepting only one of the two forms skips the other kind of container.
+         */
+        template<typename F>
+        void for_each(F&& f) const {
+            if constexpr (std::invocable<F&, CborView>) {
+                if (type() == Type::eArr) {
+                    walk([&f](const CborView item) {
+                        f(item);
+                        return true;
+                    });
+                }
+            }
+            if constexpr (std::invocable<F&, CborView, CborView>) {
+                if (type() != Type::eObj) return;
+                std::optional<CborView> key;
+                walk([&](const CborView item) {
+                    if (!key) {
+                        key = item;
+                    } else {
+                        f(*key, item);
+                        key.reset();
+                    }
+                    return true;
+                });
+            }
+        }
+
+        /**
+         * @brief Get the encoded bytes of the item, including its tags.
+         */
+        [[nodiscard]]
+        std::span<const std::byte> bytes() const noexcept {
+            return std::as_bytes(std::span{ m_begin, m_end });
+        }
+
+        /**
+         * @brief Decode the item into a Json type.
+         */
+        template<typename J>
+        [[nodiscard]]
+        std::optional<J> decode(const std::int32_t max_depth = 256) const noexcept {
+            return J::from_cbor(bytes(), max_depth);
+        }
+    };
+
+    /**
+     * @brief Read-only view of a value in a `json::Snapshot`.
+     * @details
+     * A view is a few pointers into the snapshot and is cheap to copy.
+     * Every access checks the offsets it follows against the snapshot size,
+     * so a corrupted file yields wrong values or exceptions but never reads out of bounds.
+     * The snapshot must stay alive while the view or any view taken from it is used.
+     */
+    class SnapshotView {
+        friend class Snapshot;
+        const std::uint64_t* m_slot;
+        const std::uint64_t* m_tape;
+        std::size_t m_words;
+        const char* m_pool;
+        std::size_t m_pool_size;
+
+        SnapshotView(const std::uint64_t* slot, const std::uint64_t* tape, const std::size_t words, const char* pool, const std::size_t pool_size) noexcept
+            : m_slot(slot), m_tape(tape), m_words(words), m_pool(pool), m_pool_size(pool_size) {}
+
+        [[nodiscard]]
+        SnapshotView child(const std::uint64_t* slot) const noexcept {
+            return { slot, m_tape, m_words, m_pool, m_pool_size };
+        }
+
+        /**
+         * @brief Get the children of an Arr (2 words each) or Obj (4 words each), `nullptr` if out of bounds.
+         */
+        [[nodiscard]]
+        const std::uint64_t* children(const std::size_t words_per_item) const noexcept {
+            const std::uint64_t count = m_slot[0] >> 8;
+            const std::uint64_t offset = m_slot[1];
+            if (offset > m_words || count > (m_words - offset) / words_per_item) return nullptr;
+            return m_tape + offset;
+        }
+
+        /**
+         * @brief Get the string of a Str slot, empty if out of bounds.
+         */
+        [[nodiscard]]
+        std::string_view string_of(const std::uint64_t* slot) const noexcept {
+            const std::uint64_t len = slot[0] >> 8;
+            const std::uint64_t offset = slot[1];
+            if (offset > m_pool_size || len > m_pool_size - offset) return {};
+            return { m_pool + offset, static_cast<std::size_t>(len) };
+        }
+
+        template<typename J>
+        static std::optional<J> build(const SnapshotView view, const std::int32_t max_depth) noexcept {
+            if (max_depth < 0) return std::nullopt;
+            try {
+                switch (view.type()) {
+                    case Type::eNul: return J{};
+                    case Type::eBol: return J{ static_cast<typename J::Bol>(view.m_slot[1] != 0) };
+                    case Type::eNum: return J{ std::bit_cast<typename J::Num>(view.m_slot[1]) };
+                    case Type::eStr: return J{ typename J::Str(view.string_of(view.m_slot)) };
+                    case Type::eArr: {
+                        typename J::Arr arr;
+                        arr.reserve(view.size());
+                        for (std::size_t i = 0; i < view.size(); ++i) {
+                            auto item = build<J>(view.child(view.children(2) + i * 2), max_depth - 1);
+                            if (!item) return std::nullopt;
+                            arr.emplace_back(std::move(*item));
+                        }
+                        return J{ std::move(arr) };
+                    }
+                    case Type::eObj: {
+                        J obj{ typename J::Obj{} };
+                        const std::uint64_t* items = view.children(4);
+                        for (std::size_t i = 0; i < view.size(); ++i) {
+                            auto value = build<J>(view.child(items + i * 4 + 2), max_depth - 1);
+                            if (!value) return std::nullopt;
+                            obj[view.string_of(items + i * 4)] = std::move(*value);
+                        }
+                        return obj;
+                    }
+                }
+            } catch (...) {}
+            return std::nullopt;
+        }
+
+    public:
+        /**
+         * @brief Get the type of the value.
+         */
+        [[nodiscard]]
+        Type type() const noexcept {
+            const auto tag = m_slot[0] & 0xff;
+            return tag <= static_cast<std::uint64_t>(Type::eObj) ? static_cast<Type>(tag) : Type::eNul;
+        }
+
+        [[nodiscard]] bool is_nul() const noexcept { return type() == Type::eNul; }
+        [[nodiscard]] bool is_bol() const noexcept { return type() == Type::eBol; }
+        [[nodiscard]] bool is_num() const noexcept { return type() == Type::eNum; }
+        [[nodiscard]] bool is_str() const noexcept { return type() == Type::eStr; }
+        [[nodiscard]] bool is_arr() const noexcept { return type() == Type::eArr; }
+        [[nodiscard]] bool is_obj() const noexcept { return type() == Type::eObj; }
+
+        /**
+         * @brief Get the number of items of an Arr or pairs of an Obj, 0 for other types.
+         */
+        [[nodiscard]]
+        std::size_t size() const noexcept {
+            if (type() == Type::eArr) return children(2) ? static_cast<std::size_t>(m_slot[0] >> 8) : 0;
+            if (type() == Type::eObj) return children(4) ? static_cast<std::size_t>(m_slot[0] >> 8) : 0;
+            return 0;
+        }
+
+        /**
+         * @brief Check if the value is empty, see `size`.
+         */
+        [[nodiscard]]
+        bool empty() const noexcept { return size() == 0; }
+
+        /**
+         * @brief Find the value of `key` in an Obj by binary search.
+         * @return `std::nullopt` if this is not an Obj or the key does not exist.
+         */
+        [[nodiscard]]
+        std::optional<SnapshotView> find(const std::string_view key) const noexcept {
+            if (type() != Type::eObj) return std::nullopt;
+            const std::uint64_t* items = children(4);
+            std::size_t low = 0;
+            std::size_t high = size();
+            while (low < high) {
+                const std::size_t mid = low + (high - low) / 2;
+                const auto order = string_of(items + mid * 4).compare(key);
+                if (order == 0) return child(items + mid * 4 + 2);
+                if (order < 0) low = mid + 1;
+                else high = mid;
+            }
+            return std::nullopt;
+        }
+
+        /**
+         * @brief Check if an Obj contains `key`.
+         */
+        [[nodiscard]]
+        bool contains(const std::string_view key) const noexcept { return find(key).has_value(); }
+
+        /**
+         * @brief Accessor for the value of `key` in an Obj, or the item at `index` of an Arr.
+         * @throw std::out_of_range if the key or index does not exist.
+         */
+        [[nodiscard]]
+        SnapshotView at(const std::string_view key) const {
+            const auto result = find(key);
+            if (!result) throw std::out_of_range("SnapshotView::at: key not found");
+            return *result;
+        }
+        [[nodiscard]]
+        SnapshotView at(const std::size_t index) const {
+            if (type() != Type::eArr || index >= size()) throw std::out_of_range("SnapshotView::at: index out of range");
+            return child(children(2) + index * 2);
+        }
+        [[nodiscard]]
+        SnapshotView operator[](const std::string_view key) const { return at(key); }
+        [[nodiscard]]
+        SnapshotView operator[](const std::size_t index) const { return at(index); }
+
+        /**
+         * @brief Call `f(item)` for each item of an Arr, or `f(key, value)` for each pair of an Obj in key order.
+         * @note A callable accepting only one of the two forms skips the other kind of container.
+         */
+        template<typename F>
+        void for_each(F&& f) const {
+            if constexpr (std::invocable<F&, SnapshotView>) {
+                if (type() == Type::eArr) {
+                    const std::uint64_t* items = children(2);
+                    for (std::size_t i = 0; i < size(); ++i) f(child(items + i * 2));
+                }
+            }
+            if constexpr (std::invocable<F&, std::string_view, SnapshotView>) {
+                if (type() == Type::eObj) {
+                    const std::uint64_t* items = children(4);
+                    for (std::size_t i = 0; i < size(); ++i) f(string_of(items + i * 4), child(items + i * 4 + 2));
+                }
+            }
+        }
+
+        /**
+         * @brief Type conversion, like `Json::to_if`, Str converts to anything constructible from `std::string_view`.
+         * @return The converted value, or `std::nullopt` if the type does not match.
+         * @note Num is double, so conversions to integral (and enum) types will round to nearest.
+         */
+        template<typename T>
+        requires std::is_same_v<T, std::nullptr_t> || std::is_arithmetic_v<T> || std::is_enum_v<T>
+            || std::is_constructible_v<T, std::string_view>
+        [[nodiscard]]
+        std::optional<T> to_if() const noexcept {
+            if constexpr (std::is_same_v<T, std::nullptr_t>) {
+                if (type() == Type::eNul) return nullptr;
+            } else if constexpr (std::is_same_v<T, bool>) {
+                if (type() == Type::eBol) return m_slot[1] != 0;
+            } else if constexpr (std::is_enum_v<T> || std::is_integral_v<T>) {
+                if (type() == Type::eNum) return static_cast<T>(std::llround(std::bit_cast<double>(m_slot[1])));
+            } else if constexpr (std::is_floating_point_v<T>) {
+                if (type() == Type::eNum) return static_cast<T>(std::bit_cast<double>(m_slot[1]));
+            } else {
+                if (type() == Type::eStr) return T(string_of(m_slot));
+            }
+            return std::nullopt;
+        }
+
+        /**
+         * @brief Type conversion, see `to_if`.
+         * @throw std::runtime_error if conversion fails.
+         */
+        template<typename T>
+        requires requires(const SnapshotView view) { view.to_if<T>(); }
+        [[nodiscard]]
+        T to() const {
+            auto opt = to_if<T>();
+            if (!opt) throw std::runtime_error("Cast fail.");
+            return std::move(*opt);
+        }
+
+        /**
+         * @brief Type conversion, see `to_if`.
+         * @return The converted value, or `default_result` if conversion fails.
+         */
+        template<typename T>
+        requires requires(const SnapshotView view) { view.to_if<T>(); }
+        [[nodiscard]]
+        T to_or(T default_result) const noexcept {
+            auto opt = to_if<T>();
+            if (!opt) return std::move(default_result);
+            return std::move(*opt);
+        }
+
+        /**
+         * @brief Copy the value and its children into a Json type.
+         * @param max_depth The maximum depth of nested arrays/objects allowed (default is 256).
+         * @return The value, or `std::nullopt` if it is nested deeper than `max_depth`.
+         */
+        template<typename J>
+        [[nodiscard]]
+        std::optional<J> decode(const std::int32_t max_depth = 256) const noexcept {
+            return build<J>(*this, max_depth - 1);
+        }
+    };
+
+    /**
+     * @brief A binary snapshot written by `Json::save_snapshot`, opened without parsing.
+     * @details
+     * `open` maps the file read-only with `mmap` where available, so opening costs O(1) whatever the size,
+     * pages are loaded on first access and shared by every process mapping the same file.
+     * Elsewhere the file is read into memory once. Only the header is checked when opening.
+     * Snapshots are move-only, views taken from a snapshot stay valid when it is moved.
+     */
+    class Snapshot {
+        const std::uint64_t* m_words{ nullptr };
+        std::size_t m_bytes{ 0 };
+        std::unique_ptr<std::uint64_t[]> m_owned;
+        bool m_mapped{ false };
+
+        Snapshot() noexcept = default;
+
+        void release() noexcept {
+#ifdef M_MYSVAC_JSON_HAS_MMAP
+            if (m_mapped) ::munmap(const_cast<std::uint64_t*>(m_words), m_bytes);
+#endif
+            m_owned.reset();
+            m_words = nullptr;
+            m_bytes = 0;
+            m_mapped = false;
+        }
+
+        /**
+         * @brief Check the header of the loaded bytes.
+         */
+        [[nodiscard]]
+        bool valid() const noexcept {
+            constexpr std::size_t header = snapshot_magic.size() + 3 * sizeof(std::uint64_t);
+            if (m_bytes < header + 2 * sizeof(std::uint64_t)) return false;
+            if (std::memcmp(m_words, snapshot_magic.data(), snapshot_magic.size()) != 0) return false;
+            if (m_words[1] != snapshot_order) return false;
+            const std::uint64_t words = m_words[2];
+            const std::uint64_t pool = m_words[3];
+            const std::uint64_t body = m_bytes - header;
+            return words >= 2 && words <= body / sizeof(std::uint64_t) && pool == body - words * sizeof(std::uint64_t);
+        }
+
+    public:
+        Snapshot(const Snapshot&) = delete;
+        Snapshot& operator=(const Snapshot&) = delete;
+        Snapshot(Snapshot&& other) noexcept
+            : m_words(std::exchange(other.m_words, nullptr)), m_bytes(std::exchange(other.m_bytes, 0)),
+              m_owned(std::move(other.m_owned)), m_mapped(std::exchange(other.m_mapped, false)) {}
+        Snapshot& operator=(Snapshot&& other) noexcept {
+            if (this != &other) {
+                release();
+                m_words = std::exchange(other.m_words, nullptr);
+                m_bytes = std::exchange(other.m_bytes, 0);
+                m_owned = std::move(other.m_owned);
+                m_mapped = std::exchange(other.m_mapped, false);
+            }
+            return *this;
+        }
+        ~Snapshot() { release(); }
+
+        /**
+         * @brief Open a snapshot file.
+         * @return The snapshot, or `std::nullopt` if the file cannot be read or is not a snapshot
+         * of this platform's byte order.
+         */
+        [[nodiscard]]
+        static std::optional<Snapshot> open(const std::filesystem::path& path) noexcept {
+            Snapshot result;
+#ifdef M_MYSVAC_JSON_HAS_MMAP
+            const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) return std::nullopt;
+            struct ::stat info{};
+            if (::fstat(fd, &info) != 0 || info.st_size <= 0) {
+                ::close(fd);
+                return std::nullopt;
+            }
+            void* map = ::mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if (map == MAP_FAILED) return std::nullopt;
+            result.m_words = static_cast<const std::uint64_t*>(map);
+            result.m_bytes = static_cast<std::size_t>(info.st_size);
+            result.m_mapped = true;
+#else
+            try {
+                std::ifstream file(path, std::ios::binary | std::ios::ate);
+                if (!file) return std::nullopt;
+                const auto size = static_cast<std::size_t>(file.tellg());
+                result.m_owned = std::make_unique_for_overwrite<std::uint64_t[]>(size / sizeof(std::uint64_t) + 1);
+                file.seekg(0);
+                if (!file.read(reinterpret_cast<char*>(result.m_owned.get()), static_cast<std::streamsize>(size))) return std::nullopt;
+                result.m_words = result.m_owned.get();
+                result.m_bytes = size;
+            } catch (...) {
+                return std::nullopt;
+            }
+#endif
+            if (!result.valid()) return std::nullopt;
+            return result;
+        }
+
+        /**
+         * @brief Load a snapshot from bytes in memory, e.g. the output of `Json::write_snapshot`.
+         * @return The snapshot holding a copy of `data`, or `std::nullopt` if it is not a snapshot.
+         */
+        [[nodiscard]]
+        static std::optional<Snapshot> load(const std::span<const std::byte> data) noexcept {
+            Snapshot result;
+            try {
+                result.m_owned = std::make_unique_for_overwrite<std::uint64_t[]>(data.size() / sizeof(std::uint64_t) + 1);
+            } catch (...) {
+                return std::nullopt;
+            }
+            if (!data.empty()) std::memcpy(result.m_owned.get(), data.data(), data.size());
+            result.m_words = result.m_owned.get();
+            result.m_bytes = data.size();
+            if (!result.valid()) return std::nullopt;
+            return result;
+        }
+
+        /**
+         * @brief Get a view of the root value.
+         */
+        [[nodiscard]]
+        SnapshotView root() const noexcept {
+            const std::uint64_t* tape = m_words + 4;
+            const auto words = static_cast<std::size_t>(m_words[2]);
+            return { tape, tape, words, reinterpret_cast<const char*>(tape + words), static_cast<std::size_t>(m_words[3]) };
+        }
+
+        /**
+         * @brief Get the size of the snapshot in bytes.
+         */
+        [[nodiscard]]
+        std::size_t bytes() const noexcept { return m_bytes; }
+    };
+
+    /**
+     * @brief Read-only view of a value in a `json::TapeDocument`.
+     * @details
+     * A view is the document and a tape index, and is cheap to copy.
+     * The document must stay alive while the view or any view taken from it is used.
+     */
+    class TapeView {
+        friend class TapeDocument;
+        const std::uint64_t* m_tape;
+        const char* m_strings;
+        std::size_t m_index;
+
+        TapeView(const std::uint64_t* tape, const char* strings, const std::size_t index) noexcept
+            : m_tape(tape), m_strings(strings), m_index(index) {}
+
+        [[nodiscard]]
+        static char tag_of(const std::uint64_t word) noexcept { return static_cast<char>(word >> 56); }
+        [[nodiscard]]
+        static std::uint64_t payload_of(const std::uint64_t word) noexcept { return word & 0x00ff'ffff'ffff'ffff; }
+
+        /**
+         * @brief Get the index just past the value at `index`, its next sibling.
+         */
+        [[nodiscard]]
+        std::size_t next(const std::size_t index) const noexcept {
+            switch (tag_of(m_tape[index])) {
+                case '[': case '{': return static_cast<std::size_t>(payload_of(m_tape[index]));
+                case 'd': case '"': return index + 2;
+                default: return index + 1;
+            }
+        }
+
+        [[nodiscard]]
+        std::string_view string_at(const std::size_t index) const noexcept {
+            return { m_strings + payload_of(m_tape[index]), static_cast<std::size_t>(m_tape[index + 1]) };
+        }
+
+        [[nodiscard]]
+        TapeView child(const std::size_t index) const noexcept { return { m_tape, m_strings, index }; }
+
+    public:
+        /**
+         * @brief Get the type of the value.
+         */
+        [[nodiscard]]
+        Type type() const noexcept {
+            switch (tag_of(m_tape[m_index])) {
+                case 't': case 'f': return Type::eBol;
+                case 'd': return Type::eNum;
+                case '"': return Type::eStr;
+                case '[': return Type::eArr;
+                case '{': return Type::eObj;
+                default: return Type::eNul;
+            }
+        }
+
+        [[nodiscard]] bool is_nul() const noexcept { return type() == Type::eNul; }
+        [[nodiscard]] bool is_bol() const noexcept { return type() == Type::eBol; }
+        [[nodiscard]] bool is_num() const noexcept { return type() == Type::eNum; }
+        [[nodiscard]] bool is_str() const noexcept { return type() == Type::eStr; }
+        [[nodiscard]] bool is_arr() const noexcept { return type() == Type::eArr; }
+        [[nodiscard]] bool is_obj() const noexcept { return type() == Type::eObj; }
+
+        /**
+         * @brief Get the number of items of an Arr or pairs of an Obj, 0 for other types.
+         * @note O(1), the closing word holds the count.
+         */
+        [[nodiscard]]
+        std::size_t size() const noexcept {
+            if (!is_arr() && !is_obj()) return 0;
+            return static_cast<std::size_t>(payload_of(m_tape[next(m_index) - 1]));
+        }
+
+        [[nodiscard]]
+        bool empty() const noexcept { return size() == 0; }
+
+        /**
+         * @brief Find the value of the first pair of an Obj whose key is `key`.
+         * @return `std::nullopt` if this is not an Obj or the key does not exist.
+         * @note Linear in the number of pairs, every value is skipped in O(1).
+         */
+        [[nodiscard]]
+        std::optional<TapeView> find(const std::string_view key) const noexcept {
+            if (!is_obj()) return std::nullopt;
+            const std::size_t end = next(m_index) - 1;
+            for (std::size_t i = m_index + 1; i < end; i = next(i + 2)) {
+                if (string_at(i) == key) return child(i + 2);
+            }
+            return std::nullopt;
+        }
+
+        /**
+         * @brief Check if an Obj contains `key`.
+         */
+        [[nodiscard]]
+        bool contains(const std::string_view key) const noexcept { return find(key).has_value(); }
+
+        /**
+         * @brief Accessor for the value of `key` in an Obj, or the item at `index` of an Arr.
+         * @throw std::out_of_range if the key or index does not exist.
+         * @note Items before `index` are skipped in O(1) each.
+         */
+        [[nodiscard]]
+        TapeView at(const std::string_view key) const {
+            const auto result = find(key);
+            if (!result) throw std::out_of_range("TapeView::at: key not found");
+            return *result;
+        }
+        [[nodiscard]]
+        TapeView at(const std::size_t index) const {
+            if (!is_arr() || index >= size()) throw std::out_of_range("TapeView::at: index out of range");
+            std::size_t i = m_index + 1;
+            for (std::size_t n = 0; n < index; ++n) i = next(i);
+            return child(i);
+        }
+        [[nodiscard]]
+        TapeView operator[](const std::string_view key) const { return at(key); }
+        [[nodiscard]]
+        TapeView operator[](const std::size_t index) const { return at(index); }
+
+        /**
+         * @brief Call `f(item)` for each item of an Arr, or `f(key, value)` for each pair of an Obj.
+         * @note A callable accepting only one of the two forms skips the other kind of container.
+         */
+        template<typename F>
+        void for_each(F&& f) const {
+            const std::size_t end = next(m_index) - 1;
+            if constexpr (std::invocable<F&, TapeView>) {
+                if (is_arr()) {
+                    for (std::size_t i = m_index + 1; i < end; i = next(i)) f(child(i));
+                }
+            }
+            if constexpr (std::invocable<F&, std::string_view, TapeView>) {
+                if (is_obj()) {
+                    for (std::size_t i = m_index + 1; i < end; i = next(i + 2)) f(string_at(i), child(i + 2));
+                }
+            }
+        }
+
+        /**
+         * @brief Type conversion, like `Json::to_if`, Str converts to anything constructible from `std::string_view`.
+         * @return The converted value, or `std::nullopt` if the type does not match.
+         * @note Num is double, so conversions to integral (and enum) types will round to nearest.
+         */
+        template<typename T>
+        requires std::is_same_v<T, std::nullptr_t> || std::is_arithmetic_v<T> || std::is_enum_v<T>
+            || std::is_constructible_v<T, std::string_view>
+        [[nodiscard]]
+        std::optional<T> to_if() const noexcept {
+            if constexpr (std::is_same_v<T, std::nullptr_t>) {
+                if (is_nul()) return nullptr;
+            } else if constexpr (std::is_same_v<T, bool>) {
+                if (is_bol()) return tag_of(m_tape[m_index]) == 't';
+            } else if constexpr (std::is_enum_v<T> || std::is_integral_v<T>) {
+                if (is_num()) return static_cast<T>(std::llround(std::bit_cast<double>(m_tape[m_index + 1])));
+            } else if constexpr (std::is_floating_point_v<T>) {
+                if (is_num()) return static_cast<T>(std::bit_cast<double>(m_tape[m_index + 1]));
+            } else {
+                if (is_str()) return T(string_at(m_index));
+            }
+            return std::nullopt;
+        }
+
+        /**
+         * @brief Type conversion, see `to_if`.
+         * @throw std::runtime_error if conversion fails.
+         */
+        template<typename T>
+        requires requires(const TapeView view) { view.to_if<T>(); }
         [[nodiscard]]
-        T  to( D default_range_elem = D{} ) const {
-            auto opt = to_if<T, D>( std::move(default_range_elem) );
+        T to() const {
+            auto opt = to_if<T>();
             if (!opt) throw std::runtime_error("Cast fail.");
-            return *opt;
+            return std::move(*opt);
         }
 
         /**
-         * @brief type conversion, copy inner value to specified type
-         * @tparam T The target type to convert to
-         * @tparam D The mapped_type or value_type of the target type, used for range conversion, default is Nul for other types(useless).
-         * @param default_result The default value to return if conversion fails
-         * @param default_range_elem if T is a range type and is not json::Arr or json::Obj, must be specified for safe conversion. Else, please use default value.
-         * @return The converted value or default_value if conversion fails
-         * @note Num is double, so conversions to integral (and enum) types will round to nearest.
-         * @details
-         * Attempt sequence of conversions:
-         * inner value type -> target type
-         * 1-17: equal to `to_if<T, D>()`
-         * 18: return default_result
+         * @brief Type conversion, see `to_if`.
+         * @return The converted value, or `default_result` if conversion fails.
          */
-        template<typename T, typename D = Nul>
-        requires convertible<Json, T> || convertible_map<Json, T, D> || convertible_array<Json, T, D>
+        template<typename T>
+        requires requires(const TapeView view) { view.to_if<T>(); }
         [[nodiscard]]
-        T  to_or( T default_result, D default_range_elem = D{} ) const noexcept {
-            auto opt = to_if<T, D>( std::move(default_range_elem) );
+        T to_or(T default_result) const noexcept {
+            auto opt = to_if<T>();
             if (!opt) return std::move(default_result);
-            return *opt;
+            return std::move(*opt);
         }
 
         /**
-         * @brief type conversion, Move or Copy inner value to specified type
-         * @tparam T The target type to convert to
-         * @tparam D The mapped_type or value_type of the target type, used for range conversion, default is Nul for other types(useless).
-         * @param default_range_elem if T is a range type and is not json::Arr or json::Obj, must be specified for safe conversion. Else, please use default value.
-         * @return The converted value
-         * @note
-         * Num is double, so conversions to integral (and enum) types will round to nearest.
-         * Complex types like Obj, Arr, Str will be moved if possible.
-         * Simple types like Bol, Num, Nul will be copied.
-         * @details
-         * Attempt sequence of conversions:
-         * inner value type -> target type
-         * 1. Nul -> Nul
-         * 2. Obj -> Obj (Move)
-         * 3. Arr -> Arr (Move)
-         * 4. Str -> Str (Move)
-         * 5. Bol -> Bol
-         * 6. Num -> enum types (us llround, round to nearest)
-         * 7. Num -> integral types (us llround, round to nearest)
-         * 8. Num -> floating_point types
-         * 9. Any -> T is constructible from json::Value (try Move)
-         * 10. Obj -> implicit convertible types (try Move)
-         * 11. Arr -> implicit convertible types (try Move)
-         * 12. Str -> implicit convertible types (try Move)
-         * 13. Num -> implicit convertible types
-         * 14. Bol -> implicit convertible types
-         * 15. Nul -> implicit convertible types (Nul is not convertible to bool !!!!!)
-         * 16. Obj -> Try copy to `range && Str->key_type && Value->mapped_type types && have default_range_value`  (try Move)
-         * 17. Arr -> Try copy to `range && Value->value_type types && have default_range_value`  (try Move)
-         * 18. return std::nullopt;
+         * @brief Write the value as compact JSON, the same text as `Json::write`.
+         * @details The tape is streamed front to back, only separators need a stack.
+         */
+        template<output_sink S>
+        void write(S& out) const {
+            // per open container, whether it is an Obj and how many keys and values it wrote
+            std::vector<std::pair<bool, std::uint64_t>> open;
+            const std::size_t end = next(m_index);
+            for (std::size_t i = m_index; i < end;) {
+                const char tag = tag_of(m_tape[i]);
+                if (tag == ']' || tag == '}') {
+                    out.push_back(tag);
+                    open.pop_back();
+                    ++i;
+                    continue;
+                }
+                if (!open.empty()) {
+                    auto& [object, written] = open.back();
+                    if (written) out.push_back(object && written % 2 ? ':' : ',');
+                    ++written;
+                }
+                switch (tag) {
+                    case '[': case '{':
+                        out.push_back(tag);
+                        open.emplace_back(tag == '{', 0);
+                        ++i;
+                        break;
+                    case '"':
+                        escape_to<true>(out, string_at(i));
+                        i += 2;
+                        break;
+                    case 'd':
+                        number_to(out, std::bit_cast<double>(m_tape[i + 1]));
+                        i += 2;
+                        break;
+                    case 't': out.append("true", 4); ++i; break;
+                    case 'f': out.append("false", 5); ++i; break;
+                    default: out.append("null", 4); ++i; break;
+                }
+            }
+        }
+
+        /**
+         * @brief Serialize the value to a compact JSON string.
          */
-        template<typename T, typename D = Nul>
-        requires convertible<Json, T> || convertible_map<Json, T, D> || convertible_array<Json, T, D>
         [[nodiscard]]
-        std::optional<T>  move_if( D default_range_elem = D{} ) noexcept  {
-            if constexpr (std::is_same_v<T, Nul>) {
-                if (type() == Type::eNul) return Nul{};
-            } else if constexpr (std::is_same_v<T, Obj>) {
-                if (type() == Type::eObj) return std::move(std::get<Obj>(m_data));
-            } else if constexpr (std::is_same_v<T, Arr>) {
-                if (type() == Type::eArr) return std::move(std::get<Arr>(m_data));
-            } else if constexpr (std::is_same_v<T, Str>) {
-                if (type() == Type::eStr) return std::move(std::get<Str>(m_data));
-            } else if constexpr (std::is_same_v<T, Bol>) {
-                if (type() == Type::eBol) return std::get<Bol>(m_data);
-            } else if constexpr (std::is_enum_v<T>) {
-                if (type() == Type::eNum) return static_cast<T>(std::llround(std::get<Num>(m_data)));
-            } else if constexpr (std::is_integral_v<T>) {
-                if (type() == Type::eNum) return static_cast<T>(std::llround(std::get<Num>(m_data)));
-            } else if constexpr (std::is_floating_point_v<T>) {
-                if (type() == Type::eNum) return static_cast<T>(std::get<Num>(m_data));
+        std::string dump() const {
+            std::string out;
+            write(out);
+            return out;
+        }
+
+        /**
+         * @brief Copy the value and its children into a Json type.
+         * @note Recursion is bounded by the `max_depth` the document was parsed with.
+         */
+        template<typename J>
+        [[nodiscard]]
+        std::optional<J> decode() const noexcept {
+            try {
+                switch (type()) {
+                    case Type::eNul: return J{};
+                    case Type::eBol: return J{ static_cast<typename J::Bol>(tag_of(m_tape[m_index]) == 't') };
+                    case Type::eNum: return J{ std::bit_cast<typename J::Num>(m_tape[m_index + 1]) };
+                    case Type::eStr: return J{ typename J::Str(string_at(m_index)) };
+                    case Type::eArr: {
+                        typename J::Arr arr;
+                        arr.reserve(size());
+                        for_each([&arr](const TapeView item) { arr.emplace_back(item.decode<J>().value()); });
+                        return J{ std::move(arr) };
+                    }
+                    case Type::eObj: {
+                        J obj{ typename J::Obj{} };
+                        // the first of duplicated keys is kept, like `Json::parse`
+                        for_each([&obj](const std::string_view key, const TapeView value) {
+                            if (!obj.contains(key)) obj[key] = value.decode<J>().value();
+                        });
+                        return obj;
+                    }
+                }
+            } catch (...) {}
+            return std::nullopt;
+        }
+    };
+
+    /**
+     * @brief Immutable JSON document held in one tape of 64-bit words and one string buffer.
+     * @details
+     * `parse` fills the tape directly in document order, there is no node per value:
+     * - the top byte of a word is a tag, the low 56 bits a payload
+     * - `n`, `t`, `f` take one word; `d` is followed by the bits of the double
+     * - `"` holds an offset into the string buffer and is followed by the length, keys included
+     * - `[` and `{` hold the index just past their closing word, so a container is skipped in O(1),
+     *   `]` and `}` hold the number of items or pairs
+     *
+     * The whole document is two allocations and is destroyed at once.
+     * Use it for read-only payloads, `Json` for anything that is modified.
+     */
+    class TapeDocument {
+        std::vector<std::uint64_t> m_tape;
+        std::string m_strings;
+
+        TapeDocument() = default;
+
+        static constexpr std::uint64_t word(const char tag, const std::uint64_t payload = 0) noexcept {
+            return static_cast<std::uint64_t>(static_cast<unsigned char>(tag)) << 56 | payload;
+        }
+
+        /**
+         * @brief Read a string into the buffer and append its two words, `it` is at the opening quote.
+         */
+        bool read_string(std::string_view::const_iterator& it, const std::string_view::const_iterator end) {
+            const std::size_t offset = m_strings.size();
+            ++it;
+            while (true) {
+                const auto run = std::find_if(it, end, [](const char c) { return c == '\"' || c == '\\'; });
+                m_strings.append(it, run);
+                it = run;
+                if (it == end) return false;
+                if (*it == '\"') break;
+                if (++it == end) return false;
+                switch (*it) {
+                    case '\"': m_strings.push_back('\"'); break;
+                    case '\\': m_strings.push_back('\\'); break;
+                    case '/':  m_strings.push_back('/'); break;
+                    case 'n':  m_strings.push_back('\n'); break;
+                    case 'r':  m_strings.push_back('\r'); break;
+                    case 't':  m_strings.push_back('\t'); break;
+                    case 'f':  m_strings.push_back('\f'); break;
+                    case 'b':  m_strings.push_back('\b'); break;
+                    case 'u': case 'U': if (!Json<>::unescape_unicode_next(m_strings, it, end)) return false; break;
+                    default: return false;
+                }
+                ++it;
             }
-            if constexpr (std::is_constructible_v<T, Json>) {
-                return static_cast<T>(std::move(*this));
+            ++it;
+            m_tape.push_back(word('\"', offset));
+            m_tape.push_back(m_strings.size() - offset);
+            return true;
+        }
+
+    public:
+        /**
+         * @brief Parse JSON text into a tape, accepting the same input as `Json::parse`.
+         * @param text The JSON text.
+         * @param max_depth The maximum depth of nested arrays/objects allowed (default is 256).
+         * @return The document, or `std::nullopt` if the text is not valid JSON.
+         * @note Nesting is tracked on an explicit stack.
+         */
+        [[nodiscard]]
+        static std::optional<TapeDocument> parse(const std::string_view text, const std::int32_t max_depth = 256) noexcept {
+            TapeDocument doc;
+            try {
+                // the tape grows if needed, strings never get longer when unescaped
+                doc.m_tape.reserve(text.size() / 4 + 8);
+                doc.m_strings.reserve(text.size());
+                // per open container, its opening index and the number of items or pairs so far
+                std::vector<std::pair<std::size_t, std::uint64_t>> open;
+                auto it = text.begin();
+                const auto end = text.end();
+                const auto skip_spaces = [&it, end] { while (it != end && std::isspace(*it)) ++it; };
+                const auto is_object = [&doc, &open] { return TapeView::tag_of(doc.m_tape[open.back().first]) == '{'; };
+                // after `{` or `,` in an Obj: read the key and `:`, `it` is left at the value
+                const auto read_key = [&] {
+                    if (it == end || *it != '\"' || !doc.read_string(it, end)) return false;
+                    skip_spaces();
+                    if (it == end || *it != ':') return false;
+                    ++it;
+                    skip_spaces();
+                    return it != end;
+                };
+                skip_spaces();
+                if (it == end) return std::nullopt;
+                bool value_ended = false;
+                bool closing = false;
+                while (true) {
+                    if (!value_ended) {
+                        if (std::cmp_greater_equal(open.size(), max_depth)) return std::nullopt;
+                        switch (*it) {
+                            case '[': case '{': {
+                                const char close = *it == '[' ? ']' : '}';
+                                open.emplace_back(doc.m_tape.size(), 0);
+                                doc.m_tape.push_back(word(*it));
+                                ++it;
+                                skip_spaces();
+                                if (it == end) return std::nullopt;
+                                if (*it == close) {
+                                    value_ended = true;
+                                    closing = true;
+                                    continue;
+                                }
+                                if (close == '}' && !read_key()) return std::nullopt;
+                                continue;
+                            }
+                            case '\"':
+                                if (!doc.read_string(it, end)) return std::nullopt;
+                                break;
+                            case 't':
+                                if (end - it < 4 || std::string_view{ it, it + 4 } != "true") return std::nullopt;
+                                doc.m_tape.push_back(word('t'));
+                                it += 4;
+                                break;
+                            case 'f':
+                                if (end - it < 5 || std::string_view{ it, it + 5 } != "false") return std::nullopt;
+                                doc.m_tape.push_back(word('f'));
+                                it += 5;
+                                break;
+                            case 'n':
+                                if (end - it < 4 || std::string_view{ it, it + 4 } != "null") return std::nullopt;
+                                doc.m_tape.push_back(word('n'));
+                                it += 4;
+                                break;
+                            default: {
+                                const auto start = it;
+                                while (it != end && it - start < 26 &&
+                                    (std::isdigit(*it) || *it == '-' || *it == '.' || *it == 'e' || *it == 'E' || *it == '+')
+                                ) ++it;
+                                if (it == start || it - start == 26) return std::nullopt;
+                                double value;
+                                if (const auto [ptr, ec] = std::from_chars(std::to_address(start), std::to_address(it), value);
+                                    ec != std::errc{} || ptr != std::to_address(it)
+                                ) return std::nullopt;
+                                doc.m_tape.push_back(word('d'));
+                                doc.m_tape.push_back(std::bit_cast<std::uint64_t>(value));
+                            } break;
+                        }
+                        value_ended = true;
+                    }
+                    // a value ended, or an empty container is closing at `it`
+                    if (open.empty()) break;
+                    const bool object = is_object();
+                    const char close = object ? '}' : ']';
+                    if (!std::exchange(closing, false)) {
+                        ++open.back().second;
+                        skip_spaces();
+                        if (it == end) return std::nullopt;
+                        if (*it == ',') {
+                            ++it;
+                            skip_spaces();
+                            if (it == end) return std::nullopt;
+                            // a trailing comma is accepted, like `Json::parse`
+                            if (*it != close) {
+                                if (object && !read_key()) return std::nullopt;
+                                value_ended = false;
+                                continue;
+                            }
+                        } else if (*it != close) return std::nullopt;
+                    }
+                    const auto [start, count] = open.back();
+                    open.pop_back();
+                    doc.m_tape.push_back(word(close, count));
+                    doc.m_tape[start] |= doc.m_tape.size();
+                    ++it;
+                }
+                skip_spaces();
+                if (it != end) return std::nullopt;
+            } catch (...) {
+                return std::nullopt;
             }
-            if constexpr (std::is_convertible_v<Obj, T>) {
-                if (type() == Type::eObj) return static_cast<T>(std::move(std::get<Obj>(m_data)));
+            return doc;
+        }
+
+        /**
+         * @brief Get a view of the root value.
+         */
+        [[nodiscard]]
+        TapeView root() const noexcept { return { m_tape.data(), m_strings.data(), 0 }; }
+
+        /**
+         * @brief Write the document as compact JSON, see `TapeView::write`.
+         */
+        template<output_sink S>
+        void write(S& out) const { root().write(out); }
+
+        /**
+         * @brief Serialize the document to a compact JSON string.
+         */
+        [[nodiscard]]
+        std::string dump() const { return root().dump(); }
+
+        /**
+         * @brief Get the number of words of the tape.
+         */
+        [[nodiscard]]
+        std::size_t tape_size() const noexcept { return m_tape.size(); }
+    };
+
+    /**
+     * @brief JSON Pointer (RFC 6901), parsed once and applied to any Json type.
+     * @details
+     * Each reference token keeps its unescaped key, its array index if it is one,
+     * and its key hash for the `eHash` and `eIndex` backends, so evaluating the same pointer
+     * on many documents neither re-parses the path nor allocates.
+     */
+    class JsonPointer {
+        static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+        struct token {
+            std::string key;
+            std::size_t index;  ///< the array index, or `npos`
+            std::size_t hash;   ///< `SeededHash` of the key
+            bool append;        ///< the token is `-`, the position past the last item
+        };
+        std::vector<token> m_tokens;
+
+        static token make_token(std::string key) {
+            std::size_t index = npos;
+            // digits without leading zeros, that fit in size_t
+            if (!key.empty() && key.size() <= 19 && std::ranges::all_of(key, [](const char c) { return c >= '0' && c <= '9'; })
+                && (key.size() == 1 || key.front() != '0')
+            ) index = static_cast<std::size_t>(std::stoull(key));
+            const std::size_t hash = SeededHash{}(key);
+            const bool append = key == "-";
+            return { std::move(key), index, hash, append };
+        }
+
+        template<typename J, typename M>
+        static auto find_member(M& obj, const token& item) {
+            return std::remove_const_t<J>::find_key(obj, item.key, item.hash);
+        }
+
+        template<typename J>
+        static J* step(J& node, const token& item) noexcept {
+            if (node.is_obj()) {
+                auto& obj = node.obj();
+                const auto it = find_member<J>(obj, item);
+                return it == obj.end() ? nullptr : &it->second;
             }
-            if constexpr (std::is_convertible_v<Arr, T>) {
-                if (type() == Type::eArr) return static_cast<T>(std::move(std::get<Arr>(m_data)));
+            if (node.is_arr()) {
+                auto& arr = node.arr();
+                return item.index < arr.size() ? &arr[item.index] : nullptr;
             }
-            if constexpr (std::is_convertible_v<Str, T>) {
-                if (type() == Type::eStr) return static_cast<T>(std::move(std::get<Str>(m_data)));
+            return nullptr;
+        }
+
+    public:
+        /**
+         * @brief The empty pointer, referring to the whole document.
+         */
+        JsonPointer() = default;
+
+        /**
+         * @brief Parse a JSON Pointer, `""` or a sequence of `/token`, with `~0` for `~` and `~1` for `/`.
+         * @return The pointer, or `std::nullopt` if the text is not a valid JSON Pointer.
+         */
+        [[nodiscard]]
+        static std::optional<JsonPointer> parse(const std::string_view text) noexcept {
+            JsonPointer result;
+            if (text.empty()) return result;
+            if (text.front() != '/') return std::nullopt;
+            try {
+                std::size_t begin = 1;
+                while (true) {
+                    const std::size_t end = std::min(text.find('/', begin), text.size());
+                    std::string key;
+                    key.reserve(end - begin);
+                    for (std::size_t i = begin; i < end; ++i) {
+                        if (text[i] != '~') {
+                            key.push_back(text[i]);
+                            continue;
+                        }
+                        if (++i == end || (text[i] != '0' && text[i] != '1')) return std::nullopt;
+                        key.push_back(text[i] == '0' ? '~' : '/');
+                    }
+                    result.m_tokens.push_back(make_token(std::move(key)));
+                    if (end == text.size()) break;
+                    begin = end + 1;
+                }
+            } catch (...) {
+                return std::nullopt;
+            }
+            return result;
+        }
+
+        /**
+         * @brief Get the pointer text, with `~` and `/` escaped.
+         */
+        [[nodiscard]]
+        std::string to_string() const {
+            std::string out;
+            for (const auto& item : m_tokens) {
+                out.push_back('/');
+                for (const char c : item.key) {
+                    if (c == '~') out.append("~0", 2);
+                    else if (c == '/') out.append("~1", 2);
+                    else out.push_back(c);
+                }
+            }
+            return out;
+        }
+
+        /**
+         * @brief Get the number of reference tokens.
+         */
+        [[nodiscard]]
+        std::size_t size() const noexcept { return m_tokens.size(); }
+
+        /**
+         * @brief Check if the pointer refers to the whole document.
+         */
+        [[nodiscard]]
+        bool empty() const noexcept { return m_tokens.empty(); }
+
+        /**
+         * @brief Get the value the pointer refers to.
+         * @return A pointer to the value, `nullptr` if the path does not exist.
+         * @note `-` never exists. Arr tokens must be indices, Obj tokens are keys.
+         * The walk uses the const accessors of any `J`, it neither detaches shared nodes nor drops cached dumps,
+         * so with `eShared` or `UseDumpCache` a value is modified through `set`, not through the result.
+         */
+        template<typename J>
+        requires requires { typename std::remove_const_t<J>::Obj; }
+        [[nodiscard]]
+        J* get_if(J& root) const noexcept {
+            // walk the const accessors, a lookup neither detaches shared nodes nor drops cached dumps
+            const std::remove_const_t<J>* node = &root;
+            for (const auto& item : m_tokens) {
+                node = step(*node, item);
+                if (!node) return nullptr;
+            }
+            return const_cast<J*>(node);
+        }
+
+        /**
+         * @brief Get the value the pointer refers to.
+         * @throw std::out_of_range if the path does not exist.
+         */
+        template<typename J>
+        requires requires { typename std::remove_const_t<J>::Obj; }
+        [[nodiscard]]
+        J& get(J& root) const {
+            J* node = get_if(root);
+            if (!node) throw std::out_of_range("JsonPointer::get: path not found");
+            return *node;
+        }
+
+        /**
+         * @brief Check if the path exists in `root`.
+         */
+        template<typename J>
+        requires requires { typename J::Obj; }
+        [[nodiscard]]
+        bool contains(const J& root) const noexcept { return get_if(root) != nullptr; }
+
+        /**
+         * @brief Set the value the pointer refers to, creating missing members and containers on the way.
+         * @return The value set.
+         * @throw std::out_of_range if the path passes through a Bol, Num or Str,
+         * or an Arr index is past the end. An index equal to the size, or `-`, appends.
+         * @details A Nul on the way becomes an Arr if the next token is an index or `-`, an Obj otherwise.
+         */
+        template<typename J, typename V>
+        requires requires { typename J::Obj; } && std::constructible_from<J, V>
+        J& set(J& root, V&& value) const {
+            J* node = &root;
+            for (const auto& item : m_tokens) {
+                if (node->is_nul()) {
+                    if (item.index != npos || item.append) *node = typename J::Arr{};
+                    else *node = typename J::Obj{};
+                }
+                if (node->is_obj()) {
+                    auto& obj = node->obj();
+                    node = &J::find_or_insert(obj, item.key);
+                } else if (node->is_arr()) {
+                    auto& arr = node->arr();
+                    if (item.append || item.index == arr.size()) node = &arr.emplace_back();
+                    else if (item.index < arr.size()) node = &arr[item.index];
+                    else throw std::out_of_range("JsonPointer::set: index out of range");
+                } else {
+                    throw std::out_of_range("JsonPointer::set: path passes through a scalar");
+                }
+            }
+            *node = J(std::forward<V>(value));
+            return *node;
+        }
+
+        /**
+         * @brief Remove the value the pointer refers to from its parent.
+         * @return `false` if the path does not exist, or the pointer is empty.
+         */
+        template<typename J>
+        requires requires { typename J::Obj; }
+        bool erase(J& root) const noexcept(noexcept(root.erase(std::string_view{}))) {
+            if (m_tokens.empty()) return false;
+            J* parent = &root;
+            for (std::size_t i = 0; i + 1 < m_tokens.size(); ++i) {
+                parent = step(*parent, m_tokens[i]);
+                if (!parent) return false;
+            }
+            const auto& last = m_tokens.back();
+            if (parent->is_obj()) {
+                auto& obj = parent->obj();
+                const auto it = find_member<J>(obj, last);
+                if (it == obj.end()) return false;
+                obj.erase(it);
+                return true;
+            }
+            return parent->is_arr() && parent->erase(last.index);
+        }
+
+        [[nodiscard]]
+        bool operator==(const JsonPointer& other) const noexcept {
+            return std::ranges::equal(m_tokens, other.m_tokens, {}, &token::key, &token::key);
+        }
+    };
+
+    /**
+     * @brief JSONPath query (RFC 9535 subset), compiled once and evaluated on any Json type.
+     * @details
+     * Supported: `$`, `.name`, `.*`, `..` descendants, and bracketed unions of quoted names,
+     * `*`, indexes (negative from the end), slices `start:end:step` and filters `?expr`.
+     * Filters compare singular paths (`@.a[0]`, `$.b`) and literals with `== != < <= > >=`,
+     * test existence, and combine with `&& || !` and parentheses.
+     *
+     * A query compiles to a list of segments, each a set of selectors applied to the children
+     * of the nodes reached so far, with descendant segments staying active below them.
+     * `select_all` runs any number of queries as one automaton: a single traversal carries
+     * the active (query, segment) states of each node and skips subtrees where none remain,
+     * containers whose states only hold names and indexes are entered by lookups instead of a scan.
+     */
+    class JsonPath {
+        using literal = std::variant<std::nullptr_t, bool, double, std::string>;
+
+        struct path_item {
+            std::string name;
+            std::size_t hash;   ///< `SeededHash` of the name
+            std::int64_t index;
+            bool is_index;
+        };
+
+        struct operand {
+            enum class Kind : std::uint8_t { eLiteral, eCurrent, eRoot } kind;
+            literal value;
+            std::vector<path_item> path;
+        };
+
+        struct expr {
+            enum class Kind : std::uint8_t { eOr, eAnd, eNot, eTest, eCompare } kind;
+            enum class Op : std::uint8_t { eEq, eNe, eLt, eLe, eGt, eGe } op;
+            std::size_t left;   ///< sub-expression, or operand of `eTest` and `eCompare`
+            std::size_t right;
+        };
+
+        struct selector {
+            enum class Kind : std::uint8_t { eName, eWildcard, eIndex, eSlice, eFilter } kind;
+            std::string name;
+            std::size_t hash{};
+            std::int64_t index{};   ///< the index, or the filter expression
+            std::optional<std::int64_t> start;
+            std::optional<std::int64_t> end;
+            std::int64_t step{ 1 };
+        };
+
+        struct segment {
+            std::vector<selector> selectors;
+            bool descendant;
+        };
+
+        std::vector<segment> m_segments;
+        std::vector<expr> m_exprs;
+        std::vector<operand> m_operands;
+
+        /**
+         * @brief Recursive descent over the query text, filter nesting is limited by `max_nesting`.
+         */
+        class compiler {
+            static constexpr int max_nesting = 64;
+            static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+            // integers of RFC 9535, also keeps slice arithmetic from overflowing
+            static constexpr std::int64_t max_int = (std::int64_t{ 1 } << 53) - 1;
+
+            std::string_view m_text;
+            std::size_t m_pos{ 0 };
+            JsonPath& m_out;
+
+            [[nodiscard]]
+            bool done() const noexcept { return m_pos == m_text.size(); }
+            [[nodiscard]]
+            char peek() const noexcept { return done() ? '\0' : m_text[m_pos]; }
+
+            void skip_spaces() noexcept {
+                while (!done() && (peek() == ' ' || peek() == '\t' || peek() == '\n' || peek() == '\r')) ++m_pos;
+            }
+
+            bool eat(const char c) noexcept {
+                if (done() || m_text[m_pos] != c) return false;
+                ++m_pos;
+                return true;
+            }
+
+            bool eat(const std::string_view s) noexcept {
+                if (!m_text.substr(m_pos).starts_with(s)) return false;
+                m_pos += s.size();
+                return true;
+            }
+
+            static bool is_name_first(const char c) noexcept {
+                return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || static_cast<unsigned char>(c) >= 0x80;
+            }
+
+            bool name(std::string& out) {
+                if (!is_name_first(peek())) return false;
+                const std::size_t begin = m_pos;
+                while (!done() && (is_name_first(peek()) || (peek() >= '0' && peek() <= '9'))) ++m_pos;
+                out.assign(m_text.substr(begin, m_pos - begin));
+                return true;
+            }
+
+            bool quoted(std::string& out) {
+                const char quote = peek();
+                if (quote != '\'' && quote != '"') return false;
+                ++m_pos;
+                while (true) {
+                    if (done()) return false;
+                    const char c = m_text[m_pos];
+                    if (c == quote) {
+                        ++m_pos;
+                        return true;
+                    }
+                    if (static_cast<unsigned char>(c) < 0x20) return false;
+                    if (c != '\\') {
+                        out.push_back(c);
+                        ++m_pos;
+                        continue;
+                    }
+                    if (++m_pos == m_text.size()) return false;
+                    switch (m_text[m_pos]) {
+                        case '\\': out.push_back('\\'); break;
+                        case '/': out.push_back('/'); break;
+                        case '\'': out.push_back('\''); break;
+                        case '"': out.push_back('"'); break;
+                        case 'b': out.push_back('\b'); break;
+                        case 'f': out.push_back('\f'); break;
+                        case 'n': out.push_back('\n'); break;
+                        case 'r': out.push_back('\r'); break;
+                        case 't': out.push_back('\t'); break;
+                        case 'u': {
+                            auto it = m_text.begin() + static_cast<std::ptrdiff_t>(m_pos);
+                            if (!Json<>::unescape_unicode_next(out, it, m_text.end())) return false;
+                            m_pos = static_cast<std::size_t>(it - m_text.begin());
+                            break;
+                        }
+                        default: return false;
+                    }
+                    ++m_pos;
+                }
+            }
+
+            bool integer(std::int64_t& out) noexcept {
+                const std::size_t begin = m_pos;
+                eat('-');
+                const std::size_t digits = m_pos;
+                while (peek() >= '0' && peek() <= '9') ++m_pos;
+                // no leading zeros and no `-0`
+                if (m_pos == digits || (m_text[digits] == '0' && (m_pos - digits > 1 || digits != begin))) return false;
+                const auto [ptr, ec] = std::from_chars(m_text.data() + begin, m_text.data() + m_pos, out);
+                return ec == std::errc{} && out >= -max_int && out <= max_int;
+            }
+
+            bool optional_integer(std::optional<std::int64_t>& out) noexcept {
+                skip_spaces();
+                if (peek() != '-' && (peek() < '0' || peek() > '9')) return true;
+                std::int64_t value;
+                if (!integer(value)) return false;
+                out = value;
+                return true;
+            }
+
+            bool bracket(std::vector<selector>& out, const int depth) {
+                ++m_pos;    // '['
+                do {
+                    skip_spaces();
+                    selector item{};
+                    if (peek() == '\'' || peek() == '"') {
+                        item.kind = selector::Kind::eName;
+                        if (!quoted(item.name)) return false;
+                        item.hash = SeededHash{}(item.name);
+                    } else if (eat('*')) {
+                        item.kind = selector::Kind::eWildcard;
+                    } else if (eat('?')) {
+                        item.kind = selector::Kind::eFilter;
+                        std::size_t root;
+                        if (!logical_or(root, depth + 1)) return false;
+                        item.index = static_cast<std::int64_t>(root);
+                    } else {
+                        if (!optional_integer(item.start)) return false;
+                        skip_spaces();
+                        if (eat(':')) {
+                            item.kind = selector::Kind::eSlice;
+                            if (!optional_integer(item.end)) return false;
+                            skip_spaces();
+                            if (eat(':')) {
+                                std::optional<std::int64_t> step;
+                                if (!optional_integer(step)) return false;
+                                item.step = step.value_or(1);
+                            }
+                        } else {
+                            if (!item.start) return false;
+                            item.kind = selector::Kind::eIndex;
+                            item.index = *item.start;
+                        }
+                    }
+                    out.push_back(std::move(item));
+                    skip_spaces();
+                } while (eat(','));
+                return eat(']');
+            }
+
+            bool dot_member(std::vector<selector>& out) {
+                selector item{};
+                if (eat('*')) {
+                    item.kind = selector::Kind::eWildcard;
+                } else {
+                    item.kind = selector::Kind::eName;
+                    if (!name(item.name)) return false;
+                    item.hash = SeededHash{}(item.name);
+                }
+                out.push_back(std::move(item));
+                return true;
+            }
+
+            std::size_t add_expr(const expr::Kind kind, const std::size_t left, const std::size_t right = 0, const expr::Op op = expr::Op::eEq) {
+                m_out.m_exprs.push_back({ kind, op, left, right });
+                return m_out.m_exprs.size() - 1;
+            }
+
+            /**
+             * @brief Append `right` to the chain of `kind` rooted at `result`, whose last node is `tail`.
+             * @details Chains are right-deep, `a || b || c` is `a || (b || c)`, so `test` walks them in a loop.
+             */
+            void chain(const expr::Kind kind, std::size_t& result, std::size_t& tail, const std::size_t right) {
+                if (tail == npos) {
+                    result = tail = add_expr(kind, result, right);
+                    return;
+                }
+                const std::size_t node = add_expr(kind, m_out.m_exprs[tail].right, right);
+                m_out.m_exprs[tail].right = node;
+                tail = node;
             }
-            if constexpr (std::is_convertible_v<Num, T>) {
-                if (type() == Type::eNum) return static_cast<T>(std::get<Num>(m_data));
+
+            bool logical_or(std::size_t& result, const int depth) {
+                if (depth > max_nesting || !logical_and(result, depth)) return false;
+                std::size_t tail = npos;
+                while (true) {
+                    skip_spaces();
+                    if (!eat("||")) return true;
+                    std::size_t right;
+                    if (!logical_and(right, depth)) return false;
+                    chain(expr::Kind::eOr, result, tail, right);
+                }
             }
-            if constexpr (std::is_convertible_v<Bol, T>) {
-                if (type() == Type::eBol) return static_cast<T>(std::get<Bol>(m_data));
+
+            bool logical_and(std::size_t& result, const int depth) {
+                if (!unary(result, depth)) return false;
+                std::size_t tail = npos;
+                while (true) {
+                    skip_spaces();
+                    if (!eat("&&")) return true;
+                    std::size_t right;
+                    if (!unary(right, depth)) return false;
+                    chain(expr::Kind::eAnd, result, tail, right);
+                }
             }
-            if constexpr (std::is_convertible_v<Nul, T>) {
-                if (type() == Type::eNul) return static_cast<T>(Nul{});
+
+            bool unary(std::size_t& result, const int depth) {
+                skip_spaces();
+                if (eat('!')) {
+                    std::size_t inner;
+                    if (depth + 1 > max_nesting || !unary(inner, depth + 1)) return false;
+                    result = add_expr(expr::Kind::eNot, inner);
+                    return true;
+                }
+                if (eat('(')) {
+                    if (!logical_or(result, depth + 1)) return false;
+                    skip_spaces();
+                    return eat(')');
+                }
+                std::size_t left;
+                if (!parse_operand(left)) return false;
+                skip_spaces();
+                expr::Op op;
+                if (eat("==")) op = expr::Op::eEq;
+                else if (eat("!=")) op = expr::Op::eNe;
+                else if (eat("<=")) op = expr::Op::eLe;
+                else if (eat("<")) op = expr::Op::eLt;
+                else if (eat(">=")) op = expr::Op::eGe;
+                else if (eat(">")) op = expr::Op::eGt;
+                else {
+                    // a lone literal is not a test
+                    if (m_out.m_operands[left].kind == operand::Kind::eLiteral) return false;
+                    result = add_expr(expr::Kind::eTest, left);
+                    return true;
+                }
+                skip_spaces();
+                std::size_t right;
+                if (!parse_operand(right)) return false;
+                result = add_expr(expr::Kind::eCompare, left, right, op);
+                return true;
             }
-            if constexpr ( convertible_map<Json, T, D> ) {
-                if (type() == Type::eObj) {
-                    T result{};
-                    for (auto& [key, value] : std::get<Obj>(m_data)) {
-                        auto val = value.template move_if<typename T::mapped_type>();
-                        if (!val) result.emplace(static_cast<typename T::key_type>(key), static_cast<typename T::mapped_type>(default_range_elem));
-                        else result.emplace(static_cast<typename T::key_type>(key), std::move(*val));
+
+            bool parse_operand(std::size_t& result) {
+                operand item{ operand::Kind::eLiteral, nullptr, {} };
+                if (eat('@') || eat('$')) {
+                    item.kind = m_text[m_pos - 1] == '@' ? operand::Kind::eCurrent : operand::Kind::eRoot;
+                    // singular paths only: names and indexes
+                    while (true) {
+                        path_item step{ {}, 0, 0, false };
+                        if (eat('.')) {
+                            if (!name(step.name)) return false;
+                        } else if (peek() == '[') {
+                            ++m_pos;
+                            skip_spaces();
+                            if (peek() == '\'' || peek() == '"') {
+                                if (!quoted(step.name)) return false;
+                            } else {
+                                if (!integer(step.index)) return false;
+                                step.is_index = true;
+                            }
+                            skip_spaces();
+                            if (!eat(']')) return false;
+                        } else {
+                            break;
+                        }
+                        if (!step.is_index) step.hash = SeededHash{}(step.name);
+                        item.path.push_back(std::move(step));
                     }
-                    return result;
+                } else if (peek() == '\'' || peek() == '"') {
+                    std::string text;
+                    if (!quoted(text)) return false;
+                    item.value = std::move(text);
+                } else if (eat("true")) {
+                    item.value = true;
+                } else if (eat("false")) {
+                    item.value = false;
+                } else if (eat("null")) {
+                    item.value = nullptr;
+                } else {
+                    const std::size_t begin = m_pos;
+                    while (!done() && std::string_view{ "+-.0123456789eE" }.contains(peek())) ++m_pos;
+                    double number;
+                    const auto [ptr, ec] = std::from_chars(m_text.data() + begin, m_text.data() + m_pos, number);
+                    if (m_pos == begin || ec != std::errc{} || ptr != m_text.data() + m_pos) return false;
+                    item.value = number;
                 }
+                m_out.m_operands.push_back(std::move(item));
+                result = m_out.m_operands.size() - 1;
+                return true;
             }
-            if constexpr ( convertible_array<Json, T, D> ) {
-                if (type() == Type::eArr) {
-                    T result{};
-                    for (auto& value : std::get<Arr>(m_data)) {
-                        auto val = value.template move_if<typename T::value_type>();
-                        if (!val) result.emplace_back( static_cast<typename T::value_type>(default_range_elem) );
-                        else result.emplace_back(std::move(*val));
+
+        public:
+            compiler(const std::string_view text, JsonPath& out) noexcept : m_text(text), m_out(out) {}
+
+            bool query() {
+                skip_spaces();
+                if (!eat('$')) return false;
+                while (true) {
+                    skip_spaces();
+                    if (done()) return true;
+                    segment item{ {}, false };
+                    if (eat("..")) {
+                        item.descendant = true;
+                        if (peek() == '[') {
+                            if (!bracket(item.selectors, 0)) return false;
+                        } else if (!dot_member(item.selectors)) return false;
+                    } else if (eat('.')) {
+                        if (!dot_member(item.selectors)) return false;
+                    } else if (peek() == '[') {
+                        if (!bracket(item.selectors, 0)) return false;
+                    } else {
+                        return false;
                     }
-                    return result;
+                    m_out.m_segments.push_back(std::move(item));
                 }
             }
-            return std::nullopt; // return nullopt if conversion fails
-        }
+        };
 
         /**
-         * @brief type conversion, Move or Copy inner value to specified type
-         * @tparam T The target type to convert to
-         * @tparam D The mapped_type or value_type of the target type, used for range conversion, default is Nul for other types(useless).
-         * @param default_range_elem if T is a range type and is not json::Arr or json::Obj, must be specified for safe conversion. Else, please use default value.
-         * @return The converted value
-         * @throws std::runtime_error if conversion fails
-         * @note
-         * Num is double, so conversions to integral (and enum) types will round to nearest.
-         * Complex types like Obj, Arr, Str will be moved if possible.
-         * Simple types like Bol, Num, Nul will be copied.
-         * @details
-         * Attempt sequence of conversions:
-         * inner value type -> target type
-         * 1-17: equal to `move_if<T, D>()`
-         * 18: throw std::runtime_error
+         * @brief A value taking part in a comparison: a node, a literal, or nothing for a missing path.
          */
-        template<typename T, typename D = Nul>
-        requires convertible<Json, T> || convertible_map<Json, T, D> || convertible_array<Json, T, D>
-        [[nodiscard]]
-        T  move( D default_range_elem = D{} ) {
-            auto opt = move_if<T, D>( std::move(default_range_elem) );
-            if (!opt) throw std::runtime_error("Cast fail.");
-            return *opt;
+        template<typename J>
+        struct value_ref {
+            const J* node;
+            const literal* value;
+        };
+
+        template<typename J>
+        static const J* resolve(const J* node, const std::vector<path_item>& path) noexcept {
+            for (const auto& item : path) {
+                if (item.is_index) {
+                    if (!node->is_arr()) return nullptr;
+                    const auto& arr = node->arr();
+                    const auto size = static_cast<std::int64_t>(arr.size());
+                    const std::int64_t index = item.index < 0 ? item.index + size : item.index;
+                    if (index < 0 || index >= size) return nullptr;
+                    node = &arr[static_cast<std::size_t>(index)];
+                } else {
+                    if (!node->is_obj()) return nullptr;
+                    const auto& obj = node->obj();
+                    const auto it = J::find_key(obj, item.name, item.hash);
+                    if (it == obj.end()) return nullptr;
+                    node = &it->second;
+                }
+            }
+            return node;
         }
 
-        /**
-         * @brief type conversion, Move or Copy inner value to specified type
-         * @tparam T The target type to convert to
-         * @tparam D The mapped_type or value_type of the target type, used for range conversion, default is Nul for other types(useless).
-         * @param default_result The default value to return if conversion fails
-         * @param default_range_elem if T is a range type and is not json::Arr or json::Obj, must be specified for safe conversion. Else, please use default value.
-         * @return The converted value
-         * @note
-         * Num is double, so conversions to integral (and enum) types will round to nearest.
-         * Complex types like Obj, Arr, Str will be moved if possible.
-         * Simple types like Bol, Num, Nul will be copied.
-         * @details
-         * Attempt sequence of conversions:
-         * inner value type -> target type
-         * 1-17: equal to `move_if<T, D>()`
-         * 18: return default_result;
-         */
-        template<typename T, typename D = Nul>
-        requires convertible<Json, T> || convertible_map<Json, T, D> || convertible_array<Json, T, D>
-        [[nodiscard]]
-        T  move_or( T default_result, D default_range_elem = D{} ) noexcept {
-            auto opt = move_if<T, D>( std::move(default_range_elem) );
-            if (!opt) return default_result;
-            return *opt;
+        template<typename J>
+        static std::optional<double> number_of(const value_ref<J>& v) noexcept {
+            if (v.node && v.node->is_num()) return v.node->num();
+            if (v.value && std::holds_alternative<double>(*v.value)) return std::get<double>(*v.value);
+            return std::nullopt;
         }
 
-        /**
-         * @brief For Value-to-Value accurate comparison
-         * @tparam T Type that satisfies std::equality_comparable concept
-         * @warning Num is double, so the comparison of numbers will be very strict
-         * @param other The value to compare with
-         * @return True if values are equal, false otherwise
-         */
-        [[nodiscard]]
-        bool operator==(const Json& other) const noexcept {
-            if (type() != other.type()) return false; // Different types cannot be equal
-            switch (type()) {
-                case Type::eNul: return true; // Both are null
-                case Type::eBol: return std::get<Bol>(m_data) == std::get<Bol>(other.m_data);
-                case Type::eNum: return std::get<Num>(m_data) == std::get<Num>(other.m_data);
-                case Type::eStr: return std::get<Str>(m_data) == std::get<Str>(other.m_data);
-                case Type::eObj: return std::get<Obj>(m_data) == std::get<Obj>(other.m_data);
-                case Type::eArr: return std::get<Arr>(m_data) == std::get<Arr>(other.m_data);
-            }
-            return false; // Should never reach here, but added for safety
+        template<typename J>
+        static std::optional<std::string_view> string_of(const value_ref<J>& v) noexcept {
+            if (v.node && v.node->is_str()) return std::string_view{ v.node->str() };
+            if (v.value && std::holds_alternative<std::string>(*v.value)) return std::string_view{ std::get<std::string>(*v.value) };
+            return std::nullopt;
+        }
+
+        template<typename J>
+        static bool equal(const value_ref<J>& a, const value_ref<J>& b) noexcept {
+            const bool a_nothing = !a.node && !a.value;
+            const bool b_nothing = !b.node && !b.value;
+            if (a_nothing || b_nothing) return a_nothing && b_nothing;
+            if (a.node && b.node) return *a.node == *b.node;
+            if (a.value && b.value) return *a.value == *b.value;
+            const J& node = a.node ? *a.node : *b.node;
+            const literal& value = a.value ? *a.value : *b.value;
+            return std::visit([&node]<typename T>(const T& x) -> bool {
+                if constexpr (std::is_same_v<T, std::nullptr_t>) return node.is_nul();
+                else if constexpr (std::is_same_v<T, bool>) return node.is_bol() && node.bol() == x;
+                else if constexpr (std::is_same_v<T, double>) return node.is_num() && node.num() == x;
+                else return node.is_str() && std::string_view{ node.str() } == x;
+            }, value);
         }
 
         /**
-         * @brief Generic equality comparison operator
-         * @tparam T Type that satisfies std::equality_comparable concept
-         * @param other The value to compare with
-         * @return True if values are equal, false otherwise
-         *
-         * @details
-         * rules:
-         * A. different json types are not equal( Bol, Num, Str, Arr, Obj, Nul )
-         * B. IF T is Value, use Value::operator==(const Value& other) ,
-         *    it's Accurate comparison !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
-         * --------------------------------------------------------------------------------------------
-         * 1.  IF T is Nul, return true if this Value is null, false otherwise
-         * 2.  Else if T is Bol, return true if Value is Bol and Equal to Tvalue
-         * 3.  Else if T is Num, return true if Value is Num and Equal to Tvalue
-         * 4.  Else if T is Str, return true if Value is Str and Equal to Tvalue
-         * 5.  Else if T is Arr, return true if Value is Arr and Equal to Tvalue
-         * 6.  Else if T is Obj, return true if Value is Obj and Equal to Tvalue
-         * 7.  Else if T is enum, return true if Value is Num and Equal to Tvalue, Num will be rounded to nearest integer
-         * 8.  Else if T is integral, return true if Value is Num or Bol and Equal to Tvalue, Num will be rounded to nearest integer
-         * 9.  Else if T is floating_point, return true if Value is Num and Equal to Tvalue, double to double comparison is very strict
-         * 10. Else if T is convertible to std::string_view, return true if Value is Str and Equal to std::string_view( Tvalue )
-         * 11. Else if T is equality_comparable and constructible from Value, return true if Tvalue == T(*this);
-         * 12. Else if Value is constructible from T, return true if *this == json::Value(Tvalue);
-         * 13. Else return false
+         * @brief Only numbers and strings are ordered, any other pair compares false.
          */
-        template<typename  T>
-        requires (!std::is_same_v<T, Json>)
-        [[nodiscard]]
-        bool operator==(const T& other) const  noexcept {
-            if constexpr ( std::is_same_v<T,Nul> ) {
-                return type() == Type::eNul;
-            } else if constexpr ( std::is_same_v<T,Bol> ) {
-                if ( type() == Type::eBol ) return std::get<Bol>(m_data) == other;
-            } else if constexpr ( std::is_same_v<T,Num> ) {
-                if ( type() == Type::eNum ) return std::get<Num>(m_data) == other;
-            } else if constexpr ( std::is_same_v<T,Str> ) {
-                if ( type() == Type::eStr ) return std::get<Str>(m_data) == other;
-            } else if constexpr ( std::is_same_v<T,Arr> ) {
-                if ( type() == Type::eArr ) return std::get<Arr>(m_data) == other;
-            } else if constexpr ( std::is_same_v<T,Obj> ) {
-                if ( type() == Type::eObj ) return std::get<Obj>(m_data) == other;
-            } else if constexpr (std::is_enum_v<T>) {
-                if ( type() == Type::eNum) return static_cast<T>(std::llround(std::get<Num>(m_data))) == other;
-            } else if constexpr (std::is_integral_v<T>) {
-                if ( type() == Type::eNum) return static_cast<T>(std::llround(std::get<Num>(m_data))) == other;
-            } else if constexpr (std::is_floating_point_v<T>) {
-                if ( type() == Type::eNum) return static_cast<T>(std::get<Num>(m_data)) == other;
-            } else if constexpr (std::is_convertible_v<T, std::string_view>) {
-                if( type() == Type::eStr) return std::get<Str>(m_data) == std::string_view( other );
-            } else if constexpr (std::equality_comparable<T> && std::is_constructible_v<T, Json>) {
-                return other == static_cast<T>(*this);     // Use T's operator==
-            } else if constexpr (std::is_constructible_v<Json, T>) {
-                return static_cast<Json>(other) == *this; // Use Value's operator==
-            }
+        template<typename J>
+        static bool less(const value_ref<J>& a, const value_ref<J>& b) noexcept {
+            if (const auto x = number_of(a), y = number_of(b); x && y) return *x < *y;
+            if (const auto x = string_of(a), y = string_of(b); x && y) return *x < *y;
             return false;
         }
 
-        /**
-         * @brief Get inner container size.
-         * @return The size of the inner container(Arr or Obj), or 0 for Nul, Bol, Num, Str.
-         */
-        [[nodiscard]]
-        std::size_t size() const noexcept {
-            if (type() == Type::eObj)  return std::get<Obj>(m_data).size();
-            if (type() == Type::eArr) return std::get<Arr>(m_data).size();
-            return 0; // Nul, Bol, Num, Str are considered to have size 0
+        template<typename J>
+        value_ref<J> value_of(const std::size_t index, const J& current, const J& root) const noexcept {
+            const operand& item = m_operands[index];
+            switch (item.kind) {
+                case operand::Kind::eLiteral: return { nullptr, &item.value };
+                case operand::Kind::eCurrent: return { resolve(&current, item.path), nullptr };
+                default: return { resolve(&root, item.path), nullptr };
+            }
         }
 
-        /**
-         * @brief Check if the JSON object is empty.
-         * @return False if it contains any elements (Obj or Arr), true otherwise.
-         */
-        [[nodiscard]]
-        bool empty() const noexcept {
-            if (type() == Type::eObj)  return std::get<Obj>(m_data).empty();
-            if (type() == Type::eArr) return std::get<Arr>(m_data).empty();
-            return true; // Nul, Bol, Num, Str are considered empty
+        template<typename J>
+        bool test(std::size_t index, const J& current, const J& root) const noexcept {
+            // `||` and `&&` chains are right-deep, follow them in a loop so their length does not add stack depth
+            while (m_exprs[index].kind == expr::Kind::eOr || m_exprs[index].kind == expr::Kind::eAnd) {
+                const expr& e = m_exprs[index];
+                if (test(e.left, current, root) == (e.kind == expr::Kind::eOr)) return e.kind == expr::Kind::eOr;
+                index = e.right;
+            }
+            const expr& e = m_exprs[index];
+            switch (e.kind) {
+                case expr::Kind::eNot: return !test(e.left, current, root);
+                case expr::Kind::eTest: return value_of(e.left, current, root).node != nullptr;
+                default: break;
+            }
+            const auto a = value_of(e.left, current, root);
+            const auto b = value_of(e.right, current, root);
+            switch (e.op) {
+                case expr::Op::eEq: return equal(a, b);
+                case expr::Op::eNe: return !equal(a, b);
+                case expr::Op::eLt: return less(a, b);
+                case expr::Op::eLe: return less(a, b) || equal(a, b);
+                case expr::Op::eGt: return less(b, a);
+                default: return less(b, a) || equal(a, b);
+            }
+        }
+
+        static bool in_slice(const selector& item, const std::size_t index, const std::size_t size) noexcept {
+            const auto len = static_cast<std::int64_t>(size);
+            const auto i = static_cast<std::int64_t>(index);
+            const auto normalize = [len](const std::int64_t v) { return v >= 0 ? v : len + v; };
+            if (item.step == 0) return false;
+            if (item.step > 0) {
+                const std::int64_t lower = std::clamp<std::int64_t>(normalize(item.start.value_or(0)), 0, len);
+                const std::int64_t upper = std::clamp<std::int64_t>(normalize(item.end.value_or(len)), 0, len);
+                return i >= lower && i < upper && (i - lower) % item.step == 0;
+            }
+            const std::int64_t upper = std::clamp<std::int64_t>(normalize(item.start.value_or(len - 1)), -1, len - 1);
+            const std::int64_t lower = std::clamp<std::int64_t>(normalize(item.end.value_or(-len - 1)), -1, len - 1);
+            return i <= upper && i > lower && (upper - i) % -item.step == 0;
         }
 
         /**
-         * @brief Check if the JSON object contains a key.
-         * @param key The key to check in the JSON object.
-         * @return True if the key exists in the JSON object, false if the JSON is not an object or the key does not exist.
+         * @brief A child reached from its parent, with the key or index it is reached by.
          */
-        [[nodiscard]]
-        bool contains(const Str& key) const noexcept {
-            if (type() == Type::eObj) return std::get<Obj>(m_data).contains(key);
-            return false; // Not an object
+        template<typename J>
+        struct edge {
+            const J* child;
+            std::string_view key;
+            std::size_t index;
+        };
+
+        template<typename J>
+        bool matches(const selector& item, const J& parent, const edge<J>& e, const J& root) const noexcept {
+            switch (item.kind) {
+                case selector::Kind::eName: return parent.is_obj() && e.key == item.name;
+                case selector::Kind::eWildcard: return true;
+                case selector::Kind::eIndex: {
+                    if (!parent.is_arr()) return false;
+                    const auto size = static_cast<std::int64_t>(parent.arr().size());
+                    return (item.index < 0 ? item.index + size : item.index) == static_cast<std::int64_t>(e.index);
+                }
+                case selector::Kind::eSlice: return parent.is_arr() && in_slice(item, e.index, parent.arr().size());
+                default: return test(static_cast<std::size_t>(item.index), *e.child, root);
+            }
         }
 
         /**
-         * @brief Erase a key from the JSON object or an index from the JSON array.
-         * @param key The key to erase from the JSON object.
-         * @return True if the key was erased, false if the JSON is not an object or the key does not exist.
+         * @brief An active state: `segment` of `query` is applied to the children of the node holding it.
+         * @note `count` is how many times the node is in the nodelist the segment takes, RFC 9535 keeps duplicates.
          */
-        bool erase(const Str& key) noexcept{
-            if (type() == Type::eObj) return std::get<Obj>(m_data).erase(key);
-            return false;
-        }
+        struct state {
+            std::uint32_t query;
+            std::uint32_t segment;
+            std::size_t count;
+        };
 
         /**
-         * @brief Erase an element at the specified index from the JSON array.
-         * @param index The index of the element to erase from the JSON array.
-         * @return True if the element was erased, false if the JSON is not an array or the index is out of bounds.
+         * @brief Append the children of `node` the states may select, by lookups when no state needs a scan.
          */
-        bool erase(const std::size_t index) noexcept {
-            if (type() == Type::eArr && index < std::get<Arr>(m_data).size()) {
-                std::get<Arr>(m_data).erase(std::get<Arr>(m_data).begin() + index);
-                return true;
+        template<typename J>
+        static void collect_edges(
+            const std::span<const JsonPath> queries,
+            const J& node,
+            const std::span<const state> states,
+            std::vector<edge<J>>& out
+        ) {
+            const std::size_t begin = out.size();
+            const bool lookup = std::ranges::all_of(states, [&](const state& s) {
+                const segment& seg = queries[s.query].m_segments[s.segment];
+                return !seg.descendant && std::ranges::all_of(seg.selectors, [](const selector& item) {
+                    return item.kind == selector::Kind::eName || item.kind == selector::Kind::eIndex;
+                });
+            });
+            const auto add = [&out, begin](const edge<J>& e) {
+                // unions may name the same child twice
+                if (std::ranges::none_of(out.begin() + static_cast<std::ptrdiff_t>(begin), out.end(),
+                    [&e](const edge<J>& x) { return x.child == e.child; })
+                ) out.push_back(e);
+            };
+            if (node.is_obj()) {
+                const auto& obj = node.obj();
+                if (!lookup) {
+                    for (const auto& [key, value] : obj) out.push_back({ &value, key, 0 });
+                    return;
+                }
+                for (const state& s : states) {
+                    for (const selector& item : queries[s.query].m_segments[s.segment].selectors) {
+                        if (item.kind != selector::Kind::eName) continue;
+                        const auto it = J::find_key(obj, item.name, item.hash);
+                        if (it != obj.end()) add({ &it->second, it->first, 0 });
+                    }
+                }
+            } else if (node.is_arr()) {
+                const auto& arr = node.arr();
+                if (!lookup) {
+                    for (std::size_t i = 0; i < arr.size(); ++i) out.push_back({ &arr[i], {}, i });
+                    return;
+                }
+                const auto size = static_cast<std::int64_t>(arr.size());
+                for (const state& s : states) {
+                    for (const selector& item : queries[s.query].m_segments[s.segment].selectors) {
+                        if (item.kind != selector::Kind::eIndex) continue;
+                        const std::int64_t index = item.index < 0 ? item.index + size : item.index;
+                        if (index >= 0 && index < size) add({ &arr[static_cast<std::size_t>(index)], {}, static_cast<std::size_t>(index) });
+                    }
+                }
             }
-            return false;
         }
 
+    public:
         /**
-         * @brief Insert a key-value pair into the JSON object.
-         * @param key The key to insert into the JSON object.
-         * @param value The value to insert into the JSON object.
-         * @return True if the key-value pair was inserted, false if the JSON is not an object.
+         * @brief Compile a JSONPath query.
+         * @return The query, or `std::nullopt` if the text is not a supported JSONPath query.
          */
-        template<typename  K, typename V>
-        requires std::convertible_to<K, Str> && std::convertible_to<V, Json>
-        bool insert(K&& key, V&& value) noexcept {
-            if (type() == Type::eObj) {
-                std::get<Obj>(m_data).emplace(static_cast<Str>(std::forward<K>(key)), static_cast<Json>(std::forward<V>(value)));
-                return true;
+        [[nodiscard]]
+        static std::optional<JsonPath> compile(const std::string_view text) noexcept {
+            JsonPath result;
+            try {
+                if (!compiler{ text, result }.query()) return std::nullopt;
+            } catch (...) {
+                return std::nullopt;
             }
-            return false;
+            return result;
         }
 
         /**
-         * @brief Insert a value at the specified index into the JSON array.
-         * @param index The index at which to insert the value into the JSON array.
-         * @param value The value to insert into the JSON array.
-         * @return True if the value was inserted, false if the JSON is not an array or the index is out of bounds.
+         * @brief Get the number of segments after `$`.
          */
-        template<typename V>
-        requires std::convertible_to<V, Json>
-        bool insert(const std::size_t index, V&& value) noexcept {
-            if (type() == Type::eArr && index <= std::get<Arr>(m_data).size()) {
-                std::get<Arr>(m_data).emplace(std::get<Arr>(m_data).begin() + index, static_cast<Json>(std::forward<V>(value)));
-                return true;
-            }
-            return false;
-        }
+        [[nodiscard]]
+        std::size_t size() const noexcept { return m_segments.size(); }
 
         /**
-         * @brief Push a value to the end of the JSON array.
-         * @param value The value to push to the end of the JSON array.
-         * @return True if the value was pushed, false if the JSON is not an array.
+         * @brief Evaluate several queries in one traversal of `root`.
+         * @return For each query, the matching nodes in the order they are reached.
+         * As in RFC 9535, a node is repeated for each way it is selected, e.g. by a union naming it twice.
+         * Pointers refer into `root` and are invalidated like references to its nodes.
+         * @details
+         * Children are visited in document order, except those entered by lookup,
+         * which follow the order of the names and indexes in the query.
+         * The traversal keeps its own stack, the nesting of `root` is not limited.
          */
-        template<typename V>
-        requires std::convertible_to<V, Json>
-        bool push_back(V&& value) noexcept {
-            if (type() == Type::eArr) {
-                std::get<Arr>(m_data).emplace_back( static_cast<Json>(std::forward<V>(value)) );
-                return true;
+        template<typename J>
+        [[nodiscard]]
+        static std::vector<std::vector<const J*>> select_all(const std::span<const JsonPath> queries, const J& root) {
+            std::vector<std::vector<const J*>> results(queries.size());
+            std::vector<state> states;
+            std::vector<edge<J>> edges;
+            struct frame {
+                const J* node;
+                std::size_t states_begin, states_end;
+                std::size_t edges_begin, cursor;
+            };
+            std::vector<frame> stack;
+
+            for (std::uint32_t q = 0; q < queries.size(); ++q) {
+                if (queries[q].m_segments.empty()) results[q].push_back(&root);
+                else states.push_back({ q, 0, 1 });
             }
-            return false;
+            const auto enter = [&](const J& node, const std::size_t states_begin) {
+                const std::size_t edges_begin = edges.size();
+                collect_edges(queries, node, std::span{ states }.subspan(states_begin), edges);
+                stack.push_back({ &node, states_begin, states.size(), edges_begin, edges_begin });
+            };
+            if (!states.empty()) enter(root, 0);
+
+            while (!stack.empty()) {
+                frame& top = stack.back();
+                if (top.cursor == edges.size()) {
+                    states.resize(top.states_begin);
+                    edges.resize(top.edges_begin);
+                    stack.pop_back();
+                    continue;
+                }
+                const J& parent = *top.node;
+                const std::size_t first = top.states_begin;
+                const std::size_t last = top.states_end;
+                const edge<J> e = edges[top.cursor++];
+                const std::size_t child_begin = states.size();
+                // a state reached several ways is applied once, with the sum of the counts
+                const auto activate = [&states, child_begin](const state s) {
+                    const auto it = std::find_if(states.begin() + static_cast<std::ptrdiff_t>(child_begin), states.end(),
+                        [&s](const state& x) { return x.query == s.query && x.segment == s.segment; });
+                    if (it == states.end()) states.push_back(s);
+                    else it->count += s.count;
+                };
+                for (std::size_t i = first; i < last; ++i) {
+                    const state s = states[i];
+                    const JsonPath& query = queries[s.query];
+                    const segment& seg = query.m_segments[s.segment];
+                    if (seg.descendant) activate(s);
+                    // every matching selector of a union selects the child again
+                    const auto hits = static_cast<std::size_t>(std::ranges::count_if(seg.selectors,
+                        [&](const selector& item) { return query.matches(item, parent, e, root); }));
+                    if (hits == 0) continue;
+                    if (s.segment + 1 == query.m_segments.size()) {
+                        auto& found = results[s.query];
+                        found.insert(found.end(), s.count * hits, e.child);
+                    } else {
+                        activate({ s.query, s.segment + 1, s.count * hits });
+                    }
+                }
+                // `top` may dangle from here
+                if (states.size() > child_begin && (e.child->is_obj() || e.child->is_arr())) enter(*e.child, child_begin);
+                else states.resize(child_begin);
+            }
+            return results;
         }
 
         /**
-         * @brief Pop the last value from the JSON array.
-         * @return True if the value was popped, false if the JSON is not an array or is empty.
+         * @brief Evaluate the query on `root`.
+         * @return The matching nodes, see `select_all`.
          */
-        bool pop_back() noexcept {
-            if (type() == Type::eArr && !std::get<Arr>(m_data).empty()) {
-                std::get<Arr>(m_data).pop_back();
-                return true;
-            }
-            return false;
+        template<typename J>
+        [[nodiscard]]
+        std::vector<const J*> select(const J& root) const {
+            return std::move(select_all(std::span{ this, 1 }, root).front());
         }
-
     };
 
 }
@@ -1743,3 +9311,64 @@ export namespace mysvac {
      */
     using Json = ::mysvac::json::Json<>;
 }
+
+/**
+ * @namespace mysvac::pmr
+ * @brief Allocator-aware aliases, memory comes from the resource of `json::MemoryScope`.
+ */
+export namespace mysvac::pmr {
+    /**
+     * @brief Json whose Str, Arr and Obj all allocate through `json::ResourceAllocator`.
+     */
+    using Json = ::mysvac::json::Json<true, json::ResourceAllocator, json::ResourceAllocator, json::ResourceAllocator>;
+}
+
+/**
+ * @brief Formatter for Json, writes through the format context's output iterator.
+ * @details
+ * Format spec:
+ * - `{}` compact, equal to `dump()`
+ * - `{:p}` pretty, equal to `dumpf()`
+ * - `{:pN}` pretty with N spaces per level, equal to `dumpf(N)`
+ */
+template<
+    bool UseOrderedMap,
+    template<typename U> class VecAllocator,
+    template<typename U> class MapAllocator,
+    template<typename U> class StrAllocator,
+    bool UseDumpCache,
+    mysvac::json::Storage NodeStorage,
+    mysvac::json::MapType ObjMap
+>
+struct std::formatter<mysvac::json::Json<UseOrderedMap, VecAllocator, MapAllocator, StrAllocator, UseDumpCache, NodeStorage, ObjMap>, char> {
+    bool pretty{ false };
+    std::uint16_t space_num{ 2 };
+
+    constexpr auto parse(auto& ctx) {
+        auto it = ctx.begin();
+        if (it != ctx.end() && *it == 'p') {
+            pretty = true;
+            ++it;
+            if (it != ctx.end() && *it >= '0' && *it <= '9') {
+                std::uint32_t value{ 0 };
+                for (; it != ctx.end() && *it >= '0' && *it <= '9'; ++it) {
+                    value = value * 10 + static_cast<std::uint32_t>(*it - '0');
+                    if (value > 0xFFFF) throw std::format_error("Json format spec: indentation too large.");
+                }
+                space_num = static_cast<std::uint16_t>(value);
+            }
+        }
+        if (it != ctx.end() && *it != '}') throw std::format_error("Json format spec: expected `p` or `pN`.");
+        return it;
+    }
+
+    auto format(
+        const mysvac::json::Json<UseOrderedMap, VecAllocator, MapAllocator, StrAllocator, UseDumpCache, NodeStorage, ObjMap>& json,
+        auto& ctx
+    ) const {
+        mysvac::json::iterator_sink<decltype(ctx.out())> sink{ ctx.out() };
+        if (pretty) json.writef(sink, space_num);
+        else json.write(sink);
+        return std::move(sink.it);
+    }
+};
@@ -0,0 +1,50 @@
+#include <vct/test_unit_macros.hpp>
+#define M_MYSVAC_JSON_MACROS_TYPE ::OrderedJson
+#include <mysvac/json_macros.hpp>
+import std;
+import vct.test.unit;
+import mysvac.json;
+
+
+using OrderedJson = mysvac::json::Json<true, std::allocator, std::allocator, std::allocator, false,
+    mysvac::json::Storage::eVariant, mysvac::json::MapType::eIndex>;
+
+struct Record{
+    int version{};
+    std::string name{};
+    double score{};
+    std::vector<int> ids{};
+
+    Record() = default;
+
+    M_MYSVAC_JSON_CONVERSION_FUNCTION( Record,
+        M_MYSVAC_JSON_CONVERSION_FIELD( version )
+        M_MYSVAC_JSON_CONVERSION_FIELD( name )
+        M_MYSVAC_JSON_CONVERSION_FIELD( score )
+        M_MYSVAC_JSON_CONVERSION_FIELD( ids )
+    )
+    M_MYSVAC_JSON_CONSTRUCTOR_FUNCTION( Record,
+        M_MYSVAC_JSON_CONSTRUCTOR_FIELD_DEFAULT( version )
+        M_MYSVAC_JSON_CONSTRUCTOR_FIELD_DEFAULT( name )
+        M_MYSVAC_JSON_CONSTRUCTOR_FIELD_DEFAULT( score )
+        M_MYSVAC_JSON_CONSTRUCTOR_FIELD_OR( ids, std::vector<int>{}, 0 )
+    )
+};
+
+M_TEST(Macros, Ordered) {
+    Record record;
+    record.version = 2;
+    record.name = "r";
+    record.score = 0.5;
+    record.ids = { 3, 1 };
+
+    // fields follow the declaration order instead of the key order
+    const OrderedJson value{ record };
+    M_ASSERT_EQ( value.dump(), R"({"version":2,"name":"r","score":0.5,"ids":[3,1]})" );
+
+    const Record back{ value };
+    M_ASSERT_EQ( back.version, 2 );
+    M_ASSERT_EQ( back.name, "r" );
+    M_ASSERT_EQ( back.score, 0.5 );
+    M_ASSERT_EQ( back.ids.size(), 2 );
+}
@@ -0,0 +1,81 @@
+#include <vct/test_unit_macros.hpp>
+
+import std;
+import vct.test.unit;
+import mysvac.json;
+
+
+using namespace mysvac;
+
+using AJson = json::Json<true, std::allocator, std::allocator, std::allocator, false, json::Storage::eVariant, json::MapType::eAtom>;
+
+// address of the key string of the first member
+static const std::string* first_key(const AJson& value) {
+    return &(*value.obj().begin()).first;
+}
+
+M_TEST(Atom, Parse) {
+    constexpr std::string_view text = R"([{"a field name longer than SSO":1,"b":true},{"b":false,"a field name longer than SSO":2},{"a field name longer than SSO":3,"b!":null}])";
+    const auto value = AJson::parse(text);
+    M_ASSERT_TRUE( value.has_value() );
+    // document order, like IndexMap
+    M_ASSERT_EQ( value->dump(), R"([{"a field name longer than SSO":1,"b":true},{"b":false,"a field name longer than SSO":2},{"a field name longer than SSO":3,"b!":null}])" );
+    // every record holds the same key string
+    M_ASSERT_EQ( first_key((*value)[0]), first_key((*value)[2]) );
+    M_ASSERT_EQ( first_key((*value)[0]), &(*std::next((*value)[1].obj().begin())).first );
+    M_ASSERT_EQ( (*value)[1].at("a field name longer than SSO"), 2 );
+    // the first of duplicated keys is kept
+    M_ASSERT_EQ( AJson::parse(R"({"x":1,"y":2,"x":3})")->dump(), R"({"x":1,"y":2})" );
+}
+
+M_TEST(Atom, Table) {
+    // an installed table shares keys between documents
+    json::KeyTable<std::string> table;
+    std::optional<AJson> a, b;
+    {
+        json::KeyScope scope{ table };
+        a = AJson::parse(R"({"shared key longer than SSO":1})");
+        b = AJson::parse(R"({"shared key longer than SSO":2,"other":0})");
+        M_ASSERT_EQ( table.size(), 2 );
+        AJson c{ AJson::Obj{} };
+        c["shared key longer than SSO"] = 3;
+        M_ASSERT_EQ( first_key(c), first_key(*a) );
+    }
+    M_ASSERT_EQ( first_key(*a), first_key(*b) );
+    M_ASSERT_EQ( json::KeyTable<std::string>::current(), nullptr );
+    // atoms outlive the table
+    table.clear();
+    M_ASSERT_EQ( a->dump(), R"({"shared key longer than SSO":1})" );
+
+    // without a table, a document still shares its keys
+    const auto records = AJson::parse(R"([{"k":1},{"k":2}])");
+    M_ASSERT_EQ( first_key((*records)[0]), first_key((*records)[1]) );
+    M_ASSERT_NE( first_key((*records)[0]), first_key(*a) );
+}
+
+M_TEST(Atom, Modify) {
+    AJson value{ AJson::Obj{ { "k2", 2 }, { "k1", 1 }, { "k2", 3 } } };
+    M_ASSERT_EQ( value.dump(), R"({"k2":2,"k1":1})" );
+    value["k0"] = "zero";
+    M_ASSERT_TRUE( value.insert("k3", true) );
+    M_ASSERT_TRUE( value.erase("k1") );
+    M_ASSERT_FALSE( value.erase("k1") );
+    M_ASSERT_EQ( value.dump(), R"({"k2":2,"k0":"zero","k3":true})" );
+    M_ASSERT_THROW( std::ignore = value.at("missing"), std::out_of_range );
+
+    // a copy shares the atoms, equality ignores the order
+    const AJson copy = value;
+    M_ASSERT_EQ( first_key(copy), first_key(value) );
+    M_ASSERT_EQ( copy, value );
+    const AJson same{ AJson::Obj{ { "k3", true }, { "k0", "zero" }, { "k2", 2 } } };
+    M_ASSERT_EQ( value, same );
+
+    AJson large{ AJson::Obj{} };
+    for (int i = 0; i < 100; ++i) large[std::to_string(i)] = i;
+    for (int i = 0; i < 100; i += 2) M_EXPECT_TRUE( large.erase(std::to_string(i)) );
+    for (int i = 1; i < 100; i += 2) M_EXPECT_EQ( large.at(std::to_string(i)).num(), i );
+    M_ASSERT_EQ( AJson::parse(large.dump()).value(), large );
+    std::string packed;
+    large.to_msgpack(packed);
+    M_ASSERT_EQ( AJson::from_msgpack(std::as_bytes(std::span{ packed })).value(), large );
+}
@@ -0,0 +1,100 @@
+#include <vct/test_unit_macros.hpp>
+
+import std;
+import vct.test.unit;
+import mysvac.json;
+
+
+using namespace mysvac;
+
+using BJson = json::Json<true, std::allocator, std::allocator, std::allocator, false, json::Storage::eVariant, json::MapType::eBTree>;
+
+M_TEST(BTree, Parse) {
+    constexpr std::string_view text = R"({"b":1,"a":{"z":[1,2],"y":null},"c":"s","a":"duplicate"})";
+    const auto value = BJson::parse(text);
+    M_ASSERT_TRUE( value.has_value() );
+    // same order and duplicate handling as std::map
+    M_ASSERT_EQ( value->dump(), Json::parse(text)->dump() );
+    M_ASSERT_EQ( value->dumpf(), Json::parse(text)->dumpf() );
+    M_ASSERT_EQ( value->size(), 3 );
+    M_ASSERT_TRUE( value->at("a").at("y").is_nul() );
+    M_ASSERT_THROW( std::ignore = value->at("d"), std::out_of_range );
+}
+
+M_TEST(BTree, Model) {
+    // random insertions and erasures against std::map, deep enough for several inner levels
+    std::mt19937 rng{ 42 };
+    std::uniform_int_distribution<int> pick{ 0, 19999 };
+    BJson value{ BJson::Obj{} };
+    std::map<std::string, int> model;
+    for (int i = 0; i < 40000; ++i) {
+        const int n = pick(rng);
+        const std::string key = "key" + std::to_string(n);
+        if (i % 3 == 2) {
+            M_EXPECT_EQ( value.erase(key), model.erase(key) == 1 );
+        } else {
+            value[key] = n;
+            model[key] = n;
+        }
+    }
+    const auto& obj = value.obj();
+    M_ASSERT_EQ( obj.size(), model.size() );
+    M_ASSERT_TRUE( obj.height() >= 2 );
+    auto expected = model.begin();
+    for (const auto& [key, item] : obj) {
+        M_EXPECT_EQ( key, expected->first );
+        M_EXPECT_EQ( item.num(), expected->second );
+        ++expected;
+    }
+    M_ASSERT_TRUE( expected == model.end() );
+
+    // erase everything through iterators, the tree shrinks back to nothing
+    auto& mut = value.obj();
+    for (auto it = mut.begin(); it != mut.end(); ) it = mut.erase(it);
+    M_ASSERT_TRUE( mut.empty() );
+    M_ASSERT_EQ( mut.height(), 0 );
+    value["again"] = 1;
+    M_ASSERT_EQ( value.dump(), R"({"again":1})" );
+}
+
+M_TEST(BTree, BulkLoad) {
+    std::string text = "{";
+    for (int i = 0; i < 5000; ++i) {
+        const auto digits = std::to_string(i);
+        text += "\"" + std::string(5 - digits.size(), '0') + digits + "\":" + digits;
+        text += i + 1 < 5000 ? "," : "}";
+    }
+    const auto value = BJson::parse(text);
+    M_ASSERT_TRUE( value.has_value() );
+    M_ASSERT_EQ( value->size(), 5000 );
+    M_ASSERT_EQ( value->dump(), text );
+    M_ASSERT_EQ( value->at("04321").num(), 4321 );
+
+    // copies rebuild the tree, equality compares in order
+    BJson copy = *value;
+    M_ASSERT_EQ( copy, *value );
+    copy["04321"] = 0;
+    M_ASSERT_NE( copy, *value );
+}
+
+M_TEST(BTree, Range) {
+    BJson value{ BJson::Obj{} };
+    for (const auto* key : { "user:1", "user:2", "user:10", "users", "admin:1", "user;", "user" }) value[key] = key;
+    const auto& obj = value.obj();
+
+    std::vector<std::string> users;
+    for (auto [it, last] = obj.prefix_range("user:"); it != last; ++it) users.push_back(it->first);
+    M_ASSERT_EQ( users.size(), 3 );
+    M_ASSERT_EQ( users[0], "user:1" );
+    M_ASSERT_EQ( users[1], "user:10" );
+    M_ASSERT_EQ( users[2], "user:2" );
+
+    const auto [all_first, all_last] = obj.prefix_range("");
+    M_ASSERT_EQ( std::distance(all_first, all_last), 7 );
+    const auto [none_first, none_last] = obj.prefix_range("zzz");
+    M_ASSERT_TRUE( none_first == none_last );
+
+    M_ASSERT_EQ( obj.lower_bound("user:")->first, "user:1" );
+    M_ASSERT_EQ( obj.upper_bound("user:2")->first, "user;" );
+    M_ASSERT_TRUE( obj.lower_bound("v") == obj.end() );
+}
@@ -0,0 +1,159 @@
+#include <vct/test_unit_macros.hpp>
+
+import std;
+import vct.test.unit;
+import mysvac.json;
+
+
+using namespace mysvac;
+
+using CJson = json::Json<true, std::allocator, std::allocator, std::allocator, true>;
+
+M_TEST(Cache, Size) {
+    M_ASSERT_EQ( sizeof(Json), sizeof(json::Json<true, std::allocator, std::allocator, std::allocator, false>) );
+}
+
+M_TEST(Cache, Invalidate) {
+    CJson cached = CJson::Obj{
+        { "config", CJson::Obj{ { "port", 8080 }, { "hosts", CJson::Arr{{ "a", "b" }} } } },
+        { "state", CJson::Arr{{ 1, 2, 3 }} }
+    };
+    Json plain = Json::parse(cached.dump()).value_or(nullptr);
+    M_ASSERT_EQ( cached.dump(), plain.dump() );
+    M_ASSERT_EQ( cached.dump(), plain.dump() );
+
+    cached["config"]["port"] = 9090;
+    plain["config"]["port"] = 9090;
+    M_ASSERT_EQ( cached.dump(), plain.dump() );
+
+    cached["config"]["hosts"].push_back("c");
+    plain["config"]["hosts"].push_back("c");
+    M_ASSERT_EQ( cached.dump(), plain.dump() );
+
+    cached["state"].pop_back();
+    plain["state"].pop_back();
+    M_ASSERT_EQ( cached.dump(), plain.dump() );
+
+    cached["state"].insert(0, "first");
+    plain["state"].insert(0, "first");
+    M_ASSERT_EQ( cached.dump(), plain.dump() );
+
+    cached["state"].erase(1);
+    plain["state"].erase(1);
+    M_ASSERT_EQ( cached.dump(), plain.dump() );
+
+    cached["config"].insert("debug", true);
+    plain["config"].insert("debug", true);
+    M_ASSERT_EQ( cached.dump(), plain.dump() );
+
+    cached["config"].erase("hosts");
+    plain["config"].erase("hosts");
+    M_ASSERT_EQ( cached.dump(), plain.dump() );
+
+    cached.at("state").arr().emplace_back(nullptr);
+    plain.at("state").arr().emplace_back(nullptr);
+    M_ASSERT_EQ( cached.dump(), plain.dump() );
+
+    cached["state"] = CJson::Obj{};
+    plain["state"] = Json::Obj{};
+    M_ASSERT_EQ( cached.dump(), plain.dump() );
+
+    cached["config"].reset<CJson::Arr>();
+    plain["config"].reset<Json::Arr>();
+    M_ASSERT_EQ( cached.dump(), plain.dump() );
+    M_ASSERT_EQ( cached.dumpf(), plain.dumpf() );
+    M_ASSERT_EQ( cached.dump_size(), plain.dump().size() );
+}
+
+M_TEST(Cache, CopyMove) {
+    CJson cached = CJson::Arr{{ CJson::Obj{ { "k", "v" } }, 1 }};
+    const auto text = cached.dump();
+
+    CJson copy = cached;
+    M_ASSERT_EQ( copy.dump(), text );
+    copy[0]["k"] = "w";
+    M_ASSERT_EQ( cached.dump(), text );
+    M_ASSERT_NE( copy.dump(), text );
+
+    CJson moved = std::move(cached);
+    M_ASSERT_EQ( moved.dump(), text );
+    M_ASSERT_EQ( cached.dump(), "null" );
+    cached = moved;
+    M_ASSERT_EQ( cached.dump(), text );
+
+    auto obj = std::move(moved[0]).move<CJson::Obj>();
+    M_ASSERT_EQ( moved.dump(), R"([{},1])" );
+}
+
+M_TEST(Cache, HeldReference) {
+    CJson cached = CJson::Obj{
+        { "config", CJson::Obj{ { "port", 8080 }, { "hosts", CJson::Arr{{ "a", "b" }} } } },
+        { "state", CJson::Arr{{ 1, 2, 3 }} }
+    };
+    Json plain = Json::parse(cached.dump()).value_or(nullptr);
+
+    // references taken before a dump and used after it
+    CJson& port = cached["config"]["port"];
+    auto& hosts = cached["config"]["hosts"].arr();
+    auto& state = cached.at("state").arr();
+    M_ASSERT_EQ( cached.dump(), plain.dump() );
+
+    port = 9090;
+    plain["config"]["port"] = 9090;
+    M_ASSERT_EQ( cached.dump(), plain.dump() );
+
+    hosts.emplace_back("c");
+    plain["config"]["hosts"].push_back("c");
+    M_ASSERT_EQ( cached.dump(), plain.dump() );
+
+    state.front().reset<CJson::Obj>();
+    state.front().obj().emplace("k", CJson::Arr{});
+    plain["state"][0] = Json::Obj{ { "k", Json::Arr{} } };
+    M_ASSERT_EQ( cached.dump(), plain.dump() );
+    M_ASSERT_EQ( cached["state"].dump(), plain["state"].dump() );
+
+    // replaced as a whole, the old references are gone and caching resumes
+    cached = CJson::parse(plain.dump()).value();
+    M_ASSERT_EQ( cached.dump(), plain.dump() );
+    M_ASSERT_EQ( cached.dump(), plain.dump() );
+}
+
+M_TEST(Cache, Deep) {
+    CJson cached;
+    Json plain;
+    CJson* x = &cached;
+    Json* y = &plain;
+    for (int i = 0; i < 40; ++i) {
+        *x = CJson::Arr{{ i, CJson::Arr{} }};
+        *y = Json::Arr{{ i, Json::Arr{} }};
+        x = &x->arr().back();
+        y = &y->arr().back();
+    }
+    // levels past `dump_cache_depth` are written anew each time
+    M_ASSERT_EQ( cached.dump(), plain.dump() );
+    *x = "bottom";
+    *y = "bottom";
+    M_ASSERT_EQ( cached.dump(), plain.dump() );
+    M_ASSERT_EQ( std::as_const(cached)[0].dump(), "0" );
+}
+
+M_TEST(Cache, Threads) {
+    CJson doc{ CJson::Arr{} };
+    for (int i = 0; i < 200; ++i) {
+        doc.push_back(CJson::Obj{ { "id", i }, { "tags", CJson::Arr{{ "a", "b", CJson::Obj{ { "n", i } } }} } });
+    }
+    const std::string expected = Json::parse(doc.dump()).value().dump();
+    const CJson copy = CJson::parse(expected).value();
+
+    // a const document is written from several threads while the caches are being filled
+    std::vector<std::string> results(8);
+    {
+        std::vector<std::jthread> threads;
+        for (std::size_t t = 0; t < results.size(); ++t) {
+            threads.emplace_back([&copy, &results, t] {
+                for (int round = 0; round < 4; ++round) results[t] = copy.dump();
+            });
+        }
+    }
+    for (const auto& result : results) M_EXPECT_EQ( result, expected );
+}
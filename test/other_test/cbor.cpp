@@ -0,0 +1,240 @@
+#include <vct/test_unit_macros.hpp>
+
+import std;
+import vct.test.unit;
+import mysvac.json;
+
+
+using namespace mysvac;
+
+template<typename J = Json>
+static std::string encode(const std::type_identity_t<J>& value) {
+    std::string out;
+    value.to_cbor(out);
+    return out;
+}
+
+static std::string hex(const std::string_view data) {
+    std::string out;
+    for (const unsigned char c : data) {
+        out.push_back("0123456789abcdef"[c >> 4]);
+        out.push_back("0123456789abcdef"[c & 15]);
+    }
+    return out;
+}
+
+static std::string unhex(const std::string_view text) {
+    std::string out;
+    for (std::size_t i = 0; i + 1 < text.size(); i += 2) {
+        out.push_back(static_cast<char>(std::stoi(std::string{ text.substr(i, 2) }, nullptr, 16)));
+    }
+    return out;
+}
+
+static std::optional<Json> decode(const std::string_view hex_text) {
+    const std::string data = unhex(hex_text);
+    return Json::from_cbor(std::as_bytes(std::span{ data.data(), data.size() }));
+}
+
+M_TEST(Cbor, Encode) {
+    // examples of RFC 8949 appendix A, integral floats are integers for Json
+    M_ASSERT_EQ( hex(encode(Json{ 0 })), "00" );
+    M_ASSERT_EQ( hex(encode(Json{ 23 })), "17" );
+    M_ASSERT_EQ( hex(encode(Json{ 24 })), "1818" );
+    M_ASSERT_EQ( hex(encode(Json{ 1000 })), "1903e8" );
+    M_ASSERT_EQ( hex(encode(Json{ 1000000 })), "1a000f4240" );
+    M_ASSERT_EQ( hex(encode(Json{ 1000000000000.0 })), "1b000000e8d4a51000" );
+    M_ASSERT_EQ( hex(encode(Json{ 18446744073709549568.0 })), "1bfffffffffffff800" );
+    M_ASSERT_EQ( hex(encode(Json{ -1 })), "20" );
+    M_ASSERT_EQ( hex(encode(Json{ -100 })), "3863" );
+    M_ASSERT_EQ( hex(encode(Json{ -1000 })), "3903e7" );
+    M_ASSERT_EQ( hex(encode(Json{ -0.0 })), "f98000" );
+    M_ASSERT_EQ( hex(encode(Json{ 1.1 })), "fb3ff199999999999a" );
+    M_ASSERT_EQ( hex(encode(Json{ 1.5 })), "f93e00" );
+    M_ASSERT_EQ( hex(encode(Json{ 3.4028234663852886e+38 })), "fa7f7fffff" );
+    M_ASSERT_EQ( hex(encode(Json{ 1.0e+300 })), "fb7e37e43c8800759c" );
+    M_ASSERT_EQ( hex(encode(Json{ 5.960464477539063e-8 })), "f90001" );
+    M_ASSERT_EQ( hex(encode(Json{ 0.00006103515625 })), "f90400" );
+    M_ASSERT_EQ( hex(encode(Json{ -4.1 })), "fbc010666666666666" );
+    M_ASSERT_EQ( hex(encode(Json{ std::numeric_limits<double>::infinity() })), "f97c00" );
+    M_ASSERT_EQ( hex(encode(Json{ -std::numeric_limits<double>::infinity() })), "f9fc00" );
+    M_ASSERT_EQ( hex(encode(Json{ std::numeric_limits<double>::quiet_NaN() })), "f97e00" );
+    M_ASSERT_EQ( hex(encode(Json{ false })), "f4" );
+    M_ASSERT_EQ( hex(encode(Json{ true })), "f5" );
+    M_ASSERT_EQ( hex(encode(Json{})), "f6" );
+    M_ASSERT_EQ( hex(encode(Json{ "" })), "60" );
+    M_ASSERT_EQ( hex(encode(Json{ "IETF" })), "6449455446" );
+    M_ASSERT_EQ( hex(encode(Json{ "ü" })), "62c3bc" );
+    M_ASSERT_EQ( hex(encode(Json{ Json::Arr{} })), "80" );
+    M_ASSERT_EQ( hex(encode(Json{ Json::Arr{{ 1, Json::Arr{{ 2, 3 }}, Json::Arr{{ 4, 5 }} }} })), "8301820203820405" );
+    M_ASSERT_EQ( hex(encode(Json{ Json::Arr(25, 1) })).substr(0, 6), "981901" );
+    M_ASSERT_EQ( hex(encode(Json::Obj{ { "a", 1 }, { "b", Json::Arr{{ 2, 3 }} } })), "a26161016162820203" );
+}
+
+M_TEST(Cbor, Decode) {
+    M_ASSERT_EQ( decode("1bffffffffffffffff")->num(), 18446744073709551615.0 );
+    M_ASSERT_EQ( decode("3bffffffffffffffff")->num(), -18446744073709551616.0 );
+    M_ASSERT_EQ( decode("f93c00")->num(), 1.0 );
+    M_ASSERT_EQ( decode("f97bff")->num(), 65504.0 );
+    M_ASSERT_EQ( decode("fa47c35000")->num(), 100000.0 );
+    M_ASSERT_TRUE( std::isnan(decode("f97e00")->num()) );
+    M_ASSERT_TRUE( decode("f7")->is_nul() );    // undefined
+    M_ASSERT_EQ( decode("4401020304")->str(), unhex("01020304") );
+    // tags that keep the meaning of their item are skipped
+    M_ASSERT_EQ( decode("c074323031332d30332d32315432303a30343a30305a")->str(), "2013-03-21T20:04:00Z" );
+    M_ASSERT_EQ( decode("c11a514b67b0")->num(), 1363896240 );
+    M_ASSERT_EQ( decode("d818456449455446")->str(), unhex("6449455446") );
+    M_ASSERT_EQ( decode("d82076687474703a2f2f7777772e6578616d706c652e636f6d")->str(), "http://www.example.com" );
+    M_ASSERT_EQ( decode("d9d9f783010203")->dump(), "[1,2,3]" );
+    // the others change it, a bignum or a decimal fraction is no string or array
+    M_ASSERT_FALSE( decode("c249010000000000000000").has_value() );
+    M_ASSERT_FALSE( decode("c349010000000000000000").has_value() );
+    M_ASSERT_FALSE( decode("c48221196ab3").has_value() );
+    M_ASSERT_FALSE( decode("c5822003").has_value() );
+    M_ASSERT_FALSE( decode("d9010001").has_value() );
+
+    // indefinite lengths
+    M_ASSERT_EQ( decode("5f42010243030405ff")->str(), unhex("0102030405") );
+    M_ASSERT_EQ( decode("7f657374726561646d696e67ff")->str(), "streaming" );
+    M_ASSERT_EQ( decode("9f018202039f0405ffff")->dump(), "[1,[2,3],[4,5]]" );
+    M_ASSERT_EQ( decode("83018202039f0405ff")->dump(), "[1,[2,3],[4,5]]" );
+    M_ASSERT_EQ( decode("bf61610161629f0203ffff")->dump(), R"({"a":1,"b":[2,3]})" );
+    M_ASSERT_EQ( decode("bf6346756ef563416d7421ff")->dump(), R"({"Amt":-2,"Fun":true})" );
+    M_ASSERT_EQ( decode("9fff")->dump(), "[]" );
+
+    M_ASSERT_FALSE( decode("").has_value() );
+    M_ASSERT_FALSE( decode("1c").has_value() );             // reserved additional information
+    M_ASSERT_FALSE( decode("1f").has_value() );             // indefinite integer
+    M_ASSERT_FALSE( decode("ff").has_value() );             // break outside an indefinite item
+    M_ASSERT_FALSE( decode("f0").has_value() );             // simple value 16
+    M_ASSERT_FALSE( decode("5f6161ff").has_value() );       // text chunk in a byte string
+    M_ASSERT_FALSE( decode("9f01").has_value() );           // missing break
+    M_ASSERT_FALSE( decode("a10102").has_value() );         // integer key
+    M_ASSERT_FALSE( decode("0102").has_value() );           // trailing bytes
+    M_ASSERT_FALSE( decode("63616263ff").has_value() );
+    M_ASSERT_FALSE( decode("9b00000000ffffffff01").has_value() );   // forged length
+    std::string nested;
+    for (int i = 0; i < 300; ++i) nested += "81";
+    M_ASSERT_FALSE( decode(nested + "00").has_value() );    // deeper than max_depth
+}
+
+M_TEST(Cbor, RoundTrip) {
+    Json value = Json::Obj{
+        { "name", "cbor\t\"test\"" },
+        { "list", Json::Arr{{ 1, -2, 2.5, -3e100, 1e300, 0.1, true, false, nullptr }} },
+        { "nested", Json::Obj{ { "empty_arr", Json::Arr{} }, { "empty_obj", Json::Obj{} } } },
+        { "bytes", std::string{ "\0\x01\xff", 3 } }
+    };
+    value["wide"] = Json::Obj{};
+    for (int i = 0; i < 300; ++i) value["wide"][std::to_string(i)] = i * 0.75;
+    const std::string data = encode(value);
+    const auto bytes = std::as_bytes(std::span{ data.data(), data.size() });
+    M_ASSERT_EQ( Json::from_cbor(bytes).value_or(nullptr), value );
+
+    using FJson = json::Json<true, std::allocator, std::allocator, std::allocator, false, json::Storage::eCompact, json::MapType::eFlat>;
+    const auto flat = FJson::from_cbor(bytes);
+    M_ASSERT_TRUE( flat.has_value() );
+    M_ASSERT_EQ( encode<FJson>(*flat), data );
+    using HJson = json::Json<false>;
+    const auto hashed = HJson::from_cbor(bytes);
+    M_ASSERT_TRUE( hashed.has_value() );
+    M_ASSERT_EQ( hashed->at("wide").size(), 300 );
+}
+
+M_TEST(Cbor, View) {
+    const Json value = Json::Obj{
+        { "device", "sensor-17" },
+        { "readings", Json::Arr{{ 20.5, 21, -3 }} },
+        { "ok", true },
+        { "meta", nullptr }
+    };
+    const std::string data = encode(value);
+    const auto view = json::CborView::parse(std::as_bytes(std::span{ data.data(), data.size() }));
+    M_ASSERT_TRUE( view.has_value() );
+    M_ASSERT_TRUE( view->type() == json::Type::eObj );
+    M_ASSERT_EQ( view->size(), 4 );
+
+    // strings point into the encoded buffer
+    const auto device = view->find("device")->as_str();
+    M_ASSERT_EQ( *device, "sensor-17" );
+    M_ASSERT_TRUE( device->data() >= data.data() && device->data() < data.data() + data.size() );
+
+    const auto readings = view->find("readings");
+    M_ASSERT_EQ( readings->size(), 3 );
+    M_ASSERT_EQ( readings->at(0)->as_num(), 20.5 );
+    M_ASSERT_EQ( readings->at(2)->as_num(), -3 );
+    M_ASSERT_FALSE( readings->at(3).has_value() );
+    M_ASSERT_EQ( view->find("ok")->as_bol(), true );
+    M_ASSERT_TRUE( view->find("meta")->type() == json::Type::eNul );
+    M_ASSERT_FALSE( view->find("missing").has_value() );
+    M_ASSERT_FALSE( view->find("ok")->as_num().has_value() );
+
+    std::vector<std::string_view> keys;
+    view->for_each([&keys](const json::CborView key, json::CborView) { keys.push_back(*key.as_str()); });
+    M_ASSERT_EQ( keys.size(), 4 );
+    M_ASSERT_EQ( keys.front(), "device" );
+    M_ASSERT_EQ( readings->decode<Json>()->dump(), "[20.5,21,-3]" );
+    M_ASSERT_EQ( view->decode<Json>().value_or(nullptr), value );
+
+    // indefinite lengths and tags
+    const std::string stream = unhex("bf6161c10161629f0203ff6163817f6161ffff");
+    const auto indefinite = json::CborView::parse(std::as_bytes(std::span{ stream.data(), stream.size() }));
+    M_ASSERT_TRUE( indefinite.has_value() );
+    M_ASSERT_EQ( indefinite->size(), 3 );
+    M_ASSERT_EQ( indefinite->find("a")->as_num(), 1 );
+    M_ASSERT_EQ( indefinite->find("b")->size(), 2 );
+    M_ASSERT_EQ( indefinite->find("b")->at(1)->as_num(), 3 );
+    const auto chunked = indefinite->find("c")->at(0);
+    M_ASSERT_TRUE( chunked->type() == json::Type::eStr );
+    M_ASSERT_FALSE( chunked->as_str().has_value() );
+    M_ASSERT_EQ( chunked->decode<Json>()->str(), "a" );
+
+    const std::string broken = unhex("9f0102");
+    M_ASSERT_FALSE( json::CborView::parse(std::as_bytes(std::span{ broken.data(), broken.size() })).has_value() );
+    const std::string bignum = unhex("81c249010000000000000000");
+    M_ASSERT_FALSE( json::CborView::parse(std::as_bytes(std::span{ bignum.data(), bignum.size() })).has_value() );
+}
+
+M_TEST(Cbor, Stream) {
+    const std::vector<Json> values{
+        Json::Obj{ { "id", 1 }, { "tags", Json::Arr{{ "a", "b" }} } },
+        Json{ 3.25 },
+        Json{ std::string(300, 'x') },
+        Json::Arr{{ Json::Obj{}, Json::Arr{}, nullptr, -70000 }}
+    };
+    std::string data;
+    for (const auto& value : values) value.to_cbor(data);
+    // indefinite lengths, a chunked string and tags
+    data += unhex("bf6161c10161629f0203ff6163817f6161ffff");
+
+    // one byte at a time, every item comes out once its last byte arrived
+    json::CborDecoder<Json> decoder;
+    std::vector<Json> decoded;
+    for (const char c : data) {
+        decoder.feed(std::as_bytes(std::span{ &c, 1 }));
+        while (auto value = decoder.next()) decoded.push_back(std::move(*value));
+    }
+    M_ASSERT_FALSE( decoder.failed() );
+    M_ASSERT_EQ( decoder.buffered(), 0 );
+    M_ASSERT_EQ( decoded.size(), values.size() + 1 );
+    for (std::size_t i = 0; i < values.size(); ++i) M_EXPECT_EQ( decoded[i], values[i] );
+    M_ASSERT_EQ( decoded.back().dump(), R"({"a":1,"b":[2,3],"c":["a"]})" );
+
+    // a partial item stays buffered
+    json::CborDecoder<Json> partial;
+    partial.feed(std::as_bytes(std::span{ data.data(), 5 }));
+    M_ASSERT_FALSE( partial.next().has_value() );
+    M_ASSERT_FALSE( partial.failed() );
+    M_ASSERT_EQ( partial.buffered(), 5 );
+    partial.feed(std::as_bytes(std::span{ data.data() + 5, data.size() - 5 }));
+    M_ASSERT_EQ( partial.next().value_or(nullptr), values[0] );
+
+    // malformed input stops the decoder
+    for (const auto* text : { "ff", "1c", "c249010000000000000000" }) {
+        const std::string bad = unhex(text);
+        json::CborDecoder<Json> failing;
+        failing.feed(std::as_bytes(std::span{ bad.data(), bad.size() }));
+        M_ASSERT_FALSE( failing.next().has_value() );
+        M_ASSERT_TRUE( failing.failed() );
+    }
+}
@@ -0,0 +1,62 @@
+#include <vct/test_unit_macros.hpp>
+
+import std;
+import vct.test.unit;
+import mysvac.json;
+
+
+using namespace mysvac;
+
+using CJson = json::Json<true, std::allocator, std::allocator, std::allocator, false, json::Storage::eCompact>;
+
+M_TEST(Compact, Size) {
+    M_ASSERT_EQ( sizeof(CJson), 16 );
+}
+
+M_TEST(Compact, RoundTrip) {
+    constexpr std::string_view text = R"({"a":[1,2.5,true,false,null,"s\n"],"b":{"c":{}},"d":[]})";
+    const auto value = CJson::parse(text);
+    M_ASSERT_TRUE( value.has_value() );
+    M_ASSERT_EQ( value->dump(), Json::parse(text)->dump() );
+    M_ASSERT_EQ( value->dumpf(), Json::parse(text)->dumpf() );
+    M_ASSERT_EQ( value->type(), json::Type::eObj );
+    M_ASSERT_EQ( value->at("a")[5].str(), "s\n" );
+}
+
+M_TEST(Compact, Mutation) {
+    CJson value;
+    M_ASSERT_TRUE( value.is_nul() );
+    value = 1.5;
+    M_ASSERT_EQ( value.num(), 1.5 );
+    value = "text";
+    M_ASSERT_EQ( value.str(), "text" );
+    value.str() += "!";
+    M_ASSERT_EQ( value.str(), "text!" );
+    value = CJson::Arr{};
+    value.push_back(1);
+    value.push_back(CJson::Obj{ { "k", true } });
+    M_ASSERT_EQ( value.dump(), R"([1,{"k":true}])" );
+    // assign a child into its parent
+    value = value[1];
+    M_ASSERT_EQ( value.dump(), R"({"k":true})" );
+    value = value["k"];
+    M_ASSERT_TRUE( value.bol() );
+    M_ASSERT_THROW( std::ignore = value.num(), std::bad_variant_access );
+}
+
+M_TEST(Compact, CopyMove) {
+    CJson origin{ CJson::Obj{ { "arr", CJson::Arr{ { 1, "two", nullptr } } } } };
+    CJson copy = origin;
+    M_ASSERT_EQ( copy, origin );
+    copy["arr"][1] = "changed";
+    M_ASSERT_EQ( origin["arr"][1].str(), "two" );
+
+    CJson moved = std::move(copy);
+    M_ASSERT_EQ( moved["arr"][1].str(), "changed" );
+    M_ASSERT_TRUE( copy.is_nul() );
+
+    copy = moved;
+    M_ASSERT_EQ( copy, moved );
+    moved = std::move(origin);
+    M_ASSERT_EQ( moved["arr"][1].str(), "two" );
+}
@@ -0,0 +1,96 @@
+#include <vct/test_unit_macros.hpp>
+
+import std;
+import vct.test.unit;
+import mysvac.json;
+
+
+using namespace mysvac;
+
+using SJson = json::Json<true, std::allocator, std::allocator, std::allocator, false, json::Storage::eShared>;
+
+M_TEST(COW, Share) {
+    M_ASSERT_EQ( sizeof(SJson), 16 );
+    constexpr std::string_view text = R"({"config":{"list":[1,2,3],"name":"base"},"other":[{"k":"v"}]})";
+    const auto origin = SJson::parse(text);
+    M_ASSERT_TRUE( origin.has_value() );
+
+    // copies share every container until one side writes
+    SJson copy = *origin;
+    M_ASSERT_EQ( &copy.obj(), &copy.obj() );
+    M_ASSERT_EQ( &std::as_const(copy).obj(), &std::as_const(copy).obj() );
+    const SJson snapshot = *origin;
+    M_ASSERT_EQ( &snapshot.obj(), &origin->obj() );
+    M_ASSERT_EQ( &snapshot["other"].arr(), &origin->at("other").arr() );
+    M_ASSERT_EQ( snapshot, *origin );
+}
+
+M_TEST(COW, Write) {
+    constexpr std::string_view text = R"({"config":{"list":[1,2,3],"name":"base"},"other":[{"k":"v"}]})";
+    auto origin = *SJson::parse(text);
+    const SJson snapshot = origin;
+
+    origin["config"]["name"] = "changed";
+    origin["config"]["list"].push_back(4);
+    M_ASSERT_EQ( origin.dump(), R"({"config":{"list":[1,2,3,4],"name":"changed"},"other":[{"k":"v"}]})" );
+    M_ASSERT_EQ( snapshot.dump(), text );
+    // the untouched subtree is still shared
+    M_ASSERT_EQ( &std::as_const(origin)["other"].arr(), &snapshot["other"].arr() );
+    M_ASSERT_NE( &std::as_const(origin)["config"].obj(), &snapshot["config"].obj() );
+
+    SJson moved = std::move(origin);
+    M_ASSERT_TRUE( origin.is_nul() );
+    moved["other"][0]["k"].str() += "!";
+    M_ASSERT_EQ( moved["other"][0]["k"].str(), "v!" );
+    M_ASSERT_EQ( snapshot["other"][0]["k"].str(), "v" );
+
+    SJson assigned;
+    assigned = snapshot;
+    assigned = snapshot["config"]["list"];
+    M_ASSERT_EQ( assigned.dump(), "[1,2,3]" );
+    assigned.arr().clear();
+    M_ASSERT_EQ( snapshot["config"]["list"].size(), 3 );
+}
+
+M_TEST(COW, Reference) {
+    auto origin = *SJson::parse(R"({"name":"base","list":[1,2]})");
+    // a const reference taken before the copy points into the shared node
+    const auto& name = std::as_const(origin)["name"].str();
+    const auto* list = &std::as_const(origin)["list"].arr();
+    {
+        const SJson copy = origin;
+        origin["name"] = "changed";
+        // the write detached origin, the references now belong to the copy only
+        M_ASSERT_EQ( name, "base" );
+        M_ASSERT_EQ( &name, &copy["name"].str() );
+        M_ASSERT_EQ( list, &copy["list"].arr() );
+        M_ASSERT_NE( &name, &std::as_const(origin)["name"].str() );
+        // an untouched subtree is still shared, until it is written too
+        M_ASSERT_EQ( list, &std::as_const(origin)["list"].arr() );
+        origin["list"].push_back(3);
+        M_ASSERT_EQ( list, &copy["list"].arr() );
+        M_ASSERT_EQ( list->size(), 2 );
+        M_ASSERT_NE( list, &std::as_const(origin)["list"].arr() );
+    }
+    // the copy is gone, name and list dangle, take them again
+    M_ASSERT_EQ( std::as_const(origin)["name"].str(), "changed" );
+    M_ASSERT_EQ( std::as_const(origin)["list"].size(), 3 );
+}
+
+M_TEST(COW, Threads) {
+    const auto origin = *SJson::parse(R"({"list":[1,2,3],"name":"shared"})");
+    std::array<std::string, 4> results;
+    {
+        std::vector<std::jthread> threads;
+        for (std::size_t t = 0; t < results.size(); ++t) {
+            threads.emplace_back([&results, copy = origin, t] () mutable {
+                copy["list"].push_back(static_cast<double>(t));
+                results[t] = copy.dump();
+            });
+        }
+    }
+    for (std::size_t t = 0; t < results.size(); ++t) {
+        M_ASSERT_EQ( results[t], R"({"list":[1,2,3,)" + std::to_string(t) + R"(],"name":"shared"})" );
+    }
+    M_ASSERT_EQ( origin.dump(), R"({"list":[1,2,3],"name":"shared"})" );
+}
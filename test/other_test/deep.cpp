@@ -0,0 +1,105 @@
+#include <vct/test_unit_macros.hpp>
+
+import std;
+import vct.test.unit;
+import mysvac.json;
+
+
+using namespace mysvac;
+
+// far beyond what the call stack survives with one frame per level
+static constexpr int deep_levels = 100000;
+
+template<typename J>
+static J make_deep(const int levels = deep_levels) {
+    // [1,{"k":[3,{"k":[5,{ ... }]}]}]
+    J value{ typename J::Arr{} };
+    J* node = &value;
+    for (int i = 1; i < levels; ++i) {
+        if (node->is_arr()) {
+            node->push_back(i);
+            node->push_back(typename J::Obj{});
+            node = &(*node)[1];
+        } else {
+            (*node)["k"] = typename J::Arr{};
+            node = &(*node)["k"];
+        }
+    }
+    return value;
+}
+
+template<typename J>
+static void check_deep(const int levels = deep_levels) {
+    J value = make_deep<J>(levels);
+
+    const std::string text = value.dump();
+    M_ASSERT_EQ( text.size(), value.dump_size() );
+    M_ASSERT_TRUE( text.starts_with(R"([1,{"k":[3,{"k":[5,{)") );
+    M_ASSERT_TRUE( text.contains(R"({"k":[)" + std::to_string(levels - 1) + R"(,{}]}]})") );
+    M_ASSERT_TRUE( text.ends_with("}]}]") );
+    std::string out;
+    value.write(out);
+    M_ASSERT_EQ( out, text );
+    // no indentation, the output of a deep document grows with the square of its depth otherwise
+    const std::string formatted = value.dumpf(0);
+    M_ASSERT_TRUE( formatted.starts_with("[\n1,\n{\n\"k\": [\n3,") );
+    M_ASSERT_TRUE( formatted.ends_with("\n}\n]") );
+
+    J copy = value;
+    M_ASSERT_EQ( copy, value );
+    M_ASSERT_EQ( copy.dump(), text );
+    J* node = &copy;
+    while (!node->empty()) node = node->is_arr() ? &(*node)[1] : &(*node)["k"];
+    (*node)["end"] = nullptr;
+    M_ASSERT_NE( copy, value );
+
+    J assigned{ 1 };
+    assigned = value;
+    M_ASSERT_EQ( assigned, value );
+    // both leave scope here, neither destructor may recurse per level
+}
+
+M_TEST(Deep, Default) {
+    check_deep<Json>();
+}
+
+M_TEST(Deep, Backends) {
+    // every level keeps its own serialization, the cache grows with the square of the depth
+    check_deep<json::Json<true, std::allocator, std::allocator, std::allocator, true>>(4000);
+    check_deep<json::Json<false>>();
+    check_deep<json::Json<true, std::allocator, std::allocator, std::allocator, false, json::Storage::eCompact, json::MapType::eFlat>>();
+    check_deep<json::Json<true, std::allocator, std::allocator, std::allocator, false, json::Storage::eShared, json::MapType::eHash>>();
+    check_deep<json::Json<true, std::allocator, std::allocator, std::allocator, false, json::Storage::eVariant, json::MapType::eBTree>>();
+}
+
+M_TEST(Deep, Reclaimer) {
+    json::Reclaimer reclaimer;
+    Json value = make_deep<Json>();
+    reclaimer.retire(std::move(value));
+    M_ASSERT_TRUE( value.is_nul() );
+    for (int i = 0; i < 16; ++i) {
+        Json wide{ Json::Arr{} };
+        for (int j = 0; j < 1000; ++j) wide.push_back(Json::Obj{ { "i", j } });
+        reclaimer.retire(std::move(wide));
+    }
+    reclaimer.wait_idle();
+    reclaimer.retire(std::vector<int>(10, 1));
+}
+
+template<typename J>
+concept discardable = requires(J& json) { json.discard(); };
+
+M_TEST(Deep, Discard) {
+    std::pmr::monotonic_buffer_resource arena;
+    {
+        json::MemoryScope scope{ &arena };
+        pmr::Json value = make_deep<pmr::Json>();
+        M_ASSERT_EQ( value.dump().size(), make_deep<Json>().dump().size() );
+        value.discard();
+        M_ASSERT_TRUE( value.is_nul() );
+    }
+    arena.release();
+    // a document on the global heap would only leak
+    M_ASSERT_FALSE( discardable<Json> );
+    M_ASSERT_TRUE( discardable<pmr::Json> );
+}
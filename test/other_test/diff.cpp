@@ -0,0 +1,164 @@
+#include <vct/test_unit_macros.hpp>
+
+import std;
+import vct.test.unit;
+import mysvac.json;
+
+
+using namespace mysvac;
+
+/**
+ * @brief Apply an RFC 6902 patch made of `add`, `remove`, `replace` and `move`.
+ */
+template<typename J>
+static J apply_patch(J doc, const J& patch) {
+    const auto split = [](const std::string_view path) {
+        const auto slash = path.rfind('/');
+        std::string token;
+        for (std::size_t i = slash + 1; i < path.size(); ++i) {
+            if (path[i] == '~') token.push_back(path[++i] == '0' ? '~' : '/');
+            else token.push_back(path[i]);
+        }
+        return std::pair{ json::JsonPointer::parse(path.substr(0, slash)).value(), token };
+    };
+    const auto add = [&doc, &split](const std::string_view path, J value) {
+        if (path.empty()) {
+            doc = std::move(value);
+            return;
+        }
+        const auto [parent_ptr, token] = split(path);
+        J& parent = parent_ptr.get(doc);
+        if (parent.is_arr()) {
+            const std::size_t index = token == "-" ? parent.size() : std::stoul(token);
+            if (!parent.insert(index, std::move(value))) throw std::out_of_range{ "add" };
+        } else {
+            parent.obj()[typename J::Str(token)] = std::move(value);
+        }
+    };
+    for (const J& op : patch.arr()) {
+        const std::string_view name = op["op"].str();
+        const std::string_view path = op["path"].str();
+        const auto ptr = json::JsonPointer::parse(path).value();
+        if (name == "add") {
+            add(path, op["value"]);
+        } else if (name == "remove") {
+            if (!ptr.erase(doc)) throw std::out_of_range{ "remove" };
+        } else if (name == "replace") {
+            ptr.get(doc) = op["value"];
+        } else if (name == "move") {
+            const auto from = json::JsonPointer::parse(op["from"].str()).value();
+            J value = from.get(doc);
+            from.erase(doc);
+            add(path, std::move(value));
+        }
+    }
+    return doc;
+}
+
+template<typename J>
+static void check_round_trip(const J& a, const J& b) {
+    for (const bool moves : { false, true }) {
+        const J patch = J::diff(a, b, moves);
+        M_EXPECT_EQ( apply_patch(a, patch), b );
+        M_EXPECT_EQ( J::diff(b, b, moves).size(), 0 );
+    }
+}
+
+M_TEST(Diff, Basic) {
+    const Json a = Json::parse(R"({"a":1,"b":{"c":[1,2,3],"d":"x"},"e/f":true,"g~h":null})").value();
+    const Json b = Json::parse(R"({"a":2,"b":{"c":[1,2,3,4],"d":"x"},"e/f":true,"new":[]})").value();
+    const Json patch = Json::diff(a, b);
+    M_ASSERT_EQ( patch.dump(), R"([{"op":"remove","path":"/g~0h"},{"op":"add","path":"/new","value":[]},{"op":"replace","path":"/a","value":2},{"op":"add","path":"/b/c/3","value":4}])" );
+    M_ASSERT_EQ( apply_patch(a, patch), b );
+    M_ASSERT_EQ( Json::diff(a, a).dump(), "[]" );
+    M_ASSERT_EQ( Json::diff(a, Json{ 1 }).dump(), R"([{"op":"replace","path":"","value":1}])" );
+    M_ASSERT_EQ( Json::diff(Json{ "x" }, Json{ "y" }).dump(), R"([{"op":"replace","path":"","value":"y"}])" );
+
+    check_round_trip(a, b);
+    check_round_trip(Json::parse(R"({"e/f":[{"~":1}]})").value(), Json::parse(R"({"e/f":[{"~":2}]})").value());
+    check_round_trip(Json{ Json::Arr{} }, Json::parse("[1,[2],{}]").value());
+    check_round_trip(Json::parse("[1,[2],{}]").value(), Json{ Json::Obj{} });
+}
+
+M_TEST(Diff, Arrays) {
+    const auto arr = [](const std::string_view text) { return Json::parse(text).value(); };
+    // only the middle between the common prefix and suffix is edited
+    M_ASSERT_EQ( Json::diff(arr("[0,1,2,3]"), arr("[0,3]")).dump(), R"([{"op":"remove","path":"/2"},{"op":"remove","path":"/1"}])" );
+    M_ASSERT_EQ( Json::diff(arr("[0,3]"), arr("[0,1,2,3]")).dump(), R"([{"op":"add","path":"/1","value":1},{"op":"add","path":"/2","value":2}])" );
+    M_ASSERT_EQ( Json::diff(arr("[0,1,3]"), arr("[0,2,3]")).dump(), R"([{"op":"replace","path":"/1","value":2}])" );
+
+    // a rotation is one move instead of rewriting every item
+    const Json a = arr(R"([{"id":1},{"id":2},{"id":3},{"id":4},{"id":5}])");
+    const Json b = arr(R"([{"id":5},{"id":1},{"id":2},{"id":3},{"id":4}])");
+    M_ASSERT_EQ( Json::diff(a, b, true).dump(), R"([{"from":"/4","op":"move","path":"/0"}])" );
+    M_ASSERT_EQ( Json::diff(a, b).size(), 5 );
+    // unmatched items are diffed in place
+    const Json c = arr(R"([{"id":4},{"id":1,"x":0},{"id":2},{"id":3},{"id":9}])");
+    M_ASSERT_EQ( apply_patch(a, Json::diff(a, c, true)), c );
+    check_round_trip(a, b);
+    check_round_trip(a, c);
+    check_round_trip(arr("[1,1,2,2,3,3]"), arr("[3,2,1,3,2,1,0]"));
+    check_round_trip(arr("[1,2,3,4,5,6,7,8]"), arr("[8,7,6,5,4,3,2,1]"));
+    check_round_trip(arr("[[1],[2],[1]]"), arr("[[1],[1],[3]]"));
+
+    // pseudo-random edits of arrays of small records
+    std::mt19937 rng{ 42 };
+    for (int round = 0; round < 200; ++round) {
+        Json x{ Json::Arr{} }, y{ Json::Arr{} };
+        for (std::size_t i = rng() % 12; i > 0; --i) x.arr().push_back(Json::Obj{ { "v", static_cast<int>(rng() % 6) } });
+        y = x;
+        for (std::size_t i = rng() % 6; i > 0; --i) {
+            switch (rng() % 4) {
+                case 0: y.arr().push_back(Json::Obj{ { "v", static_cast<int>(rng() % 6) } }); break;
+                case 1: if (!y.arr().empty()) y.arr().erase(y.arr().begin() + static_cast<std::ptrdiff_t>(rng() % y.size())); break;
+                case 2: if (!y.arr().empty()) y.arr()[rng() % y.size()]["v"] = static_cast<int>(rng() % 6); break;
+                default: std::ranges::shuffle(y.arr(), rng); break;
+            }
+        }
+        check_round_trip(x, y);
+    }
+}
+
+M_TEST(Diff, Backends) {
+    using HJson = json::Json<false>;
+    using IJson = json::Json<true, std::allocator, std::allocator, std::allocator, false, json::Storage::eCompact, json::MapType::eIndex>;
+    using FJson = json::Json<true, std::allocator, std::allocator, std::allocator, false, json::Storage::eVariant, json::MapType::eFlat>;
+    const std::string_view a = R"({"k1":[1,2,{"x":"y"}],"k2":{"n":null,"t":true},"k3":"s"})";
+    const std::string_view b = R"({"k0":0,"k1":[1,{"x":"z"}],"k2":{"n":false,"t":true}})";
+    check_round_trip(HJson::parse(a).value(), HJson::parse(b).value());
+    check_round_trip(IJson::parse(a).value(), IJson::parse(b).value());
+    check_round_trip(FJson::parse(a).value(), FJson::parse(b).value());
+
+    // copies share untouched subtrees, which are skipped without a look inside
+    using SJson = json::Json<true, std::allocator, std::allocator, std::allocator, false, json::Storage::eShared>;
+    SJson base{ SJson::Obj{} };
+    for (int i = 0; i < 1000; ++i) base[std::to_string(i)] = SJson::Arr{{ i, std::to_string(i), SJson::Obj{ { "i", i } } }};
+    SJson next = base;
+    next["500"][2]["i"] = -1;
+    M_ASSERT_EQ( SJson::diff(base, next).dump(), R"([{"op":"replace","path":"/500/2/i","value":-1}])" );
+
+    // a cached dump does not change the result
+    using CJson = json::Json<true, std::allocator, std::allocator, std::allocator, true>;
+    const CJson x = CJson::parse(R"({"a":[1,2],"b":1})").value();
+    CJson y = x;
+    y["b"] = 2;
+    std::ignore = x.dump();
+    std::ignore = y.dump();
+    M_ASSERT_EQ( CJson::diff(x, y).dump(), R"([{"op":"replace","path":"/b","value":2}])" );
+}
+
+M_TEST(Diff, Deep) {
+    Json a, b;
+    Json* x = &a;
+    Json* y = &b;
+    for (int i = 0; i < 5000; ++i) {
+        *x = Json::Arr{{ i }};
+        *y = Json::Arr{{ i }};
+        x = &x->arr().emplace_back();
+        y = &y->arr().emplace_back();
+    }
+    *y = "bottom";
+    const Json patch = Json::diff(a, b);
+    M_ASSERT_EQ( patch.size(), 1 );
+    M_ASSERT_EQ( patch[0]["path"].str().size(), 5000 * 2 );
+}
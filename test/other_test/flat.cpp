@@ -0,0 +1,108 @@
+#include <vct/test_unit_macros.hpp>
+
+import std;
+import vct.test.unit;
+import mysvac.json;
+
+
+using namespace mysvac;
+
+using FJson = json::Json<true, std::allocator, std::allocator, std::allocator, false, json::Storage::eVariant, json::MapType::eFlat>;
+
+M_TEST(Flat, Parse) {
+    constexpr std::string_view text = R"({"b":1,"a":{"z":[1,2],"y":null},"c":"s","a":"duplicate"})";
+    const auto value = FJson::parse(text);
+    M_ASSERT_TRUE( value.has_value() );
+    // same order and duplicate handling as std::map
+    M_ASSERT_EQ( value->dump(), Json::parse(text)->dump() );
+    M_ASSERT_EQ( value->dumpf(), Json::parse(text)->dumpf() );
+    M_ASSERT_EQ( value->size(), 3 );
+    M_ASSERT_TRUE( value->contains("a") );
+    M_ASSERT_FALSE( value->contains("d") );
+    M_ASSERT_TRUE( value->at("a").at("y").is_nul() );
+}
+
+M_TEST(Flat, Modify) {
+    FJson value{ FJson::Obj{ { "k2", 2 }, { "k1", 1 }, { "k2", 3 } } };
+    M_ASSERT_EQ( value.dump(), R"({"k1":1,"k2":2})" );
+    value["k0"] = "zero";
+    M_ASSERT_TRUE( value.insert("k3", true) );
+    M_ASSERT_EQ( value.dump(), R"({"k0":"zero","k1":1,"k2":2,"k3":true})" );
+    M_ASSERT_TRUE( value.erase("k1") );
+    M_ASSERT_FALSE( value.erase("k1") );
+    M_ASSERT_EQ( value.dump(), R"({"k0":"zero","k2":2,"k3":true})" );
+    M_ASSERT_THROW( std::ignore = value.at("missing"), std::out_of_range );
+}
+
+M_TEST(Flat, Large) {
+    // above the linear threshold lookups use binary search
+    FJson value{ FJson::Obj{} };
+    Json expected{ Json::Obj{} };
+    for (int i = 99; i >= 0; --i) {
+        value[std::to_string(i)] = i;
+        expected[std::to_string(i)] = i;
+    }
+    M_ASSERT_EQ( value.size(), 100 );
+    M_ASSERT_EQ( value.dump(), expected.dump() );
+    for (int i = 0; i < 100; ++i) {
+        M_EXPECT_EQ( value.at(std::to_string(i)).num(), i );
+    }
+    const auto parsed = FJson::parse(expected.dump());
+    M_ASSERT_TRUE( parsed.has_value() );
+    M_ASSERT_EQ( *parsed, value );
+}
+
+M_TEST(Flat, Tree) {
+    // past the tree threshold the pairs move to a BTreeMap, iteration stays in key order
+    using Map = json::FlatMap<std::string, int>;
+    static_assert(std::is_same_v<decltype((*std::declval<Map&>().begin()).first), const std::string&>);
+    Map map;
+    std::map<std::string, int> expected;
+    for (int i = 0; i < 1000; ++i) {
+        const auto key = std::to_string(i * 7919 % 1000);
+        map[key] = i;
+        expected[key] = i;
+        M_EXPECT_EQ( map.is_tree(), map.size() > Map::tree_threshold );
+    }
+    M_ASSERT_EQ( map.size(), expected.size() );
+    M_ASSERT_TRUE( std::ranges::equal(map, expected, [](const auto& a, const auto& b) {
+        return a.first == b.first && a.second == b.second;
+    }) );
+    M_ASSERT_FALSE( map.try_emplace("500", -1).second );
+    M_ASSERT_EQ( map.at("500"), expected.at("500") );
+
+    Map copy = map;
+    M_ASSERT_EQ( copy, map );
+    M_ASSERT_EQ( copy.erase("500"), 1 );
+    M_ASSERT_EQ( copy.erase(copy.find("501"))->first, "502" );
+    M_ASSERT_EQ( copy.size(), 998 );
+    M_ASSERT_FALSE( copy == map );
+    Map moved = std::move(copy);
+    M_ASSERT_EQ( moved.size(), 998 );
+    M_ASSERT_FALSE( moved.contains("500") );
+
+    // a large vector is handed over at once
+    Map adopted{ Map::container_type(expected.rbegin(), expected.rend()) };
+    M_ASSERT_TRUE( adopted.is_tree() );
+    M_ASSERT_EQ( adopted, map );
+    adopted.clear();
+    M_ASSERT_FALSE( adopted.is_tree() );
+    adopted["a"] = 1;
+    M_ASSERT_EQ( adopted.size(), 1 );
+
+    FJson value{ FJson::Obj{} };
+    for (int i = 0; i < 200; ++i) value[std::to_string(i)] = i;
+    M_ASSERT_TRUE( value.obj().is_tree() );
+    M_ASSERT_EQ( FJson::parse(value.dump()).value(), value );
+}
+
+M_TEST(Flat, Compact) {
+    using CFJson = json::Json<true, std::allocator, std::allocator, std::allocator, false, json::Storage::eCompact, json::MapType::eFlat>;
+    constexpr std::string_view text = R"({"x":{"b":[true],"a":"s"},"w":[]})";
+    const auto value = CFJson::parse(text);
+    M_ASSERT_TRUE( value.has_value() );
+    M_ASSERT_EQ( value->dump(), Json::parse(text)->dump() );
+    CFJson copy = *value;
+    copy["x"]["c"] = 1;
+    M_ASSERT_NE( copy, *value );
+}
@@ -0,0 +1,34 @@
+#include <vct/test_unit_macros.hpp>
+
+import std;
+import vct.test.unit;
+import mysvac.json;
+
+
+using namespace mysvac;
+
+M_TEST(Format, Spec) {
+    const Json value = Json::Obj{
+        { "msg", "line\n\"quoted\"" },
+        { "list", Json::Arr{{ 1, 2.5, true, nullptr }} },
+        { "empty", Json::Obj{} }
+    };
+    M_ASSERT_EQ( std::format("{}", value), value.dump() );
+    M_ASSERT_EQ( std::format("{:p}", value), value.dumpf() );
+    M_ASSERT_EQ( std::format("{:p4}", value), value.dumpf(4) );
+    M_ASSERT_EQ( std::format("{:p0}", value), value.dumpf(0) );
+    M_ASSERT_EQ( std::format("log: {} end", value["list"]), "log: " + value["list"].dump() + " end" );
+
+    std::string out = "prefix ";
+    std::format_to(std::back_inserter(out), "{}", value["msg"]);
+    M_ASSERT_EQ( out, "prefix " + value["msg"].dump() );
+
+    const Json nul;
+    M_ASSERT_EQ( std::format("{}", nul), "null" );
+}
+
+M_TEST(Format, Error) {
+    const Json value = Json::Arr{};
+    M_ASSERT_THROW( std::ignore = std::vformat("{:x}", std::make_format_args(value)), std::format_error );
+    M_ASSERT_THROW( std::ignore = std::vformat("{:p99999}", std::make_format_args(value)), std::format_error );
+}
@@ -0,0 +1,107 @@
+#include <vct/test_unit_macros.hpp>
+
+import std;
+import vct.test.unit;
+import mysvac.json;
+
+
+using namespace mysvac;
+
+using HJson = json::Json<true, std::allocator, std::allocator, std::allocator, false, json::Storage::eVariant, json::MapType::eHash>;
+
+M_TEST(Hash, Parse) {
+    constexpr std::string_view text = R"({"b":1,"a":{"z":[1,2],"y":null},"c":"s","a":"duplicate"})";
+    const auto value = HJson::parse(text);
+    M_ASSERT_TRUE( value.has_value() );
+    M_ASSERT_EQ( value->size(), 3 );
+    // the first of duplicated keys is kept, like std::map
+    M_ASSERT_TRUE( value->at("a").is_obj() );
+    M_ASSERT_TRUE( value->at("a").at("y").is_nul() );
+    M_ASSERT_EQ( value->at("c").str(), "s" );
+    M_ASSERT_FALSE( value->contains("d") );
+    // iteration order is unspecified, the content round-trips
+    const auto again = HJson::parse(value->dump());
+    M_ASSERT_TRUE( again.has_value() );
+    M_ASSERT_EQ( *again, *value );
+}
+
+M_TEST(Hash, Modify) {
+    HJson value{ HJson::Obj{ { "k2", 2 }, { "k1", 1 }, { "k2", 3 } } };
+    M_ASSERT_EQ( value.size(), 2 );
+    M_ASSERT_EQ( value.at("k2").num(), 2 );
+    value["k0"] = "zero";
+    M_ASSERT_TRUE( value.insert("k3", true) );
+    M_ASSERT_TRUE( value.erase("k1") );
+    M_ASSERT_FALSE( value.erase("k1") );
+    M_ASSERT_EQ( value.size(), 3 );
+    M_ASSERT_FALSE( value.contains("k1") );
+    M_ASSERT_EQ( value.at("k0").str(), "zero" );
+    M_ASSERT_THROW( std::ignore = value.at("missing"), std::out_of_range );
+
+    const HJson same{ HJson::Obj{ { "k3", true }, { "k2", 2 }, { "k0", "zero" } } };
+    M_ASSERT_EQ( value, same );
+    value["k2"] = 5;
+    M_ASSERT_NE( value, same );
+}
+
+M_TEST(Hash, Large) {
+    HJson value{ HJson::Obj{} };
+    for (int i = 0; i < 1000; ++i) value[std::to_string(i)] = i;
+    M_ASSERT_EQ( value.size(), 1000 );
+    const auto& table = value.obj();
+    // power of two with at most 7/8 of the slots used
+    M_ASSERT_EQ( std::popcount(table.capacity()), 1 );
+    M_ASSERT_TRUE( table.capacity() * 7 >= table.size() * 8 );
+
+    // erase half, the tombstones must not break lookups of the rest
+    for (int i = 0; i < 1000; i += 2) M_EXPECT_TRUE( value.erase(std::to_string(i)) );
+    M_ASSERT_EQ( value.size(), 500 );
+    for (int i = 0; i < 1000; ++i) {
+        M_EXPECT_EQ( value.contains(std::to_string(i)), i % 2 == 1 );
+    }
+    // churn through erased slots without growing forever
+    for (int round = 0; round < 20; ++round) {
+        for (int i = 0; i < 1000; i += 2) value[std::to_string(i + 1000 * round)] = round;
+        for (int i = 0; i < 1000; i += 2) M_EXPECT_TRUE( value.erase(std::to_string(i + 1000 * round)) );
+    }
+    M_ASSERT_EQ( value.size(), 500 );
+    M_ASSERT_TRUE( table.capacity() <= 2048 );
+
+    std::size_t visited = 0;
+    for (const auto& [key, item] : value.obj()) {
+        M_EXPECT_EQ( std::to_string(static_cast<int>(item.num())), key );
+        ++visited;
+    }
+    M_ASSERT_EQ( visited, 500 );
+
+    auto& obj = value.obj();
+    for (auto it = obj.begin(); it != obj.end(); ) {
+        if (static_cast<int>(it->second.num()) % 3 == 0) it = obj.erase(it);
+        else ++it;
+    }
+    M_ASSERT_EQ( obj.size(), 333 );
+}
+
+M_TEST(Hash, Seed) {
+    const json::SeededHash hash;
+    M_ASSERT_EQ( hash("key"), hash(std::string{ "key" }) );
+    M_ASSERT_NE( hash("key"), hash("kez") );
+    M_ASSERT_NE( hash(""), hash(std::string_view{ "\0", 1 }) );
+    // the seed is fixed for the process, the same key maps to another value under another seed
+    M_ASSERT_EQ( json::SeededHash::seed(), json::SeededHash::seed() );
+    M_ASSERT_NE( json::SeededHash::hash("key", 1), json::SeededHash::hash("key", 2) );
+    constexpr std::string_view long_key = "a key long enough to take the sixteen byte loop twice";
+    M_ASSERT_NE( hash(long_key), hash(long_key.substr(1)) );
+}
+
+M_TEST(Hash, Compact) {
+    using CHJson = json::Json<true, std::allocator, std::allocator, std::allocator, false, json::Storage::eCompact, json::MapType::eHash>;
+    constexpr std::string_view text = R"({"x":{"b":[true],"a":"s"},"w":[]})";
+    const auto value = CHJson::parse(text);
+    M_ASSERT_TRUE( value.has_value() );
+    CHJson copy = *value;
+    M_ASSERT_EQ( copy, *value );
+    copy["x"]["c"] = 1;
+    M_ASSERT_NE( copy, *value );
+    M_ASSERT_EQ( value->at("x").size(), 2 );
+}
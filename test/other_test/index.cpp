@@ -0,0 +1,97 @@
+#include <vct/test_unit_macros.hpp>
+
+import std;
+import vct.test.unit;
+import mysvac.json;
+
+
+using namespace mysvac;
+
+using IJson = json::Json<true, std::allocator, std::allocator, std::allocator, false, json::Storage::eVariant, json::MapType::eIndex>;
+
+M_TEST(Index, Parse) {
+    constexpr std::string_view text = R"({"b":1,"a":{"z":[1,2],"y":null},"c":"s"})";
+    const auto value = IJson::parse(text);
+    M_ASSERT_TRUE( value.has_value() );
+    // document order survives a round trip
+    M_ASSERT_EQ( value->dump(), text );
+    M_ASSERT_EQ( IJson::parse(value->dumpf())->dump(), text );
+    // the first of duplicated keys is kept, at its first position
+    const auto dup = IJson::parse(R"({"x":1,"y":2,"x":3})");
+    M_ASSERT_TRUE( dup.has_value() );
+    M_ASSERT_EQ( dup->dump(), R"({"x":1,"y":2})" );
+}
+
+M_TEST(Index, Modify) {
+    IJson value{ IJson::Obj{ { "k2", 2 }, { "k1", 1 }, { "k2", 3 } } };
+    M_ASSERT_EQ( value.dump(), R"({"k2":2,"k1":1})" );
+    value["k0"] = "zero";
+    M_ASSERT_TRUE( value.insert("k3", true) );
+    M_ASSERT_EQ( value.dump(), R"({"k2":2,"k1":1,"k0":"zero","k3":true})" );
+    M_ASSERT_TRUE( value.erase("k1") );
+    M_ASSERT_FALSE( value.erase("k1") );
+    M_ASSERT_EQ( value.dump(), R"({"k2":2,"k0":"zero","k3":true})" );
+    M_ASSERT_THROW( std::ignore = value.at("missing"), std::out_of_range );
+    // equality ignores the order
+    const IJson same{ IJson::Obj{ { "k3", true }, { "k0", "zero" }, { "k2", 2 } } };
+    M_ASSERT_EQ( value, same );
+}
+
+M_TEST(Index, Large) {
+    // above the linear threshold lookups go through the index
+    IJson value{ IJson::Obj{} };
+    std::string expected = "{";
+    for (int i = 99; i >= 0; --i) {
+        value[std::to_string(i)] = i;
+        expected += "\"" + std::to_string(i) + "\":" + std::to_string(i) + (i ? "," : "}");
+    }
+    M_ASSERT_EQ( value.dump(), expected );
+    for (int i = 0; i < 100; ++i) {
+        M_EXPECT_EQ( value.at(std::to_string(i)).num(), i );
+    }
+
+    // erase closes the gap and keeps both the order and the index consistent
+    for (int i = 0; i < 100; i += 3) M_EXPECT_TRUE( value.erase(std::to_string(i)) );
+    M_ASSERT_EQ( value.size(), 66 );
+    int previous = 100;
+    for (const auto& [key, item] : value.obj()) {
+        const int number = static_cast<int>(item.num());
+        M_EXPECT_TRUE( number < previous );
+        M_EXPECT_EQ( std::to_string(number), key );
+        previous = number;
+    }
+    for (int i = 0; i < 100; ++i) {
+        M_EXPECT_EQ( value.contains(std::to_string(i)), i % 3 != 0 );
+    }
+
+    auto& obj = value.obj();
+    for (auto it = obj.begin(); it != obj.end(); ) {
+        if (static_cast<int>(it->second.num()) % 2 == 0) it = obj.erase(it);
+        else ++it;
+    }
+    M_ASSERT_EQ( obj.size(), 33 );
+    for (int i = 0; i < 100; ++i) {
+        M_EXPECT_EQ( value.contains(std::to_string(i)), i % 3 != 0 && i % 2 != 0 );
+    }
+    // back below the threshold and up again
+    while (obj.size() > 4) obj.erase(obj.begin());
+    for (int i = 0; i < 20; ++i) value[std::to_string(i + 1000)] = i;
+    M_ASSERT_EQ( obj.size(), 24 );
+    M_ASSERT_EQ( value.at("1019").num(), 19 );
+
+    const auto parsed = IJson::parse(value.dump());
+    M_ASSERT_TRUE( parsed.has_value() );
+    M_ASSERT_EQ( parsed->dump(), value.dump() );
+}
+
+M_TEST(Index, Compact) {
+    using CIJson = json::Json<true, std::allocator, std::allocator, std::allocator, false, json::Storage::eCompact, json::MapType::eIndex>;
+    constexpr std::string_view text = R"({"x":{"b":[true],"a":"s"},"w":[]})";
+    const auto value = CIJson::parse(text);
+    M_ASSERT_TRUE( value.has_value() );
+    M_ASSERT_EQ( value->dump(), text );
+    CIJson copy = *value;
+    copy["x"]["c"] = 1;
+    M_ASSERT_NE( copy, *value );
+    M_ASSERT_EQ( copy.dump(), R"({"x":{"b":[true],"a":"s","c":1},"w":[]})" );
+}
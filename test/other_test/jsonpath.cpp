@@ -0,0 +1,148 @@
+#include <vct/test_unit_macros.hpp>
+
+import std;
+import vct.test.unit;
+import mysvac.json;
+
+
+using namespace mysvac;
+
+// keeps the document order of keys, so results follow the text below
+using IJson = json::Json<true, std::allocator, std::allocator, std::allocator, false, json::Storage::eVariant, json::MapType::eIndex>;
+
+static json::JsonPath path(const std::string_view text) {
+    return json::JsonPath::compile(text).value();
+}
+
+template<typename J>
+static std::string dump_all(const std::vector<const J*>& nodes) {
+    std::string out = "[";
+    for (const J* node : nodes) {
+        if (out.size() > 1) out.push_back(',');
+        out += node->dump();
+    }
+    return out + "]";
+}
+
+static const IJson store = IJson::parse(R"({ "store": {
+    "book": [
+        { "category": "reference", "author": "Nigel Rees", "title": "Sayings of the Century", "price": 8.5 },
+        { "category": "fiction", "author": "Evelyn Waugh", "title": "Sword of Honour", "price": 12.25 },
+        { "category": "fiction", "author": "Herman Melville", "title": "Moby Dick", "isbn": "0-553-21311-3", "price": 8.75 },
+        { "category": "fiction", "author": "J. R. R. Tolkien", "title": "The Lord of the Rings", "isbn": "0-395-19395-8", "price": 22.5 }
+    ],
+    "bicycle": { "color": "red", "price": 399 }
+} })").value();
+
+static std::string query(const std::string_view text) {
+    return dump_all(path(text).select(store));
+}
+
+M_TEST(JsonPath, Select) {
+    // RFC 9535 table 2
+    M_ASSERT_EQ( query("$.store.book[*].author"), R"(["Nigel Rees","Evelyn Waugh","Herman Melville","J. R. R. Tolkien"])" );
+    M_ASSERT_EQ( query("$..author"), R"(["Nigel Rees","Evelyn Waugh","Herman Melville","J. R. R. Tolkien"])" );
+    M_ASSERT_EQ( path("$.store.*").select(store).size(), 2 );
+    M_ASSERT_EQ( query("$.store..price"), "[8.5,12.25,8.75,22.5,399]" );
+    M_ASSERT_EQ( query("$..book[2].author"), R"(["Herman Melville"])" );
+    M_ASSERT_EQ( query("$..book[2].publisher"), "[]" );
+    M_ASSERT_EQ( query("$..book[-1].title"), R"(["The Lord of the Rings"])" );
+    M_ASSERT_EQ( query("$..book[0,1].price"), "[8.5,12.25]" );
+    M_ASSERT_EQ( query("$..book[:2].price"), "[8.5,12.25]" );
+    M_ASSERT_EQ( query("$..book[?@.isbn].price"), "[8.75,22.5]" );
+    M_ASSERT_EQ( query("$..book[?(@.price < 10)].title"), R"(["Sayings of the Century","Moby Dick"])" );
+    M_ASSERT_EQ( path("$..*").select(store).size(), 27 );
+    M_ASSERT_EQ( query("$"), "[" + store.dump() + "]" );
+
+    M_ASSERT_EQ( query("$['store']['bicycle'][\"color\"]"), R"(["red"])" );
+    M_ASSERT_EQ( query("$.store.book[?@.category == 'fiction' && !(@.price >= 20)].author"), R"(["Evelyn Waugh","Herman Melville"])" );
+    M_ASSERT_EQ( query("$.store.book[?@.price > $.store.bicycle.price || @.author == \"Nigel Rees\"].price"), "[8.5]" );
+    // a missing member is not null, only two missing members are equal
+    M_ASSERT_EQ( query("$.store.book[?@.isbn != null].price"), "[8.5,12.25,8.75,22.5]" );
+    M_ASSERT_EQ( query("$.store.book[?@.missing == @.other].price"), "[8.5,12.25,8.75,22.5]" );
+    M_ASSERT_EQ( query("$.store.book[?@.price <= 'x'].price"), "[]" );
+    // a node is returned once per selector naming it, as RFC 9535 keeps duplicates
+    M_ASSERT_EQ( query("$.store.book[0,0,-4].price"), "[8.5,8.5,8.5]" );
+    M_ASSERT_EQ( query("$.store.book[0,*].price"), "[8.5,8.5,12.25,8.75,22.5]" );
+}
+
+M_TEST(JsonPath, Slice) {
+    const IJson arr = IJson::parse("[0,1,2,3,4,5,6,7,8,9]").value();
+    const auto slice = [&arr](const std::string_view text) { return dump_all(path(text).select(arr)); };
+    M_ASSERT_EQ( slice("$[1:3]"), "[1,2]" );
+    M_ASSERT_EQ( slice("$[5:]"), "[5,6,7,8,9]" );
+    M_ASSERT_EQ( slice("$[1:9:3]"), "[1,4,7]" );
+    M_ASSERT_EQ( slice("$[-3:]"), "[7,8,9]" );
+    M_ASSERT_EQ( slice("$[:-8]"), "[0,1]" );
+    M_ASSERT_EQ( slice("$[::0]"), "[]" );
+    M_ASSERT_EQ( slice("$[20:30]"), "[]" );
+    // selected in document order
+    M_ASSERT_EQ( slice("$[::-3]"), "[0,3,6,9]" );
+    M_ASSERT_EQ( slice("$[5:1:-2]"), "[3,5]" );
+    M_ASSERT_EQ( slice("$[?@ > 6]"), "[7,8,9]" );
+    M_ASSERT_EQ( slice("$[-1, 0]"), "[9,0]" );
+    M_ASSERT_EQ( slice("$[0:2, 1, ?@ < 2]"), "[0,0,1,1,1]" );
+    // every `a` is an input of `..b`, the inner `b` is below both and comes first in document order
+    const IJson nested = IJson::parse(R"({"a":{"a":{"b":1},"b":2}})").value();
+    M_ASSERT_EQ( dump_all(path("$..a..b").select(nested)), "[1,1,2]" );
+}
+
+M_TEST(JsonPath, Batch) {
+    std::vector<json::JsonPath> queries;
+    for (const auto* text : { "$..price", "$.store.book[*].title", "$..isbn", "$.store.bicycle", "$.none..x" }) {
+        queries.push_back(path(text));
+    }
+    const auto results = json::JsonPath::select_all(std::span<const json::JsonPath>{ queries }, store);
+    M_ASSERT_EQ( results.size(), queries.size() );
+    for (std::size_t i = 0; i < queries.size(); ++i) {
+        M_EXPECT_EQ( results[i], queries[i].select(store) );
+    }
+    // the nodes themselves are returned
+    M_ASSERT_EQ( results[3].front(), &store["store"]["bicycle"] );
+
+    // other backends and a nesting deeper than any parse limit
+    Json deep;
+    Json* node = &deep;
+    for (int i = 0; i < 5000; ++i) {
+        *node = Json::Obj{ { "v", i } };
+        node = &(node->obj()["next"] = Json{});
+    }
+    *node = "bottom";
+    const auto found = path("$..v").select(deep);
+    M_ASSERT_EQ( found.size(), 5000 );
+    M_ASSERT_EQ( path("$..[?@ == 'bottom']").select(deep).size(), 1 );
+    using HJson = json::Json<true, std::allocator, std::allocator, std::allocator, false, json::Storage::eCompact, json::MapType::eHash>;
+    const HJson hashed = HJson::parse(store.dump()).value();
+    M_ASSERT_EQ( path("$.store.book[?@.author == 'Herman Melville'].price").select(hashed).front()->num(), 8.75 );
+    M_ASSERT_EQ( path("$..price").select(hashed).size(), 5 );
+}
+
+M_TEST(JsonPath, Invalid) {
+    for (const auto* text : {
+        "", "store", "$.", "$..", "$[", "$[1", "$['a'", "$[01]", "$[-0]", "$[1.5]", "$.1a",
+        "$[?]", "$[?@.a ==]", "$[?'a']", "$[?(@.a]", "$[?@.a == 1 &&]", "$['\\x']", "$[9007199254740992]", "$ x"
+    }) {
+        M_EXPECT_FALSE( json::JsonPath::compile(text).has_value() );
+    }
+    M_ASSERT_TRUE( json::JsonPath::compile(" $ .a [ 0 , 'b' ] ..c ").has_value() );
+    M_ASSERT_EQ( path("$['\\u00e9']").select(IJson::parse(R"({"é":1})").value()).size(), 1 );
+    M_ASSERT_FALSE( json::JsonPath::compile("$[?" + std::string(100, '(') + "@" + std::string(100, ')') + "]").has_value() );
+    M_ASSERT_EQ( path("$.a.b").size(), 2 );
+}
+
+M_TEST(JsonPath, Chain) {
+    // precedence and order survive the right-deep chains
+    M_ASSERT_EQ( query("$.store.book[?@.price < 9 || @.price > 20 && @.isbn || @.missing].price"), "[8.5,8.75,22.5]" );
+    M_ASSERT_EQ( query("$.store.book[?@.isbn && @.price > 20 || @.price == 8.5 && @.category == 'reference'].price"), "[8.5,22.5]" );
+    M_ASSERT_EQ( query("$.store.book[?!@.isbn && @.price > 10 && @.category == 'fiction'].price"), "[12.25]" );
+
+    // a flat chain of any length is evaluated without growing the stack
+    std::string any = "$.store.book[?@.missing";
+    std::string all = "$.store.book[?@.price";
+    for (int i = 0; i < 200000; ++i) {
+        any += " || @.missing";
+        all += " && @.price";
+    }
+    M_ASSERT_EQ( dump_all(path(any + " || @.isbn].price").select(store)), "[8.75,22.5]" );
+    M_ASSERT_EQ( dump_all(path(all + " && @.isbn].price").select(store)), "[8.75,22.5]" );
+}
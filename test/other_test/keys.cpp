@@ -0,0 +1,50 @@
+#include <vct/test_unit_macros.hpp>
+
+import std;
+import vct.test.unit;
+import mysvac.json;
+
+
+using namespace mysvac;
+
+M_TEST(Keys, Unescape) {
+    constexpr std::string_view text = R"({"":0,"plain":1,"\tstart":2,"mid\"dle":3,"end\\":4,"a key longer than the small string buffer":5,"AB":6})";
+    const auto value = Json::parse(text);
+    M_ASSERT_TRUE( value.has_value() );
+    M_ASSERT_EQ( value->size(), 7 );
+    M_ASSERT_EQ( value->at("").num(), 0 );
+    M_ASSERT_EQ( value->at("plain").num(), 1 );
+    M_ASSERT_EQ( value->at("\tstart").num(), 2 );
+    M_ASSERT_EQ( value->at("mid\"dle").num(), 3 );
+    M_ASSERT_EQ( value->at("end\\").num(), 4 );
+    M_ASSERT_EQ( value->at("a key longer than the small string buffer").num(), 5 );
+    M_ASSERT_EQ( value->at("AB").num(), 6 );
+
+    // the stream reader takes the generic path
+    std::istringstream iss{ std::string{ text } };
+    const auto streamed = Json::parse(iss);
+    M_ASSERT_TRUE( streamed.has_value() );
+    M_ASSERT_EQ( *streamed, *value );
+}
+
+M_TEST(Keys, Unterminated) {
+    M_ASSERT_FALSE( Json::parse(R"({"key)").has_value() );
+    M_ASSERT_FALSE( Json::parse(R"({"ke\)").has_value() );
+    M_ASSERT_FALSE( Json::parse(R"("abc)").has_value() );
+    M_ASSERT_FALSE( Json::parse(R"("a\q")").has_value() );
+}
+
+M_TEST(Keys, Records) {
+    std::string text = "[";
+    for (int i = 0; i < 1000; ++i) {
+        if (i) text += ',';
+        const auto id = std::to_string(i);
+        text += R"({"active":true,"id":)" + id + R"(,"name":"n)" + id + R"("})";
+    }
+    text += ']';
+    const auto value = Json::parse(text);
+    M_ASSERT_TRUE( value.has_value() );
+    M_ASSERT_EQ( value->size(), 1000 );
+    M_ASSERT_EQ( value->at(999).at("name").str(), "n999" );
+    M_ASSERT_EQ( value->dump(), text );
+}
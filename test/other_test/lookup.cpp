@@ -0,0 +1,65 @@
+#include <vct/test_unit_macros.hpp>
+
+import std;
+import vct.test.unit;
+import mysvac.json;
+
+
+using namespace mysvac;
+
+namespace {
+    template<typename J>
+    void check_lookup() {
+        J value{ typename J::Obj{ { "id", 1 }, { "name", "n" }, { typename J::Str{ "nul\0key", 7 }, nullptr } } };
+        const std::string_view id = "id";
+        const std::string name = "name";
+
+        M_ASSERT_TRUE( value.contains(id) );
+        M_ASSERT_TRUE( value.contains(name) );
+        M_ASSERT_TRUE( value.contains(std::string_view{ "nul\0key", 7 }) );
+        M_ASSERT_FALSE( value.contains("nul") );
+        M_ASSERT_FALSE( value.contains("missing") );
+
+        M_ASSERT_EQ( value[id].num(), 1 );
+        M_ASSERT_EQ( std::as_const(value)[id].num(), 1 );
+        M_ASSERT_EQ( value.at(name).str(), "n" );
+        M_ASSERT_EQ( std::as_const(value).at("name").str(), "n" );
+        M_ASSERT_THROW( std::ignore = value.at("missing"), std::out_of_range );
+        M_ASSERT_THROW( std::ignore = std::as_const(value)["missing"], std::out_of_range );
+        M_ASSERT_FALSE( value.contains("missing") );
+
+        value[std::string_view{ "added" }] = true;
+        M_ASSERT_TRUE( value.at("added").bol() );
+        M_ASSERT_EQ( value.size(), 4 );
+        // an existing key is found by the same lookup, not inserted again
+        value[name] = "m";
+        M_ASSERT_EQ( value.at(name).str(), "m" );
+        M_ASSERT_EQ( value.size(), 4 );
+
+        M_ASSERT_TRUE( value.erase(id) );
+        M_ASSERT_FALSE( value.erase(id) );
+        M_ASSERT_FALSE( value.contains("id") );
+        M_ASSERT_EQ( value.size(), 3 );
+    }
+}
+
+M_TEST(Lookup, Map) {
+    check_lookup<Json>();
+}
+
+M_TEST(Lookup, HashMap) {
+    check_lookup<json::Json<false>>();
+}
+
+M_TEST(Lookup, Backends) {
+    check_lookup<json::Json<true, std::allocator, std::allocator, std::allocator, false, json::Storage::eVariant, json::MapType::eFlat>>();
+    check_lookup<json::Json<true, std::allocator, std::allocator, std::allocator, false, json::Storage::eCompact, json::MapType::eShape>>();
+    check_lookup<pmr::Json>();
+
+    // only a shape may allocate when a key is erased
+    using SJson = json::Json<true, std::allocator, std::allocator, std::allocator, false, json::Storage::eVariant, json::MapType::eShape>;
+    M_ASSERT_TRUE( noexcept(std::declval<Json&>().erase(std::string_view{})) );
+    M_ASSERT_TRUE( noexcept(std::declval<json::Json<false>&>().erase(std::string_view{})) );
+    M_ASSERT_FALSE( noexcept(std::declval<SJson&>().erase(std::string_view{})) );
+    M_ASSERT_TRUE( noexcept(std::declval<const SJson&>().contains(std::string_view{})) );
+}
@@ -0,0 +1,178 @@
+#include <vct/test_unit_macros.hpp>
+
+import std;
+import vct.test.unit;
+import mysvac.json;
+
+
+using namespace mysvac;
+
+template<typename J = Json>
+static std::string encode(const std::type_identity_t<J>& value) {
+    std::string out;
+    value.to_msgpack(out);
+    return out;
+}
+
+static std::span<const std::byte> bytes(const std::string_view data) {
+    return std::as_bytes(std::span{ data.data(), data.size() });
+}
+
+// the largest number of bytes held at once
+struct PeakResource : std::pmr::memory_resource {
+    std::size_t current{ 0 };
+    std::size_t peak{ 0 };
+
+    void* do_allocate(const std::size_t bytes, const std::size_t align) override {
+        current += bytes;
+        peak = std::max(peak, current);
+        return std::pmr::new_delete_resource()->allocate(bytes, align);
+    }
+    void do_deallocate(void* ptr, const std::size_t bytes, const std::size_t align) override {
+        current -= bytes;
+        std::pmr::new_delete_resource()->deallocate(ptr, bytes, align);
+    }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+};
+
+static std::string hex(const std::string_view data) {
+    std::string out;
+    for (const unsigned char c : data) {
+        out.push_back("0123456789abcdef"[c >> 4]);
+        out.push_back("0123456789abcdef"[c & 15]);
+    }
+    return out;
+}
+
+M_TEST(Msgpack, Encode) {
+    M_ASSERT_EQ( hex(encode(Json::Obj{ { "compact", true }, { "schema", 0 } })), "82a7636f6d70616374c3a6736368656d6100" );
+    M_ASSERT_EQ( hex(encode(Json{})), "c0" );
+    M_ASSERT_EQ( hex(encode(Json{ false })), "c2" );
+    // integral numbers take the smallest integer format
+    M_ASSERT_EQ( hex(encode(Json{ 127 })), "7f" );
+    M_ASSERT_EQ( hex(encode(Json{ 128 })), "cc80" );
+    M_ASSERT_EQ( hex(encode(Json{ 65536 })), "ce00010000" );
+    M_ASSERT_EQ( hex(encode(Json{ 4294967296.0 })), "cf0000000100000000" );
+    M_ASSERT_EQ( hex(encode(Json{ -32 })), "e0" );
+    M_ASSERT_EQ( hex(encode(Json{ -33 })), "d0df" );
+    M_ASSERT_EQ( hex(encode(Json{ -40000 })), "d2ffff63c0" );
+    M_ASSERT_EQ( hex(encode(Json{ -9223372036854775808.0 })), "d38000000000000000" );
+    // the rest is float 64, -0.0 keeps its sign
+    M_ASSERT_EQ( hex(encode(Json{ 1.5 })), "cb3ff8000000000000" );
+    M_ASSERT_EQ( hex(encode(Json{ -0.0 })), "cb8000000000000000" );
+    M_ASSERT_EQ( hex(encode(Json{ 18446744073709551616.0 })), "cb43f0000000000000" );
+
+    M_ASSERT_EQ( hex(encode(Json{ std::string(31, 'a') })).substr(0, 2), "bf" );
+    M_ASSERT_EQ( hex(encode(Json{ std::string(32, 'a') })).substr(0, 4), "d920" );
+    M_ASSERT_EQ( hex(encode(Json{ std::string(256, 'a') })).substr(0, 6), "da0100" );
+    M_ASSERT_EQ( hex(encode(Json{ std::string(65536, 'a') })).substr(0, 10), "db00010000" );
+    M_ASSERT_EQ( hex(encode(Json{ Json::Arr(15) })).substr(0, 2), "9f" );
+    M_ASSERT_EQ( hex(encode(Json{ Json::Arr(16) })).substr(0, 6), "dc0010" );
+    M_ASSERT_EQ( hex(encode(Json{ Json::Arr(70000) })).substr(0, 10), "dd00011170" );
+}
+
+M_TEST(Msgpack, RoundTrip) {
+    Json value = Json::Obj{
+        { "name", "msgpack\t\"test\"" },
+        { "list", Json::Arr{{ 1, -2, 2.5, -3e100, 1e300, true, false, nullptr }} },
+        { "nested", Json::Obj{ { "empty_arr", Json::Arr{} }, { "empty_obj", Json::Obj{} } } },
+        { "bytes", std::string{ "\0\x01\xff", 3 } }
+    };
+    value["wide"] = Json::Obj{};
+    for (int i = 0; i < 300; ++i) value["wide"][std::to_string(i)] = i * 1000.25;
+    const std::string data = encode(value);
+    const auto decoded = Json::from_msgpack(bytes(data));
+    M_ASSERT_TRUE( decoded.has_value() );
+    M_ASSERT_EQ( *decoded, value );
+    M_ASSERT_EQ( decoded->dump(), value.dump() );
+
+    // other backends and storage produce the same bytes for sorted maps
+    using FJson = json::Json<true, std::allocator, std::allocator, std::allocator, false, json::Storage::eCompact, json::MapType::eFlat>;
+    const auto flat = FJson::from_msgpack(bytes(data));
+    M_ASSERT_TRUE( flat.has_value() );
+    M_ASSERT_EQ( encode<FJson>(*flat), data );
+    using HJson = json::Json<true, std::allocator, std::allocator, std::allocator, false, json::Storage::eVariant, json::MapType::eHash>;
+    const auto hashed = HJson::from_msgpack(bytes(data));
+    M_ASSERT_TRUE( hashed.has_value() );
+    M_ASSERT_EQ( hashed->at("wide").size(), 300 );
+    M_ASSERT_EQ( HJson::from_msgpack(bytes(encode<HJson>(*hashed))).value_or(nullptr), *hashed );
+}
+
+M_TEST(Msgpack, Decode) {
+    using namespace std::string_view_literals;
+    // formats the encoder never writes
+    M_ASSERT_EQ( Json::from_msgpack(bytes("\xca\x3f\xc0\x00\x00"sv))->num(), 1.5 );
+    M_ASSERT_EQ( Json::from_msgpack(bytes("\xc4\x02\x00\x01"sv))->str(), std::string("\0\x01", 2) );
+    M_ASSERT_EQ( Json::from_msgpack(bytes("\xd1\xff\x00"sv))->num(), -256 );
+    M_ASSERT_EQ( Json::from_msgpack(bytes("\xcf\xff\xff\xff\xff\xff\xff\xff\xff"sv))->num(), 18446744073709551615.0 );
+    // duplicated keys keep the first value, like parse
+    const auto dup = Json::from_msgpack(bytes("\x82\xa1k\x01\xa1k\x02"sv));
+    M_ASSERT_TRUE( dup.has_value() );
+    M_ASSERT_EQ( dup->dump(), R"({"k":1})" );
+
+    M_ASSERT_FALSE( Json::from_msgpack(bytes(""sv)).has_value() );
+    M_ASSERT_FALSE( Json::from_msgpack(bytes("\xc1"sv)).has_value() );            // never used
+    M_ASSERT_FALSE( Json::from_msgpack(bytes("\xd4\x01\x00"sv)).has_value() );    // fixext 1
+    M_ASSERT_FALSE( Json::from_msgpack(bytes("\x81\x01\x02"sv)).has_value() );    // integer key
+    M_ASSERT_FALSE( Json::from_msgpack(bytes("\x92\x01"sv)).has_value() );        // truncated
+    M_ASSERT_FALSE( Json::from_msgpack(bytes("\xa3" "ab"sv)).has_value() );
+    M_ASSERT_FALSE( Json::from_msgpack(bytes("\xcd\x01"sv)).has_value() );
+    M_ASSERT_FALSE( Json::from_msgpack(bytes("\x01\x02"sv)).has_value() );        // trailing bytes
+    // a forged length must fail before reserving
+    M_ASSERT_FALSE( Json::from_msgpack(bytes("\xdd\xff\xff\xff\xff\x01"sv)).has_value() );
+    M_ASSERT_FALSE( Json::from_msgpack(bytes("\xdf\xff\xff\xff\xff\xa1k\x01"sv)).has_value() );
+
+    // every level claims the whole remaining input, only a bounded part of it is reserved
+    std::string forged(1 << 16, '\xc0');
+    for (int level = 0; level < 200; ++level) {
+        const auto length = static_cast<std::uint32_t>(forged.size());
+        forged.insert(0, { '\xdd', static_cast<char>(length >> 24), static_cast<char>(length >> 16), static_cast<char>(length >> 8), static_cast<char>(length) });
+    }
+    PeakResource resource;
+    {
+        const json::MemoryScope scope{ &resource };
+        M_ASSERT_FALSE( pmr::Json::from_msgpack(bytes(forged)).has_value() );
+    }
+    M_ASSERT_TRUE( resource.peak < (64u << 20) );
+
+    const std::string deep = std::string(300, '\x91') + '\xc0';
+    M_ASSERT_FALSE( Json::from_msgpack(bytes(deep)).has_value() );
+    M_ASSERT_TRUE( Json::from_msgpack(bytes(deep), 400).has_value() );
+}
+
+M_TEST(Msgpack, Stream) {
+    const std::vector<Json> values{
+        Json::Obj{ { "id", 1 }, { "tags", Json::Arr{{ "a", "b" }} } },
+        Json{ 3.25 },
+        Json{ std::string(300, 'x') },
+        Json::Arr{{ Json::Obj{}, Json::Arr{}, nullptr, -70000 }}
+    };
+    std::string data;
+    for (const auto& value : values) value.to_msgpack(data);
+
+    // one byte at a time, every value comes out once its last byte arrived
+    json::MsgpackDecoder<Json> decoder;
+    std::vector<Json> decoded;
+    for (const char c : data) {
+        decoder.feed(bytes(std::string_view{ &c, 1 }));
+        while (auto value = decoder.next()) decoded.push_back(std::move(*value));
+    }
+    M_ASSERT_FALSE( decoder.failed() );
+    M_ASSERT_EQ( decoder.buffered(), 0 );
+    M_ASSERT_EQ( decoded.size(), values.size() );
+    for (std::size_t i = 0; i < values.size(); ++i) M_EXPECT_EQ( decoded[i], values[i] );
+
+    // a partial value stays buffered
+    json::MsgpackDecoder<Json> partial;
+    partial.feed(bytes(std::string_view{ data }.substr(0, 5)));
+    M_ASSERT_FALSE( partial.next().has_value() );
+    M_ASSERT_FALSE( partial.failed() );
+    M_ASSERT_EQ( partial.buffered(), 5 );
+    partial.feed(bytes(std::string_view{ data }.substr(5)));
+    M_ASSERT_EQ( partial.next().value_or(nullptr), values[0] );
+
+    json::MsgpackDecoder<Json> broken;
+    broken.feed(bytes("\x91\xc1"));
+    M_ASSERT_FALSE( broken.next().has_value() );
+    M_ASSERT_TRUE( broken.failed() );
+}
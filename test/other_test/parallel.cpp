@@ -0,0 +1,50 @@
+#include <vct/test_unit_macros.hpp>
+
+import std;
+import vct.test.unit;
+import mysvac.json;
+
+
+using namespace mysvac;
+
+M_TEST(Parallel, Arr) {
+    Json value = Json::Arr{};
+    for (int i = 0; i < 2000; ++i) {
+        value.push_back(Json::Obj{
+            { "id", i },
+            { "name", std::string(static_cast<std::size_t>(i % 37), 'x') + "\n" },
+            { "tags", Json::Arr{{ i % 2 == 0, nullptr, i * 0.5 }} }
+        });
+    }
+    const std::string expected = value.dump();
+    M_ASSERT_EQ( value.dump_parallel(4), expected );
+    M_ASSERT_EQ( value.dump_parallel(3), expected );
+    M_ASSERT_EQ( value.dump_parallel(1), expected );
+    M_ASSERT_EQ( value.dump_parallel(), expected );
+}
+
+M_TEST(Parallel, Obj) {
+    Json value = Json::Obj{};
+    for (int i = 0; i < 500; ++i) {
+        value["key\t" + std::to_string(i)] = Json::Arr{{ i, "v\"" + std::to_string(i) }};
+    }
+    M_ASSERT_EQ( value.dump_parallel(8), value.dump() );
+}
+
+M_TEST(Parallel, Small) {
+    M_ASSERT_EQ( Json{}.dump_parallel(4), "null" );
+    M_ASSERT_EQ( Json{ Json::Arr{} }.dump_parallel(4), "[]" );
+    M_ASSERT_EQ( Json{ Json::Obj{} }.dump_parallel(4), "{}" );
+    const Json one = Json::Arr{{ "only" }};
+    M_ASSERT_EQ( one.dump_parallel(4), one.dump() );
+    const Json two = Json::Obj{ { "a", 1 }, { "b", Json::Arr{} } };
+    M_ASSERT_EQ( two.dump_parallel(16), two.dump() );
+}
+
+M_TEST(Parallel, Exception) {
+    pmr::Json value = pmr::Json::Arr{};
+    for (int i = 0; i < 100; ++i) value.push_back(i);
+    // the result is allocated between the two passes, the failure comes back to the caller
+    json::MemoryScope scope{ std::pmr::null_memory_resource() };
+    M_ASSERT_THROW( std::ignore = value.dump_parallel(4), std::bad_alloc );
+}
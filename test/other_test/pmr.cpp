@@ -0,0 +1,141 @@
+#include <vct/test_unit_macros.hpp>
+
+import std;
+import vct.test.unit;
+import mysvac.json;
+
+
+using namespace mysvac;
+
+namespace {
+    // counts allocations, forwards to an upstream resource
+    struct CountingResource : std::pmr::memory_resource {
+        std::pmr::memory_resource* upstream;
+        std::size_t allocations{ 0 };
+        std::size_t live{ 0 };
+
+        explicit CountingResource(std::pmr::memory_resource* up) : upstream(up) {}
+
+        void* do_allocate(const std::size_t bytes, const std::size_t align) override {
+            ++allocations; ++live;
+            return upstream->allocate(bytes, align);
+        }
+        void do_deallocate(void* ptr, const std::size_t bytes, const std::size_t align) override {
+            --live;
+            upstream->deallocate(ptr, bytes, align);
+        }
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+    };
+
+    constexpr std::string_view pmr_text = R"({"name":"a string longer than the small buffer","list":[1,2,{"k":"v","w":[true,null]}],"empty":{}})";
+}
+
+M_TEST(PMR, Scope) {
+    std::pmr::monotonic_buffer_resource arena;
+    M_ASSERT_EQ( json::current_resource(), std::pmr::get_default_resource() );
+    {
+        json::MemoryScope scope{ &arena };
+        M_ASSERT_EQ( json::current_resource(), &arena );
+        {
+            json::MemoryScope inner{ std::pmr::new_delete_resource() };
+            M_ASSERT_EQ( json::current_resource(), std::pmr::new_delete_resource() );
+        }
+        M_ASSERT_EQ( json::current_resource(), &arena );
+    }
+    M_ASSERT_EQ( json::current_resource(), std::pmr::get_default_resource() );
+}
+
+M_TEST(PMR, Parse) {
+    // anything escaping the arena would hit the null resource and throw
+    const auto prev = std::pmr::set_default_resource(std::pmr::null_memory_resource());
+    CountingResource counter{ std::pmr::new_delete_resource() };
+    {
+        json::MemoryScope scope{ &counter };
+        auto doc = pmr::Json::parse(pmr_text);
+        M_EXPECT_TRUE( doc.has_value() );
+        if (doc) {
+            const auto text = doc->dump();
+            M_EXPECT_EQ( std::string_view{ text }, Json::parse(pmr_text)->dump() );
+            M_EXPECT_EQ( doc->at("name").str().get_allocator().resource(), &counter );
+            doc->at("list").push_back(pmr::Json::Obj{ { "added", "another string longer than the small buffer" } });
+            doc->at("empty")["key"] = pmr::Json::Arr{ { 1, 2, 3 } };
+            M_EXPECT_EQ( doc->at("list")[3]["added"].str().get_allocator().resource(), &counter );
+        }
+        M_EXPECT_TRUE( counter.allocations > 0 );
+    }
+    std::pmr::set_default_resource(prev);
+    M_ASSERT_EQ( counter.live, 0 );
+}
+
+M_TEST(PMR, Copy) {
+    std::pmr::monotonic_buffer_resource arena;
+    std::optional<pmr::Json> doc;
+    {
+        json::MemoryScope scope{ &arena };
+        doc = pmr::Json::parse(pmr_text);
+    }
+    M_ASSERT_TRUE( doc.has_value() );
+    M_ASSERT_EQ( doc->at("name").str().get_allocator().resource(), &arena );
+
+    // copies allocate from the current resource, outliving the arena scope
+    const pmr::Json copy = *doc;
+    M_ASSERT_EQ( copy, *doc );
+    M_ASSERT_EQ( copy["name"].str().get_allocator().resource(), std::pmr::get_default_resource() );
+    M_ASSERT_EQ( copy["list"][2]["k"].str().get_allocator().resource(), std::pmr::get_default_resource() );
+}
+
+M_TEST(PMR, Compact) {
+    using PJson = json::Json<true, json::ResourceAllocator, json::ResourceAllocator, json::ResourceAllocator, false, json::Storage::eCompact>;
+    const auto prev = std::pmr::set_default_resource(std::pmr::null_memory_resource());
+    CountingResource counter{ std::pmr::new_delete_resource() };
+    {
+        json::MemoryScope scope{ &counter };
+        auto doc = PJson::parse(pmr_text);
+        M_EXPECT_TRUE( doc.has_value() );
+        if (doc) {
+            const auto text = doc->dump();
+            M_EXPECT_EQ( std::string_view{ text }, Json::parse(pmr_text)->dump() );
+            PJson copy = *doc;
+            copy["list"] = "replaced";
+            M_EXPECT_EQ( copy["list"].str(), "replaced" );
+        }
+    }
+    std::pmr::set_default_resource(prev);
+    M_ASSERT_EQ( counter.live, 0 );
+}
+
+M_TEST(PMR, Propagate) {
+    CountingResource counter{ std::pmr::new_delete_resource() };
+    {
+        std::optional<pmr::Json> doc;
+        {
+            json::MemoryScope scope{ &counter };
+            doc = pmr::Json::parse(pmr_text);
+        }
+        M_ASSERT_TRUE( doc.has_value() );
+        const pmr::Json extra = pmr::Json::parse(R"({"added":"another string longer than the small buffer"})").value();
+        M_ASSERT_EQ( extra["added"].str().get_allocator().resource(), std::pmr::get_default_resource() );
+
+        // outside the scope and on another thread, what a container creates comes from its own resource
+        std::jthread{ [&doc, &extra] {
+            json::MemoryScope other{ std::pmr::new_delete_resource() };
+            doc->at("list").push_back(extra);
+            doc->at("list").insert(0, extra);
+            doc->at("empty").insert("a key longer than the small string buffer", extra);
+            doc->at("empty")["another key longer than the small string buffer"] = 1;
+        } }.join();
+        M_EXPECT_EQ( doc->at("list")[0]["added"].str().get_allocator().resource(), &counter );
+        M_EXPECT_EQ( doc->at("list")[4]["added"].str().get_allocator().resource(), &counter );
+        for (const auto& [key, value] : doc->at("empty").obj()) {
+            M_EXPECT_EQ( key.get_allocator().resource(), &counter );
+        }
+        M_EXPECT_EQ( doc->at("empty")["a key longer than the small string buffer"]["added"].str().get_allocator().resource(), &counter );
+
+        // a container keeps its resource when another one is moved into it
+        pmr::Json::Arr target{ json::ResourceAllocator<pmr::Json>{ &counter } };
+        target = pmr::Json::Arr{{ 1, 2 }};
+        M_EXPECT_EQ( target.get_allocator().resource(), &counter );
+        M_EXPECT_FALSE( std::allocator_traits<json::ResourceAllocator<int>>::propagate_on_container_move_assignment::value );
+    }
+    M_ASSERT_EQ( counter.live, 0 );
+}
@@ -0,0 +1,133 @@
+#include <vct/test_unit_macros.hpp>
+
+import std;
+import vct.test.unit;
+import mysvac.json;
+
+
+using namespace mysvac;
+
+static json::JsonPointer ptr(const std::string_view text) {
+    return json::JsonPointer::parse(text).value();
+}
+
+template<typename J>
+static void check_rfc_examples() {
+    // RFC 6901 section 5
+    const auto doc = J::parse(R"({
+        "foo": ["bar", "baz"], "": 0, "a/b": 1, "c%d": 2, "e^f": 3,
+        "g|h": 4, "i\\j": 5, "k\"l": 6, " ": 7, "m~n": 8
+    })").value();
+    M_ASSERT_EQ( ptr("").get(doc), doc );
+    M_ASSERT_EQ( ptr("/foo").get(doc).size(), 2 );
+    M_ASSERT_EQ( ptr("/foo/0").get(doc).str(), "bar" );
+    M_ASSERT_EQ( ptr("/").get(doc).num(), 0 );
+    M_ASSERT_EQ( ptr("/a~1b").get(doc).num(), 1 );
+    M_ASSERT_EQ( ptr("/c%d").get(doc).num(), 2 );
+    M_ASSERT_EQ( ptr("/e^f").get(doc).num(), 3 );
+    M_ASSERT_EQ( ptr("/g|h").get(doc).num(), 4 );
+    M_ASSERT_EQ( ptr("/i\\j").get(doc).num(), 5 );
+    M_ASSERT_EQ( ptr("/k\"l").get(doc).num(), 6 );
+    M_ASSERT_EQ( ptr("/ ").get(doc).num(), 7 );
+    M_ASSERT_EQ( ptr("/m~0n").get(doc).num(), 8 );
+    M_ASSERT_EQ( ptr("/foo/-").get_if(doc), nullptr );
+    M_ASSERT_EQ( ptr("/foo/2").get_if(doc), nullptr );
+    M_ASSERT_EQ( ptr("/foo/01").get_if(doc), nullptr );
+    M_ASSERT_EQ( ptr("/missing").get_if(doc), nullptr );
+    M_ASSERT_EQ( ptr("/a~1b/x").get_if(doc), nullptr );
+    M_ASSERT_THROW( std::ignore = ptr("/missing").get(doc), std::out_of_range );
+}
+
+M_TEST(Pointer, Get) {
+    check_rfc_examples<Json>();
+    check_rfc_examples<json::Json<false>>();
+    check_rfc_examples<json::Json<true, std::allocator, std::allocator, std::allocator, false, json::Storage::eVariant, json::MapType::eHash>>();
+    check_rfc_examples<json::Json<true, std::allocator, std::allocator, std::allocator, false, json::Storage::eVariant, json::MapType::eIndex>>();
+    check_rfc_examples<json::Json<true, std::allocator, std::allocator, std::allocator, false, json::Storage::eCompact, json::MapType::eFlat>>();
+    check_rfc_examples<json::Json<true, std::allocator, std::allocator, std::allocator, false, json::Storage::eVariant, json::MapType::eShape>>();
+    check_rfc_examples<json::Json<true, std::allocator, std::allocator, std::allocator, false, json::Storage::eVariant, json::MapType::eBTree>>();
+
+    // an IndexMap over its linear threshold is looked up through its hash index
+    using IJson = json::Json<true, std::allocator, std::allocator, std::allocator, false, json::Storage::eVariant, json::MapType::eIndex>;
+    IJson wide{ IJson::Obj{} };
+    for (int i = 0; i < 100; ++i) wide[std::to_string(i)] = i;
+    M_ASSERT_EQ( ptr("/42").get(wide).num(), 42 );
+    M_ASSERT_FALSE( ptr("/100").contains(wide) );
+}
+
+M_TEST(Pointer, Parse) {
+    M_ASSERT_TRUE( ptr("").empty() );
+    M_ASSERT_EQ( ptr("/a/b/0").size(), 3 );
+    M_ASSERT_EQ( ptr("//").size(), 2 );
+    M_ASSERT_EQ( ptr("/a~1b/m~0n/-").to_string(), "/a~1b/m~0n/-" );
+    M_ASSERT_TRUE( ptr("/a~1b") == ptr("/a~1b") );
+    M_ASSERT_FALSE( ptr("/a") == ptr("/a/b") );
+    M_ASSERT_FALSE( json::JsonPointer::parse("a").has_value() );
+    M_ASSERT_FALSE( json::JsonPointer::parse("/~").has_value() );
+    M_ASSERT_FALSE( json::JsonPointer::parse("/~2").has_value() );
+    M_ASSERT_FALSE( json::JsonPointer::parse("/a~").has_value() );
+}
+
+M_TEST(Pointer, Set) {
+    Json doc;
+    ptr("/config/servers/0/host").set(doc, "a.example");
+    ptr("/config/servers/-/host").set(doc, "b.example");
+    ptr("/config/retries").set(doc, 3);
+    M_ASSERT_EQ( doc.dump(), R"({"config":{"retries":3,"servers":[{"host":"a.example"},{"host":"b.example"}]}})" );
+    ptr("/config/retries").set(doc, Json::Arr{{ 1, 2 }});
+    M_ASSERT_EQ( ptr("/config/retries/1").get(doc).num(), 2 );
+    M_ASSERT_EQ( ptr("/config/retries/2").set(doc, 3).num(), 3 );
+    M_ASSERT_THROW( ptr("/config/retries/9").set(doc, 0), std::out_of_range );
+    M_ASSERT_THROW( ptr("/config/retries/0/x").set(doc, 0), std::out_of_range );
+    ptr("").set(doc, "replaced");
+    M_ASSERT_EQ( doc.str(), "replaced" );
+
+    using HJson = json::Json<true, std::allocator, std::allocator, std::allocator, false, json::Storage::eVariant, json::MapType::eHash>;
+    HJson hashed;
+    ptr("/a/b").set(hashed, 1);
+    ptr("/a/b").set(hashed, 2);
+    M_ASSERT_EQ( hashed.at("a").size(), 1 );
+    M_ASSERT_EQ( ptr("/a/b").get(hashed).num(), 2 );
+
+    // values cached for `write` are dropped on the way
+    using CJson = json::Json<true, std::allocator, std::allocator, std::allocator, true>;
+    CJson cached = CJson::parse(R"({"a":{"b":1}})").value();
+    M_ASSERT_EQ( cached.dump(), R"({"a":{"b":1}})" );
+    ptr("/a/b").set(cached, 2);
+    M_ASSERT_EQ( cached.dump(), R"({"a":{"b":2}})" );
+}
+
+M_TEST(Pointer, Erase) {
+    Json doc = Json::parse(R"({"a":{"b":[1,2,3],"c":true},"d":null})").value();
+    M_ASSERT_TRUE( ptr("/a/b/1").erase(doc) );
+    M_ASSERT_TRUE( ptr("/a/c").erase(doc) );
+    M_ASSERT_FALSE( ptr("/a/c").erase(doc) );
+    M_ASSERT_FALSE( ptr("/a/b/5").erase(doc) );
+    M_ASSERT_FALSE( ptr("/a/b/-").erase(doc) );
+    M_ASSERT_FALSE( ptr("/x/y").erase(doc) );
+    M_ASSERT_FALSE( ptr("").erase(doc) );
+    M_ASSERT_EQ( doc.dump(), R"({"a":{"b":[1,3]},"d":null})" );
+}
+
+M_TEST(Pointer, Shared) {
+    using SJson = json::Json<true, std::allocator, std::allocator, std::allocator, false, json::Storage::eShared>;
+    SJson doc = SJson::parse(R"({"a":{"b":[1,2,3]},"c":"x"})").value();
+    const SJson copy = doc;
+
+    // reading through a non-const document leaves every node shared
+    M_ASSERT_EQ( ptr("/a/b/1").get(doc).num(), 2 );
+    M_ASSERT_TRUE( ptr("/c").contains(doc) );
+    M_ASSERT_EQ( &std::as_const(doc).obj(), &copy.obj() );
+    M_ASSERT_EQ( &std::as_const(doc)["a"]["b"].arr(), &copy["a"]["b"].arr() );
+
+    // set walks the mutable accessors, only the path to the value is copied
+    ptr("/a/b/-").set(doc, 4);
+    M_ASSERT_NE( &std::as_const(doc)["a"].obj(), &copy["a"].obj() );
+    M_ASSERT_EQ( doc.dump(), R"({"a":{"b":[1,2,3,4]},"c":"x"})" );
+    M_ASSERT_EQ( copy.dump(), R"({"a":{"b":[1,2,3]},"c":"x"})" );
+
+    M_ASSERT_TRUE( ptr("/a/b/0").erase(doc) );
+    M_ASSERT_TRUE( ptr("/c").erase(doc) );
+    M_ASSERT_EQ( doc.dump(), R"({"a":{"b":[2,3,4]}})" );
+    M_ASSERT_EQ( copy.dump(), R"({"a":{"b":[1,2,3]},"c":"x"})" );
+}
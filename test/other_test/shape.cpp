@@ -0,0 +1,139 @@
+#include <vct/test_unit_macros.hpp>
+
+import std;
+import vct.test.unit;
+import mysvac.json;
+
+
+using namespace mysvac;
+
+using SJson = json::Json<true, std::allocator, std::allocator, std::allocator, false, json::Storage::eVariant, json::MapType::eShape>;
+
+M_TEST(Shape, Records) {
+    constexpr std::string_view text = R"([{"id":1,"name":"a","tags":[]},{"id":2,"name":"b","tags":["x"]},{"name":"c","id":3,"tags":[]}])";
+    const auto value = SJson::parse(text);
+    M_ASSERT_TRUE( value.has_value() );
+    // insertion order is kept
+    M_ASSERT_EQ( value->dump(), text );
+    const auto& records = value->arr();
+    M_ASSERT_EQ( records[0].obj().shape(), records[1].obj().shape() );
+    M_ASSERT_NE( records[0].obj().shape(), records[2].obj().shape() );
+    // same keys in another order are still equal
+    const SJson reordered{ SJson::Obj{ { "id", 3 }, { "name", "c" }, { "tags", SJson::Arr{} } } };
+    M_ASSERT_EQ( records[2], reordered );
+    M_ASSERT_EQ( records[1].at("tags")[0].str(), "x" );
+    M_ASSERT_EQ( records[2].at("id").num(), 3 );
+}
+
+M_TEST(Shape, Keys) {
+    std::string text = "[";
+    for (int i = 0; i < 100; ++i) {
+        if (i) text += ',';
+        text += R"({"a key longer than the small string buffer":)" + std::to_string(i) + R"(,"esc\"aped":true,"short":null,"short":1})";
+    }
+    text += ']';
+    const auto value = SJson::parse(text);
+    M_ASSERT_TRUE( value.has_value() );
+    // every record refers to the same key strings
+    const auto& first = value->at(0).obj();
+    const auto& last = value->at(99).obj();
+    M_ASSERT_EQ( first.shape(), last.shape() );
+    M_ASSERT_EQ( &(*first.begin()).first, &(*last.begin()).first );
+    M_ASSERT_EQ( last.at("a key longer than the small string buffer").num(), 99 );
+    M_ASSERT_EQ( last.at("esc\"aped").bol(), true );
+    // the first of duplicated keys is kept
+    M_ASSERT_TRUE( last.at("short").is_nul() );
+    M_ASSERT_EQ( last.size(), 3 );
+
+    std::istringstream iss{ text };
+    const auto streamed = SJson::parse(iss);
+    M_ASSERT_TRUE( streamed.has_value() );
+    M_ASSERT_EQ( *streamed, *value );
+    M_ASSERT_EQ( streamed->dump(), value->dump() );
+}
+
+M_TEST(Shape, Modify) {
+    SJson a{ SJson::Obj{} };
+    SJson b{ SJson::Obj{} };
+    a["x"] = 1;
+    a["y"] = 2;
+    b["x"] = 3;
+    b["y"] = 4;
+    M_ASSERT_EQ( a.obj().shape(), b.obj().shape() );
+    M_ASSERT_TRUE( a.erase("x") );
+    M_ASSERT_FALSE( a.erase("x") );
+    M_ASSERT_EQ( a.dump(), R"({"y":2})" );
+    M_ASSERT_EQ( b.dump(), R"({"x":3,"y":4})" );
+    M_ASSERT_TRUE( a.insert("x", 5) );
+    a.insert("x", 6);
+    M_ASSERT_EQ( a.dump(), R"({"y":2,"x":5})" );
+    M_ASSERT_NE( a.obj().shape(), b.obj().shape() );
+    M_ASSERT_THROW( std::ignore = a.at("z"), std::out_of_range );
+    M_ASSERT_TRUE( a.erase("y") );
+    M_ASSERT_TRUE( a.erase("x") );
+    M_ASSERT_TRUE( a.empty() );
+    M_ASSERT_EQ( a.obj().shape(), nullptr );
+}
+
+M_TEST(Shape, Large) {
+    // beyond max_shared_keys objects own a private shape
+    std::string text = "{";
+    Json expected{ Json::Obj{} };
+    for (int i = 0; i < 200; ++i) {
+        const auto key = std::to_string(i * 7 % 200);
+        if (i) text += ',';
+        text += '"' + key + R"(":)" + std::to_string(i);
+        expected[key] = i;
+    }
+    text += R"(,"0":-1})";
+    const auto value = SJson::parse(text);
+    M_ASSERT_TRUE( value.has_value() );
+    M_ASSERT_EQ( value->size(), 200 );
+    for (int i = 0; i < 200; ++i) {
+        M_EXPECT_EQ( value->at(std::to_string(i * 7 % 200)).num(), i );
+    }
+
+    SJson copy = *value;
+    copy["extra"] = true;
+    M_ASSERT_TRUE( copy.erase("5") );
+    M_ASSERT_EQ( value->size(), 200 );
+    M_ASSERT_EQ( copy.size(), 200 );
+    M_ASSERT_TRUE( value->contains("5") );
+    M_ASSERT_FALSE( value->contains("extra") );
+    M_ASSERT_EQ( copy.at("extra").bol(), true );
+    M_ASSERT_EQ( copy.at("199").num(), value->at("199").num() );
+    M_ASSERT_EQ( Json::parse(value->dump())->dump(), expected.dump() );
+}
+
+M_TEST(Shape, Threads) {
+    std::vector<std::jthread> threads;
+    std::array<std::optional<SJson>, 4> results;
+    for (std::size_t t = 0; t < results.size(); ++t) {
+        threads.emplace_back([&results, t] {
+            results[t] = SJson::parse(R"([{"a":1,"b":2},{"a":3,"b":4},{"a":5,"c":6}])");
+        });
+    }
+    threads.clear();
+    for (const auto& result : results) {
+        M_ASSERT_TRUE( result.has_value() );
+        M_ASSERT_EQ( result->at(0).obj().shape(), results[0]->at(1).obj().shape() );
+    }
+}
+
+M_TEST(Shape, Arena) {
+    using PJson = json::Json<true, json::ResourceAllocator, json::ResourceAllocator, json::ResourceAllocator, false, json::Storage::eVariant, json::MapType::eShape>;
+    constexpr std::string_view text = R"([{"first_long_key_name":1,"second_long_key_name":2},{"first_long_key_name":3,"second_long_key_name":4}])";
+    {
+        std::pmr::monotonic_buffer_resource arena;
+        const json::MemoryScope scope{ &arena };
+        const auto value = PJson::parse(text);
+        M_ASSERT_TRUE( value.has_value() );
+    }
+    // the shapes only hold keys from the global heap, so they outlive the arena
+    const auto value = PJson::parse(text);
+    M_ASSERT_TRUE( value.has_value() );
+    M_ASSERT_EQ( value->dump(), text );
+    PJson copy = *value;
+    copy[0].erase("first_long_key_name");
+    M_ASSERT_EQ( copy[0].obj().shape(), PJson::parse(R"({"second_long_key_name":0})")->obj().shape() );
+}
@@ -0,0 +1,192 @@
+#include <vct/test_unit_macros.hpp>
+#if __has_include(<unistd.h>)
+#include <unistd.h>
+#endif
+#if __has_include(<unistd.h>) && __has_include(<sys/uio.h>) && __has_include(<poll.h>) && __has_include(<fcntl.h>)
+#include <fcntl.h>
+#define M_TEST_WRITEV_SINK
+#endif
+
+import std;
+import vct.test.unit;
+import mysvac.json;
+
+
+using namespace mysvac;
+
+static const Json sink_value = Json::Obj{
+    { "name", "sink\t\"test\"\n" },
+    { "list", Json::Arr{{ 1, 2.5, -3e100, true, false, nullptr }} },
+    { "nested", Json::Obj{ { "empty_arr", Json::Arr{} }, { "empty_obj", Json::Obj{} } } },
+    { "ctrl", std::string{ "\x01\x1f", 2 } }
+};
+
+M_TEST(Sink, Str) {
+    std::string out;
+    sink_value.write(out);
+    M_ASSERT_EQ( out, sink_value.dump() );
+    M_ASSERT_EQ( Json::parse(out).value_or(nullptr), sink_value );
+    out.clear();
+    sink_value.writef(out, 4);
+    M_ASSERT_EQ( out, sink_value.dumpf(4) );
+}
+
+M_TEST(Sink, FixedBuffer) {
+    const std::string expected = sink_value.dump();
+
+    std::array<char, 512> buffer{};
+    json::FixedBufferSink sink{ buffer };
+    sink_value.write(sink);
+    M_ASSERT_FALSE( sink.overflow() );
+    M_ASSERT_EQ( sink.size(), expected.size() );
+    M_ASSERT_EQ( sink.view(), expected );
+
+    std::array<char, 16> small{};
+    json::FixedBufferSink small_sink{ small.data(), small.size() };
+    sink_value.write(small_sink);
+    M_ASSERT_TRUE( small_sink.overflow() );
+    M_ASSERT_EQ( small_sink.size(), small.size() );
+    M_ASSERT_EQ( small_sink.required_size(), expected.size() );
+    M_ASSERT_EQ( small_sink.view(), std::string_view(expected).substr(0, small.size()) );
+}
+
+M_TEST(Sink, Chunk) {
+    std::string joined;
+    std::size_t chunks = 0;
+    {
+        json::ChunkSink sink{ [&](const std::string_view chunk) {
+            joined.append(chunk);
+            ++chunks;
+        }, 8 };
+        sink_value.writef(sink);
+        M_ASSERT_TRUE( sink.flush() );
+    }
+    M_ASSERT_EQ( joined, sink_value.dumpf() );
+    M_ASSERT_TRUE( chunks > 1 );
+}
+
+M_TEST(Sink, ChunkThrows) {
+    std::size_t calls = 0;
+    {
+        json::ChunkSink sink{ [&](std::string_view) {
+            ++calls;
+            throw std::runtime_error{ "full" };
+        }, 1024 };
+        sink_value.write(sink);
+        // the destructor flushes the buffered bytes and swallows the exception
+    }
+    M_ASSERT_EQ( calls, 1 );
+}
+
+#if __has_include(<unistd.h>)
+M_TEST(Sink, Fd) {
+    const std::string expected = sink_value.dumpf();
+    int fds[2];
+    M_ASSERT_EQ( ::pipe(fds), 0 );
+    {
+        // a buffer smaller than the output, so several writes are made
+        json::FdSink sink{ fds[1], 16 };
+        sink_value.writef(sink);
+        M_ASSERT_TRUE( sink.flush() );
+        M_ASSERT_FALSE( sink.failed() );
+    }
+    ::close(fds[1]);
+    std::string out;
+    char buffer[256];
+    for (::ssize_t n; (n = ::read(fds[0], buffer, sizeof(buffer))) > 0; ) out.append(buffer, static_cast<std::size_t>(n));
+    ::close(fds[0]);
+    M_ASSERT_EQ( out, expected );
+
+    // errors are reported by flush(), the destructor stays quiet
+    {
+        json::FdSink sink{ -1, 16 };
+        sink_value.write(sink);
+        M_ASSERT_TRUE( sink.failed() );
+        M_ASSERT_FALSE( sink.flush() );
+    }
+}
+#endif
+
+#ifdef M_TEST_WRITEV_SINK
+/**
+ * @brief Run `write(int fd)` with the write end of a pipe, return what the read end received.
+ * @param non_blocking Make the write end non-blocking, so that large writes come back partial.
+ */
+template<typename F>
+static std::string through_pipe(const F& write, const bool non_blocking = false) {
+    int fds[2];
+    if (::pipe(fds) != 0) return {};
+    if (non_blocking) ::fcntl(fds[1], F_SETFL, ::fcntl(fds[1], F_GETFL) | O_NONBLOCK);
+    std::string out;
+    std::jthread reader{ [&out, fd = fds[0]] {
+        char buffer[4096];
+        for (::ssize_t n; (n = ::read(fd, buffer, sizeof(buffer))) > 0; ) out.append(buffer, static_cast<std::size_t>(n));
+    } };
+    write(fds[1]);
+    ::close(fds[1]);
+    reader.join();
+    ::close(fds[0]);
+    return out;
+}
+
+M_TEST(Sink, Writev) {
+    // many referenced strings with copied separators, more pieces than one `writev` call takes
+    Json big{ Json::Arr{} };
+    for (int i = 0; i < 5000; ++i) big.push_back(std::string(300, static_cast<char>('a' + i % 26)));
+    big.push_back(sink_value);
+    const std::string expected = big.dump();
+
+    M_ASSERT_EQ( through_pipe([&big](const int fd) {
+        json::WritevSink sink{ fd };
+        big.write(sink);
+        M_EXPECT_TRUE( sink.flush() );
+    }), expected );
+
+    // a non-blocking pipe fills up, writes come back partial and are resumed
+    M_ASSERT_EQ( through_pipe([&big](const int fd) {
+        json::WritevSink sink{ fd };
+        big.write(sink);
+        big.writef(sink);
+        M_EXPECT_TRUE( sink.flush() );
+    }, true), expected + big.dumpf() );
+
+    M_ASSERT_EQ( through_pipe([](const int fd) {
+        json::FdSink sink{ fd, 1000 };
+        for (int i = 0; i < 200; ++i) sink_value.write(sink);
+        M_EXPECT_TRUE( sink.flush() );
+    }, true).size(), sink_value.dump().size() * 200 );
+
+    json::WritevSink bad{ -1 };
+    sink_value.write(bad);
+    M_ASSERT_FALSE( bad.flush() );
+    M_ASSERT_TRUE( bad.failed() );
+}
+
+M_TEST(Sink, WritevBorrow) {
+    // strings of the written value from `ref_threshold` bytes on are referenced until the flush,
+    // shorter ones and those given to JsonWriter are copied
+    Json value = Json::Arr{{ std::string(8, 'a'), std::string(7, 'b') }};
+    std::string text(8, 'c');
+    const std::string out = through_pipe([&](const int fd) {
+        json::WritevSink sink{ fd, 8 };
+        value.write(sink);
+        json::JsonWriter writer{ sink };
+        writer.begin_array().value(std::string_view{ text }).value(Json{ std::string(8, 'd') }).end_array();
+        value[0].str().assign(8, 'A');
+        value[1].str().assign(7, 'B');
+        text.assign(8, 'C');
+        M_EXPECT_TRUE( sink.flush() );
+    });
+    M_ASSERT_EQ( out, R"(["AAAAAAAA","bbbbbbb"]["cccccccc","dddddddd"])" );
+}
+#endif
+
+M_TEST(Sink, Stream) {
+    std::ostringstream oss;
+    sink_value.write(oss);
+    M_ASSERT_EQ( oss.str(), sink_value.dump() );
+
+    std::ostringstream oss_f;
+    sink_value.writef(oss_f, 3, 1);
+    M_ASSERT_EQ( oss_f.str(), sink_value.dumpf(3, 1) );
+}
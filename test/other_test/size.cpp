@@ -0,0 +1,31 @@
+#include <vct/test_unit_macros.hpp>
+
+import std;
+import vct.test.unit;
+import mysvac.json;
+
+
+using namespace mysvac;
+
+M_TEST(Size, Dump) {
+    const Json value = Json::Obj{
+        { "str", "esc\"ape\\\n\r\t\x01" },
+        { "num", Json::Arr{{ 0, -1, 3.141592653589793, 1e-300, 123456789012345678.0 }} },
+        { "bol", Json::Arr{{ true, false, nullptr }} },
+        { "empty", Json::Obj{ { "a", Json::Arr{} }, { "o", Json::Obj{} } } }
+    };
+    M_ASSERT_EQ( value.dump_size(), value.dump().size() );
+    M_ASSERT_EQ( value.dumpf_size(), value.dumpf().size() );
+    M_ASSERT_EQ( value.dumpf_size(4, 3), value.dumpf(4, 3).size() );
+    M_ASSERT_EQ( value.dumpf_size(100), value.dumpf(100).size() );
+    M_ASSERT_EQ( Json{}.dump_size(), 4 );
+    M_ASSERT_EQ( Json{"a"}.dump_size(), 3 );
+}
+
+M_TEST(Size, Reserve) {
+    Json value = Json::Arr{};
+    for (int i = 0; i < 1000; ++i) value.push_back(Json::Obj{ { "index", i }, { "name", "item" } });
+    const std::string out = value.dump();
+    M_ASSERT_EQ( out.size(), value.dump_size() );
+    M_ASSERT_EQ( Json::parse(out).value_or(nullptr), value );
+}
@@ -0,0 +1,125 @@
+#include <vct/test_unit_macros.hpp>
+
+import std;
+import vct.test.unit;
+import mysvac.json;
+
+
+using namespace mysvac;
+
+static std::string encode(const Json& value) {
+    std::string out;
+    value.write_snapshot(out);
+    return out;
+}
+
+static std::optional<json::Snapshot> load(const std::string_view data) {
+    return json::Snapshot::load(std::as_bytes(std::span{ data.data(), data.size() }));
+}
+
+M_TEST(Snapshot, View) {
+    Json value = Json::Obj{
+        { "name", "snapshot" },
+        { "version", 3 },
+        { "ratio", -0.25 },
+        { "enabled", true },
+        { "none", nullptr },
+        { "list", Json::Arr{{ 1, "two", Json::Arr{{ 3 }}, Json::Obj{ { "four", 4 } } }} },
+        { "empty", Json::Obj{} }
+    };
+    const auto snapshot = load(encode(value));
+    M_ASSERT_TRUE( snapshot.has_value() );
+    const json::SnapshotView root = snapshot->root();
+    M_ASSERT_TRUE( root.is_obj() );
+    M_ASSERT_EQ( root.size(), 7 );
+    M_ASSERT_EQ( root["name"].to<std::string_view>(), "snapshot" );
+    M_ASSERT_EQ( root.at("version").to<int>(), 3 );
+    M_ASSERT_EQ( root.at("ratio").to<double>(), -0.25 );
+    M_ASSERT_EQ( root.at("enabled").to<bool>(), true );
+    M_ASSERT_TRUE( root.at("none").is_nul() );
+    M_ASSERT_TRUE( root.at("empty").is_obj() && root.at("empty").empty() );
+    M_ASSERT_FALSE( root.contains("missing") );
+    M_ASSERT_THROW( std::ignore = root.at("missing"), std::out_of_range );
+    M_ASSERT_FALSE( root.at("name").to_if<double>().has_value() );
+    M_ASSERT_EQ( root.at("name").to_or<int>(-1), -1 );
+
+    const auto list = root.at("list");
+    M_ASSERT_EQ( list.size(), 4 );
+    M_ASSERT_EQ( list[1].to<std::string>(), "two" );
+    M_ASSERT_EQ( list[2][0].to<int>(), 3 );
+    M_ASSERT_EQ( list[3]["four"].to<int>(), 4 );
+    M_ASSERT_THROW( std::ignore = list.at(4), std::out_of_range );
+    M_ASSERT_THROW( std::ignore = list.at("four"), std::out_of_range );
+
+    // objects iterate in key order whatever the backend
+    std::vector<std::string_view> keys;
+    root.for_each([&keys](const std::string_view key, json::SnapshotView) { keys.push_back(key); });
+    M_ASSERT_TRUE( std::ranges::is_sorted(keys) );
+    M_ASSERT_EQ( keys.size(), 7 );
+    int items = 0;
+    list.for_each([&items](json::SnapshotView) { ++items; });
+    M_ASSERT_EQ( items, 4 );
+
+    M_ASSERT_EQ( root.decode<Json>().value_or(nullptr), value );
+    M_ASSERT_EQ( list.decode<Json>()->dump(), R"([1,"two",[3],{"four":4}])" );
+}
+
+M_TEST(Snapshot, Backends) {
+    using HJson = json::Json<false>;
+    using IJson = json::Json<true, std::allocator, std::allocator, std::allocator, false, json::Storage::eCompact, json::MapType::eIndex>;
+    IJson value = IJson::Obj{};
+    for (int i = 0; i < 500; ++i) value[std::to_string(i * 7919 % 500)] = i;
+    std::string data;
+    value.write_snapshot(data);
+    const auto snapshot = load(data);
+    M_ASSERT_TRUE( snapshot.has_value() );
+    for (int i = 0; i < 500; ++i) {
+        M_EXPECT_EQ( snapshot->root().at(std::to_string(i * 7919 % 500)).to<int>(), i );
+    }
+    const auto hashed = snapshot->root().decode<HJson>();
+    M_ASSERT_TRUE( hashed.has_value() );
+    M_ASSERT_EQ( hashed->size(), 500 );
+    M_ASSERT_EQ( hashed->at("0").to<int>(), 0 );
+}
+
+M_TEST(Snapshot, File) {
+    std::ifstream ifs( CURRENT_PATH "/files/medium_1_plain.json" );
+    const Json value = Json::parse(ifs).value_or( nullptr );
+    M_ASSERT_NE( value.type(), json::Type::eNul );
+
+    const auto path = std::filesystem::temp_directory_path() / "mysvac_json_snapshot_test.bin";
+    M_ASSERT_TRUE( value.save_snapshot(path) );
+    {
+        auto snapshot = json::Snapshot::open(path);
+        M_ASSERT_TRUE( snapshot.has_value() );
+        M_ASSERT_EQ( snapshot->bytes(), std::filesystem::file_size(path) );
+        const auto root = snapshot->root();
+        // views stay valid when the snapshot moves
+        const json::Snapshot moved = std::move(*snapshot);
+        M_ASSERT_EQ( root.decode<Json>().value_or(nullptr), value );
+        M_ASSERT_EQ( moved.root().size(), value.size() );
+    }
+    std::filesystem::remove(path);
+    M_ASSERT_FALSE( json::Snapshot::open(path).has_value() );
+}
+
+M_TEST(Snapshot, Invalid) {
+    const std::string data = encode(Json::Arr{{ 1, 2, 3 }});
+    M_ASSERT_TRUE( load(data).has_value() );
+    M_ASSERT_FALSE( load("").has_value() );
+    M_ASSERT_FALSE( load(std::string_view{ data }.substr(0, data.size() - 1)).has_value() );
+    M_ASSERT_FALSE( load(data + "x").has_value() );
+    std::string bad_magic = data;
+    bad_magic[0] = 'X';
+    M_ASSERT_FALSE( load(bad_magic).has_value() );
+
+    // a corrupted child offset is caught when followed
+    std::string corrupted = data;
+    const std::uint64_t offset = 1u << 20;
+    std::memcpy(corrupted.data() + 40, &offset, sizeof(offset));
+    const auto snapshot = load(corrupted);
+    M_ASSERT_TRUE( snapshot.has_value() );
+    M_ASSERT_TRUE( snapshot->root().is_arr() );
+    M_ASSERT_EQ( snapshot->root().size(), 0 );
+    M_ASSERT_THROW( std::ignore = snapshot->root().at(0), std::out_of_range );
+}
@@ -0,0 +1,92 @@
+#include <vct/test_unit_macros.hpp>
+
+import std;
+import vct.test.unit;
+import mysvac.json;
+
+
+using namespace mysvac;
+
+// keeps the document order of keys, like the tape
+using IJson = json::Json<true, std::allocator, std::allocator, std::allocator, false, json::Storage::eVariant, json::MapType::eIndex>;
+
+static std::string read_file(const std::string& path) {
+    std::ifstream file( CURRENT_PATH "/" + path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Failed to open file: " + path);
+    }
+    return { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+}
+
+M_TEST(Tape, View) {
+    const auto doc = json::TapeDocument::parse(R"( {
+        "name": "tape\n\u00e9",
+        "count": 3,
+        "ratio": -2.5e-3,
+        "flags": [true, false, null],
+        "nested": { "list": [[1, 2], [], {}], "last": "x" }
+    } )");
+    M_ASSERT_TRUE( doc.has_value() );
+    const auto root = doc->root();
+    M_ASSERT_TRUE( root.is_obj() );
+    M_ASSERT_EQ( root.size(), 5 );
+    M_ASSERT_EQ( root["name"].to<std::string_view>(), "tape\n\xc3\xa9" );
+    M_ASSERT_EQ( root["count"].to<int>(), 3 );
+    M_ASSERT_EQ( root["ratio"].to<double>(), -2.5e-3 );
+    M_ASSERT_EQ( root["flags"][0].to<bool>(), true );
+    M_ASSERT_TRUE( root["flags"][2].is_nul() );
+    M_ASSERT_EQ( root["flags"].size(), 3 );
+    // siblings are skipped over whole containers
+    M_ASSERT_EQ( root["nested"]["list"][0][1].to<int>(), 2 );
+    M_ASSERT_TRUE( root["nested"]["list"][1].is_arr() && root["nested"]["list"][1].empty() );
+    M_ASSERT_TRUE( root["nested"]["list"][2].is_obj() );
+    M_ASSERT_EQ( root["nested"]["last"].to<std::string>(), "x" );
+    M_ASSERT_FALSE( root.contains("missing") );
+    M_ASSERT_THROW( std::ignore = root.at("missing"), std::out_of_range );
+    M_ASSERT_THROW( std::ignore = root["flags"].at(3), std::out_of_range );
+    M_ASSERT_EQ( root["name"].to_or<int>(-1), -1 );
+
+    std::vector<std::string_view> keys;
+    root.for_each([&keys](const std::string_view key, json::TapeView) { keys.push_back(key); });
+    M_ASSERT_EQ( keys, (std::vector<std::string_view>{ "name", "count", "ratio", "flags", "nested" }) );
+
+    M_ASSERT_EQ( root["nested"].dump(), R"({"list":[[1,2],[],{}],"last":"x"})" );
+    M_ASSERT_EQ( root.decode<IJson>().value_or(nullptr).dump(), doc->dump() );
+}
+
+M_TEST(Tape, Files) {
+    for (const auto* name : { "files/medium_1.json", "files/many_all.json", "files/many_complex.json", "files/simple_2.json" }) {
+        const std::string text = read_file(name);
+        const auto value = IJson::parse(text);
+        const auto doc = json::TapeDocument::parse(text);
+        M_ASSERT_TRUE( value.has_value() && doc.has_value() );
+        M_EXPECT_EQ( doc->dump(), value->dump() );
+        M_EXPECT_EQ( doc->root().decode<IJson>().value_or(nullptr), *value );
+        M_EXPECT_EQ( doc->root().decode<Json>().value_or(nullptr), Json::parse(text).value_or(nullptr) );
+        M_EXPECT_EQ( doc->root().size(), value->size() );
+    }
+}
+
+M_TEST(Tape, Invalid) {
+    // the same input as `Json::parse` is accepted
+    for (const auto* text : { "[1,]", "{\"a\":1,}", " 12 ", "\"\"", "[[[]]]", "{}" }) {
+        M_EXPECT_TRUE( Json::parse(text).has_value() );
+        M_EXPECT_TRUE( json::TapeDocument::parse(text).has_value() );
+    }
+    for (const auto* text : { "", "[", "[1 2]", "{\"a\" 1}", "{1:2}", "[,1]", "tru", "nul", "[1]x", "\"abc", "\"\\x\"", "{\"a\":}", "-" }) {
+        M_EXPECT_FALSE( Json::parse(text).has_value() );
+        M_EXPECT_FALSE( json::TapeDocument::parse(text).has_value() );
+    }
+    // duplicated keys are all kept on the tape, `find` returns the first like `Json::parse`
+    const auto dup = json::TapeDocument::parse(R"({"k":1,"k":2})");
+    M_ASSERT_EQ( dup->root()["k"].to<int>(), 1 );
+    M_ASSERT_EQ( dup->root().decode<Json>()->dump(), R"({"k":1})" );
+
+    const std::string deep = std::string(300, '[') + std::string(300, ']');
+    M_ASSERT_FALSE( json::TapeDocument::parse(deep).has_value() );
+    M_ASSERT_TRUE( json::TapeDocument::parse(deep, 400).has_value() );
+    const std::string limit = std::string(255, '[') + std::string(255, ']');
+    M_ASSERT_EQ( Json::parse(limit).has_value(), json::TapeDocument::parse(limit).has_value() );
+    const std::string over = std::string(256, '[') + std::string(256, ']');
+    M_ASSERT_EQ( Json::parse(over).has_value(), json::TapeDocument::parse(over).has_value() );
+}
@@ -21,9 +21,9 @@ M_TEST(Type, enum) {
 // Test the Obj type
 M_TEST(Type, Obj) {
 
-    M_ASSERT_TRUE( (std::is_same_v<Json::Obj, std::map<Json::Str, Json>>) );
-    M_ASSERT_EQ( Json::Obj{}, (std::map<Json::Str, Json> {} ));
-    M_ASSERT_EQ( Json::Obj(), (std::map<Json::Str, Json> {} ));
+    M_ASSERT_TRUE( (std::is_same_v<Json::Obj, std::map<Json::Str, Json, std::less<>>>) );
+    M_ASSERT_EQ( Json::Obj{}, (std::map<Json::Str, Json, std::less<>> {} ));
+    M_ASSERT_EQ( Json::Obj(), (std::map<Json::Str, Json, std::less<>> {} ));
 }
 
 // Test the Num type
@@ -0,0 +1,103 @@
+#include <vct/test_unit_macros.hpp>
+
+import std;
+import vct.test.unit;
+import mysvac.json;
+
+
+using namespace mysvac;
+
+M_TEST(Writer, Basic) {
+    std::string out;
+    json::JsonWriter writer{ out };
+    writer.begin_object()
+        .key("id").value(42)
+        .key("name").value("wri\"ter")
+        .key("ok").value(true)
+        .key("none").value(nullptr)
+        .key("list").begin_array()
+            .value(1.5).value(std::string{"x"}).begin_object().end_object().begin_array().end_array()
+        .end_array()
+    .end_object();
+    M_ASSERT_TRUE( writer.done() );
+
+    const Json expected = Json::Obj{
+        { "id", 42 },
+        { "name", "wri\"ter" },
+        { "ok", true },
+        { "none", nullptr },
+        { "list", Json::Arr{{ 1.5, "x", Json::Obj{}, Json::Arr{} }} }
+    };
+    M_ASSERT_EQ( Json::parse(out).value_or(nullptr), expected );
+    M_ASSERT_EQ( out, R"({"id":42,"name":"wri\"ter","ok":true,"none":null,"list":[1.5,"x",{},[]]})" );
+}
+
+M_TEST(Writer, EmbedJson) {
+    const Json sub = Json::Obj{ { "a", Json::Arr{{ 1, 2, 3 }} }, { "b", "text" } };
+    std::string out;
+    json::JsonWriter writer{ out };
+    writer.begin_array().value(sub).value(sub["a"]).value(0).end_array();
+    M_ASSERT_TRUE( writer.done() );
+    M_ASSERT_EQ( out, "[" + sub.dump() + "," + sub["a"].dump() + ",0]" );
+}
+
+M_TEST(Writer, Scalar) {
+    std::string out;
+    json::JsonWriter writer{ out };
+    M_ASSERT_FALSE( writer.done() );
+    writer.value(-0.25);
+    M_ASSERT_TRUE( writer.done() );
+    M_ASSERT_EQ( out, "-0.25" );
+}
+
+M_TEST(Writer, Chunked) {
+    std::string joined;
+    {
+        json::ChunkSink sink{ [&](const std::string_view chunk) { joined.append(chunk); }, 16 };
+        json::JsonWriter writer{ sink };
+        writer.begin_array();
+        for (int i = 0; i < 100; ++i) writer.begin_object().key("i").value(i).end_object();
+        writer.end_array();
+    }
+    const Json value = Json::parse(joined).value_or(nullptr);
+    M_ASSERT_TRUE( value.is_arr() );
+    M_ASSERT_EQ( value.size(), 100 );
+    M_ASSERT_EQ( value[99]["i"], 99 );
+}
+
+M_TEST(Writer, Nesting) {
+#ifndef NDEBUG
+    std::string out;
+    json::JsonWriter bad_key{ out };
+    M_ASSERT_THROW( bad_key.begin_array().key("k"), std::logic_error );
+
+    json::JsonWriter bad_end{ out };
+    M_ASSERT_THROW( bad_end.begin_object().end_array(), std::logic_error );
+
+    json::JsonWriter no_key{ out };
+    M_ASSERT_THROW( no_key.begin_object().value(1), std::logic_error );
+
+    json::JsonWriter dangling{ out };
+    M_ASSERT_THROW( dangling.begin_object().key("k").end_object(), std::logic_error );
+
+    json::JsonWriter twice{ out };
+    M_ASSERT_THROW( twice.value(1).value(2), std::logic_error );
+#endif
+}
+
+M_TEST(Writer, Integers) {
+    std::string out;
+    json::JsonWriter writer{ out };
+    writer.begin_array()
+        .value(std::numeric_limits<std::int64_t>::min())
+        .value(9007199254740993LL)
+        .value(std::numeric_limits<std::uint64_t>::max())
+        .value(static_cast<short>(-7))
+    .end_array();
+    M_ASSERT_EQ( out, "[-9223372036854775808,9007199254740993,18446744073709551615,-7]" );
+
+    // checked in every build, an empty stack has no frame to close
+    json::JsonWriter empty{ out };
+    M_ASSERT_THROW( empty.key("k"), std::logic_error );
+    M_ASSERT_THROW( empty.end_array(), std::logic_error );
+}